@@ -0,0 +1,441 @@
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include <nlohmann/json.hpp>
+
+#include <PurrfectEngine/PurrfectEngine.hpp>
+
+using namespace PurrfectEngine;
+namespace renderer = PurrfectEngine::renderer;
+using json = nlohmann::json;
+
+// Stress scenes, every run with the same seed and options builds exactly the same scenes.
+struct BenchScene {
+  const char *name;
+  uint32_t objects;
+  uint32_t meshes;
+  bool dynamic; // Every object moves each frame.
+};
+
+static const BenchScene sScenes[] = {
+  { "static_1k_m1",     1000,    1,  false },
+  { "dynamic_1k_m8",    1000,    8,  true  },
+  { "static_10k_m8",    10000,   8,  false },
+  { "dynamic_10k_m32",  10000,   32, true  },
+  { "static_100k_m32",  100000,  32, false },
+  { "dynamic_100k_m32", 100000,  32, true  },
+  { "static_1m_m64",    1000000, 64, false },
+  { "dynamic_1m_m64",   1000000, 64, true  },
+};
+
+struct BenchOptions {
+  uint32_t seed = 1337;
+  uint32_t frames = 120;
+  uint32_t warmup = 10;
+  uint32_t maxObjects = 100000; // purrScene inserts are O(n) each, the 1M scenes take minutes to build.
+  int width = 1280;
+  int height = 720;
+  const char *scene = nullptr;   // Run only this scene.
+  const char *model = "../models/ico.obj";
+  const char *jsonPath = nullptr;
+  const char *baselinePath = nullptr;
+  const char *saveBaselinePath = nullptr;
+  double tolerance = 0.10;       // Allowed p50 regression against the baseline.
+};
+
+struct Metric {
+  std::string name;
+  const char *unit;
+  bool higherIsBetter;
+  std::vector<double> samples;
+};
+
+struct SceneResult {
+  std::string scene;
+  std::vector<Metric> metrics;
+};
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsedNs(Clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+// Nearest rank on a sorted copy.
+static double percentile(std::vector<double> sorted, double p) {
+  if (sorted.empty()) return 0.0;
+  std::sort(sorted.begin(), sorted.end());
+  size_t rank = static_cast<size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+static json metricToJson(const Metric &metric) {
+  double sum = 0.0;
+  for (double s: metric.samples) sum += s;
+  json result{};
+  result["unit"] = metric.unit;
+  result["higherIsBetter"] = metric.higherIsBetter;
+  result["samples"] = metric.samples.size();
+  result["mean"] = metric.samples.empty() ? 0.0 : sum / metric.samples.size();
+  result["min"] = percentile(metric.samples, 0.0);
+  result["p50"] = percentile(metric.samples, 50.0);
+  result["p90"] = percentile(metric.samples, 90.0);
+  result["p99"] = percentile(metric.samples, 99.0);
+  result["max"] = percentile(metric.samples, 100.0);
+  return result;
+}
+
+static void printResult(const SceneResult &result) {
+  printf("\n%s\n", result.scene.c_str());
+  printf("  %-22s %12s %12s %12s %12s  %s\n", "metric", "p50", "p90", "p99", "mean", "unit");
+  for (const Metric &metric: result.metrics) {
+    json stats = metricToJson(metric);
+    printf("  %-22s %12.3f %12.3f %12.3f %12.3f  %s\n", metric.name.c_str(),
+           stats["p50"].get<double>(), stats["p90"].get<double>(), stats["p99"].get<double>(), stats["mean"].get<double>(), metric.unit);
+  }
+}
+
+// Box with a per-mesh scale, so every mesh gets buffers of its own.
+static purrMesh *createBoxMesh(PurrfectEngineContext *context, float size) {
+  static const glm::vec3 corners[8] = {
+    {-1,-1,-1}, { 1,-1,-1}, { 1, 1,-1}, {-1, 1,-1},
+    {-1,-1, 1}, { 1,-1, 1}, { 1, 1, 1}, {-1, 1, 1},
+  };
+  static const uint32_t faces[36] = {
+    0,2,1, 0,3,2, 4,5,6, 4,6,7, 0,1,5, 0,5,4,
+    2,3,7, 2,7,6, 1,2,6, 1,6,5, 0,4,7, 0,7,3,
+  };
+  std::vector<Vertex3D> vertices{};
+  for (const glm::vec3 &corner: corners)
+    vertices.push_back(Vertex3D{ corner * size, glm::vec3(1.0f), glm::vec2(0.0f), glm::normalize(corner) });
+  std::vector<uint32_t> indices(faces, faces + 36);
+
+  purrMesh *mesh = new purrMesh();
+  mesh->initialize(context->frCommands, vertices, indices);
+  return mesh;
+}
+
+static SceneResult runScene(PurrfectEngineContext *context, const BenchScene &desc, const BenchOptions &options, purrPipeline *scenePipeline, purrTexture *sceneTarget) {
+  SceneResult result{ desc.name, {} };
+  Metric insert{ "scene.insert", "ns/object", false, {} };
+  Metric lookup{ "scene.lookup", "ns/lookup", false, {} };
+  Metric animate{ "animate", "ms/frame", false, {} };
+  Metric transforms{ "updateTransforms", "ms/frame", false, {} };
+  Metric record{ "renderScene", "ms/frame", false, {} };
+  Metric frameTime{ "frame", "ms/frame", false, {} };
+
+  std::mt19937 rng(options.seed ^ desc.objects ^ (desc.meshes << 20));
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+  std::vector<purrMesh*> meshes{};
+  for (uint32_t i = 0; i < desc.meshes; ++i) meshes.push_back(createBoxMesh(context, 0.05f + 0.05f * (i % 4)));
+
+  purrScene *scene = new purrScene();
+  std::vector<purrObject*> objects{};
+  objects.reserve(desc.objects);
+  float extent = std::cbrt(static_cast<float>(desc.objects)) * 0.5f;
+
+  // Batches of 1000, the cost per insert grows with the scene so the percentiles show the spread.
+  const uint32_t batchSize = 1000;
+  uint32_t collisions = 0;
+  for (uint32_t first = 0; first < desc.objects; first += batchSize) {
+    uint32_t count = std::min(batchSize, desc.objects - first);
+    std::vector<purrObject*> batch{};
+    for (uint32_t i = 0; i < count; ++i) {
+      purrObject *object = new purrObject(new purrTransform(glm::vec3(unit(rng), unit(rng), unit(rng) + 1.0f) * extent));
+      object->addComponent(new purrMeshComp(meshes[(first + i) % desc.meshes], false));
+      batch.push_back(object);
+    }
+
+    Clock::time_point start = Clock::now();
+    for (purrObject *object: batch) {
+      if (scene->addObject(object)) objects.push_back(object);
+      else { delete object; ++collisions; } // PUIDs are random, a 32-bit collision now and then is expected.
+    }
+    insert.samples.push_back(elapsedNs(start) / count);
+  }
+  if (collisions) printf("[bench]: %s: %u PUID collisions, scene has %zu objects\n", desc.name, collisions, objects.size());
+
+  std::uniform_int_distribution<size_t> pick(0, objects.size() - 1);
+  for (uint32_t i = 0; i < 32; ++i) {
+    std::vector<PUID> keys{};
+    for (uint32_t j = 0; j < 256; ++j) keys.push_back(objects[pick(rng)]->getUuid());
+    Clock::time_point start = Clock::now();
+    size_t found = 0;
+    for (PUID key: keys) found += scene->getObject(key) != nullptr;
+    lookup.samples.push_back(elapsedNs(start) / keys.size());
+    if (found != keys.size()) fprintf(stderr, "[bench]: %s: lookup missed %zu objects!\n", desc.name, keys.size() - found);
+  }
+
+  purrObject *camera = new purrObject(new purrTransform(glm::vec3(0.0f, 0.0f, -extent)));
+  camera->addComponent(new purrCameraComp(new purrCamera()));
+  scene->addObject(camera);
+  scene->setCamera(camera);
+  renderer::setScene(scene);
+
+  std::vector<glm::vec3> velocities{};
+  if (desc.dynamic) for (size_t i = 0; i < objects.size(); ++i) velocities.push_back(glm::vec3(unit(rng), unit(rng), unit(rng)));
+
+  for (uint32_t frame = 0; frame < options.warmup + options.frames; ++frame) {
+    Clock::time_point frameStart = Clock::now();
+    if (!renderer::renderBegin()) continue;
+
+    Clock::time_point start = Clock::now();
+    if (desc.dynamic) {
+      const float dt = 1.0f / 60.0f;
+      for (size_t i = 0; i < objects.size(); ++i) {
+        purrTransform *transform = objects[i]->getTransform();
+        transform->setPosition(transform->getPosition() + velocities[i] * dt);
+      }
+    }
+    double animateNs = elapsedNs(start);
+
+    renderer::updateCamera();
+    start = Clock::now();
+    renderer::updateTransforms();
+    double transformsNs = elapsedNs(start);
+
+    double recordNs = 0.0;
+    purrRenderGraph graph{};
+    purrRenderGraph::Handle target = graph.importTexture("Scene", sceneTarget);
+    graph.addPass("Scene", [&](purrRenderGraph::Builder &builder) {
+      builder.write(target, purrResourceAccess::ColorAttachment, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }, [&](VkCommandBuffer) {
+      scenePipeline->begin({{{0.0f, 0.0f, 0.0f, 1.0f}}});
+      Clock::time_point recordStart = Clock::now();
+      renderer::renderScene(scenePipeline);
+      recordNs = elapsedNs(recordStart);
+      scenePipeline->end();
+    });
+    graph.addPass("Composite", [&](purrRenderGraph::Builder &builder) {
+      builder.read(target, purrResourceAccess::SampledFragment);
+      builder.sideEffect();
+    }, [&](VkCommandBuffer) {
+      renderer::render();
+    });
+    graph.compile();
+    graph.execute(context->frActiveCmdBuf);
+    renderer::present();
+
+    if (frame < options.warmup) continue;
+    if (desc.dynamic) animate.samples.push_back(animateNs / 1e6);
+    transforms.samples.push_back(transformsNs / 1e6);
+    record.samples.push_back(recordNs / 1e6);
+    frameTime.samples.push_back(elapsedNs(frameStart) / 1e6);
+  }
+  renderer::waitIdle();
+  renderer::setScene(nullptr);
+
+  delete scene;
+  for (purrMesh *mesh: meshes) delete mesh;
+
+  result.metrics.push_back(insert);
+  result.metrics.push_back(lookup);
+  if (desc.dynamic) result.metrics.push_back(animate);
+  result.metrics.push_back(transforms);
+  result.metrics.push_back(record);
+  result.metrics.push_back(frameTime);
+  return result;
+}
+
+// Scene independent costs: importing a model through assimp and pushing vertex data to the GPU.
+static SceneResult runAssets(PurrfectEngineContext *context, const BenchOptions &options) {
+  SceneResult result{ "assets", {} };
+  Metric import{ "loadMesh", "ms/mesh", false, {} };
+  Metric upload{ "upload", "MiB/s", true, {} };
+
+  for (uint32_t i = 0; i < 20; ++i) {
+    purrMesh mesh{};
+    Clock::time_point start = Clock::now();
+    mesh.initialize(options.model);
+    double ns = elapsedNs(start);
+    if (!mesh.isValid()) {
+      fprintf(stderr, "[bench]: Failed to load \"%s\", skipping loadMesh.\n", options.model);
+      break;
+    }
+    import.samples.push_back(ns / 1e6);
+  }
+
+  // 16 MiB of vertices plus indices, staged and copied the same way every mesh upload is.
+  std::mt19937 rng(options.seed);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  std::vector<Vertex3D> vertices(16 * 1024 * 1024 / sizeof(Vertex3D));
+  for (Vertex3D &vertex: vertices) vertex = Vertex3D{ glm::vec3(unit(rng), unit(rng), unit(rng)), glm::vec3(1.0f), glm::vec2(0.0f), glm::vec3(0.0f, 1.0f, 0.0f) };
+  std::vector<uint32_t> indices(vertices.size());
+  for (uint32_t i = 0; i < indices.size(); ++i) indices[i] = i;
+  double bytes = static_cast<double>(vertices.size() * sizeof(Vertex3D) + indices.size() * sizeof(uint32_t));
+
+  for (uint32_t i = 0; i < 10; ++i) {
+    purrMesh mesh{};
+    Clock::time_point start = Clock::now();
+    mesh.initialize(context->frCommands, vertices, indices);
+    double seconds = elapsedNs(start) / 1e9;
+    upload.samples.push_back(bytes / (1024.0 * 1024.0) / seconds);
+  }
+
+  result.metrics.push_back(import);
+  result.metrics.push_back(upload);
+  return result;
+}
+
+// Compares p50 of every metric the baseline has, returns the number of regressions.
+static uint32_t compareBaseline(const json &current, const json &baseline, double tolerance) {
+  uint32_t regressions = 0;
+  printf("\nBaseline comparison (tolerance %.0f%%)\n", tolerance * 100.0);
+  for (auto scene = baseline["results"].begin(); scene != baseline["results"].end(); ++scene) {
+    if (!current["results"].contains(scene.key())) continue;
+    const json &currentScene = current["results"][scene.key()];
+    for (auto metric = scene.value().begin(); metric != scene.value().end(); ++metric) {
+      if (!currentScene.contains(metric.key())) continue;
+      double base = metric.value()["p50"].get<double>();
+      double now = currentScene[metric.key()]["p50"].get<double>();
+      if (base <= 0.0) continue;
+      bool higherIsBetter = metric.value().value("higherIsBetter", false);
+      double change = (now - base) / base;
+      bool regressed = higherIsBetter ? change < -tolerance : change > tolerance;
+      if (regressed) ++regressions;
+      printf("  %-18s %-20s %12.3f -> %12.3f  %+7.1f%%%s\n", scene.key().c_str(), metric.key().c_str(), base, now, change * 100.0, regressed ? "  REGRESSION" : "");
+    }
+  }
+  return regressions;
+}
+
+static bool writeJson(const char *path, const json &data) {
+  FILE *fd = fopen(path, "wb");
+  if (!fd) {
+    fprintf(stderr, "[bench]: Failed to open \"%s\" for writing!\n", path);
+    return false;
+  }
+  std::string text = data.dump(2);
+  fwrite(text.data(), 1, text.size(), fd);
+  fclose(fd);
+  return true;
+}
+
+static bool readJson(const char *path, json *data) {
+  FILE *fd = fopen(path, "rb");
+  if (!fd) {
+    fprintf(stderr, "[bench]: Failed to open \"%s\"!\n", path);
+    return false;
+  }
+  std::string text{};
+  char buffer[4096];
+  size_t read = 0;
+  while ((read = fread(buffer, 1, sizeof(buffer), fd)) > 0) text.append(buffer, read);
+  fclose(fd);
+  *data = json::parse(text, nullptr, false);
+  if (data->is_discarded() || !data->contains("results")) {
+    fprintf(stderr, "[bench]: \"%s\" is not a benchmark result!\n", path);
+    return false;
+  }
+  return true;
+}
+
+static void printUsage() {
+  printf("usage: bench [options]\n"
+         "  --scene <name>          run one scene only\n"
+         "  --list                  list scenes and exit\n"
+         "  --frames <n>            measured frames per scene (120)\n"
+         "  --warmup <n>            unmeasured frames per scene (10)\n"
+         "  --max-objects <n>       skip scenes with more objects (100000)\n"
+         "  --seed <n>              scene generation seed (1337)\n"
+         "  --size <w> <h>          render resolution (1280 720)\n"
+         "  --model <path>          model for loadMesh (../models/ico.obj)\n"
+         "  --json <path>           write results as JSON\n"
+         "  --save-baseline <path>  write results as the new baseline\n"
+         "  --baseline <path>       compare p50s against a baseline, exit 1 on regressions\n"
+         "  --tolerance <fraction>  allowed regression (0.10)\n");
+}
+
+int main(int argc, char **argv) {
+  BenchOptions options{};
+  for (int i = 1; i < argc; ++i) {
+    bool hasValue = i+1 < argc;
+    if (strcmp(argv[i], "--scene") == 0 && hasValue) options.scene = argv[++i];
+    else if (strcmp(argv[i], "--frames") == 0 && hasValue) options.frames = static_cast<uint32_t>(atoi(argv[++i]));
+    else if (strcmp(argv[i], "--warmup") == 0 && hasValue) options.warmup = static_cast<uint32_t>(atoi(argv[++i]));
+    else if (strcmp(argv[i], "--max-objects") == 0 && hasValue) options.maxObjects = static_cast<uint32_t>(atoi(argv[++i]));
+    else if (strcmp(argv[i], "--seed") == 0 && hasValue) options.seed = static_cast<uint32_t>(atoi(argv[++i]));
+    else if (strcmp(argv[i], "--size") == 0 && i+2 < argc) { options.width = atoi(argv[++i]); options.height = atoi(argv[++i]); }
+    else if (strcmp(argv[i], "--model") == 0 && hasValue) options.model = argv[++i];
+    else if (strcmp(argv[i], "--json") == 0 && hasValue) options.jsonPath = argv[++i];
+    else if (strcmp(argv[i], "--save-baseline") == 0 && hasValue) options.saveBaselinePath = argv[++i];
+    else if (strcmp(argv[i], "--baseline") == 0 && hasValue) options.baselinePath = argv[++i];
+    else if (strcmp(argv[i], "--tolerance") == 0 && hasValue) options.tolerance = atof(argv[++i]);
+    else if (strcmp(argv[i], "--list") == 0) {
+      for (const BenchScene &scene: sScenes) printf("%-18s %8u objects %4u meshes\n", scene.name, scene.objects, scene.meshes);
+      return 0;
+    } else {
+      printUsage();
+      return strcmp(argv[i], "--help") == 0 ? 0 : 2;
+    }
+  }
+
+  json baseline{};
+  if (options.baselinePath && !readJson(options.baselinePath, &baseline)) return 2;
+
+  PurrfectEngineContext *context = new PurrfectEngineContext();
+  context->settings.headless = true;
+  // Shader compile time isn't measured here and a warm cache keeps runs comparable.
+  context->settings.pipelineCachePath = "./bench_pipeline_cache.bin";
+
+  std::vector<SceneResult> results{};
+  try {
+  renderer::setContext(context);
+  renderer::initialize("PurrfectEngine - Bench", options.width, options.height);
+
+  purrSampler *sampler = new purrSampler();
+  sampler->initialize(fr::frSampler::frSamplerInfo{});
+  purrTexture *sceneTarget = purrRenderTargetPool::getDefault()->acquire(purrRenderTargetDesc{
+    options.width, options.height, VK_FORMAT_R16G16B16A16_SFLOAT
+  }, sampler);
+  purrPipeline *scenePipeline = new purrPipeline(purrPipelineCreateInfo{
+    options.width, options.height,
+    { {VK_SHADER_STAGE_VERTEX_BIT, "../shaders/vert.spv"}, {VK_SHADER_STAGE_FRAGMENT_BIT, "../shaders/frag.spv"} },
+    sceneTarget
+  });
+  scenePipeline->initialize();
+  renderer::setScenePipeline(scenePipeline);
+
+  results.push_back(runAssets(context, options));
+  printResult(results.back());
+  for (const BenchScene &scene: sScenes) {
+    if (options.scene && strcmp(options.scene, scene.name) != 0) continue;
+    if (scene.objects > options.maxObjects) continue;
+    results.push_back(runScene(context, scene, options, scenePipeline, sceneTarget));
+    printResult(results.back());
+  }
+
+  renderer::waitIdle();
+  purrRenderTargetPool::getDefault()->release(sceneTarget);
+  delete scenePipeline;
+  delete sampler;
+  renderer::cleanup();
+  } catch (fr::frVulkanException &ex) {
+    fprintf(stderr, "Vulkan exception caught: %s\n", ex.what());
+    delete context;
+    return 2;
+  }
+  delete context;
+
+  json output{};
+  output["seed"] = options.seed;
+  output["frames"] = options.frames;
+  output["width"] = options.width;
+  output["height"] = options.height;
+  for (const SceneResult &result: results) {
+    for (const Metric &metric: result.metrics) output["results"][result.scene][metric.name] = metricToJson(metric);
+  }
+
+  if (options.jsonPath) writeJson(options.jsonPath, output);
+  else printf("\n%s\n", output.dump().c_str());
+  if (options.saveBaselinePath) writeJson(options.saveBaselinePath, output);
+
+  if (options.baselinePath && compareBaseline(output, baseline, options.tolerance) > 0) return 1;
+  return 0;
+}
\ No newline at end of file
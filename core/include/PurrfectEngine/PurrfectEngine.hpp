@@ -2,10 +2,16 @@
 #define   PURRENGINE_PURRFECTENGINE_HPP_
 
 #include <fr/fr.hpp>
+#include "PurrfectEngine/clock.hpp"
+#include "PurrfectEngine/workers.hpp"
+#include "PurrfectEngine/mailbox.hpp"
+#include "PurrfectEngine/queue.hpp"
+#include "PurrfectEngine/allocators.hpp"
 #include "PurrfectEngine/transform.hpp"
 #include "PurrfectEngine/camera.hpp"
 #include "PurrfectEngine/scene.hpp"
 #include "PurrfectEngine/assets.hpp"
+#include "PurrfectEngine/loop.hpp"
 namespace PurrfectEngine {
 
   enum class MSAA {
@@ -19,7 +25,19 @@ namespace PurrfectEngine {
   };
 
   struct PurrfectEngineSettings {
+    // Scene pipeline samples (purrPipelineCreateInfo::msaa), resolved before the composite. See renderer::setMsaa.
     MSAA msaa = MSAA::None;
+    // Frames the CPU may record ahead of the GPU, independent of the swapchain image count.
+    // More hides CPU/GPU stalls, fewer lowers input latency.
+    uint32_t framesInFlight = 2;
+    // Serialized VkPipelineCache, nullptr disables it.
+    const char *pipelineCachePath = "./pipeline_cache.bin";
+    // No window, swapchain or surface. Frames are rendered into offscreen targets, see renderer::setReadbackCallback.
+    bool headless = false;
+    // Render the scene pipeline at a scale picked from GPU frame time, see renderer::getDynamicResolution.
+    bool dynamicResolution = false;
+    // Compiled engine shaders (upscale.frag.spv, ...), built by the core_shaders target.
+    const char *shaderPath = "../shaders/";
   };
 
   struct PurrfectEngineContext {
@@ -29,15 +47,14 @@ namespace PurrfectEngine {
     fr::frRenderer                 *frRenderer = nullptr;
     fr::frSwapchain                *frSwapchain = nullptr;
     fr::frRenderPass               *frRenderPass = nullptr;
-    fr::frPipeline                 *frPipeline = nullptr;
     std::vector<fr::frImage*>       frScImages{};
     std::vector<fr::frFramebuffer*> frFbs{};
     fr::frCommands                 *frCommands = nullptr;
-    fr::frDescriptors              *frDescriptors = nullptr;
-    fr::frDescriptors              *frTextureDescriptors = nullptr;
     fr::frDescriptorLayout         *frTextureLayout = nullptr;
     fr::frDescriptorLayout         *frUboLayout = nullptr;
     fr::frDescriptorLayout         *frStorageBufLayout = nullptr;
+    fr::frDescriptorLayout         *frLightsLayout = nullptr;
+    fr::frDescriptorLayout         *frDrawDataLayout = nullptr;
     VkCommandBuffer                 frActiveCmdBuf = VK_NULL_HANDLE;
     VkFormat                        frDepthFormat = VK_FORMAT_UNDEFINED;
 
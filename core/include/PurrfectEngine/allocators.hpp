@@ -0,0 +1,160 @@
+#ifndef   PURRENGINE_ALLOCATORS_HPP_
+#define   PURRENGINE_ALLOCATORS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace PurrfectEngine {
+
+  struct purrPoolStats {
+    uint32_t live = 0;      // Slots handed out.
+    uint32_t capacity = 0;  // Slots in all chunks.
+    uint32_t chunks = 0;
+    uint32_t heapAllocations = 0; // Too large for a pool, passed on to operator new (purrObjectPools only).
+  };
+
+  // Slots of one size carved out of chunks. Freed slots go on a free list that's handed out first, chunks are only
+  // returned when the pool is destroyed, so a long session reuses the same memory instead of fragmenting the heap.
+  // Not thread safe.
+  class purrFixedPool {
+  public:
+    purrFixedPool(size_t slotSize, size_t slotAlign = alignof(std::max_align_t), uint32_t slotsPerChunk = 256);
+    ~purrFixedPool();
+
+    purrFixedPool(const purrFixedPool&) = delete;
+    purrFixedPool &operator=(const purrFixedPool&) = delete;
+
+    void *allocate();
+    void free(void *ptr);
+
+    size_t getSlotSize() const { return mSlotSize; }
+    purrPoolStats getStats() const { return mStats; }
+  private:
+    struct FreeSlot {
+      FreeSlot *next;
+    };
+
+    void grow();
+  private:
+    size_t mSlotSize = 0;
+    size_t mSlotAlign = 0;
+    uint32_t mSlotsPerChunk = 0;
+    std::vector<void*> mChunks{};
+    FreeSlot *mFree = nullptr;
+    purrPoolStats mStats{};
+  };
+
+  // Typed purrFixedPool, create() constructs in a free slot and destroy() destructs and frees it.
+  template<typename T>
+  class purrPool {
+  public:
+    purrPool(uint32_t slotsPerChunk = 256):
+      mPool(sizeof(T), alignof(T), slotsPerChunk)
+    {}
+
+    template<typename... Args>
+    T *create(Args&&... args) {
+      return new (mPool.allocate()) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T *object) {
+      if (!object) return;
+      object->~T();
+      mPool.free(object);
+    }
+
+    purrPoolStats getStats() const { return mPool.getStats(); }
+  private:
+    purrFixedPool mPool;
+  };
+
+  // Size class pools (multiples of 16 bytes up to 512) behind operator new/delete of the scene types, see
+  // PURR_POOLED. Thread safe, the pools live until the process exits so objects may be deleted at any point.
+  namespace purrObjectPools {
+    void *allocate(size_t size);
+    void free(void *ptr, size_t size);
+    // Summed over the size classes.
+    purrPoolStats getStats();
+  }
+
+  // Class scope operator new/delete from purrObjectPools, `new purrObject(...)` and `delete object` stay as they are.
+  // Deleting through a base pointer needs a virtual destructor, so the sized delete gets the derived size.
+  #define PURR_POOLED \
+    static void *operator new(size_t size) { return ::PurrfectEngine::purrObjectPools::allocate(size); } \
+    static void operator delete(void *ptr, size_t size) { ::PurrfectEngine::purrObjectPools::free(ptr, size); }
+
+  struct purrArenaStats {
+    size_t used = 0;      // Since the last reset.
+    size_t peak = 0;      // Most a frame used.
+    size_t capacity = 0;
+    uint32_t blocks = 0;
+  };
+
+  // Bump allocator for data that lives for one frame, freed all at once by reset(). A frame that didn't fit the
+  // block makes reset() replace the blocks with a single one large enough, so after the first frames nothing is
+  // allocated from the heap. Not thread safe.
+  class purrFrameArena {
+  public:
+    purrFrameArena(size_t blockSize = 256 * 1024);
+    ~purrFrameArena();
+
+    purrFrameArena(const purrFrameArena&) = delete;
+    purrFrameArena &operator=(const purrFrameArena&) = delete;
+
+    void *allocate(size_t size, size_t align = alignof(std::max_align_t));
+    // Everything allocated since the last reset is invalid afterwards.
+    void reset();
+
+    purrArenaStats getStats() const;
+  private:
+    struct Block {
+      uint8_t *data;
+      size_t size;
+    };
+
+    void addBlock(size_t minSize);
+  private:
+    size_t mBlockSize = 0;
+    std::vector<Block> mBlocks{};
+    uint32_t mBlock = 0;   // Block being bumped.
+    size_t mOffset = 0;
+    size_t mUsed = 0;
+    size_t mPeak = 0;
+  };
+
+  // Standard allocator on a purrFrameArena, deallocate does nothing. Containers using it must not outlive the frame.
+  template<typename T>
+  class purrArenaAllocator {
+  public:
+    using value_type = T;
+
+    purrArenaAllocator(purrFrameArena *arena):
+      mArena(arena)
+    {}
+    template<typename U>
+    purrArenaAllocator(const purrArenaAllocator<U> &other):
+      mArena(other.getArena())
+    {}
+
+    T *allocate(size_t count) { return static_cast<T*>(mArena->allocate(sizeof(T) * count, alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    purrFrameArena *getArena() const { return mArena; }
+
+    template<typename U>
+    bool operator==(const purrArenaAllocator<U> &other) const { return mArena == other.getArena(); }
+    template<typename U>
+    bool operator!=(const purrArenaAllocator<U> &other) const { return mArena != other.getArena(); }
+  private:
+    purrFrameArena *mArena = nullptr;
+  };
+
+  template<typename T>
+  using purrFrameVector = std::vector<T, purrArenaAllocator<T>>;
+
+}
+
+#endif // PURRENGINE_ALLOCATORS_HPP_
\ No newline at end of file
@@ -5,6 +5,7 @@ namespace PurrfectEngine {
 
   class purrCamera {
   public:
+    PURR_POOLED
     struct Settings {
       float fov = 90.0f;
       float aspectRatio = 16.0f/9.0f; // if (aspectRatio == 0) { aspectRatio = (float)(width/height); }
@@ -16,9 +17,12 @@ namespace PurrfectEngine {
     ~purrCamera();
 
     void setSettings(Settings settings) { mSettings = settings; }
+    Settings getSettings() const { return mSettings; }
 
     glm::mat4 getProjection();
     glm::mat4 getView();
+    // View of the camera's transform interpolated between its last two simulation states, see purrTransform::getInterpolated.
+    glm::mat4 getInterpolatedView(float alpha);
 
     void setTransform(purrTransform *trans) { mTransform = trans; }
     purrTransform *getTransform() const { return mTransform; }
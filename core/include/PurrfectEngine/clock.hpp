@@ -0,0 +1,54 @@
+#ifndef   PURRENGINE_CLOCK_HPP_
+#define   PURRENGINE_CLOCK_HPP_
+
+namespace PurrfectEngine {
+
+  // Time source for pacing and timing code, so it can be driven by a purrManualClock instead of real time.
+  class purrClock {
+  public:
+    virtual ~purrClock() = default;
+
+    // Monotonic, in nanoseconds.
+    virtual uint64_t now() = 0;
+    // Returns once now() >= ns.
+    virtual void sleepUntil(uint64_t ns) = 0;
+
+    // steady_clock based, shared by everything that isn't given a clock of its own.
+    static purrClock *getDefault();
+
+    static void cleanupAll();
+  };
+
+  // steady_clock. OS sleeps overshoot by up to a scheduler tick, so the last `spinNs` are spent yielding instead.
+  class purrSystemClock : public purrClock {
+  public:
+    purrSystemClock(uint64_t spinNs = 1500000);
+
+    virtual uint64_t now() override;
+    virtual void sleepUntil(uint64_t ns) override;
+  private:
+    uint64_t mSpinNs = 0;
+  };
+
+  // Only moves when told to. sleepUntil jumps straight to the wake up time.
+  class purrManualClock : public purrClock {
+  public:
+    purrManualClock(uint64_t start = 0):
+      mNow(start)
+    {}
+
+    virtual uint64_t now() override { return mNow; }
+    virtual void sleepUntil(uint64_t ns) override { if (ns > mNow) { mSleptNs += ns - mNow; mNow = ns; } }
+
+    void advance(uint64_t ns) { mNow += ns; }
+    void set(uint64_t ns) { mNow = ns; }
+    // Total time skipped by sleepUntil.
+    uint64_t getSleptNs() const { return mSleptNs; }
+  private:
+    uint64_t mNow = 0;
+    uint64_t mSleptNs = 0;
+  };
+
+}
+
+#endif // PURRENGINE_CLOCK_HPP_
\ No newline at end of file
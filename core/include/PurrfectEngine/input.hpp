@@ -1,6 +1,9 @@
 #ifndef   PURRENGINE_INPUT_HPP_
 #define   PURRENGINE_INPUT_HPP_
 
+#include <bitset>
+#include <memory>
+
 namespace PurrfectEngine {
 
   namespace Input {
@@ -163,8 +166,68 @@ namespace PurrfectEngine {
     };
     }
 
+    constexpr uint32_t KeyCount = key::Menu + 1;
+    constexpr uint32_t MouseButtonCount = mouse::ButtonLast + 1;
+
+    enum class EventType : uint8_t {
+      KeyPressed,
+      KeyReleased,
+      MousePressed,
+      MouseReleased,
+      MouseMoved,    // value is the new cursor position.
+      MouseScrolled, // value is the scroll offset.
+    };
+
+    struct Event {
+      EventType type;
+      KeyCode code;    // Key or mouse button.
+      int32_t mods;    // GLFW_MOD_* bits.
+      glm::vec2 value;
+      uint64_t time;   // purrClock::getDefault() time the callback ran at.
+    };
+
+    // Input of one frame, built by Update() and never changed afterwards, so any thread may read it.
+    struct Snapshot {
+      uint64_t frame = 0;
+      uint64_t startTime = 0;   // Update() time of the previous snapshot, events are in (startTime, time].
+      uint64_t time = 0;
+      std::bitset<KeyCount> keysDown{};         // At `time`.
+      std::bitset<KeyCount> keysPressed{};      // Went down during the frame, even if released again.
+      std::bitset<KeyCount> keysReleased{};
+      std::bitset<KeyCount> keysDownAtStart{};
+      std::bitset<MouseButtonCount> buttonsDown{};
+      std::bitset<MouseButtonCount> buttonsPressed{};
+      std::bitset<MouseButtonCount> buttonsReleased{};
+      std::bitset<MouseButtonCount> buttonsDownAtStart{};
+      glm::vec2 mousePos{0.0f};
+      glm::vec2 mouseDelta{0.0f};
+      glm::vec2 scroll{0.0f};
+      std::vector<Event> events{}; // In the order they happened.
+
+      bool IsKeyDown(KeyCode key) const { return key < KeyCount && keysDown[key]; }
+      bool WasKeyPressed(KeyCode key) const { return key < KeyCount && keysPressed[key]; }
+      bool WasKeyReleased(KeyCode key) const { return key < KeyCount && keysReleased[key]; }
+      bool IsMouseDown(MouseCode btn) const { return btn < MouseButtonCount && buttonsDown[btn]; }
+      bool WasMousePressed(MouseCode btn) const { return btn < MouseButtonCount && buttonsPressed[btn]; }
+      bool WasMouseReleased(MouseCode btn) const { return btn < MouseButtonCount && buttonsReleased[btn]; }
+      // State at a time within the frame, replayed from the events. Fixed steps ask for their own time
+      // (purrMainLoop::getTickTime) instead of the frame's, so presses land on the tick they happened in.
+      bool IsKeyDownAt(KeyCode key, uint64_t time) const;
+      bool IsMouseDownAt(MouseCode btn, uint64_t time) const;
+    };
+
     void setContext(PurrfectEngineContext *context);
 
+    // Takes the events the GLFW callbacks queued since the last call and publishes them as the new snapshot.
+    // Call on the thread that polls events, right after glfwPollEvents. The callbacks are installed by the first
+    // call once the window exists, callbacks that were set before keep being called.
+    void Update();
+    // The last Update()'s snapshot, any thread. Holding on to it keeps it alive.
+    std::shared_ptr<const Snapshot> GetSnapshot();
+    // Events that didn't fit the queue because Update() wasn't called for too long.
+    uint64_t GetDroppedEvents();
+
+    // Read the current snapshot, so they only change with Update().
     bool      IsKeyDown(KeyCode key);
     bool      IsKeyUp(KeyCode key);
     bool      IsMouseDown(MouseCode btn);
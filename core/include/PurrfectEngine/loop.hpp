@@ -0,0 +1,72 @@
+#ifndef   PURRENGINE_LOOP_HPP_
+#define   PURRENGINE_LOOP_HPP_
+
+#include <functional>
+
+namespace PurrfectEngine {
+
+  struct purrMainLoopSettings {
+    double tickRate = 60.0;          // Simulation steps per second.
+    // Steps a single frame may run. A larger backlog (a slow frame) is caught up over the next frames instead of
+    // all at once, so one hitch doesn't turn into a long frame that falls behind again.
+    uint32_t maxStepsPerFrame = 4;
+    // Spiral of death guard: once the simulation is behind by more steps than this, the excess is dropped
+    // and the game slows down instead of never catching up.
+    uint32_t maxBacklogSteps = 16;
+    double maxFrameSeconds = 0.25;   // Longer frames (breakpoints, window drags) count as this long.
+  };
+
+  struct purrMainLoopStats {
+    uint64_t ticks = 0;
+    uint64_t frames = 0;
+    uint32_t lastSteps = 0;          // Of the last frame.
+    uint32_t maxSteps = 0;           // Most steps a frame ran.
+    uint32_t backlog = 0;            // Due steps left for the next frames.
+    uint64_t droppedSteps = 0;       // Thrown away by the backlog guard.
+    float alpha = 1.0f;
+  };
+
+  // Fixed timestep main loop. Real time from the clock is accumulated and spent in steps of exactly 1 / tickRate,
+  // so the simulation is deterministic no matter the frame rate. Before each step the scene's transforms are saved
+  // (purrTransform::savePrevious), and the frame is rendered the leftover fraction of a step between the last
+  // two states (renderer::setInterpolation), so movement stays smooth at a low tick rate on a fast display.
+  class purrMainLoop {
+  public:
+    using TickCallback = std::function<void(double dt)>;
+    // Return false to leave run().
+    using FrameCallback = std::function<bool(float alpha, double frameSeconds)>;
+
+    purrMainLoop(purrMainLoopSettings settings = {}, purrClock *clock = nullptr);
+
+    // Runs the steps that are due since the last call and sets the renderer's interpolation, returns it.
+    // The first call only starts the clock.
+    float advance(purrScene *scene, const TickCallback &tick);
+    // advance() and frame() until frame returns false or renderer::shouldClose().
+    void run(purrScene *scene, const TickCallback &tick, const FrameCallback &frame);
+    // Forgets the accumulated time, e.g. after loading.
+    void reset();
+
+    double getTickSeconds() const { return static_cast<double>(mTickNs) * 1e-9; }
+    // Simulation time is getTick() * getTickSeconds().
+    uint64_t getTick() const { return mStats.ticks; }
+    double getFrameSeconds() const { return static_cast<double>(mFrameNs) * 1e-9; }
+    // Clock time the running tick simulates up to, what it should sample input at (Input::Snapshot::IsKeyDownAt).
+    // Ticks that catch up a backlog are at their own times in the past, not all at the frame's.
+    uint64_t getTickTime() const { return mTickTimeNs; }
+    purrMainLoopSettings getSettings() const { return mSettings; }
+    purrMainLoopStats getStats() const { return mStats; }
+  private:
+    purrMainLoopSettings mSettings{};
+    purrClock *mClock = nullptr;
+    uint64_t mTickNs = 0;
+    uint64_t mLastNs = 0;
+    uint64_t mFrameNs = 0;
+    uint64_t mAccumulatorNs = 0;
+    uint64_t mTickTimeNs = 0;
+    bool mStarted = false;
+    purrMainLoopStats mStats{};
+  };
+
+}
+
+#endif // PURRENGINE_LOOP_HPP_
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef   PURRENGINE_MAILBOX_HPP_
+#define   PURRENGINE_MAILBOX_HPP_
+
+#include <atomic>
+
+namespace PurrfectEngine {
+
+  // Hands the newest value from one writer thread to one reader thread without locks or copies. Of the three slots
+  // the writer fills one, the reader holds one and the third is the last published value, so neither side ever
+  // waits for the other. A published value the reader didn't take is replaced by the next one.
+  template<typename T>
+  class purrMailbox {
+  public:
+    // Writer only, the slot stays the writer's until publish(). It holds whatever was written to it three
+    // publishes ago, so storage can be reused.
+    T &getWriteSlot() { return mSlots[mWrite]; }
+    // Returns true when it replaced a value the reader never took.
+    bool publish() {
+      uint32_t previous = mMiddle.exchange(mWrite | FRESH_BIT, std::memory_order_acq_rel);
+      mWrite = previous & INDEX_MASK;
+      return (previous & FRESH_BIT) != 0;
+    }
+
+    // Reader only, takes the newest published value if there's one the reader hasn't seen.
+    bool acquire() {
+      if (!hasNew()) return false;
+      mRead = mMiddle.exchange(mRead, std::memory_order_acq_rel) & INDEX_MASK;
+      return true;
+    }
+    // Reader only, the value of the last successful acquire().
+    const T &getReadSlot() const { return mSlots[mRead]; }
+    bool hasNew() const { return (mMiddle.load(std::memory_order_acquire) & FRESH_BIT) != 0; }
+  private:
+    static constexpr uint32_t INDEX_MASK = 3;
+    static constexpr uint32_t FRESH_BIT = 4;
+
+    T mSlots[3]{};
+    uint32_t mWrite = 0;
+    uint32_t mRead = 1;
+    std::atomic<uint32_t> mMiddle{2}; // Slot index, FRESH_BIT while the reader hasn't taken it.
+  };
+
+}
+
+#endif // PURRENGINE_MAILBOX_HPP_
\ No newline at end of file
@@ -27,8 +27,10 @@ namespace PurrfectEngine {
     uint32_t mId = 0;
   };
 
+  // Components, objects, transforms, cameras and meshes come from purrObjectPools (PURR_POOLED).
   class purrComponent {
   public:
+    PURR_POOLED
     purrComponent();
     virtual ~purrComponent() = default;
 
@@ -39,7 +41,8 @@ namespace PurrfectEngine {
   class purrMesh;
   class purrMeshComp : public purrComponent {
   public:
-    purrMeshComp(purrMesh *mesh);
+    // Shared meshes (one mesh drawn by many objects) are passed with ownsMesh = false and outlive the component.
+    purrMeshComp(purrMesh *mesh, bool ownsMesh = true);
     // purrMeshComp(purrMesh2D *mesh);
     purrMeshComp(bool is2D, const char *filename);
     virtual ~purrMeshComp() override;
@@ -49,6 +52,7 @@ namespace PurrfectEngine {
     purrMesh *getMesh() const { return mMesh; }
   private:
     bool is2D = false;
+    bool mOwnsMesh = true;
     purrMesh *mMesh = nullptr;
     // purrMesh2D *mMesh2D = nullptr;
   };
@@ -65,9 +69,50 @@ namespace PurrfectEngine {
     purrCamera *mCamera = nullptr;
   };
 
+  // Point light at the owning object's position, gathered by renderer::updateLights.
+  class purrLightComp : public purrComponent {
+  public:
+    purrLightComp(glm::vec3 color = glm::vec3(1.0f), float intensity = 1.0f, float radius = 10.0f);
+    virtual ~purrLightComp() override;
+
+    virtual const char *getName() override { return "lightComponent"; }
+
+    void setColor(glm::vec3 color) { mColor = color; }
+    glm::vec3 getColor() const { return mColor; }
+    void setIntensity(float intensity) { mIntensity = intensity; }
+    float getIntensity() const { return mIntensity; }
+    // Distance at which the light's contribution reaches zero, smaller radii mean fewer clusters per light.
+    void setRadius(float radius) { mRadius = radius; }
+    float getRadius() const { return mRadius; }
+  private:
+    glm::vec3 mColor{1.0f};
+    float mIntensity = 1.0f;
+    float mRadius = 10.0f;
+  };
+
+  // Simplified, model space geometry the CPU occlusion culler rasterizes to hide what's behind the object
+  // (see purrOcclusionCuller). Should lie inside the rendered mesh, e.g. a box fitted to a building's walls.
+  class purrOccluderComp : public purrComponent {
+  public:
+    purrOccluderComp(std::vector<glm::vec3> positions, std::vector<uint32_t> indices);
+    virtual ~purrOccluderComp() override;
+
+    virtual const char *getName() override { return "occluderComponent"; }
+
+    const std::vector<glm::vec3> &getPositions() const { return mPositions; }
+    const std::vector<uint32_t> &getIndices() const { return mIndices; }
+
+    static purrOccluderComp *box(glm::vec3 min, glm::vec3 max);
+  private:
+    std::vector<glm::vec3> mPositions{};
+    std::vector<uint32_t> mIndices{};
+  };
+
   class purrObject {
   public:
-    purrObject(purrTransform *transform = new purrTransform());
+    PURR_POOLED
+    // Takes ownership of the transform, nullptr creates an identity one.
+    purrObject(purrTransform *transform = nullptr);
     ~purrObject();
 
     bool addComponent(purrComponent* component);
@@ -78,10 +123,15 @@ namespace PurrfectEngine {
     purrTransform *getTransform() const { return mTransform; }
     // void setTransform(purrTransform *trans) { mTransform = trans; }
 
+    // Static objects are expected not to move, systems may cache work for them (e.g. purrCascadedShadows).
+    void setStatic(bool isStatic) { mStatic = isStatic; }
+    bool isStatic() const { return mStatic; }
+
     PUID getUuid() const { return mUuid; }
   private:
     PUID mUuid{};
-    purrTransform *mTransform = new purrTransform();
+    purrTransform *mTransform = nullptr;
+    bool mStatic = false;
 
     std::vector<const char *> mCompNames{};
     std::vector<purrComponent*> mComponents{};
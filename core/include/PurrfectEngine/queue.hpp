@@ -0,0 +1,44 @@
+#ifndef   PURRENGINE_QUEUE_HPP_
+#define   PURRENGINE_QUEUE_HPP_
+
+#include <atomic>
+#include <cstdint>
+
+namespace PurrfectEngine {
+
+  // Fixed size FIFO between one producer thread and one consumer thread, without locks. push() fails when it's full
+  // instead of growing, so the producer never allocates or waits (it can be a callback inside glfwPollEvents).
+  template<typename T, uint32_t Capacity>
+  class purrSpscQueue {
+    static_assert(Capacity && (Capacity & (Capacity - 1)) == 0, "purrSpscQueue capacity must be a power of two");
+  public:
+    // Producer only.
+    bool push(const T &value) {
+      uint32_t head = mHead.load(std::memory_order_relaxed);
+      if (head - mTail.load(std::memory_order_acquire) == Capacity) return false;
+      mItems[head & (Capacity - 1)] = value;
+      mHead.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+    // Consumer only.
+    bool pop(T *value) {
+      uint32_t tail = mTail.load(std::memory_order_relaxed);
+      if (tail == mHead.load(std::memory_order_acquire)) return false;
+      *value = mItems[tail & (Capacity - 1)];
+      mTail.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+    // Only a hint while the other side is running.
+    uint32_t size() const { return mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_acquire); }
+  private:
+    T mItems[Capacity]{};
+    // On separate cache lines, producer and consumer each write one of them.
+    alignas(64) std::atomic<uint32_t> mHead{0};
+    alignas(64) std::atomic<uint32_t> mTail{0};
+  };
+
+}
+
+#endif // PURRENGINE_QUEUE_HPP_
\ No newline at end of file
@@ -6,6 +6,11 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <fr/fr.hpp>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
 
 namespace PurrfectEngine {
 
@@ -79,38 +84,147 @@ namespace PurrfectEngine {
   };
 
   class purrPipeline;
+  class purrDynamicResolution;
+  class purrFramePacer;
+  class purrLightClusters;
+  class purrCascadedShadows;
+  class purrOcclusionCuller;
+  class purrDrawList;
+  class purrPostProcess;
+  class purrObject;
+  class purrRingBuffer;
+  struct purrRingAllocation;
+  struct purrDirectionalLight;
+  struct purrRenderSnapshot;
+  struct purrRenderCamera;
   namespace renderer {
+    // Tightly packed RGBA8 pixels, only valid during the call.
+    using ReadbackCallback = std::function<void(const uint8_t *pixels, int width, int height, uint64_t frame)>;
+    // Writes an object's per-draw data, `data` has the pipeline's purrPipelineCreateInfo::drawDataSize bytes (zeroed).
+    // Called by extractSnapshot, on the thread that owns the scene.
+    using DrawDataCallback = std::function<void(purrObject *object, uint32_t objectIndex, void *data)>;
+
     void setContext(PurrfectEngineContext *context);
     void setScene(purrScene *scene);
 
+    // FIFO when enabled, immediate otherwise.
     void setVSync(bool enabled);
+    // Falls back to what the surface supports (see Utils::choosePresentMode), the swapchain is only
+    // recreated when that changes the mode it has. getPresentMode() returns the mode in use.
+    // Needs an fr that has frSwapchain::setPresentMode, without it fr's default mode is kept and a warning printed.
+    void setPresentMode(VkPresentModeKHR mode);
+    VkPresentModeKHR getPresentMode();
+    // Frame limiter, its framePresented() is called by present(). The application calls waitForFrame()
+    // right before sampling input, after renderBegin() so the fence and acquire waits don't age the input.
+    purrFramePacer *getFramePacer();
     void initialize(std::string title, int width, int height);
 
     void getSwapchainSize(int *width, int *height);
     void setScenePipeline(purrPipeline *scenePipeline);
+    // Switches the scene pipeline to another sample count (see purrPipeline::setSampleCount), waits for the GPU first.
+    // Call between frames or before the scene pass, the swapchain pass is always single sample.
+    void setMsaa(MSAA msaa);
     void updateCamera();
     void updateTransforms();
+    // Bins the snapshot's lights (every purrLightComp of the scene) into the camera's froxel grid and uploads
+    // lights, clusters and index lists for this frame. Call after updateCamera, pipelines created with
+    // purrPipelineCreateInfo::lighting read them in the fragment shader.
+    void updateLights();
+    void setDirectionalLight(const purrDirectionalLight &light);
+    // Cascades and shadow map the lighting pipelines sample for the directional light, nullptr disables shadows.
+    // The shadows aren't owned, update() and render() them every frame before updateLights and the scene pass.
+    void setShadows(purrCascadedShadows *shadows);
+    // renderScene skips the objects the culler didn't find visible, nullptr draws everything.
+    // Not owned, the application calls its update() (and build() in GPU mode) every frame.
+    void setOcclusionCuller(purrOcclusionCuller *culler);
+    // How far the rendered frame is between the last two simulation states (see purrMainLoop), 1 draws the
+    // current transforms. extractSnapshot interpolates the transforms, camera and lights by it.
+    void setInterpolation(float alpha);
+    float getInterpolation();
+    // Copies what a frame reads from the scene (camera, interpolated transforms, meshes, lights and per-draw data)
+    // into `snapshot`, reusing its storage. Call it where the scene is changed, see purrRenderThread.
+    void extractSnapshot(purrScene *scene, purrRenderSnapshot *snapshot);
+    // The renderer and its passes read the bound snapshot instead of the scene. Without one (nullptr) the active
+    // scene is extracted the first time a frame asks for it, after the simulation for that frame ran.
+    void setSnapshot(const purrRenderSnapshot *snapshot);
+    const purrRenderSnapshot *getSnapshot();
+    // Exposure, bloom, tonemapping and grading for the scene pipeline's HDR target, nullptr composites it as is.
+    // Not owned and has to be initialized, render() records its build() before the composite.
+    void setPostProcess(purrPostProcess *post);
 
     bool shouldClose();
     bool renderBegin();
-    void bindCamera(fr::frPipeline *pipeline);
-    void bindTransforms(fr::frPipeline *pipeline);
+    void bindCamera(VkPipelineLayout layout);
+    void bindTransforms(VkPipelineLayout layout);
+    void bindLights(VkPipelineLayout layout);
+    // This frame's ring for per-draw data, reset when the frame begins. Allocations are bound with bindDrawData,
+    // renderScene fills and binds them itself for pipelines with purrPipelineCreateInfo::drawDataSize.
+    purrRingBuffer *getDrawData();
+    void bindDrawData(VkPipelineLayout layout, uint32_t set, const purrRingAllocation &allocation);
+    void setDrawDataCallback(DrawDataCallback callback);
+    // Fills the draw list with the scene's visible mesh objects (pre-pass items too when the pipeline has one)
+    // and sorts it. renderScene calls it when the list wasn't built this frame, call it earlier to use the list
+    // before the scene pass.
+    void buildDrawList(purrPipeline *pipeline);
+    purrDrawList *getDrawList();
+    // Memory for data that doesn't outlive the frame being recorded (purrFrameVector), reset by renderBegin.
+    // Belongs to the thread that records frames.
+    purrFrameArena *getFrameArena();
+    // Draws the draw list in sorted order, the pre-pass range first if the pipeline bound its pre-pass variant.
     void renderScene(purrPipeline *pipeline);
     void render();
     bool present();
-    
+    // Index of the per-frame resource set that is being recorded, in [0, getFramesInFlight()).
+    uint32_t getFrameIndex();
+    uint32_t getFramesInFlight();
+
+    // Only active with PurrfectEngineSettings::dynamicResolution. Scales the scene pipeline's viewport
+    // each frame to keep GPU time on budget, the composite upscales it back. Call initialize() to tune it.
+    purrDynamicResolution *getDynamicResolution();
+    // Froxel grid of the last updateLights(), getStats() has the per-frame light and cluster counts.
+    purrLightClusters *getLightClusters();
+
+    // Headless only. Every presented frame is copied to host memory and handed to the callback
+    // once its fence signals (a few frames later), flushReadbacks() waits for the remaining ones.
+    void setReadbackCallback(ReadbackCallback callback);
+    void flushReadbacks();
+
     void waitIdle();
     void cleanup();
   }
 
   namespace Utils {
     size_t formatToChannels(VkFormat format);
+    VkImageAspectFlags formatToAspect(VkFormat format);
+    // Returns false if no memory type in typeBits has all of the requested properties.
+    bool findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties, uint32_t *index);
+    uint64_t hash64(const void *data, size_t size, uint64_t seed = 0xcbf29ce484222325ULL);
+    VkPresentModeKHR choosePresentMode(VkPresentModeKHR requested, const std::vector<VkPresentModeKHR> &supported);
+    // Makes compute shader writes visible to the next dispatch's reads and writes.
+    void computeBarrier(VkCommandBuffer cmdBuf);
   }
 
 }
 
+#include "PurrfectEngine/renderer/allocator.hpp"
+#include "PurrfectEngine/renderer/buffer.hpp"
+#include "PurrfectEngine/renderer/descriptors.hpp"
+#include "PurrfectEngine/renderer/ringBuffer.hpp"
 #include "PurrfectEngine/renderer/texture.hpp"
+#include "PurrfectEngine/renderer/targetPool.hpp"
 #include "PurrfectEngine/renderer/mesh.hpp"
+#include "PurrfectEngine/renderer/pipelineCache.hpp"
 #include "PurrfectEngine/renderer/pipeline.hpp"
+#include "PurrfectEngine/renderer/renderGraph.hpp"
+#include "PurrfectEngine/renderer/profiler.hpp"
+#include "PurrfectEngine/renderer/dynamicResolution.hpp"
+#include "PurrfectEngine/renderer/framePacer.hpp"
+#include "PurrfectEngine/renderer/lighting.hpp"
+#include "PurrfectEngine/renderer/shadows.hpp"
+#include "PurrfectEngine/renderer/occlusion.hpp"
+#include "PurrfectEngine/renderer/drawList.hpp"
+#include "PurrfectEngine/renderer/postProcess.hpp"
+#include "PurrfectEngine/renderer/particles.hpp"
+#include "PurrfectEngine/renderer/renderThread.hpp"
 
 #endif // PURRENGINE_RENDERER_HPP_
\ No newline at end of file
@@ -0,0 +1,151 @@
+#ifndef   PURRENGINE_RENDERER_ALLOCATOR_HPP_
+#define   PURRENGINE_RENDERER_ALLOCATOR_HPP_
+
+namespace PurrfectEngine {
+
+  enum class purrMemoryCategory : uint32_t {
+    Mesh,
+    Texture,
+    Target,  // Render targets, see purrRenderTargetPool.
+    Staging, // Upload buffers that live until their copy is done.
+    Frame,   // Per-frame data the CPU writes (camera, transforms, lights, readbacks).
+    Count
+  };
+
+  enum class purrAllocStrategy {
+    Default, // Picked by category: Staging is Linear, Target is Buddy, everything else Tlsf.
+    Linear,  // Bump allocation, the block is reset once everything in it was freed. For short-lived allocations.
+    Buddy,   // Power of two splits, fast and without external fragmentation for similarly sized resources.
+    Tlsf,    // Two-level segregated fit, O(1) allocate and free with little waste for arbitrary sizes.
+  };
+
+  struct purrAllocationInfo {
+    VkMemoryRequirements requirements{};
+    VkMemoryPropertyFlags required = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    VkMemoryPropertyFlags preferred = 0; // Tried together with required first, e.g. LAZILY_ALLOCATED or HOST_CACHED.
+    purrMemoryCategory category = purrMemoryCategory::Mesh;
+    // Optimal tiling images get blocks of their own, buffers and images never share one (bufferImageGranularity).
+    bool image = false;
+    bool dedicated = false; // A VkDeviceMemory of its own regardless of the size.
+    purrAllocStrategy strategy = purrAllocStrategy::Default;
+  };
+
+  struct purrAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void *mapped = nullptr; // Persistently mapped when the memory type is host visible.
+    uint32_t memoryType = 0;
+    purrMemoryCategory category = purrMemoryCategory::Mesh;
+
+    void *block = nullptr; // nullptr for dedicated allocations.
+    uint64_t handle = 0;   // Strategy specific, identifies the allocation inside its block.
+
+    bool isValid() const { return memory != VK_NULL_HANDLE; }
+  };
+
+  struct purrMemoryCategoryStats {
+    uint32_t allocations = 0;
+    VkDeviceSize bytes = 0;
+  };
+
+  struct purrMemoryHeapStats {
+    VkDeviceSize size = 0;
+    VkDeviceSize allocated = 0; // Device memory allocated by purrGpuAllocator on this heap.
+    // Whole process usage and what the driver suggests staying below, from VK_EXT_memory_budget.
+    // Without the extension usage is `allocated` and budget the heap size.
+    VkDeviceSize usage = 0;
+    VkDeviceSize budget = 0;
+  };
+
+  struct purrGpuMemoryStats {
+    purrMemoryCategoryStats categories[static_cast<uint32_t>(purrMemoryCategory::Count)]{};
+    uint32_t blockCount = 0;
+    VkDeviceSize blockBytes = 0;
+    VkDeviceSize blockUsedBytes = 0;    // Suballocated from the blocks, the rest is free or lost to alignment.
+    uint32_t dedicatedCount = 0;
+    VkDeviceSize dedicatedBytes = 0;
+    uint32_t deviceAllocations = 0;     // Live vkAllocateMemory allocations.
+    uint32_t maxDeviceAllocations = 0;  // maxMemoryAllocationCount of the device.
+    bool budgetExtension = false;
+    std::vector<purrMemoryHeapStats> heaps{};
+  };
+
+  struct purrGpuAllocatorSettings {
+    VkDeviceSize deviceBlockSize = 64ull << 20; // Powers of two, the buddy strategy needs them.
+    VkDeviceSize hostBlockSize = 16ull << 20;
+    // Resources at least this big get a dedicated allocation, 0 is half the block size.
+    VkDeviceSize dedicatedThreshold = 0;
+  };
+
+  // Suballocates device memory out of large blocks, one set of blocks per memory type, strategy and resource kind,
+  // so a scene's worth of meshes and textures takes a handful of vkAllocateMemory calls instead of one each.
+  // Allocations never move, host visible blocks are mapped once for their whole lifetime.
+  // Before a new block is allocated the heap's budget is checked (VK_EXT_memory_budget when the device has it),
+  // going over it releases cached empty blocks first and warns if that wasn't enough.
+  class purrGpuAllocator {
+  public:
+    purrGpuAllocator(purrGpuAllocatorSettings settings = {});
+    ~purrGpuAllocator();
+
+    void initialize();
+    // Frees every block, allocations still alive at this point are reported as leaks.
+    void cleanup();
+
+    bool allocate(const purrAllocationInfo &info, purrAllocation *allocation);
+    // Resets the allocation, freeing an invalid one does nothing.
+    void free(purrAllocation &allocation);
+
+    // Create the resource, allocate for its requirements and bind. On failure nothing is left behind.
+    bool createBuffer(const VkBufferCreateInfo &createInfo, purrAllocationInfo info, VkBuffer *buffer, purrAllocation *allocation);
+    bool createImage(const VkImageCreateInfo &createInfo, purrAllocationInfo info, VkImage *image, purrAllocation *allocation);
+    void destroyBuffer(VkBuffer buffer, purrAllocation &allocation);
+    void destroyImage(VkImage image, purrAllocation &allocation);
+
+    // Queries the heap budgets, so it isn't free, don't call it every frame.
+    purrGpuMemoryStats getStats();
+    purrGpuAllocatorSettings getSettings() const { return mSettings; }
+
+    static const char *getCategoryName(purrMemoryCategory category);
+
+    static void setContext(PurrfectEngineContext *context);
+
+    static purrGpuAllocator *getDefault();
+
+    static void cleanupAll();
+  private:
+    struct Block;
+    struct LinearBlock;
+    struct BuddyBlock;
+    struct TlsfBlock;
+
+    bool findMemoryType(const purrAllocationInfo &info, uint32_t *memoryType) const;
+    bool allocateMemory(uint32_t memoryType, VkDeviceSize size, VkDeviceMemory *memory, void **mapped);
+    void freeMemory(uint32_t memoryType, VkDeviceSize size, VkDeviceMemory memory);
+    // Returns false when the heap is still over budget after releasing empty blocks.
+    bool checkBudget(uint32_t heap, VkDeviceSize size);
+    void queryBudget(std::vector<purrMemoryHeapStats> &heaps);
+    void releaseEmptyBlocks(uint32_t heap);
+  private:
+    purrGpuAllocatorSettings mSettings{};
+    bool mInitialized = false;
+    bool mBudgetExtension = false;
+    VkPhysicalDeviceMemoryProperties mMemoryProperties{};
+    uint32_t mMaxAllocations = 0;
+    PFN_vkGetPhysicalDeviceMemoryProperties2 mGetMemoryProperties2 = nullptr;
+
+    std::vector<Block*> mBlocks{};
+    std::vector<VkDeviceSize> mHeapAllocated{};
+    std::vector<bool> mHeapWarned{};
+    uint32_t mDeviceAllocations = 0;
+    uint32_t mDedicatedCount = 0;
+    VkDeviceSize mDedicatedBytes = 0;
+    purrMemoryCategoryStats mCategories[static_cast<uint32_t>(purrMemoryCategory::Count)]{};
+
+    // Meshes and textures may be loaded off the render thread.
+    std::mutex mMutex{};
+  };
+
+}
+
+#endif // PURRENGINE_RENDERER_ALLOCATOR_HPP_
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef   PURRENGINE_RENDERER_BUFFER_HPP_
+#define   PURRENGINE_RENDERER_BUFFER_HPP_
+
+namespace PurrfectEngine {
+
+  // A VkBuffer suballocated from purrGpuAllocator::getDefault(), stands in for fr::frBuffer wherever the engine
+  // creates buffers so their memory shows up in the allocator's per-category stats.
+  class purrBuffer {
+  public:
+    purrBuffer();
+    ~purrBuffer();
+
+    bool initialize(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, purrMemoryCategory category);
+    void cleanup();
+
+    // Host visible buffers only, they stay mapped.
+    void copyData(VkDeviceSize offset, VkDeviceSize size, const void *data);
+    // Copies the first `size` bytes of src with a one time command buffer and waits for it.
+    void copyFromBuffer(fr::frCommands *commands, purrBuffer *src, VkDeviceSize size);
+
+    VkBuffer get() const { return mBuffer; }
+    VkDeviceSize getSize() const { return mSize; }
+    void *getMapped() const { return mAllocation.mapped; }
+    const purrAllocation &getAllocation() const { return mAllocation; }
+  private:
+    VkBuffer mBuffer = VK_NULL_HANDLE;
+    VkDeviceSize mSize = 0;
+    purrAllocation mAllocation{};
+  };
+
+}
+
+#endif // PURRENGINE_RENDERER_BUFFER_HPP_
\ No newline at end of file
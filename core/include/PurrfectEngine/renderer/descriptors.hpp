@@ -0,0 +1,96 @@
+#ifndef   PURRENGINE_RENDERER_DESCRIPTORS_HPP_
+#define   PURRENGINE_RENDERER_DESCRIPTORS_HPP_
+
+namespace PurrfectEngine {
+
+  enum class purrDescriptorLifetime {
+    Frame,      // Sets live until reset(), pools are reset wholesale and never free single sets.
+    Persistent, // Sets live until free(), e.g. texture descriptors.
+  };
+
+  struct purrDescriptorAllocatorSettings {
+    purrDescriptorLifetime lifetime = purrDescriptorLifetime::Persistent;
+    uint32_t setsPerPool = 64;     // Of the first pool, every new one holds twice as many up to maxSetsPerPool.
+    uint32_t maxSetsPerPool = 4096;
+    // Descriptors of each type a pool reserves per set it holds.
+    std::vector<VkDescriptorPoolSize> typesPerSet = {
+      { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 },
+      { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 },
+      { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 },
+      { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 },
+      { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1 },
+    };
+  };
+
+  struct purrDescriptorStats {
+    uint32_t pools = 0;
+    uint32_t sets = 0;        // Allocated since the last reset (Frame) or alive (Persistent).
+    uint32_t poolsAdded = 0;  // Pools created because all others were full, since the last reset.
+    uint32_t failures = 0;    // Allocations that failed even on a fresh pool, the layout needs more than typesPerSet.
+  };
+
+  // Hands out descriptor sets from a growing list of pools, an exhausted pool never fails an allocation,
+  // the next one (or a new, bigger one) is tried instead.
+  // Frame allocators are meant to be one per frame in flight: reset() once the frame's fence signaled recycles
+  // every pool with a single vkResetDescriptorPool each, so sets can be allocated and written fresh every frame.
+  class purrDescriptorAllocator {
+  public:
+    purrDescriptorAllocator(purrDescriptorAllocatorSettings settings = {});
+    ~purrDescriptorAllocator();
+
+    void cleanup();
+
+    // VK_NULL_HANDLE on failure.
+    VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+    // Persistent only, freeing VK_NULL_HANDLE does nothing.
+    void free(VkDescriptorSet set);
+    // Frame only, every set allocated since the last reset becomes invalid.
+    void reset();
+
+    purrDescriptorStats getStats() const { return mStats; }
+
+    static void setContext(PurrfectEngineContext *context);
+
+    // Persistent allocator for long-lived sets.
+    static purrDescriptorAllocator *getDefault();
+
+    static void cleanupAll();
+  private:
+    struct Pool {
+      VkDescriptorPool pool = VK_NULL_HANDLE;
+      uint32_t maxSets = 0;
+      uint32_t sets = 0;
+      bool full = false; // An allocation failed on it, skipped until something is freed (or reset).
+    };
+
+    bool addPool();
+    bool allocateFrom(uint32_t pool, VkDescriptorSetLayout layout, VkDescriptorSet *set);
+  private:
+    purrDescriptorAllocatorSettings mSettings{};
+    std::vector<Pool> mPools{};
+    uint32_t mCurrent = 0;
+    uint32_t mNextPoolSets = 0;
+    std::unordered_map<VkDescriptorSet, uint32_t> mSetPools{}; // Persistent only.
+    purrDescriptorStats mStats{};
+  };
+
+  // Writes all bindings of a set in one vkUpdateDescriptorSetWithTemplate call. Each entry reads its
+  // VkDescriptorBufferInfo / VkDescriptorImageInfo from `offset` (and `stride` for arrays) in the data passed to update.
+  // Falls back to vkUpdateDescriptorSets on devices without Vulkan 1.1 or VK_KHR_descriptor_update_template.
+  class purrDescriptorTemplate {
+  public:
+    purrDescriptorTemplate();
+    ~purrDescriptorTemplate();
+
+    bool initialize(VkDescriptorSetLayout layout, const std::vector<VkDescriptorUpdateTemplateEntry> &entries);
+    void cleanup();
+
+    void update(VkDescriptorSet set, const void *data) const;
+  private:
+    std::vector<VkDescriptorUpdateTemplateEntry> mEntries{};
+    VkDescriptorUpdateTemplate mTemplate = VK_NULL_HANDLE;
+  };
+
+}
+
+#endif // PURRENGINE_RENDERER_DESCRIPTORS_HPP_
\ No newline at end of file
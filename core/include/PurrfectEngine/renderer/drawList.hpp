@@ -0,0 +1,66 @@
+#ifndef   PURRENGINE_RENDERER_DRAWLIST_HPP_
+#define   PURRENGINE_RENDERER_DRAWLIST_HPP_
+
+namespace PurrfectEngine {
+
+  // Passes sort before everything else in a key, so each one is a contiguous range of the sorted list.
+  enum class purrDrawPass : uint8_t {
+    DepthPrepass = 0,
+    Opaque = 1,
+  };
+
+  struct purrDrawItem {
+    uint64_t key;
+    purrPipeline *pipeline;
+    purrMesh *mesh;
+    uint32_t objectIndex; // Into the scene's objects, which is the transforms SSBO index.
+  };
+
+  struct purrDrawListStats {
+    uint32_t draws = 0;
+    uint32_t pipelineChanges = 0; // Binds a renderer following the sorted order needs, the first one included.
+    uint32_t meshChanges = 0;
+    uint32_t sortPasses = 0;      // Radix passes run, bytes that are equal in every key are skipped.
+    double sortMs = 0.0;
+  };
+
+  // A frame's draws as 64-bit keys, sorted so that draws sharing state end up next to each other:
+  //   pass (4) | pipeline (12) | material (12) | mesh (16) | depth (20)
+  // Pipelines and meshes get small ids in the order they're first added, materials are ids the caller assigns.
+  // Depth is the view depth quantized to the top 20 bits of its float, so opaque draws of one mesh go front to back.
+  // Ids that don't fit their field wrap around, that only costs grouping, never correctness.
+  class purrDrawList {
+  public:
+    purrDrawList();
+    ~purrDrawList();
+
+    void clear();
+    // Negative depths (behind the camera) are clamped to 0.
+    void add(purrDrawPass pass, purrPipeline *pipeline, uint32_t material, purrMesh *mesh, uint32_t objectIndex, float depth);
+    // Parallel LSD radix sort on the pool, 8 bits per pass. Stable, equal keys keep the order they were added in.
+    void sort(purrWorkerPool *pool = purrWorkerPool::getDefault());
+
+    // Sorted after sort(), in the order they were added before.
+    const std::vector<purrDrawItem> &getItems() const { return mItems; }
+    // [first, first + count) of the sorted items that belong to pass.
+    void getRange(purrDrawPass pass, uint32_t *first, uint32_t *count) const;
+    bool empty() const { return mItems.empty(); }
+    uint32_t size() const { return static_cast<uint32_t>(mItems.size()); }
+
+    purrDrawListStats getStats() const { return mStats; }
+
+    static uint64_t makeKey(purrDrawPass pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth);
+  private:
+    uint32_t getId(std::unordered_map<const void*, uint32_t> &ids, const void *ptr);
+  private:
+    std::vector<purrDrawItem> mItems{};
+    std::vector<purrDrawItem> mScratch{};
+    std::vector<uint32_t> mHistograms{}; // 256 counters per chunk.
+    std::unordered_map<const void*, uint32_t> mPipelineIds{};
+    std::unordered_map<const void*, uint32_t> mMeshIds{};
+    purrDrawListStats mStats{};
+  };
+
+}
+
+#endif // PURRENGINE_RENDERER_DRAWLIST_HPP_
\ No newline at end of file
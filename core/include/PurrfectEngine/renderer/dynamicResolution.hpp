@@ -0,0 +1,46 @@
+#ifndef   PURRENGINE_RENDERER_DYNAMICRESOLUTION_HPP_
+#define   PURRENGINE_RENDERER_DYNAMICRESOLUTION_HPP_
+
+namespace PurrfectEngine {
+
+  struct purrDynamicResolutionSettings {
+    float budgetMs = 16.0f;  // GPU time per frame to stay under.
+    float minScale = 0.5f;   // Per axis, relative to the scene target.
+    float maxScale = 1.0f;
+    float headroom = 0.85f;  // Only scale up while the GPU is below budget * headroom.
+    uint32_t upDelay = 30;   // Frames under headroom before scaling up again.
+    float maxUpStep = 0.05f; // Largest increase per frame, decreases aren't limited.
+    float sharpness = 0.5f;  // Of the upscaling composite, 0 is plain bilinear.
+  };
+
+  // Picks a render scale from GPU frame times. Pixel cost is taken as proportional to scale^2,
+  // so a frame that took t ms at scale s predicts s * sqrt(budget / t) to land on budget.
+  // A time arrives framesInFlight frames late, so s is the scale that frame slot was rendered at, not the current one.
+  // Over budget the scale drops right away, under it it only climbs back slowly and after upDelay calm frames,
+  // so a spike costs resolution for a moment instead of a dropped frame, and the scale doesn't oscillate.
+  class purrDynamicResolution {
+  public:
+    purrDynamicResolution();
+    ~purrDynamicResolution();
+
+    void initialize(purrDynamicResolutionSettings settings);
+
+    // Feed the GPU time of the frame that last used frameIndex's slot (0 if it wasn't measured),
+    // returns the new scale, which is remembered as the one this slot renders at.
+    float update(uint32_t frameIndex, double gpuFrameMs);
+    void reset();
+
+    float getScale() const { return mScale; }
+
+    purrDynamicResolutionSettings getSettings() const { return mSettings; }
+  private:
+    purrDynamicResolutionSettings mSettings{};
+    float mScale = 1.0f;
+    double mAverageCost = 0.0; // GPU ms per frame at scale 1.
+    uint32_t mCalmFrames = 0;
+    std::vector<float> mSlotScales{}; // 0 while a slot hasn't rendered yet.
+  };
+
+}
+
+#endif // PURRENGINE_RENDERER_DYNAMICRESOLUTION_HPP_
\ No newline at end of file
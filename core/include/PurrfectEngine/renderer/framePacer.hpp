@@ -0,0 +1,72 @@
+#ifndef   PURRENGINE_RENDERER_FRAMEPACER_HPP_
+#define   PURRENGINE_RENDERER_FRAMEPACER_HPP_
+
+namespace PurrfectEngine {
+
+  struct purrFramePacerSettings {
+    double targetFps = 0.0;       // 0 disables the limiter, frames are then paced by the present mode alone.
+    uint64_t marginNs = 1000000;  // Slack kept between the predicted end of a frame and its deadline.
+    uint32_t workWindow = 32;     // Frames the CPU work prediction looks back on.
+  };
+
+  struct purrFramePacingStats {
+    uint32_t frames = 0;
+    uint32_t missedDeadlines = 0; // Frames presented after their deadline (limiter only).
+    double frameMsMean = 0.0;     // Present to present.
+    double frameMsStdDev = 0.0;
+    double frameMsP99 = 0.0;
+    double latencyMsMean = 0.0;   // Input sampled (waitForFrame returned) to present queued.
+    double latencyMsP99 = 0.0;
+    double sleepMsMean = 0.0;     // Time spent in waitForFrame.
+  };
+
+  // Latency oriented frame limiter. Instead of sleeping after present, which leaves the next frame working
+  // on input that has aged by the whole sleep, it sleeps before input is sampled: until the frame's deadline
+  // minus the CPU work it is predicted to take (90th percentile of recent frames) minus a margin.
+  // Deadlines are on a fixed grid of 1/targetFps, a missed one re-anchors the grid instead of bursting to catch up.
+  //
+  // Usage per frame: waitForFrame(), sample input, record and submit, framePresented().
+  class purrFramePacer {
+  public:
+    purrFramePacer(purrClock *clock = purrClock::getDefault());
+    ~purrFramePacer();
+
+    void setSettings(purrFramePacerSettings settings);
+    purrFramePacerSettings getSettings() const { return mSettings; }
+
+    // Returns the time input should be sampled at (now, after the sleep).
+    uint64_t waitForFrame();
+    void framePresented();
+
+    purrFramePacingStats getStats() const;
+    void resetStats();
+
+    // Next present deadline, 0 while the limiter is off or before the first frame.
+    uint64_t getDeadline() const { return mDeadline; }
+    uint64_t getPredictedWorkNs() const;
+  private:
+    uint64_t getPeriodNs() const;
+  private:
+    purrClock *mClock = nullptr;
+    purrFramePacerSettings mSettings{};
+
+    uint64_t mDeadline = 0;
+    uint64_t mFrameStart = 0;
+    uint64_t mLastPresent = 0;
+    bool mInFrame = false;
+
+    std::vector<uint64_t> mWork{};
+    uint32_t mWorkNext = 0;
+
+    // Last STATS_WINDOW frames, ring buffers.
+    std::vector<double> mFrameMs{};
+    std::vector<double> mLatencyMs{};
+    uint32_t mStatsNext = 0;
+    uint32_t mFrames = 0;
+    uint32_t mMissed = 0;
+    double mSleepMsTotal = 0.0;
+  };
+
+}
+
+#endif // PURRENGINE_RENDERER_FRAMEPACER_HPP_
\ No newline at end of file
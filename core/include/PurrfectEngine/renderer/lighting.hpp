@@ -0,0 +1,72 @@
+#ifndef   PURRENGINE_RENDERER_LIGHTING_HPP_
+#define   PURRENGINE_RENDERER_LIGHTING_HPP_
+
+namespace PurrfectEngine {
+
+  // Point light as laid out in the lights SSBO (std430).
+  struct purrLight {
+    glm::vec3 position; // World space.
+    float radius;       // Attenuation reaches zero here, the light is only binned into clusters it can reach.
+    glm::vec3 color;
+    float intensity;
+  };
+
+  struct purrDirectionalLight {
+    glm::vec3 direction{0.0f, -1.0f, 0.0f}; // Direction the light travels in.
+    glm::vec3 color{1.0f};
+    float intensity = 0.0f;                 // Off by default.
+  };
+
+  struct purrLightClusterStats {
+    uint32_t lightCount = 0;
+    uint32_t visibleLights = 0;    // Lights that touched at least one cluster.
+    uint32_t indexCount = 0;       // Sum of all per-cluster lists.
+    uint32_t maxLightsPerCluster = 0;
+    uint32_t occupiedClusters = 0;
+    double buildMs = 0.0;
+  };
+
+  // View space froxel grid: x/y tiles split the screen evenly, z slices are exponential between the camera's
+  // near and far planes (slice = log(z / near) / log(far / near) * slices), which keeps froxels roughly cubic.
+  // Every light's sphere is binned analytically: per z slice it covers, the sphere is cut to that slice's depth range
+  // and the projected bounds of that piece give the tile rectangle, so small lights land in only a handful of clusters.
+  // The result is one (offset, count) pair per cluster into a compact light index list, built with a counting pass
+  // and a prefix sum, no fixed per-cluster capacity.
+  class purrLightClusters {
+  public:
+    purrLightClusters(uint32_t tilesX = 16, uint32_t tilesY = 9, uint32_t slices = 24);
+    ~purrLightClusters();
+
+    void build(const std::vector<purrLight> &lights, const glm::mat4 &view, const glm::mat4 &projection, float nearPlane, float farPlane);
+
+    glm::uvec3 getGridSize() const { return glm::uvec3(mTilesX, mTilesY, mSlices); }
+    uint32_t getClusterIndex(uint32_t x, uint32_t y, uint32_t z) const { return (z * mTilesY + y) * mTilesX + x; }
+    // Shader side: slice = floor(log(viewDepth) * scale + bias).
+    glm::vec2 getSliceScaleBias() const { return mSliceScaleBias; }
+
+    // (offset, count) into getIndices(), indexed by getClusterIndex().
+    const std::vector<glm::uvec2> &getClusters() const { return mClusters; }
+    const std::vector<uint32_t> &getIndices() const { return mIndices; }
+    purrLightClusterStats getStats() const { return mStats; }
+  private:
+    struct Range {
+      uint32_t light;
+      uint32_t slice;
+      uint32_t x0, x1, y0, y1;
+    };
+
+    bool tileRange(const glm::mat4 &projection, glm::vec3 min, glm::vec3 max, Range *range) const;
+  private:
+    uint32_t mTilesX = 16, mTilesY = 9, mSlices = 24;
+    float mNear = 0.01f, mFar = 100.0f;
+    glm::vec2 mSliceScaleBias{};
+
+    std::vector<Range> mRanges{};
+    std::vector<glm::uvec2> mClusters{};
+    std::vector<uint32_t> mIndices{};
+    purrLightClusterStats mStats{};
+  };
+
+}
+
+#endif // PURRENGINE_RENDERER_LIGHTING_HPP_
\ No newline at end of file
@@ -5,6 +5,7 @@ namespace PurrfectEngine {
 
   class purrMesh {
   public:
+    PURR_POOLED
     purrMesh();
     ~purrMesh();
 
@@ -15,6 +16,8 @@ namespace PurrfectEngine {
     void render(VkCommandBuffer cmdBuf);
 
     bool isValid() const { return mValid; }
+    // Model space bounding sphere, xyz center and w radius.
+    glm::vec4 getBoundingSphere() const { return mBoundingSphere; }
 
     static void setContext(PurrfectEngineContext *context);
 
@@ -23,10 +26,11 @@ namespace PurrfectEngine {
     static void cleanupAll();
   private:
     bool mValid = false;
+    glm::vec4 mBoundingSphere{0.0f};
 
     size_t mIndexCount = 0;
-    fr::frBuffer *mVertexBuffer = nullptr;
-    fr::frBuffer *mIndexBuffer = nullptr;
+    purrBuffer *mVertexBuffer = nullptr;
+    purrBuffer *mIndexBuffer = nullptr;
   };
 
   class purrMesh2D {
@@ -45,8 +49,8 @@ namespace PurrfectEngine {
     static void cleanupAll();
   private:
     size_t mIndexCount = 0;
-    fr::frBuffer *mVertexBuffer = nullptr;
-    fr::frBuffer *mIndexBuffer = nullptr;
+    purrBuffer *mVertexBuffer = nullptr;
+    purrBuffer *mIndexBuffer = nullptr;
   };
 
 }
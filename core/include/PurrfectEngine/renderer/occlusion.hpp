@@ -0,0 +1,140 @@
+#ifndef   PURRENGINE_RENDERER_OCCLUSION_HPP_
+#define   PURRENGINE_RENDERER_OCCLUSION_HPP_
+
+namespace PurrfectEngine {
+
+  enum class purrOcclusionMode {
+    Off, // Frustum culling only.
+    Cpu, // Occluders (purrOccluderComp) are rasterized into a small depth buffer on worker threads, no GPU involved.
+    Gpu, // Bounds are tested against a depth pyramid of the scene pass, see purrOcclusionCuller::build.
+  };
+
+  struct purrOcclusionSettings {
+    purrOcclusionMode mode = purrOcclusionMode::Cpu;
+    // CPU depth buffer, a fraction of the render resolution is plenty for culling whole objects.
+    uint32_t width = 320;
+    uint32_t height = 192;
+    uint32_t threads = 0;      // Workers besides the calling thread, 0 uses hardware_concurrency - 1 (see purrWorkerPool).
+    float boundsScale = 1.05f; // Bounding spheres are inflated by this, covers the motion of a frame old depth pyramid.
+  };
+
+  struct purrOcclusionStats {
+    uint32_t tested = 0;         // Objects with a mesh.
+    uint32_t frustumCulled = 0;
+    uint32_t occluded = 0;
+    uint32_t occluders = 0;      // CPU only.
+    uint32_t occluderTriangles = 0;
+    double rasterMs = 0.0;       // CPU only, transforming and rasterizing the occluders.
+    double testMs = 0.0;
+  };
+
+  // Decides per frame which of the scene's mesh objects renderer::renderScene draws (see renderer::setOcclusionCuller).
+  // Everything outside the camera's frustum is culled in every mode, occlusion comes from one of two depth sources:
+  //  - Cpu: the occluder meshes are rasterized with a conservative depth (the farthest vertex of each triangle)
+  //    into bands of rows on a small worker pool, then reduced to 8x8 tiles holding their farthest depth.
+  //    Bounds whose nearest depth is behind every tile they cover are occluded.
+  //  - Gpu: after the scene pass build() reduces its depth into a max-depth pyramid and tests every object against it
+  //    in a compute shader. The results are read back when the frame slot comes around again, so they're framesInFlight
+  //    frames old, objects that just came out from behind an occluder show up that much later.
+  class purrOcclusionCuller {
+  public:
+    purrOcclusionCuller(purrOcclusionSettings settings = {});
+    ~purrOcclusionCuller();
+
+    // Creates the pyramid and test passes, only needed for purrOcclusionMode::Gpu.
+    void initialize();
+    void cleanup();
+
+    // Decides this frame's visibility from viewProjection and the frame's transforms (renderer::getSnapshot).
+    // Call before renderer::renderScene.
+    void update(const glm::mat4 &viewProjection);
+    // GPU mode only, records the pyramid build and the bounds test into the active command buffer. `depth` is the
+    // depth target of the scene pass that just ended, its pipeline must be created with purrPipelineCreateInfo::keepDepth.
+    // renderExtent is the part of it that was rendered to (see purrPipeline::getRenderExtent).
+    void build(purrTexture *depth, VkExtent2D renderExtent);
+
+    // Indices are the scene's object indices. Objects the culler hasn't seen yet are visible.
+    bool isVisible(uint32_t objectIndex) const { return objectIndex >= mVisible.size() || mVisible[objectIndex]; }
+
+    void setMode(purrOcclusionMode mode) { mSettings.mode = mode; }
+    purrOcclusionSettings getSettings() const { return mSettings; }
+    purrOcclusionStats getStats() const { return mStats; }
+    // CPU depth buffer of the last update, row major, 1.0 where no occluder was rasterized.
+    const std::vector<float> &getDepth() const { return mDepth; }
+    // Tests a world space sphere (center, radius) against that depth buffer with the last update's camera,
+    // the same test update() applies to the scene's objects.
+    bool isOccluded(glm::vec4 sphere) const;
+
+    static void setContext(PurrfectEngineContext *context);
+  private:
+    struct Triangle {
+      float x[3], y[3];
+      float depth; // Farthest of the three vertices.
+      int32_t minY, maxY;
+      bool valid;
+    };
+
+    struct FrameData {
+      purrBuffer *bounds = nullptr;
+      VkDeviceSize boundsCapacity = 0;
+      VkBuffer visibility = VK_NULL_HANDLE;
+      purrAllocation visibilityAllocation{};
+      uint32_t *visibilityData = nullptr;
+      VkDeviceSize visibilityCapacity = 0;
+      fr::frDescriptor *descriptor = nullptr;
+      std::vector<uint32_t> keys{}; // Object UUIDs in the order the bounds were tested in.
+      uint32_t objectCount = 0;
+      bool pending = false;
+    };
+
+    void gatherBounds();
+    // 0 when the sphere is outside the frustum, 1 when it's inside, 2 when it crosses the near plane.
+    // Otherwise rect is the sphere's box in NDC (min x, min y, max x, max y) and depth its nearest depth.
+    int projectSphere(glm::vec4 sphere, glm::vec4 *rect, float *depth) const;
+    void updateCpu();
+    void rasterizeBand(uint32_t band);
+    bool isOccludedCpu(const glm::vec4 &rect, float depth) const;
+    void readbackGpu();
+
+    void createPyramid(purrTexture *depth);
+    void destroyPyramid();
+    bool reserveFrame(FrameData &frame, uint32_t objectCount);
+  private:
+    purrOcclusionSettings mSettings{};
+    purrOcclusionStats mStats{};
+    glm::mat4 mViewProjection{1.0f};
+
+    std::vector<uint8_t> mVisible{};
+    std::vector<glm::vec4> mSpheres{}; // World space per scene object, w < 0 for objects without a mesh.
+    std::vector<uint32_t> mKeys{};     // UUID per scene object, GPU results are matched by these when the scene changed.
+
+    // CPU
+    std::vector<Triangle> mTriangles{};
+    std::vector<float> mDepth{};
+    std::vector<float> mTileDepth{};
+    uint32_t mTilesX = 0, mTilesY = 0;
+    purrWorkerPool *mWorkers = nullptr;
+
+    // GPU
+    std::vector<FrameData> mFrames{};
+    fr::frDescriptorLayout *mReduceLayout = nullptr;
+    fr::frDescriptorLayout *mTestLayout = nullptr;
+    VkPipelineLayout mReducePipelineLayout = VK_NULL_HANDLE;
+    VkPipelineLayout mTestPipelineLayout = VK_NULL_HANDLE;
+    VkPipeline mReducePipeline = VK_NULL_HANDLE;
+    VkPipeline mTestPipeline = VK_NULL_HANDLE;
+    VkSampler mSampler = VK_NULL_HANDLE;
+
+    VkImageView mSourceView = VK_NULL_HANDLE; // Depth view the reduce descriptors were written for.
+    VkExtent2D mPyramidSize{};
+    VkImage mPyramid = VK_NULL_HANDLE;
+    purrAllocation mPyramidAllocation{};
+    VkImageView mPyramidView = VK_NULL_HANDLE;
+    std::vector<VkImageView> mMipViews{};
+    fr::frDescriptors *mDescriptors = nullptr;
+    std::vector<fr::frDescriptor*> mReduceDescriptors{};
+  };
+
+}
+
+#endif // PURRENGINE_RENDERER_OCCLUSION_HPP_
\ No newline at end of file
@@ -0,0 +1,176 @@
+#ifndef   PURRENGINE_RENDERER_PARTICLES_HPP_
+#define   PURRENGINE_RENDERER_PARTICLES_HPP_
+
+namespace PurrfectEngine {
+
+  struct purrParticleEmitterSettings {
+    uint32_t maxParticles = 65536;
+    float rate = 5000.0f;                // Particles per second.
+    glm::vec2 lifetime{1.0f, 2.0f};      // Seconds, each particle picks one in [x, y].
+    float spawnRadius = 0.1f;            // Half size of the box around the object's position new particles start in.
+    glm::vec3 velocity{0.0f, 3.0f, 0.0f};
+    float velocitySpread = 1.0f;         // Added per axis, in [-spread, spread].
+    glm::vec3 gravity{0.0f, -9.81f, 0.0f};
+    float drag = 0.2f;                   // Fraction of the velocity lost per second.
+    glm::vec2 size{0.05f, 0.01f};        // World space half size at birth and at death.
+    glm::vec4 colorStart{4.0f, 2.0f, 0.5f, 1.0f}; // HDR, alpha blended.
+    glm::vec4 colorEnd{0.5f, 0.1f, 0.05f, 0.0f};
+    bool sort = true;                    // Back to front, can be turned off when the order isn't visible.
+    uint32_t seed = 0;
+  };
+
+  // One particle as laid out in the particle buffers (std430), see shaders/particleSimulate.comp.
+  struct purrParticle {
+    glm::vec4 positionAge;      // World space position, seconds alive.
+    glm::vec4 velocityLifetime; // Velocity, seconds it lives.
+  };
+
+  struct purrParticleStats {
+    uint32_t emitters = 0;
+    uint32_t alive = 0;      // Read back from the GPU, a few frames old.
+    uint32_t capacity = 0;
+    uint32_t emitted = 0;    // Requested by the last update(), dropped when an emitter is full.
+    uint32_t dispatches = 0; // Compute dispatches of the last update(), sorting is most of them.
+  };
+
+  // Turns a rate into whole particles per step, the remainder carries over so no fraction is ever lost.
+  struct purrParticleSpawner {
+    float accumulator = 0.0f;
+    uint32_t spawned = 0;    // Total so far, new particles are numbered from it and seeded with their number.
+
+    uint32_t step(float rate, float dt) {
+      accumulator += rate * dt;
+      uint32_t count = static_cast<uint32_t>(accumulator);
+      accumulator -= static_cast<float>(count);
+      return count;
+    }
+  };
+
+  // GPU buffers of one emitter, created by purrParticleSystem::update on first use.
+  // WARNING: Destroyed with its component, the GPU must be done with the frames that used it.
+  class purrParticleBuffers {
+  public:
+    purrParticleBuffers();
+    ~purrParticleBuffers();
+
+    bool initialize(uint32_t capacity, VkDescriptorSetLayout layout, purrDescriptorTemplate *descriptorTemplate);
+    void cleanup();
+
+    uint32_t getCapacity() const { return mCapacity; }
+    // Capacity rounded up to a power of two (at least one sort block), the length of the sort keys.
+    uint32_t getSortCapacity() const { return mSortCapacity; }
+    // Set of the next update, it reads the current particles (binding 0) and writes the compacted ones (binding 1).
+    VkDescriptorSet getSet() const { return mSets[mParity]; }
+    // Set of the last update, binding 1 holds the particles it left.
+    VkDescriptorSet getDrawSet() const { return mSets[mParity ^ 1]; }
+    void swap() { mParity ^= 1; }
+    VkBuffer getState() const;
+    uint32_t getAlive() const;
+  private:
+    uint32_t mCapacity = 0;
+    uint32_t mSortCapacity = 0;
+    purrBuffer *mParticles[2] = {};
+    purrBuffer *mState = nullptr; // Counters, draw and dispatch arguments, host visible for getAlive().
+    purrBuffer *mKeys = nullptr;
+    VkDescriptorSet mSets[2] = {};
+    uint32_t mParity = 0;
+  };
+
+  // Emits particles at the owning object's position, simulated and drawn by purrParticleSystem.
+  class purrParticleComp : public purrComponent {
+  public:
+    purrParticleComp(purrParticleEmitterSettings settings = {});
+    virtual ~purrParticleComp() override;
+
+    virtual const char *getName() override { return "particleComponent"; }
+
+    // maxParticles is fixed once the buffers exist.
+    void setSettings(purrParticleEmitterSettings settings) { mSettings = settings; }
+    purrParticleEmitterSettings getSettings() const { return mSettings; }
+    purrParticleSpawner &getSpawner() { return mSpawner; }
+    purrParticleBuffers *getBuffers() const { return mBuffers; }
+    void setBuffers(purrParticleBuffers *buffers) { mBuffers = buffers; }
+  private:
+    purrParticleEmitterSettings mSettings{};
+    purrParticleSpawner mSpawner{};
+    purrParticleBuffers *mBuffers = nullptr;
+  };
+
+  // Runs every purrParticleComp of the frame's snapshot (renderer::getSnapshot) on the GPU, nothing is done per particle on the CPU.
+  // update() records per emitter:
+  //  - simulate: every live particle is integrated and, if it's still alive, appended to the other buffer
+  //    (an atomic counter), which compacts the dead ones away,
+  //  - emit: new particles are appended behind the survivors, each seeded with its spawn number,
+  //  - finalize: a single invocation clamps the count and writes the draw and dispatch arguments,
+  //  - sort: bitonic sort of (view depth, index) keys, blocks of 1024 in shared memory and the larger merge steps
+  //    in global memory. It covers the sort capacity, keys past the live count sort last.
+  // The next simulate is dispatched indirectly over the live count and render() draws it with vkCmdDrawIndirect,
+  // six vertices of a camera facing quad per instance.
+  // purrParticleReference runs the same steps on the CPU.
+  class purrParticleSystem {
+  public:
+    purrParticleSystem();
+    ~purrParticleSystem();
+
+    void initialize();
+    void cleanup();
+
+    // Records this frame's compute passes into the active command buffer, call after renderer::renderBegin and
+    // before the scene pass.
+    void update(float dt);
+    // Draws the particles into the scene pass, after renderer::renderScene.
+    void render(purrPipeline *pipeline);
+
+    purrParticleStats getStats() const;
+
+    static void setContext(PurrfectEngineContext *context);
+  private:
+    void sort(VkCommandBuffer cmdBuf, const glm::vec4 &viewRow);
+  private:
+    fr::frDescriptorLayout *mLayout = nullptr; // Particles in, particles out, state, sort keys.
+    purrDescriptorTemplate mTemplate{};
+    VkPipelineLayout mPipelineLayout = VK_NULL_HANDLE;
+    VkPipeline mSimulatePipeline = VK_NULL_HANDLE;
+    VkPipeline mEmitPipeline = VK_NULL_HANDLE;
+    VkPipeline mFinalizePipeline = VK_NULL_HANDLE;
+    VkPipeline mSortPipeline = VK_NULL_HANDLE;
+
+    VkPipelineLayout mDrawLayout = VK_NULL_HANDLE; // Owned by purrPipelineCache, as is the draw pipeline.
+    uint64_t mDrawKey = 0;
+    uint64_t mDrawHash = 0; // State the key was requested for, the scene pipeline's formats and samples.
+
+    std::vector<purrParticleComp*> mEmitters{}; // Of the last update(), drawn by render().
+    uint32_t mEmitted = 0;
+    uint32_t mDispatches = 0;
+  };
+
+  // CPU version of one emitter for tests, same steps and the same random numbers as the shaders. The compaction
+  // keeps the survivors in order, so indices differ from the GPU's, the back to front sequence of particles doesn't.
+  class purrParticleReference {
+  public:
+    purrParticleReference(purrParticleEmitterSettings settings = {});
+
+    void update(float dt, glm::vec3 emitterPosition, const glm::mat4 &view);
+
+    const std::vector<purrParticle> &getParticles() const { return mParticles; }
+    // Indices into getParticles(), back to front when sorting.
+    const std::vector<uint32_t> &getDrawOrder() const { return mDrawOrder; }
+    uint32_t getAlive() const { return static_cast<uint32_t>(mParticles.size()); }
+
+    // PCG hash, shaders/particleEmit.comp has the same.
+    static uint32_t hash(uint32_t value);
+    static purrParticle spawn(const purrParticleEmitterSettings &settings, glm::vec3 position, uint32_t spawnIndex);
+    // False when the particle died during the step.
+    static bool simulate(const purrParticleEmitterSettings &settings, float dt, purrParticle *particle);
+    // Ascending key is back to front, ties broken by index. See shaders/particleSort.comp.
+    static uint32_t sortKey(const purrParticle &particle, const glm::vec4 &viewRow);
+  private:
+    purrParticleEmitterSettings mSettings{};
+    purrParticleSpawner mSpawner{};
+    std::vector<purrParticle> mParticles{};
+    std::vector<uint32_t> mDrawOrder{};
+  };
+
+}
+
+#endif // PURRENGINE_RENDERER_PARTICLES_HPP_
\ No newline at end of file
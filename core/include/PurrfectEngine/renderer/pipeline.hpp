@@ -5,12 +5,33 @@
 
 namespace PurrfectEngine {
 
+  // Per-draw data every lighting pipeline has, pbr.frag's vec4 tint.
+  #define PURR_LIGHTING_DRAW_DATA 16
+
   struct purrPipelineCreateInfo {
     int width;
     int height;
     std::unordered_map<VkShaderStageFlagBits, const char *> shaders;
     purrTexture* colorTarget;
-    purrTexture* depthTarget; // Can be set to nullptr if not needed. In that case, it will be automatically generated by the purrPipeline constructor.
+    purrTexture* depthTarget; // Can be set to nullptr if not needed. In that case, a transient one is acquired from purrRenderTargetPool by the purrPipeline constructor.
+    purrPipelineCompileMode compileMode = purrPipelineCompileMode::Block;
+    purrPipeline *fallback = nullptr; // Used while compiling with purrPipelineCompileMode::Fallback, must render to compatible targets.
+    const char *name = "purrPipeline"; // Label of this pipeline's purrProfiler GPU zone.
+    // Adds the clustered lights (set 2, see renderer::updateLights) and the shadow map (set 3) to the layout and binds them in begin().
+    // pbr.frag reads a tint from the per-draw data, so drawDataSize is raised to at least PURR_LIGHTING_DRAW_DATA.
+    bool lighting = false;
+    // Stores the depth and leaves it in DEPTH_STENCIL_READ_ONLY_OPTIMAL for compute and fragment shaders after the pass
+    // (e.g. purrOcclusionCuller::build). The pooled depth target is sampled then instead of transient, a depthTarget must have SAMPLED usage.
+    bool keepDepth = false;
+    // renderer::renderScene lays down depth with a vertex only variant first, then draws color with depth writes off
+    // and LESS_OR_EQUAL, so each pixel is shaded once. Pays off when the fragment shader is the expensive part.
+    bool depthPrepass = false;
+    // Renders into transient multisampled color and depth (lazily allocated where the device has it) that are
+    // resolved into colorTarget, which stays single sample. Clamped to what the device supports.
+    MSAA msaa = MSAA::None;
+    // Bytes of per-draw data (at most PURR_MAX_DRAW_DATA) renderScene hands to renderer::setDrawDataCallback and binds
+    // as a dynamic uniform buffer at set getDrawDataSet(), after the other sets. 0 leaves the set out of the layout.
+    uint32_t drawDataSize = 0;
   };
 
   class purrPipeline {
@@ -22,30 +43,74 @@ namespace PurrfectEngine {
 
     void cleanup();
 
+    // Swaps in targets of a new size and rebuilds only the framebuffer (and the pooled depth target).
+    // Render pass and pipeline are kept, viewport and scissor are dynamic and follow the new size.
+    // WARNING: The GPU must be done with the old framebuffer.
+    void resize(int width, int height, purrTexture *colorTarget, purrTexture *depthTarget = nullptr);
+    // Rebuilds render pass, framebuffer and multisampled targets and switches to the variants for the new count.
+    // WARNING: The GPU must be done with the old framebuffer.
+    void setSampleCount(VkSampleCountFlagBits samples);
+    VkSampleCountFlagBits getSampleCount() const { return mSamples; }
+
     // Binds render pass and pipeline, ready for rendering.
+    // If the pipeline is still compiling, only the render pass is begun (attachments get cleared) and isBound() is false.
     // WARNING: There must be an active command buffer in the PurrfectEngineContext.
     void begin(VkClearValue clearColor);
     void end();
 
+    // Renders into the top-left scale x scale part of the targets (render area, viewport and scissor),
+    // the targets themselves keep their size. Used by dynamic resolution, see renderer::render for the upscale.
+    void setRenderScale(float scale);
+    float getRenderScale() const { return mRenderScale; }
+    VkExtent2D getRenderExtent() const;
+
     static void setContext(PurrfectEngineContext *context);
   public:
-    fr::frPipeline *get() const { return mPipeline; }
+    // VK_NULL_HANDLE while the pipeline is compiling in the background.
+    VkPipeline get();
+    VkPipelineLayout getLayout() const { return mLayout; }
+    bool isReady() { return get() != VK_NULL_HANDLE; }
+    // Whether draws can be recorded after begin().
+    bool isBound() const { return mBound; }
+    // Depth only variant, VK_NULL_HANDLE without purrPipelineCreateInfo::depthPrepass or while it's compiling.
+    VkPipeline getPrepass();
+    // begin() bound the pre-pass variant, the draws recorded now only write depth. Bind get() for the color draws.
+    bool isPrepassActive() const { return mPrepassActive; }
+    // Set index of the per-draw data, UINT32_MAX without purrPipelineCreateInfo::drawDataSize.
+    uint32_t getDrawDataSet() const { return mDrawDataSet; }
+    uint32_t getDrawDataSize() const { return mCreateInfo.drawDataSize; }
 
     purrTexture *getColor() const { return mColorTexture; }
     purrTexture *getDepth() const { return mDepthTexture; }
+  private:
+    VkSampleCountFlagBits pickSamples(VkSampleCountFlagBits requested) const;
+    void acquireTargets(int width, int height);
+    void releaseTargets();
+    purrTexture *acquireDepth(int width, int height);
+    void createRenderPass();
+    void createFramebuffer();
   private:
     purrPipelineCreateInfo mCreateInfo{};
     fr::frRenderer *mRenderer = nullptr;
 
     fr::frRenderPass *mRenderPass = nullptr;
-    fr::frPipeline *mPipeline = nullptr;
+    VkPipelineLayout mLayout = VK_NULL_HANDLE;
+    VkPipeline mPipeline = VK_NULL_HANDLE;
+    uint64_t mKey = 0;
+    VkPipeline mPrepass = VK_NULL_HANDLE;
+    uint64_t mPrepassKey = 0;
+    bool mBound = false;
+    bool mPrepassActive = false;
+    bool mInitialized = false;
+    float mRenderScale = 1.0f;
+    VkSampleCountFlagBits mSamples = VK_SAMPLE_COUNT_1_BIT;
+    uint32_t mDrawDataSet = UINT32_MAX;
 
-    purrTexture *mColorTexture = nullptr;
+    purrTexture *mColorTexture = nullptr; // Resolve target when multisampled.
     purrTexture *mDepthTexture = nullptr;
+    purrTexture *mMultisampleTexture = nullptr;
 
     fr::frFramebuffer *mFramebuffer = nullptr;
-
-    std::vector<fr::frShader*> mShaders{};
   };
 
 }
@@ -0,0 +1,143 @@
+#ifndef   PURRENGINE_RENDERER_PIPELINECACHE_HPP_
+#define   PURRENGINE_RENDERER_PIPELINECACHE_HPP_
+
+namespace PurrfectEngine {
+
+  struct purrPipelineCacheStats {
+    bool warm = false;               // Cache data was loaded from disk and accepted.
+    size_t loadedBytes = 0;
+    double loadMs = 0.0;
+    uint32_t pipelineCount = 0;
+    double pipelineMs = 0.0;         // Total time spent in vkCreate*Pipelines.
+    uint32_t shaderRequests = 0;
+    uint32_t shaderModuleCount = 0;  // Unique modules, keyed by SPIR-V hash.
+    double shaderMs = 0.0;           // Reading SPIR-V and creating modules.
+    uint32_t variantCount = 0;       // Pipeline state objects keyed by purrGraphicsPipelineState::hash().
+    uint32_t variantHits = 0;
+    uint32_t pendingCount = 0;       // Variants still compiling on the worker threads.
+  };
+
+  enum class purrPipelineCompileMode {
+    Block,    // Compile on the calling thread when the variant is missing.
+    Skip,     // Compile in the background, draws are skipped until it's ready.
+    Fallback, // Compile in the background, draw with a fallback pipeline until it's ready.
+  };
+
+  // Everything that ends up in a graphics pipeline. The cache keys variants by this hash and the SPIR-V of the shaders,
+  // so a shader recompiled to the same path gets a new pipeline.
+  struct purrGraphicsPipelineState {
+    std::vector<std::pair<VkShaderStageFlagBits, std::string>> shaders{};
+
+    VkVertexInputBindingDescription binding{};
+    std::vector<VkVertexInputAttributeDescription> attributes{};
+
+    // Render pass compatibility, the cache creates a compatible render pass of its own.
+    std::vector<VkFormat> colorFormats{};
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+    VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+    VkFrontFace frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    bool depthTest = true;
+    bool depthWrite = true;
+    VkCompareOp depthCompare = VK_COMPARE_OP_LESS;
+    bool blend = false;
+    bool colorWrite = true; // False for depth only passes that keep the color attachments of their render pass.
+    // Enabled when either is non-zero, e.g. for shadow casters.
+    float depthBiasConstant = 0.0f;
+    float depthBiasSlope = 0.0f;
+
+    uint64_t hash() const;
+  };
+
+  // Wraps a VkPipelineCache that is serialized to disk, the file is only used when it was written
+  // by the same device (vendor, device, pipelineCacheUUID) and driver version and its content hash matches.
+  // Also owns shader modules, they're created on first use and shared by every pipeline using the same SPIR-V,
+  // and pipeline variants, which are compiled on worker threads when requested with Skip/Fallback.
+  class purrPipelineCache {
+  public:
+    purrPipelineCache();
+    ~purrPipelineCache();
+
+    void initialize(const char *path);
+    // Writes the cache to disk (if it has a path) and destroys it and all shader modules.
+    void cleanup();
+    bool save();
+
+    VkShaderModule getShaderModule(const char *path);
+    VkShaderModule getShaderModule(const std::vector<char> &code);
+
+    VkPipeline createGraphicsPipeline(const VkGraphicsPipelineCreateInfo &createInfo);
+    VkPipeline createComputePipeline(const VkComputePipelineCreateInfo &createInfo);
+    // Entry point "main" of the shader at path. VK_NULL_HANDLE if the shader can't be loaded, the caller owns the pipeline.
+    VkPipeline createComputePipeline(const std::string &path, VkPipelineLayout layout);
+
+    // Layouts are shared as well, pipelines built from equal states must get the same layout handle.
+    VkPipelineLayout getPipelineLayout(const std::vector<VkDescriptorSetLayout> &setLayouts, const std::vector<VkPushConstantRange> &pushConstants);
+
+    // Returns the key of the variant, compiling it now (Block) or queuing it for the worker threads.
+    uint64_t requestPipeline(const purrGraphicsPipelineState &state, purrPipelineCompileMode mode);
+    // VK_NULL_HANDLE while the variant is still compiling or if it failed. Owned by the cache.
+    VkPipeline getPipeline(uint64_t key);
+    bool isPending(uint64_t key);
+    // Blocks until the worker threads are idle.
+    void waitIdle();
+
+    VkPipelineCache get() const { return mCache; }
+    purrPipelineCacheStats getStats() const { return mStats; }
+
+    static void setContext(PurrfectEngineContext *context);
+
+    static purrPipelineCache *getDefault();
+
+    static void cleanupAll();
+  private:
+    struct Variant {
+      purrGraphicsPipelineState state{};
+      std::vector<VkShaderModule> modules{}; // Resolved when requested, in the order of state.shaders.
+      VkPipeline pipeline = VK_NULL_HANDLE;
+      bool pending = false;
+      bool failed = false;
+    };
+
+    struct ShaderFile {
+      uint64_t hash;     // SPIR-V hash, the key into mShaderModules.
+      int64_t modified;  // Write time when it was read, a newer file is read again.
+    };
+
+    std::vector<char> load();
+    VkShaderModule getShaderModuleLocked(const std::string &path, uint64_t *hash = nullptr);
+    VkShaderModule getShaderModuleLocked(const std::vector<char> &code);
+    VkRenderPass getRenderPass(const purrGraphicsPipelineState &state);
+    VkPipeline compile(const purrGraphicsPipelineState &state, const std::vector<VkShaderModule> &modules);
+    void workerMain();
+    void stopWorkers();
+  private:
+    std::string mPath{};
+    VkPipelineCache mCache = VK_NULL_HANDLE;
+
+    std::unordered_map<std::string, ShaderFile> mShaderPaths{};
+    std::unordered_map<uint64_t, VkShaderModule> mShaderModules{};
+    std::unordered_map<uint64_t, VkRenderPass> mRenderPasses{};
+    std::unordered_map<uint64_t, VkPipelineLayout> mLayouts{};
+    std::unordered_map<uint64_t, Variant*> mVariants{};
+
+    // Guards everything above except mCache, VkPipelineCache is internally synchronized.
+    std::mutex mMutex{};
+    std::condition_variable mQueueCv{};
+    std::condition_variable mIdleCv{};
+    std::deque<uint64_t> mQueue{};
+    std::vector<std::thread> mWorkers{};
+    uint32_t mBusyWorkers = 0;
+    bool mStopping = false;
+
+    purrPipelineCacheStats mStats{};
+  };
+
+}
+
+#endif // PURRENGINE_RENDERER_PIPELINECACHE_HPP_
\ No newline at end of file
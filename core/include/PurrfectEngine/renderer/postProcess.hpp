@@ -0,0 +1,110 @@
+#ifndef   PURRENGINE_RENDERER_POSTPROCESS_HPP_
+#define   PURRENGINE_RENDERER_POSTPROCESS_HPP_
+
+namespace PurrfectEngine {
+
+  enum class purrTonemapper : uint32_t {
+    None,     // Clamped.
+    Reinhard,
+    Aces,     // Narkowicz's fit of the ACES filmic curve.
+  };
+
+  struct purrPostProcessSettings {
+    // Metered from a luminance histogram of the scene, otherwise `exposure` is used as is.
+    bool autoExposure = true;
+    float exposure = 1.0f;
+    float exposureCompensation = 0.0f; // EV, applied on top of both.
+    // log2 luminance range of the histogram, the average is clamped to it.
+    float minLogLuminance = -10.0f;
+    float maxLogLuminance = 4.0f;
+    float adaptationSpeed = 1.5f;      // Per second, the metered luminance moves 1 - e^-speed of the way each second.
+
+    bool bloom = true;
+    uint32_t bloomLevels = 6;          // Half resolution and below, fewer when the target is small.
+    float bloomThreshold = 1.0f;       // Scene brightness (before exposure) where bloom starts.
+    float bloomKnee = 0.5f;            // Soft transition below the threshold, as a fraction of it.
+    float bloomIntensity = 0.05f;
+
+    purrTonemapper tonemapper = purrTonemapper::Aces;
+    // Grading after tonemapping, lift/gamma/gain per channel then saturation and contrast around middle gray.
+    glm::vec3 lift{0.0f};
+    glm::vec3 gamma{1.0f};
+    glm::vec3 gain{1.0f};
+    float saturation = 1.0f;
+    float contrast = 1.0f;
+  };
+
+  struct purrPostProcessStats {
+    float averageLuminance = 0.0f; // Adapted, a few frames old as it's read back from the GPU.
+    float exposure = 0.0f;         // What the composite multiplies the scene with.
+    uint32_t bloomLevels = 0;
+  };
+
+  // HDR post-processing of the scene pipeline's color target, enabled with renderer::setPostProcess.
+  // build() runs in compute before the composite:
+  //  - one kernel reads the scene once, thresholding it into the first (half resolution) bloom level and
+  //    binning its luminance into a 256 bin histogram with shared memory atomics,
+  //  - a single workgroup reduces the histogram to the average luminance and adapts towards it,
+  //  - the bloom chain is downsampled (13 taps) and upsampled (3x3 tent) back to the first level.
+  // Exposure, bloom, tonemapping and grading are applied by the composite itself (shaders/post.frag), which writes
+  // the swapchain image, so the HDR target is never written back or read a second time at full resolution.
+  class purrPostProcess {
+  public:
+    purrPostProcess(purrPostProcessSettings settings = {});
+    ~purrPostProcess();
+
+    void initialize();
+    void cleanup();
+
+    // Records the compute passes into the active command buffer, called by renderer::render. `scene` has to be in
+    // SHADER_READ_ONLY_OPTIMAL, renderExtent is the part of it that was rendered to (see purrPipeline::getRenderExtent).
+    void build(purrTexture *scene, VkExtent2D renderExtent);
+
+    // Set 1 of the composite: bloom (binding 0) and the adapted luminance (binding 1).
+    VkDescriptorSetLayout getCompositeLayout() const;
+    VkDescriptorSet getCompositeSet() const { return mCompositeSet; }
+    // Part of the first bloom level that holds this frame's bloom, in uv.
+    glm::vec2 getBloomScale() const { return mBloomScale; }
+    bool isReady() const { return mCompositeSet != VK_NULL_HANDLE; }
+
+    void setSettings(purrPostProcessSettings settings);
+    purrPostProcessSettings getSettings() const { return mSettings; }
+    purrPostProcessStats getStats() const;
+
+    static void setContext(PurrfectEngineContext *context);
+  private:
+    void createBloom(purrTexture *scene);
+    void destroyBloom();
+  private:
+    purrPostProcessSettings mSettings{};
+    uint64_t mLastBuild = 0;
+
+    fr::frDescriptorLayout *mLayout = nullptr;          // Sampled source, storage destination, exposure buffer.
+    fr::frDescriptorLayout *mCompositeLayout = nullptr;
+    VkPipelineLayout mPipelineLayout = VK_NULL_HANDLE;
+    VkPipeline mDownsamplePipeline = VK_NULL_HANDLE;
+    VkPipeline mExposurePipeline = VK_NULL_HANDLE;
+    VkPipeline mUpsamplePipeline = VK_NULL_HANDLE;
+    VkSampler mSampler = VK_NULL_HANDLE;
+    purrDescriptorAllocator *mDescriptors = nullptr;
+    purrDescriptorTemplate mTemplate{};
+    purrDescriptorTemplate mCompositeTemplate{};
+
+    purrBuffer *mExposure = nullptr; // 256 histogram bins, then the adapted luminance.
+
+    VkImageView mSourceView = VK_NULL_HANDLE; // Scene view the sets were written for.
+    VkExtent2D mSourceSize{};
+    VkExtent2D mBloomSize{};
+    VkImage mBloom = VK_NULL_HANDLE;
+    purrAllocation mBloomAllocation{};
+    VkImageView mBloomView = VK_NULL_HANDLE;
+    std::vector<VkImageView> mMipViews{};
+    std::vector<VkDescriptorSet> mSets{}; // [0] reads the scene, [1 + i] reads the chain and writes level i.
+    VkDescriptorSet mCompositeSet = VK_NULL_HANDLE;
+    glm::vec2 mBloomScale{1.0f};
+    bool mBloomFresh = false; // Still in UNDEFINED layout.
+  };
+
+}
+
+#endif // PURRENGINE_RENDERER_POSTPROCESS_HPP_
\ No newline at end of file
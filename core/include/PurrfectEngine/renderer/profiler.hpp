@@ -0,0 +1,103 @@
+#ifndef   PURRENGINE_RENDERER_PROFILER_HPP_
+#define   PURRENGINE_RENDERER_PROFILER_HPP_
+
+namespace PurrfectEngine {
+
+  struct purrProfileEvent {
+    const char *name; // Must be a string literal (or outlive the profiler), only the pointer is stored.
+    uint64_t startNs;
+    uint64_t endNs;
+    uint32_t thread;
+    bool gpu;
+  };
+
+  // CPU zones are timed with steady_clock, GPU zones with timestamp queries written around passes.
+  // Queries have a range per frame in flight and are read back when that frame slot comes around again,
+  // its fence has signaled by then, so resolving never stalls.
+  class purrProfiler {
+  public:
+    purrProfiler();
+    ~purrProfiler();
+
+    void initialize(uint32_t framesInFlight, uint32_t maxGpuZones = 64);
+    void cleanup();
+
+    void setEnabled(bool enabled) { mEnabled = enabled; }
+    bool isEnabled() const { return mEnabled; }
+
+    // Called by the renderer around each frame's command buffer.
+    void beginFrame(VkCommandBuffer cmdBuf, uint32_t frameIndex);
+    void endFrame(VkCommandBuffer cmdBuf);
+
+    void beginGpuZone(VkCommandBuffer cmdBuf, const char *name);
+    void endGpuZone(VkCommandBuffer cmdBuf);
+
+    void beginCpuZone(const char *name);
+    void endCpuZone();
+
+    // Chrome trace event format, open with chrome://tracing or Perfetto.
+    bool exportChromeTrace(const char *path);
+    void clear();
+
+    const std::vector<purrProfileEvent> &getEvents() const { return mEvents; }
+
+    // GPU time of the most recent resolved frame, which is framesInFlight frames old.
+    // Measured even while the profiler is disabled, 0 until the first frame resolves or without timestamp support.
+    double getGpuFrameMs() const { return mGpuFrameMs; }
+    // Whether the last beginFrame resolved a new getGpuFrameMs(), false when that slot's timestamps weren't available.
+    bool hasNewGpuFrameMs() const { return mNewGpuFrameMs; }
+
+    static void setContext(PurrfectEngineContext *context);
+
+    static purrProfiler *getDefault();
+
+    static void cleanupAll();
+  private:
+    struct GpuZone {
+      const char *name;
+      uint32_t startQuery;
+      uint32_t endQuery;
+    };
+
+    struct FrameQueries {
+      std::vector<GpuZone> zones{};
+      std::vector<uint32_t> open{};
+      uint32_t used = 0;
+      uint64_t submitNs = 0;
+      bool pending = false;
+    };
+
+    void writeZoneBegin(VkCommandBuffer cmdBuf, const char *name);
+    void writeZoneEnd(VkCommandBuffer cmdBuf);
+    void resolve(FrameQueries &frame, uint32_t frameIndex);
+    void addEvent(purrProfileEvent event);
+  private:
+    bool mEnabled = false;
+    VkQueryPool mQueryPool = VK_NULL_HANDLE;
+    uint32_t mQueriesPerFrame = 0;
+    double mTimestampPeriod = 1.0; // ns per tick
+    uint64_t mTimestampMask = ~0ULL;
+
+    std::vector<FrameQueries> mFrames{};
+    uint32_t mFrameIndex = 0;
+    bool mInFrame = false;
+    double mGpuFrameMs = 0.0;
+    bool mNewGpuFrameMs = false;
+
+    std::mutex mMutex{};
+    std::vector<purrProfileEvent> mEvents{};
+  };
+
+  class purrProfileScope {
+  public:
+    purrProfileScope(const char *name) { purrProfiler::getDefault()->beginCpuZone(name); }
+    ~purrProfileScope() { purrProfiler::getDefault()->endCpuZone(); }
+  };
+
+  #define PURR_PROFILE_CONCAT_(a, b) a##b
+  #define PURR_PROFILE_CONCAT(a, b) PURR_PROFILE_CONCAT_(a, b)
+  #define PURR_PROFILE_SCOPE(name) ::PurrfectEngine::purrProfileScope PURR_PROFILE_CONCAT(purrProfileScope_, __LINE__)(name)
+
+}
+
+#endif // PURRENGINE_RENDERER_PROFILER_HPP_
\ No newline at end of file
@@ -0,0 +1,138 @@
+#ifndef   PURRENGINE_RENDERER_RENDERGRAPH_HPP_
+#define   PURRENGINE_RENDERER_RENDERGRAPH_HPP_
+
+namespace PurrfectEngine {
+
+  enum class purrResourceAccess {
+    // Images
+    ColorAttachment,
+    DepthAttachment,
+    DepthRead,
+    SampledFragment,
+    SampledCompute,
+    StorageImageRead,
+    StorageImageWrite,
+    TransferSrc,
+    TransferDst,
+    // Buffers
+    UniformRead,
+    StorageRead,
+    StorageWrite,
+    VertexRead,
+    IndexRead,
+    IndirectRead,
+  };
+
+  // Passes declare what they read and write, the graph orders them, culls the ones nobody needs,
+  // records the pipeline barriers between them and allocates transient targets from purrRenderTargetPool.
+  class purrRenderGraph {
+  public:
+    using Handle = uint32_t;
+    static constexpr Handle InvalidHandle = UINT32_MAX;
+
+    class Builder {
+      friend class purrRenderGraph;
+    public:
+      void read(Handle resource, purrResourceAccess access);
+      // finalLayout is the layout the pass leaves the image in, when it transitions it itself (e.g. render pass finalLayout).
+      void write(Handle resource, purrResourceAccess access, VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED);
+      // Pass has effects outside of the graph (presenting, readback), it's never culled.
+      void sideEffect();
+    private:
+      Builder(purrRenderGraph *graph, uint32_t pass):
+        mGraph(graph), mPass(pass)
+      {}
+
+      purrRenderGraph *mGraph = nullptr;
+      uint32_t mPass = 0;
+    };
+
+    using SetupFn = std::function<void(Builder&)>;
+    using ExecuteFn = std::function<void(VkCommandBuffer)>;
+  public:
+    purrRenderGraph();
+    ~purrRenderGraph();
+
+    Handle importTexture(const char *name, purrTexture *texture, VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED);
+    Handle importImage(const char *name, VkImage image, VkFormat format, VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED);
+    Handle importBuffer(const char *name, VkBuffer buffer, VkDeviceSize size = VK_WHOLE_SIZE);
+    // Lives only between its first and last use, memory is aliased with other transient targets.
+    Handle createTexture(const char *name, purrRenderTargetDesc desc, purrSampler *sampler = nullptr);
+
+    void addPass(const char *name, SetupFn setup, ExecuteFn execute);
+    // Passes that don't (indirectly) contribute to an output or have side effects are culled.
+    void setOutput(Handle resource);
+
+    void compile();
+    void execute(VkCommandBuffer cmdBuf);
+    // Removes all passes and resources.
+    void reset();
+
+    // Only valid while the graph is executing a pass that uses the resource (transient ones) or after import.
+    purrTexture *getTexture(Handle resource) const;
+    VkBuffer getBuffer(Handle resource) const;
+
+    uint32_t getPassCount() const { return static_cast<uint32_t>(mPasses.size()); }
+    uint32_t getCulledPassCount() const { return mCulledCount; }
+    uint32_t getBarrierCount() const { return mBarrierCount; }
+  private:
+    struct Resource {
+      const char *name = nullptr;
+      bool buffer = false;
+      bool transient = false;
+      bool output = false;
+
+      purrRenderTargetDesc desc{};
+      purrSampler *sampler = nullptr;
+      purrTexture *texture = nullptr;
+      VkImage image = VK_NULL_HANDLE;
+      VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+      VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+      VkBuffer vkBuffer = VK_NULL_HANDLE;
+      VkDeviceSize size = VK_WHOLE_SIZE;
+
+      // Computed by compile()
+      int32_t firstPass = -1;
+      int32_t lastPass = -1;
+
+      // Tracked while executing
+      VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+      VkPipelineStageFlags writeStages = 0;
+      VkAccessFlags writeAccess = 0;
+      VkPipelineStageFlags readStages = 0;
+      VkAccessFlags readAccess = 0;
+    };
+
+    struct Access {
+      Handle resource;
+      purrResourceAccess access;
+      VkImageLayout finalLayout;
+      bool write;
+    };
+
+    struct Pass {
+      const char *name = nullptr;
+      ExecuteFn execute{};
+      std::vector<Access> accesses{};
+      std::vector<uint32_t> dependencies{}; // Passes that have to run before this one and produce something it needs.
+      std::vector<uint32_t> after{};        // Passes that have to run before this one (including write-after-read).
+      bool sideEffect = false;
+      bool culled = false;
+    };
+
+    Handle addResource(Resource resource);
+    void recordBarriers(VkCommandBuffer cmdBuf, const Pass &pass);
+  private:
+    std::vector<Resource> mResources{};
+    std::vector<Pass> mPasses{};
+    std::vector<uint32_t> mOrder{};
+    bool mCompiled = false;
+
+    uint32_t mCulledCount = 0;
+    uint32_t mBarrierCount = 0;
+  };
+
+}
+
+#endif // PURRENGINE_RENDERER_RENDERGRAPH_HPP_
\ No newline at end of file
@@ -0,0 +1,97 @@
+#ifndef   PURRENGINE_RENDERER_RENDERTHREAD_HPP_
+#define   PURRENGINE_RENDERER_RENDERTHREAD_HPP_
+
+namespace PurrfectEngine {
+
+  // The camera as one frame sees it, interpolated like the transforms.
+  struct purrRenderCamera {
+    glm::mat4 view{1.0f};
+    glm::mat4 projection{1.0f};
+    glm::vec3 position{0.0f};
+    purrCamera::Settings settings{};
+  };
+
+  // What the renderer needs of one scene object, indexed like the scene's objects and the transforms SSBO.
+  // Meshes and occluder geometry are referenced, not copied, they must not change while a render thread runs.
+  struct purrRenderObject {
+    purrMesh *mesh = nullptr;
+    purrOccluderComp *occluder = nullptr;
+    purrParticleComp *emitter = nullptr;
+    bool isStatic = false;
+    uint32_t uuid = 0; // Of the object, identifies it across snapshots when objects are added or removed.
+  };
+
+  // Everything the renderer and its passes read from the scene in a frame, see renderer::extractSnapshot.
+  struct purrRenderSnapshot {
+    uint64_t frame = 0;                     // Counts extractions.
+    bool hasCamera = false;
+    purrRenderCamera camera{};
+    std::vector<glm::mat4> transforms{};    // Interpolated model matrices, one per object.
+    std::vector<purrRenderObject> objects{};
+    std::vector<purrLight> lights{};        // Every purrLightComp, positions interpolated.
+    uint32_t drawDataSize = 0;              // Of the scene pipeline, drawData has that many bytes per object.
+    std::vector<uint8_t> drawData{};
+
+    // Keeps the capacity, so a snapshot that's reused every frame stops allocating.
+    void clear() {
+      hasCamera = false;
+      camera = {};
+      transforms.clear();
+      objects.clear();
+      lights.clear();
+      drawDataSize = 0;
+      drawData.clear();
+    }
+  };
+
+  struct purrRenderThreadStats {
+    uint64_t submitted = 0;
+    uint64_t rendered = 0;
+    uint64_t dropped = 0;  // Replaced by a newer snapshot before the render thread got to them.
+  };
+
+  // Records and presents frames on a thread of its own, so the simulation of the next frame overlaps with the
+  // rendering of this one. The main thread extracts the scene into a snapshot (submit) and hands it over through
+  // a triple-buffered purrMailbox, the render thread binds the newest one (renderer::setSnapshot) and runs the
+  // frame callback with it. Nothing the render thread reads belongs to the scene, which the main thread is free
+  // to change while a frame renders.
+  // While it runs, the render thread owns the renderer: the main thread only submits, polls events and calls
+  // renderer::shouldClose, everything else waits until stop().
+  class purrRenderThread {
+  public:
+    // Records and presents one frame, typically renderBegin to present. Return false to stop the thread.
+    using FrameCallback = std::function<bool(const purrRenderSnapshot &snapshot)>;
+
+    purrRenderThread();
+    ~purrRenderThread();
+
+    void start(FrameCallback frame);
+    // Waits for the frame being rendered and joins the thread, snapshots that weren't rendered are dropped.
+    void stop();
+
+    // Extracts the scene into the mailbox's free slot and wakes the render thread. With `wait` it then blocks until
+    // the render thread took the previous snapshot, so the simulation is at most one frame ahead. Without it the
+    // previous snapshot is replaced if it's still waiting, which trades dropped frames for lower latency.
+    void submit(purrScene *scene, bool wait = true);
+    // Waits until every submitted snapshot was rendered or dropped.
+    void flush();
+
+    // False once the frame callback returned false or after stop().
+    bool isRunning() const { return mRunning; }
+    purrRenderThreadStats getStats() const;
+  private:
+    void threadMain();
+  private:
+    purrMailbox<purrRenderSnapshot> mMailbox{};
+    FrameCallback mFrame{};
+    std::thread mThread{};
+    mutable std::mutex mMutex{};  // Only to sleep on, the snapshots themselves are handed over lock free.
+    std::condition_variable mCv{};
+    std::atomic<bool> mRunning{false};
+    bool mStopping = false;
+    purrRenderThreadStats mStats{};
+  };
+
+}
+
+#endif // PURRENGINE_RENDERER_RENDERTHREAD_HPP_
\ No newline at end of file
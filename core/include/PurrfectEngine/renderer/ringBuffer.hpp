@@ -0,0 +1,84 @@
+#ifndef   PURRENGINE_RENDERER_RINGBUFFER_HPP_
+#define   PURRENGINE_RENDERER_RINGBUFFER_HPP_
+
+#include <cstring>
+#include <type_traits>
+
+namespace PurrfectEngine {
+
+  // Bytes a per-draw payload may have, it's the range of the dynamic uniform buffer descriptor renderScene binds.
+  #define PURR_MAX_DRAW_DATA 256
+
+  struct purrRingAllocation {
+    void *data = nullptr; // nullptr when the allocation failed.
+    VkBuffer buffer = VK_NULL_HANDLE;
+    uint32_t offset = 0;  // Dynamic offset into buffer.
+    uint32_t block = 0;   // Which of the ring's buffers, descriptor sets are per block.
+  };
+
+  struct purrRingBufferStats {
+    VkDeviceSize used = 0; // Since the last reset, alignment padding included.
+    VkDeviceSize capacity = 0;
+    uint32_t allocations = 0;
+    uint32_t blocks = 0;   // More than one means it overflowed since the last reset.
+  };
+
+  // Persistently mapped bump allocator for data the GPU reads once, meant to be one per frame in flight
+  // (see renderer::getDrawData). Offsets are aligned for dynamic uniform and storage buffer descriptors.
+  // When it runs full another, bigger buffer is added instead of failing. Sets written for the first one
+  // stay valid, the next reset() then replaces all of them with a single buffer big enough for the whole frame.
+  class purrRingBuffer {
+  public:
+    purrRingBuffer();
+    ~purrRingBuffer();
+
+    // bindRange is what a descriptor reads past an offset, every buffer is padded so it stays in bounds.
+    bool initialize(VkDeviceSize capacity, VkBufferUsageFlags usage, VkDeviceSize bindRange = 0);
+    void cleanup();
+
+    // Every allocation becomes invalid, the GPU has to be done with them.
+    void reset();
+
+    purrRingAllocation allocate(VkDeviceSize size);
+
+    template <typename T>
+    purrRingAllocation push(const T &value) {
+      static_assert(std::is_trivially_copyable<T>::value, "Ring buffer data is copied as bytes!");
+      purrRingAllocation allocation = allocate(sizeof(T));
+      if (allocation.data) memcpy(allocation.data, &value, sizeof(T));
+      return allocation;
+    }
+
+    // Uninitialized storage for a T to be written in place.
+    template <typename T>
+    T *allocate(purrRingAllocation *allocation) {
+      static_assert(std::is_trivially_copyable<T>::value, "Ring buffer data is copied as bytes!");
+      *allocation = allocate(sizeof(T));
+      return static_cast<T*>(allocation->data);
+    }
+
+    VkBuffer getBuffer(uint32_t block) const { return mBlocks[block].buffer->get(); }
+    uint32_t getBlockCount() const { return static_cast<uint32_t>(mBlocks.size()); }
+    VkDeviceSize getAlignment() const { return mAlignment; }
+    purrRingBufferStats getStats() const;
+
+    static void setContext(PurrfectEngineContext *context);
+  private:
+    struct Block {
+      purrBuffer *buffer = nullptr;
+      VkDeviceSize capacity = 0;
+      VkDeviceSize head = 0;
+    };
+
+    bool addBlock(VkDeviceSize capacity);
+  private:
+    VkBufferUsageFlags mUsage = 0;
+    VkDeviceSize mBindRange = 0;
+    VkDeviceSize mAlignment = 1;
+    std::vector<Block> mBlocks{};
+    uint32_t mAllocations = 0;
+  };
+
+}
+
+#endif // PURRENGINE_RENDERER_RINGBUFFER_HPP_
\ No newline at end of file
@@ -0,0 +1,115 @@
+#ifndef   PURRENGINE_RENDERER_SHADOWS_HPP_
+#define   PURRENGINE_RENDERER_SHADOWS_HPP_
+
+namespace PurrfectEngine {
+
+  #define PURR_MAX_SHADOW_CASCADES 4
+
+  struct purrShadowSettings {
+    uint32_t cascadeCount = 4;       // At most PURR_MAX_SHADOW_CASCADES.
+    uint32_t resolution = 2048;      // Per cascade, cascades are tiles of one depth atlas.
+    float maxDistance = 50.0f;       // Shadows end here, or at the camera's far plane if that's closer.
+    float splitLambda = 0.75f;       // Blend between uniform (0) and logarithmic (1) splits.
+    // Cascades cover this fraction more than their frustum slice. The camera can move that far before
+    // a cascade is re-centered, which is the only time its cached static casters are re-rendered.
+    float padding = 0.15f;
+    float casterDistance = 50.0f;    // How far past a cascade towards the light casters are still rendered.
+    float depthBiasConstant = 1.25f;
+    float depthBiasSlope = 1.75f;
+  };
+
+  struct purrShadowCascade {
+    glm::mat4 viewProjection{1.0f};
+    float splitDepth = 0.0f; // View depth where the cascade ends.
+    float texelSize = 0.0f;  // World units per shadow map texel.
+    float radius = 0.0f;     // Half the side of the cascade, padding included.
+    bool staticDirty = true; // Static casters get re-rendered by the next render().
+  };
+
+  struct purrShadowStats {
+    uint32_t staticCascades = 0; // Cascades whose static casters were re-rendered.
+    uint32_t staticDraws = 0;
+    uint32_t dynamicDraws = 0;
+    uint32_t culledDraws = 0;    // Caster/cascade pairs skipped because the caster's bounds miss the cascade.
+  };
+
+  // Directional light shadows in up to four cascades, packed into one depth atlas.
+  // Static objects (purrObject::setStatic) are rendered into an atlas of their own that is only touched for cascades
+  // that were re-centered or when a static object changed. Every frame that atlas is copied into the sampled one and
+  // the dynamic casters are drawn on top, so the steady state cost is one copy plus the dynamic casters.
+  class purrCascadedShadows {
+  public:
+    purrCascadedShadows(purrShadowSettings settings = {});
+    ~purrCascadedShadows();
+
+    void initialize();
+    void cleanup();
+
+    // Fits the cascades to the camera's frustum. Projections are built from bounding spheres and snapped to whole
+    // texels, so rotating or moving the camera doesn't make the shadow edges crawl.
+    void update(const purrRenderCamera &camera, glm::vec3 lightDirection);
+    // Moved, added or removed static objects are picked up by update(), this is for changes it can't see.
+    void invalidateStatic();
+    // Records the shadow passes into the active command buffer for the casters update() found.
+    // Draws with this frame's transforms, so it goes after renderer::updateTransforms.
+    void render();
+
+    purrTexture *getShadowMap() const { return mShadowMap; }
+    const std::vector<purrShadowCascade> &getCascades() const { return mCascades; }
+    glm::vec3 getLightDirection() const { return mLightDirection; }
+    // Cascades per atlas row and the atlas size in texels.
+    uint32_t getAtlasColumns() const { return mColumns; }
+    glm::uvec2 getAtlasSize() const;
+    purrShadowSettings getSettings() const { return mSettings; }
+    purrShadowStats getStats() const { return mStats; }
+
+    static void setContext(PurrfectEngineContext *context);
+  private:
+    struct CascadeBounds {
+      glm::vec3 anchor;      // Unsnapped world center at the last re-centering.
+      glm::vec3 lightCenter; // Snapped center in light view space.
+      float zMin, zMax;      // Light view depth range, casters included.
+      bool valid;
+    };
+
+    struct Caster {
+      uint32_t index; // Into the scene's objects, which is the transforms SSBO index.
+      purrMesh *mesh;
+      glm::vec3 center;
+      float radius;
+      bool isStatic;
+    };
+
+    void gatherCasters();
+    bool overlaps(const Caster &caster, uint32_t cascade) const;
+    void drawCasters(VkCommandBuffer cmdBuf, uint32_t cascade, bool isStatic);
+    VkRect2D getTile(uint32_t cascade) const;
+  private:
+    purrShadowSettings mSettings{};
+    uint32_t mColumns = 1, mRows = 1;
+    VkFormat mFormat = VK_FORMAT_UNDEFINED;
+
+    std::vector<purrShadowCascade> mCascades{};
+    std::vector<CascadeBounds> mBounds{};
+    glm::vec3 mLightDirection{0.0f, -1.0f, 0.0f};
+    glm::mat4 mLightView{1.0f};
+    bool mLightViewValid = false; // The first update() builds the view whatever the direction.
+    uint64_t mStaticHash = 0;
+    bool mStaticInitialized = false;
+
+    std::vector<Caster> mCasters{};
+    purrShadowStats mStats{};
+
+    purrTexture *mStaticMap = nullptr;
+    purrTexture *mShadowMap = nullptr;
+    fr::frRenderPass *mStaticPass = nullptr;
+    fr::frRenderPass *mDynamicPass = nullptr;
+    fr::frFramebuffer *mStaticFramebuffer = nullptr;
+    fr::frFramebuffer *mDynamicFramebuffer = nullptr;
+    VkPipelineLayout mLayout = VK_NULL_HANDLE;
+    uint64_t mPipelineKey = 0;
+  };
+
+}
+
+#endif // PURRENGINE_RENDERER_SHADOWS_HPP_
\ No newline at end of file
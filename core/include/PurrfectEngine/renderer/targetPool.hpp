@@ -0,0 +1,90 @@
+#ifndef   PURRENGINE_RENDERER_TARGETPOOL_HPP_
+#define   PURRENGINE_RENDERER_TARGETPOOL_HPP_
+
+namespace PurrfectEngine {
+
+  struct purrRenderTargetDesc {
+    int width;
+    int height;
+    VkFormat format;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    bool transient = false; // Contents never leave the render pass (depth, MSAA). Gets TRANSIENT_ATTACHMENT usage and LAZILY_ALLOCATED memory if the device has it.
+
+    bool operator==(const purrRenderTargetDesc &other) const {
+      return width == other.width && height == other.height && format == other.format &&
+             samples == other.samples && usage == other.usage && transient == other.transient;
+    }
+  };
+
+  struct purrRenderTargetStats {
+    VkDeviceSize allocatedBytes = 0; // Device memory currently held by the pool.
+    VkDeviceSize peakBytes = 0;      // Highest allocatedBytes seen.
+    VkDeviceSize requestedBytes = 0; // Memory that the live targets would take without aliasing.
+    uint32_t targetCount = 0;
+    uint32_t blockCount = 0;
+  };
+
+  // Recycles render targets keyed by (extent, format, samples, usage).
+  // Released targets give their memory back, targets acquired later may alias it,
+  // so attachments whose lifetimes don't overlap share the same VkDeviceMemory.
+  // WARNING: Contents of a released target are lost, render passes must not load them.
+  class purrRenderTargetPool {
+  public:
+    purrRenderTargetPool();
+    ~purrRenderTargetPool();
+
+    purrTexture *acquire(purrRenderTargetDesc desc, purrSampler *sampler = nullptr);
+    // `stages` and `access` are the last GPU use of the target, whoever aliases its memory next has to wait for them.
+    void release(purrTexture *target, VkPipelineStageFlags stages = 0, VkAccessFlags access = 0);
+    // What the previous user of the target's memory left behind, see release.
+    void getAliasHazard(purrTexture *target, VkPipelineStageFlags *stages, VkAccessFlags *access) const;
+
+    // Destroys targets and memory that weren't used for the last `maxIdleFrames` frames, which have to be more than
+    // PurrfectEngineSettings::framesInFlight.
+    void trim(uint32_t maxIdleFrames);
+    void nextFrame();
+    void cleanup();
+
+    purrRenderTargetStats getStats() const;
+
+    static void setContext(PurrfectEngineContext *context);
+
+    static purrRenderTargetPool *getDefault();
+
+    static void cleanupAll();
+  private:
+    struct Block {
+      purrAllocation allocation{};
+      VkDeviceSize size = 0;
+      uint32_t memoryType = 0;
+      bool inUse = false;
+      uint64_t lastUsed = 0;
+      VkPipelineStageFlags stages = 0; // Last use, from release.
+      VkAccessFlags access = 0;
+    };
+
+    struct Entry {
+      purrRenderTargetDesc desc{};
+      purrTexture *texture = nullptr;
+      VkImage image = VK_NULL_HANDLE;
+      VkDeviceSize size = 0;
+      Block *block = nullptr;
+      bool inUse = false;
+      uint64_t lastUsed = 0;
+    };
+
+    Block *findBlock(VkMemoryRequirements requirements, uint32_t memoryType);
+    void destroyEntry(Entry *entry);
+  private:
+    std::vector<Entry*> mEntries{};
+    std::vector<Block*> mBlocks{};
+
+    uint64_t mFrame = 0;
+    VkDeviceSize mAllocatedBytes = 0;
+    VkDeviceSize mPeakBytes = 0;
+  };
+
+}
+
+#endif // PURRENGINE_RENDERER_TARGETPOOL_HPP_
\ No newline at end of file
@@ -21,12 +21,15 @@ namespace PurrfectEngine {
 
   class purrTexture {
     friend class purrPipeline;
+    friend class purrRenderTargetPool;
   public:
     purrTexture(int width, int height, VkFormat format);
     ~purrTexture();
 
-    // if (!sampler) mDescriptor = nullptr;
+    // if (!sampler) mDescriptor = VK_NULL_HANDLE;
     void initialize(purrSampler *sampler = purrSampler::getDefault(), bool mipmaps = true, bool color = true);
+    // Wraps an image owned by someone else (e.g. purrRenderTargetPool), only the view and descriptor are owned by the texture.
+    void initialize(VkImage image, VkImageUsageFlags usage, purrSampler *sampler = nullptr, bool color = true);
     void cleanup();
     void resize(int width, int height);
 
@@ -37,17 +40,29 @@ namespace PurrfectEngine {
   public:
     fr::frImage *getImage() const { return mImage; }
 
-    fr::frDescriptor *getDescriptor() const { return mDescriptor; }
+    // Allocated from purrDescriptorAllocator::getDefault(), VK_NULL_HANDLE without a sampler.
+    VkDescriptorSet getDescriptor() const { return mDescriptor; }
+
+    int getWidth() const { return mWidth; }
+    int getHeight() const { return mHeight; }
+    VkFormat getFormat() const { return mFormat; }
+    VkSampleCountFlagBits getSampleCount() const { return mSampleCount; }
+  private:
+    void setSampler(purrSampler *sampler);
   private:
     int mWidth = 0, mHeight = 0;
     VkFormat mFormat = VK_FORMAT_UNDEFINED;
     bool mMipmaps = true;
     bool mColor = true;
     VkSampleCountFlagBits mSampleCount = VK_SAMPLE_COUNT_1_BIT;
+    bool mPooled = false;
 
     fr::frImage *mImage = nullptr;
+    // Set when the texture created its image itself, wrapped images belong to someone else.
+    VkImage mOwnedImage = VK_NULL_HANDLE;
+    purrAllocation mAllocation{};
     purrSampler *mSampler = nullptr;
-    fr::frDescriptor *mDescriptor = nullptr;
+    VkDescriptorSet mDescriptor = VK_NULL_HANDLE;
   };
 
 }
@@ -23,7 +23,7 @@ namespace PurrfectEngine {
 
     purrObject *newObject();
   public:
-    std::vector<purrObject*> getObjects() const { return mObjects; }
+    const std::vector<purrObject*> &getObjects() const { return mObjects; }
   private:
     PUID mUuid{};
     std::vector<PUID> mUuids{};
@@ -8,6 +8,7 @@ namespace PurrfectEngine {
 
   class purrTransform {
   public:
+    PURR_POOLED
     purrTransform(glm::vec3 position = glm::vec3(0.0f), glm::quat rotation = glm::quat(), glm::vec3 scale = glm::vec3(1.0f));
     purrTransform(glm::mat4 transform);
     ~purrTransform();
@@ -29,9 +30,22 @@ namespace PurrfectEngine {
     glm::vec3   getScale()    const { return mScale; }
 
     glm::mat4 getTransform() { update(); return mTransform; }
+  public:
+    // Fixed timestep interpolation (see purrMainLoop): keeps the state before a simulation step, rendering blends
+    // from it to the current one. Call it after teleporting an object too, so it doesn't smear across the jump.
+    void savePrevious() { mPrevPos = mPos; mPrevRot = mRot; mPrevScale = mScale; }
+
+    glm::vec3 getInterpolatedPosition(float alpha) const;
+    glm::quat getInterpolatedRotation(float alpha) const;
+    // alpha = 0 is the previous state, 1 the current one.
+    glm::mat4 getInterpolated(float alpha) const;
+  private:
+    static glm::mat4 compose(glm::vec3 position, glm::quat rotation, glm::vec3 scale);
   private:
     glm::vec3 mPos = glm::vec3(), mScale = glm::vec3();
     glm::quat mRot = glm::quat();
+    glm::vec3 mPrevPos = glm::vec3(), mPrevScale = glm::vec3();
+    glm::quat mPrevRot = glm::quat();
 
     glm::mat4 mTransform = glm::mat4();
   };
@@ -0,0 +1,52 @@
+#ifndef   PURRENGINE_WORKERS_HPP_
+#define   PURRENGINE_WORKERS_HPP_
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+namespace PurrfectEngine {
+
+  // A fixed set of threads that split loops with the calling thread, for per-frame work like culling and sorting.
+  class purrWorkerPool {
+  public:
+    // Workers besides the calling thread, 0 uses hardware_concurrency - 1. They're started on first use.
+    purrWorkerPool(uint32_t threads = 0);
+    ~purrWorkerPool();
+
+    // Runs job(0..count-1) on the workers and the calling thread, returns when all are done.
+    // Jobs are handed out one index at a time, a job must not call parallelFor on the same pool.
+    // Calls from different threads (a render thread and the main thread) take turns.
+    void parallelFor(uint32_t count, const std::function<void(uint32_t)> &job);
+    // Workers plus the calling thread.
+    uint32_t getConcurrency() const;
+
+    // Shared by everything that isn't given a pool of its own.
+    static purrWorkerPool *getDefault();
+
+    static void cleanupAll();
+  private:
+    void start();
+    void stop();
+    void runJobs();
+    void workerMain(uint32_t generation);
+  private:
+    uint32_t mThreadCount = 0;
+    std::vector<std::thread> mWorkers{};
+    std::mutex mCallMutex{};
+    std::mutex mMutex{};
+    std::condition_variable mWorkCv{};
+    std::condition_variable mDoneCv{};
+    const std::function<void(uint32_t)> *mJob = nullptr;
+    uint32_t mJobCount = 0;
+    std::atomic<uint32_t> mNextJob{0};
+    uint32_t mGeneration = 0;
+    uint32_t mBusyWorkers = 0;
+    bool mStopping = false;
+  };
+
+}
+
+#endif // PURRENGINE_WORKERS_HPP_
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+#include <mutex>
+
+namespace PurrfectEngine {
+
+  #define POOL_GRANULARITY 16
+  #define POOL_MAX_SIZE 512
+  #define POOL_CLASS_COUNT (POOL_MAX_SIZE / POOL_GRANULARITY)
+
+  static size_t alignUp(size_t value, size_t align) {
+    return (value + align - 1) & ~(align - 1);
+  }
+
+  purrFixedPool::purrFixedPool(size_t slotSize, size_t slotAlign, uint32_t slotsPerChunk):
+    mSlotAlign(std::max(slotAlign, alignof(FreeSlot))), mSlotsPerChunk(std::max(slotsPerChunk, 1u))
+  {
+    // Free slots hold the list link.
+    mSlotSize = alignUp(std::max(slotSize, sizeof(FreeSlot)), mSlotAlign);
+  }
+
+  purrFixedPool::~purrFixedPool() {
+    for (void *chunk: mChunks) ::operator delete(chunk, std::align_val_t(mSlotAlign));
+  }
+
+  void *purrFixedPool::allocate() {
+    if (!mFree) grow();
+    FreeSlot *slot = mFree;
+    mFree = slot->next;
+    ++mStats.live;
+    return slot;
+  }
+
+  void purrFixedPool::free(void *ptr) {
+    if (!ptr) return;
+    FreeSlot *slot = static_cast<FreeSlot*>(ptr);
+    slot->next = mFree;
+    mFree = slot;
+    --mStats.live;
+  }
+
+  void purrFixedPool::grow() {
+    uint8_t *chunk = static_cast<uint8_t*>(::operator new(mSlotSize * mSlotsPerChunk, std::align_val_t(mSlotAlign)));
+    mChunks.push_back(chunk);
+    // Linked back to front, so slots are handed out in address order.
+    for (uint32_t i = mSlotsPerChunk; i-- > 0;) {
+      FreeSlot *slot = reinterpret_cast<FreeSlot*>(chunk + i * mSlotSize);
+      slot->next = mFree;
+      mFree = slot;
+    }
+    mStats.capacity += mSlotsPerChunk;
+    ++mStats.chunks;
+  }
+
+  // Never destroyed, objects deleted by static destructors still find their pool.
+  static std::mutex *sPoolMutex = new std::mutex();
+  static purrFixedPool *sPools[POOL_CLASS_COUNT] = {};
+  static uint32_t sHeapAllocations = 0;
+
+  void *purrObjectPools::allocate(size_t size) {
+    if (size == 0) size = 1;
+    if (size > POOL_MAX_SIZE) {
+      std::lock_guard<std::mutex> lock(*sPoolMutex);
+      ++sHeapAllocations;
+      return ::operator new(size);
+    }
+    size_t index = (size - 1) / POOL_GRANULARITY;
+    std::lock_guard<std::mutex> lock(*sPoolMutex);
+    if (!sPools[index]) sPools[index] = new purrFixedPool((index + 1) * POOL_GRANULARITY, POOL_GRANULARITY);
+    return sPools[index]->allocate();
+  }
+
+  void purrObjectPools::free(void *ptr, size_t size) {
+    if (!ptr) return;
+    if (size == 0) size = 1;
+    if (size > POOL_MAX_SIZE) {
+      std::lock_guard<std::mutex> lock(*sPoolMutex);
+      --sHeapAllocations;
+      ::operator delete(ptr);
+      return;
+    }
+    std::lock_guard<std::mutex> lock(*sPoolMutex);
+    sPools[(size - 1) / POOL_GRANULARITY]->free(ptr);
+  }
+
+  purrPoolStats purrObjectPools::getStats() {
+    std::lock_guard<std::mutex> lock(*sPoolMutex);
+    purrPoolStats stats{};
+    for (purrFixedPool *pool: sPools) {
+      if (!pool) continue;
+      purrPoolStats poolStats = pool->getStats();
+      stats.live += poolStats.live;
+      stats.capacity += poolStats.capacity;
+      stats.chunks += poolStats.chunks;
+    }
+    stats.heapAllocations = sHeapAllocations;
+    return stats;
+  }
+
+  purrFrameArena::purrFrameArena(size_t blockSize):
+    mBlockSize(std::max<size_t>(blockSize, 1024))
+  {}
+
+  purrFrameArena::~purrFrameArena() {
+    for (Block &block: mBlocks) ::operator delete(block.data);
+  }
+
+  void *purrFrameArena::allocate(size_t size, size_t align) {
+    if (size == 0) size = 1;
+    while (mBlock < mBlocks.size()) {
+      Block &block = mBlocks[mBlock];
+      uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+      size_t offset = alignUp(base + mOffset, align) - base;
+      if (offset + size <= block.size) {
+        mOffset = offset + size;
+        mUsed += size;
+        return block.data + offset;
+      }
+      ++mBlock;
+      mOffset = 0;
+    }
+    addBlock(size + align);
+    return allocate(size, align);
+  }
+
+  void purrFrameArena::reset() {
+    mPeak = std::max(mPeak, mUsed);
+    if (mBlocks.size() > 1) {
+      // The frame spilled into more blocks, next frame gets one that holds all of it.
+      size_t total = 0;
+      for (Block &block: mBlocks) {
+        total += block.size;
+        ::operator delete(block.data);
+      }
+      mBlocks.clear();
+      addBlock(total);
+    }
+    mBlock = 0;
+    mOffset = 0;
+    mUsed = 0;
+  }
+
+  purrArenaStats purrFrameArena::getStats() const {
+    purrArenaStats stats{};
+    stats.used = mUsed;
+    stats.peak = std::max(mPeak, mUsed);
+    for (const Block &block: mBlocks) stats.capacity += block.size;
+    stats.blocks = static_cast<uint32_t>(mBlocks.size());
+    return stats;
+  }
+
+  void purrFrameArena::addBlock(size_t minSize) {
+    size_t size = std::max(mBlockSize, minSize);
+    mBlocks.push_back(Block{ static_cast<uint8_t*>(::operator new(size)), size });
+  }
+
+}
\ No newline at end of file
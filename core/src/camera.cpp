@@ -18,4 +18,10 @@ namespace PurrfectEngine {
     return glm::lookAt(mTransform->getPosition(), mTransform->getPosition() + mTransform->getForward(), glm::vec3(0.0f, -1.0f, 0.0f)); // TODO: Maybe let user to choose up direction?
   }
 
+  glm::mat4 purrCamera::getInterpolatedView(float alpha) {
+    glm::vec3 position = mTransform->getInterpolatedPosition(alpha);
+    glm::vec3 forward = mTransform->getInterpolatedRotation(alpha) * glm::vec3(0.0f, 0.0f, 1.0f);
+    return glm::lookAt(position, position + forward, glm::vec3(0.0f, -1.0f, 0.0f));
+  }
+
 }
\ No newline at end of file
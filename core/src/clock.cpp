@@ -0,0 +1,34 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+#include <chrono>
+#include <thread>
+
+namespace PurrfectEngine {
+
+  static purrClock *sDefaultClock = nullptr;
+
+  purrClock *purrClock::getDefault() {
+    if (!sDefaultClock) sDefaultClock = new purrSystemClock();
+    return sDefaultClock;
+  }
+
+  void purrClock::cleanupAll() {
+    if (sDefaultClock) delete sDefaultClock;
+    sDefaultClock = nullptr;
+  }
+
+  purrSystemClock::purrSystemClock(uint64_t spinNs):
+    mSpinNs(spinNs)
+  {}
+
+  uint64_t purrSystemClock::now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+  }
+
+  void purrSystemClock::sleepUntil(uint64_t ns) {
+    uint64_t current = now();
+    if (ns > current + mSpinNs) std::this_thread::sleep_for(std::chrono::nanoseconds(ns - current - mSpinNs));
+    while (now() < ns) std::this_thread::yield();
+  }
+
+}
\ No newline at end of file
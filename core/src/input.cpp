@@ -2,14 +2,156 @@
 
 namespace PurrfectEngine {
 
+  // Events between two Update()s, a few seconds of fast mouse movement.
+  #define INPUT_QUEUE_SIZE 4096
+
   static PurrfectEngineContext *sContext = nullptr;
 
+  static purrSpscQueue<Input::Event, INPUT_QUEUE_SIZE> sEvents{};
+  static std::atomic<uint64_t> sDroppedEvents{0};
+  static std::atomic<bool> sCallbacksInstalled{false};
+  static GLFWkeyfun sPrevKeyCallback = nullptr;
+  static GLFWmousebuttonfun sPrevMouseButtonCallback = nullptr;
+  static GLFWcursorposfun sPrevCursorPosCallback = nullptr;
+  static GLFWscrollfun sPrevScrollCallback = nullptr;
+  // Only replaced as a whole (atomic_store), a published snapshot is never written again.
+  static std::shared_ptr<const Input::Snapshot> sSnapshot = std::make_shared<const Input::Snapshot>();
+
+  static void pushEvent(Input::EventType type, int code, int mods, glm::vec2 value) {
+    Input::Event event{ type, static_cast<Input::KeyCode>(code), mods, value, purrClock::getDefault()->now() };
+    if (!sEvents.push(event)) ++sDroppedEvents;
+  }
+
+  static void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods) {
+    if (sPrevKeyCallback) sPrevKeyCallback(window, key, scancode, action, mods);
+    // Repeats don't change the state, unknown keys are -1.
+    if (action == GLFW_REPEAT || key < 0 || key >= static_cast<int>(Input::KeyCount)) return;
+    pushEvent(action == GLFW_PRESS ? Input::EventType::KeyPressed : Input::EventType::KeyReleased, key, mods, glm::vec2(0.0f));
+  }
+
+  static void mouseButtonCallback(GLFWwindow *window, int button, int action, int mods) {
+    if (sPrevMouseButtonCallback) sPrevMouseButtonCallback(window, button, action, mods);
+    if (button < 0 || button >= static_cast<int>(Input::MouseButtonCount)) return;
+    pushEvent(action == GLFW_PRESS ? Input::EventType::MousePressed : Input::EventType::MouseReleased, button, mods, glm::vec2(0.0f));
+  }
+
+  static void cursorPosCallback(GLFWwindow *window, double x, double y) {
+    if (sPrevCursorPosCallback) sPrevCursorPosCallback(window, x, y);
+    pushEvent(Input::EventType::MouseMoved, 0, 0, glm::vec2(x, y));
+  }
+
+  static void scrollCallback(GLFWwindow *window, double x, double y) {
+    if (sPrevScrollCallback) sPrevScrollCallback(window, x, y);
+    pushEvent(Input::EventType::MouseScrolled, 0, 0, glm::vec2(x, y));
+  }
+
+  static void installCallbacks() {
+    GLFWwindow *window = sContext->frWindow->get();
+    sPrevKeyCallback = glfwSetKeyCallback(window, keyCallback);
+    sPrevMouseButtonCallback = glfwSetMouseButtonCallback(window, mouseButtonCallback);
+    sPrevCursorPosCallback = glfwSetCursorPosCallback(window, cursorPosCallback);
+    sPrevScrollCallback = glfwSetScrollCallback(window, scrollCallback);
+    sCallbacksInstalled = true;
+
+    // Keys held down before this are only seen once they're released, the cursor starts where it is.
+    std::shared_ptr<Input::Snapshot> snapshot = std::make_shared<Input::Snapshot>();
+    snapshot->time = purrClock::getDefault()->now();
+    double x = 0.0, y = 0.0;
+    glfwGetCursorPos(window, &x, &y);
+    snapshot->mousePos = glm::vec2(x, y);
+    std::atomic_store(&sSnapshot, std::shared_ptr<const Input::Snapshot>(snapshot));
+  }
+
   void Input::setContext(PurrfectEngineContext *context) {
     sContext = context;
   }
 
+  bool Input::Snapshot::IsKeyDownAt(KeyCode key, uint64_t at) const {
+    if (key >= KeyCount) return false;
+    if (at >= time) return keysDown[key];
+    bool down = keysDownAtStart[key];
+    for (const Event &event: events) {
+      if (event.time > at) break;
+      if (event.code != key) continue;
+      if (event.type == EventType::KeyPressed) down = true;
+      else if (event.type == EventType::KeyReleased) down = false;
+    }
+    return down;
+  }
+
+  bool Input::Snapshot::IsMouseDownAt(MouseCode btn, uint64_t at) const {
+    if (btn >= MouseButtonCount) return false;
+    if (at >= time) return buttonsDown[btn];
+    bool down = buttonsDownAtStart[btn];
+    for (const Event &event: events) {
+      if (event.time > at) break;
+      if (event.code != btn) continue;
+      if (event.type == EventType::MousePressed) down = true;
+      else if (event.type == EventType::MouseReleased) down = false;
+    }
+    return down;
+  }
+
+  void Input::Update() {
+    if (!sCallbacksInstalled) {
+      if (!sContext || !sContext->frWindow) return;
+      installCallbacks();
+    }
+
+    std::shared_ptr<const Snapshot> previous = GetSnapshot();
+    std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+    snapshot->frame = previous->frame + 1;
+    snapshot->startTime = previous->time;
+    snapshot->keysDown = snapshot->keysDownAtStart = previous->keysDown;
+    snapshot->buttonsDown = snapshot->buttonsDownAtStart = previous->buttonsDown;
+    snapshot->mousePos = previous->mousePos;
+
+    Event event{};
+    while (sEvents.pop(&event)) {
+      switch (event.type) {
+      case EventType::KeyPressed:
+        snapshot->keysDown.set(event.code);
+        snapshot->keysPressed.set(event.code);
+        break;
+      case EventType::KeyReleased:
+        snapshot->keysDown.reset(event.code);
+        snapshot->keysReleased.set(event.code);
+        break;
+      case EventType::MousePressed:
+        snapshot->buttonsDown.set(event.code);
+        snapshot->buttonsPressed.set(event.code);
+        break;
+      case EventType::MouseReleased:
+        snapshot->buttonsDown.reset(event.code);
+        snapshot->buttonsReleased.set(event.code);
+        break;
+      case EventType::MouseMoved:
+        snapshot->mouseDelta += event.value - snapshot->mousePos;
+        snapshot->mousePos = event.value;
+        break;
+      case EventType::MouseScrolled:
+        snapshot->scroll += event.value;
+        break;
+      }
+      snapshot->events.push_back(event);
+    }
+    // After draining, so every event is at or before it.
+    snapshot->time = purrClock::getDefault()->now();
+    std::atomic_store(&sSnapshot, std::shared_ptr<const Snapshot>(snapshot));
+  }
+
+  std::shared_ptr<const Input::Snapshot> Input::GetSnapshot() {
+    return std::atomic_load(&sSnapshot);
+  }
+
+  uint64_t Input::GetDroppedEvents() {
+    return sDroppedEvents;
+  }
+
+  // Until Update() is first called there's no snapshot, the queries poll GLFW like they always did.
   bool Input::IsKeyDown(KeyCode key) {
-    return glfwGetKey(sContext->frWindow->get(), static_cast<int32_t>(key)) == GLFW_PRESS;
+    if (!sCallbacksInstalled) return glfwGetKey(sContext->frWindow->get(), static_cast<int32_t>(key)) == GLFW_PRESS;
+    return GetSnapshot()->IsKeyDown(key);
   }
 
   bool Input::IsKeyUp(KeyCode key) {
@@ -17,10 +159,12 @@ namespace PurrfectEngine {
   }
   
   bool Input::IsMouseDown(MouseCode btn) {
-    return glfwGetMouseButton(sContext->frWindow->get(), static_cast<int32_t>(btn)) == GLFW_PRESS;
+    if (!sCallbacksInstalled) return glfwGetMouseButton(sContext->frWindow->get(), static_cast<int32_t>(btn)) == GLFW_PRESS;
+    return GetSnapshot()->IsMouseDown(btn);
   }
   
   glm::vec2 Input::GetMousePos() {
+    if (sCallbacksInstalled) return GetSnapshot()->mousePos;
     glm::dvec2 mouse{};
     glfwGetCursorPos(sContext->frWindow->get(), &mouse.x, &mouse.y);
     return {mouse.x,mouse.y};
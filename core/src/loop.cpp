@@ -0,0 +1,64 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace PurrfectEngine {
+
+  purrMainLoop::purrMainLoop(purrMainLoopSettings settings, purrClock *clock):
+    mSettings(settings), mClock(clock ? clock : purrClock::getDefault())
+  {
+    mTickNs = static_cast<uint64_t>(std::llround(1e9 / std::max(mSettings.tickRate, 1e-3)));
+    mSettings.maxStepsPerFrame = std::max(mSettings.maxStepsPerFrame, 1u);
+    mSettings.maxBacklogSteps = std::max(mSettings.maxBacklogSteps, mSettings.maxStepsPerFrame);
+  }
+
+  float purrMainLoop::advance(purrScene *scene, const TickCallback &tick) {
+    uint64_t now = mClock->now();
+    mFrameNs = mStarted ? now - mLastNs : 0;
+    mLastNs = now;
+    mStarted = true;
+    mAccumulatorNs += std::min(mFrameNs, static_cast<uint64_t>(mSettings.maxFrameSeconds * 1e9));
+
+    uint64_t due = mAccumulatorNs / mTickNs;
+    if (due > mSettings.maxBacklogSteps) {
+      uint64_t dropped = due - mSettings.maxBacklogSteps;
+      mAccumulatorNs -= dropped * mTickNs;
+      mStats.droppedSteps += dropped;
+      due = mSettings.maxBacklogSteps;
+    }
+
+    uint32_t steps = static_cast<uint32_t>(std::min<uint64_t>(due, mSettings.maxStepsPerFrame));
+    double dt = getTickSeconds();
+    for (uint32_t i = 0; i < steps; ++i) {
+      if (scene) for (purrObject *object: scene->getObjects()) object->getTransform()->savePrevious();
+      mAccumulatorNs -= mTickNs;
+      mTickTimeNs = now - std::min(now, mAccumulatorNs);
+      if (tick) tick(dt);
+      ++mStats.ticks;
+    }
+
+    // Still behind, the newest state is as far as it can be shown.
+    mStats.backlog = static_cast<uint32_t>(due - steps);
+    mStats.alpha = mStats.backlog ? 1.0f : static_cast<float>(static_cast<double>(mAccumulatorNs) / mTickNs);
+    mStats.lastSteps = steps;
+    mStats.maxSteps = std::max(mStats.maxSteps, steps);
+    ++mStats.frames;
+    renderer::setInterpolation(mStats.alpha);
+    return mStats.alpha;
+  }
+
+  void purrMainLoop::run(purrScene *scene, const TickCallback &tick, const FrameCallback &frame) {
+    while (!renderer::shouldClose()) {
+      float alpha = advance(scene, tick);
+      if (!frame(alpha, getFrameSeconds())) break;
+    }
+  }
+
+  void purrMainLoop::reset() {
+    mStarted = false;
+    mAccumulatorNs = 0;
+    mFrameNs = 0;
+  }
+
+}
\ No newline at end of file
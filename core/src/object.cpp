@@ -15,8 +15,8 @@ namespace PurrfectEngine {
   purrComponent::purrComponent()
   {}
 
-  purrMeshComp::purrMeshComp(purrMesh *mesh):
-    mMesh(mesh)
+  purrMeshComp::purrMeshComp(purrMesh *mesh, bool ownsMesh):
+    mOwnsMesh(ownsMesh), mMesh(mesh)
   { assert(mesh); }
 
   // purrMeshComp::purrMeshComp(purrMesh2D *mesh):
@@ -36,7 +36,7 @@ namespace PurrfectEngine {
   }
 
   purrMeshComp::~purrMeshComp() {
-    if (mMesh) delete mMesh;
+    if (mMesh && mOwnsMesh) delete mMesh;
     // if (mMesh2D) delete mMesh2D;
   }
   
@@ -48,8 +48,35 @@ namespace PurrfectEngine {
     delete mCamera;
   }
 
+  purrLightComp::purrLightComp(glm::vec3 color, float intensity, float radius):
+    mColor(color), mIntensity(intensity), mRadius(radius)
+  {}
+
+  purrLightComp::~purrLightComp()
+  {}
+
+  purrOccluderComp::purrOccluderComp(std::vector<glm::vec3> positions, std::vector<uint32_t> indices):
+    mPositions(positions), mIndices(indices)
+  {}
+
+  purrOccluderComp::~purrOccluderComp()
+  {}
+
+  purrOccluderComp *purrOccluderComp::box(glm::vec3 min, glm::vec3 max) {
+    std::vector<glm::vec3> corners(8);
+    for (uint32_t i = 0; i < 8; ++i) corners[i] = glm::vec3((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z);
+    return new purrOccluderComp(corners, {
+      0, 2, 1, 1, 2, 3, // -z
+      4, 5, 6, 5, 7, 6, // +z
+      0, 1, 4, 1, 5, 4, // -y
+      2, 6, 3, 3, 6, 7, // +y
+      0, 4, 2, 2, 4, 6, // -x
+      1, 3, 5, 3, 7, 5, // +x
+    });
+  }
+
   purrObject::purrObject(purrTransform *transform):
-    mTransform(transform)
+    mTransform(transform ? transform : new purrTransform())
   {}
 
   purrObject::~purrObject() {
@@ -81,8 +108,9 @@ namespace PurrfectEngine {
   bool purrObject::removeComponent(const char *name) {
     std::vector<const char*>::iterator it;
     if ((it = std::find(mCompNames.begin(), mCompNames.end(), name)) == mCompNames.end()) return false;
-    mCompNames.erase(it);
+    // Before erasing, `it` is invalid afterwards.
     mComponents.erase(mComponents.begin()+(it-mCompNames.begin()));
+    mCompNames.erase(it);
     return true;
   }
 
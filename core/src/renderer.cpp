@@ -1,6 +1,7 @@
 #include "PurrfectEngine/PurrfectEngine.hpp"
 
 #include <inttypes.h>
+#include <chrono>
 
 namespace PurrfectEngine {
 
@@ -9,43 +10,180 @@ namespace PurrfectEngine {
     glm::mat4 view;
   };
 
-  static bool sVSync = false;
+  // Start of the lights SSBO (std430), the purrLight array follows it. See shaders/pbr.frag.
+  struct LightsHeader {
+    glm::mat4 view;
+    glm::uvec4 grid;   // Tiles x, tiles y, slices, light count.
+    glm::vec4 slicing; // Slice scale, slice bias, viewport width, viewport height.
+    glm::vec4 eye;     // World space camera position.
+    glm::vec4 sunDirection; // Towards the light, w is the shadow cascade count (0 without shadows).
+    glm::vec4 sunColor;     // Color times intensity.
+    glm::vec4 shadowSplits; // View depth where each cascade ends.
+    glm::vec4 shadowAtlas;  // Tiles per row, 1 / tiles per row, 1 / tiles per column, texels per cascade.
+    glm::mat4 shadowMatrices[PURR_MAX_SHADOW_CASCADES];
+  };
+
+  // Everything the CPU writes while recording a frame, one set per frame in flight
+  // so the GPU can still read the previous frame's data.
+  struct FrameData {
+    fr::frCommands *commands = nullptr;
+    VkCommandBuffer cmdBuf = VK_NULL_HANDLE;
+    fr::frSynchronization *sync = nullptr;
+    // Reset when the frame begins, the sets below are allocated and written the first time they're bound.
+    purrDescriptorAllocator *descriptors = nullptr;
+
+    purrBuffer *cameraBuffer = nullptr;
+    VkDescriptorSet cameraSet = VK_NULL_HANDLE;
+
+    purrBuffer *transformsBuffer = nullptr;
+    uint32_t transformsBufCap = 0;
+    VkDescriptorSet transformsSet = VK_NULL_HANDLE;
+
+    // Clustered lighting (renderer::updateLights), grown on demand like the transforms buffer.
+    purrBuffer *lightsBuffer = nullptr;
+    VkDeviceSize lightsBufSize = 0;
+    purrBuffer *clustersBuffer = nullptr;
+    VkDeviceSize clustersBufSize = 0;
+    purrBuffer *lightIndicesBuffer = nullptr;
+    VkDeviceSize lightIndicesBufSize = 0;
+    VkDescriptorSet lightsSet = VK_NULL_HANDLE;
+
+    // Per-draw data, one dynamic uniform buffer set per ring block, allocated when first bound.
+    purrRingBuffer *drawData = nullptr;
+    std::vector<VkDescriptorSet> drawDataSets{};
+
+    // Headless only, there are no semaphores to wait on so frames are only fenced.
+    VkFence fence = VK_NULL_HANDLE;
+    VkBuffer readbackBuffer = VK_NULL_HANDLE;
+    purrAllocation readbackAllocation{};
+    void *readbackData = nullptr;
+    bool readbackPending = false;
+    uint64_t readbackFrame = 0;
+  };
+
   static bool sScDirty = false;
+  // Requested mode and the one the swapchain got after falling back to what the surface supports.
+  static VkPresentModeKHR sRequestedPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+  static VkPresentModeKHR sPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+  static purrFramePacer *sFramePacer = nullptr;
   static uint32_t sImageCount = 0;
   static uint32_t sFrame = 0;
   static uint32_t sImageIndex = 0;
 
-  static fr::frDescriptor *sSceneDescriptor = nullptr;
+  static VkDescriptorSet sSceneDescriptor = VK_NULL_HANDLE;
+  static purrDescriptorTemplate sCameraTemplate{};
+  static purrDescriptorTemplate sTransformsTemplate{};
+  static purrDescriptorTemplate sLightsTemplate{};
+  static purrDescriptorTemplate sDrawDataTemplate{};
+  static renderer::DrawDataCallback sDrawDataCallback{};
 
-  static fr::frBuffer *sCameraBuffer = nullptr;
-  static fr::frDescriptor *sCameraUBO = nullptr;
-  
-  static fr::frBuffer *sTransformsBuffer = nullptr;
-  static uint32_t sTransformsBufCap = 0;
-  static bool sTransformsBufDirty = true;
-  static fr::frDescriptor *sTransformsDesc = nullptr;
+  static std::vector<FrameData> sFrames{};
+  // Frame (its fence) that last rendered to each swapchain image.
+  static std::vector<fr::frSynchronization*> sImagesInFlight{};
 
   static purrPipeline *sScenePipeline = nullptr;
 
+  static VkPipelineLayout sSwapchainPipelineLayout = VK_NULL_HANDLE;
+  static VkPipeline sSwapchainPipeline = VK_NULL_HANDLE;
+  // Composite that upscales the scaled scene viewport (bilinear plus contrast adaptive sharpening), see shaders/upscale.frag.
+  static VkPipeline sUpscalePipeline = VK_NULL_HANDLE;
+  // Composite of purrPostProcess (shaders/post.frag), its bloom and exposure are set 1.
+  static purrPostProcess *sPostProcess = nullptr;
+  static VkPipelineLayout sPostPipelineLayout = VK_NULL_HANDLE;
+  static VkPipeline sPostPipeline = VK_NULL_HANDLE;
+  static purrDynamicResolution sDynamicResolution{};
+  static purrLightClusters sLightClusters{};
+  static purrDirectionalLight sSun{};
+  static purrCascadedShadows *sShadows = nullptr;
+  static purrOcclusionCuller *sOcclusion = nullptr;
+  static purrDrawList sDrawList{};
+  // Transient allocations of the frame being recorded, reset by renderBegin.
+  static purrFrameArena sFrameArena{};
+  static uint64_t sDrawListFrame = UINT64_MAX; // sFrameCount of the last buildDrawList.
+  // Bound by setSnapshot, otherwise the active scene is extracted into sLiveSnapshot once per frame.
+  static const purrRenderSnapshot *sSnapshot = nullptr;
+  static purrRenderSnapshot sLiveSnapshot{};
+  static uint64_t sLiveSnapshotFrame = UINT64_MAX;
+  static uint64_t sSnapshotCount = 0;
+  // Thread that initialized the renderer, the only one that may wait for window events.
+  static std::thread::id sMainThread{};
+  // Bound as set 3 when there are no shadows, a white texel reads as "lit".
+  static purrTexture *sNoShadowMap = nullptr;
+
+  struct CompositeConstants {
+    glm::vec2 uvScale;   // Part of the scene target that was rendered to.
+    glm::vec2 texelSize;
+    float sharpness;
+  };
+
+  // Same layout as shaders/post.frag.
+  struct PostConstants {
+    glm::vec2 uvScale;
+    glm::vec2 texelSize;
+    float sharpness;
+    float bloomIntensity;
+    float exposure;
+    uint32_t flags;       // 1: auto exposure, 2-3: tonemapper, 8: bloom.
+    glm::vec2 bloomScale;
+    float saturation;
+    float contrast;
+    glm::vec4 lift;
+    glm::vec4 gamma;
+    glm::vec4 gain;
+  };
+
+  static uint64_t sFrameCount = 0;
+  // Between the previous (0) and current (1) simulation state, see renderer::setInterpolation.
+  static float sInterpolation = 1.0f;
+
+  // Headless mode renders into pooled targets instead of swapchain images, one per frame in flight.
+  static int sHeadlessWidth = 0, sHeadlessHeight = 0;
+  static std::vector<purrTexture*> sHeadlessTargets{};
+  static renderer::ReadbackCallback sReadbackCallback{};
+
+  #define HEADLESS_FORMAT VK_FORMAT_R8G8B8A8_UNORM
+
   #define IMAGE_NAME_FMT "Swapchain Image %u"
   #define FRAMEBUFFER_NAME_FMT "Swapchain Framebuffer %u"
 
   std::vector<char> vertexShader_program = {3, 2, 35, 7, 0, 0, 1, 0, 11, 0, 13, 0, 31, 0, 0, 0, 0, 0, 0, 0, 17, 0, 2, 0, 1, 0, 0, 0, 11, 0, 6, 0, 1, 0, 0, 0, 71, 76, 83, 76, 46, 115, 116, 100, 46, 52, 53, 48, 0, 0, 0, 0, 14, 0, 3, 0, 0, 0, 0, 0, 1, 0, 0, 0, 15, 0, 9, 0, 0, 0, 0, 0, 4, 0, 0, 0, 109, 97, 105, 110, 0, 0, 0, 0, 13, 0, 0, 0, 18, 0, 0, 0, 28, 0, 0, 0, 29, 0, 0, 0, 3, 0, 3, 0, 2, 0, 0, 0, -62, 1, 0, 0, 4, 0, 10, 0, 71, 76, 95, 71, 79, 79, 71, 76, 69, 95, 99, 112, 112, 95, 115, 116, 121, 108, 101, 95, 108, 105, 110, 101, 95, 100, 105, 114, 101, 99, 116, 105, 118, 101, 0, 0, 4, 0, 8, 0, 71, 76, 95, 71, 79, 79, 71, 76, 69, 95, 105, 110, 99, 108, 117, 100, 101, 95, 100, 105, 114, 101, 99, 116, 105, 118, 101, 0, 5, 0, 4, 0, 4, 0, 0, 0, 109, 97, 105, 110, 0, 0, 0, 0, 5, 0, 6, 0, 11, 0, 0, 0, 103, 108, 95, 80, 101, 114, 86, 101, 114, 116, 101, 120, 0, 0, 0, 0, 6, 0, 6, 0, 11, 0, 0, 0, 0, 0, 0, 0, 103, 108, 95, 80, 111, 115, 105, 116, 105, 111, 110, 0, 6, 0, 7, 0, 11, 0, 0, 0, 1, 0, 0, 0, 103, 108, 95, 80, 111, 105, 110, 116, 83, 105, 122, 101, 0, 0, 0, 0, 6, 0, 7, 0, 11, 0, 0, 0, 2, 0, 0, 0, 103, 108, 95, 67, 108, 105, 112, 68, 105, 115, 116, 97, 110, 99, 101, 0, 6, 0, 7, 0, 11, 0, 0, 0, 3, 0, 0, 0, 103, 108, 95, 67, 117, 108, 108, 68, 105, 115, 116, 97, 110, 99, 101, 0, 5, 0, 3, 0, 13, 0, 0, 0, 0, 0, 0, 0, 5, 0, 4, 0, 18, 0, 0, 0, 105, 110, 80, 111, 115, 0, 0, 0, 5, 0, 4, 0, 28, 0, 0, 0, 111, 117, 116, 85, 86, 0, 0, 0, 5, 0, 4, 0, 29, 0, 0, 0, 105, 110, 85, 86, 0, 0, 0, 0, 72, 0, 5, 0, 11, 0, 0, 0, 0, 0, 0, 0, 11, 0, 0, 0, 0, 0, 0, 0, 72, 0, 5, 0, 11, 0, 0, 0, 1, 0, 0, 0, 11, 0, 0, 0, 1, 0, 0, 0, 72, 0, 5, 0, 11, 0, 0, 0, 2, 0, 0, 0, 11, 0, 0, 0, 3, 0, 0, 0, 72, 0, 5, 0, 11, 0, 0, 0, 3, 0, 0, 0, 11, 0, 0, 0, 4, 0, 0, 0, 71, 0, 3, 0, 11, 0, 0, 0, 2, 0, 0, 0, 71, 0, 4, 0, 18, 0, 0, 0, 30, 0, 0, 0, 0, 0, 0, 0, 71, 0, 4, 0, 28, 0, 0, 0, 30, 0, 0, 0, 0, 0, 0, 0, 71, 0, 4, 0, 29, 0, 0, 0, 30, 0, 0, 0, 1, 0, 0, 0, 19, 0, 2, 0, 2, 0, 0, 0, 33, 0, 3, 0, 3, 0, 0, 0, 2, 0, 0, 0, 22, 0, 3, 0, 6, 0, 0, 0, 32, 0, 0, 0, 23, 0, 4, 0, 7, 0, 0, 0, 6, 0, 0, 0, 4, 0, 0, 0, 21, 0, 4, 0, 8, 0, 0, 0, 32, 0, 0, 0, 0, 0, 0, 0, 43, 0, 4, 0, 8, 0, 0, 0, 9, 0, 0, 0, 1, 0, 0, 0, 28, 0, 4, 0, 10, 0, 0, 0, 6, 0, 0, 0, 9, 0, 0, 0, 30, 0, 6, 0, 11, 0, 0, 0, 7, 0, 0, 0, 6, 0, 0, 0, 10, 0, 0, 0, 10, 0, 0, 0, 32, 0, 4, 0, 12, 0, 0, 0, 3, 0, 0, 0, 11, 0, 0, 0, 59, 0, 4, 0, 12, 0, 0, 0, 13, 0, 0, 0, 3, 0, 0, 0, 21, 0, 4, 0, 14, 0, 0, 0, 32, 0, 0, 0, 1, 0, 0, 0, 43, 0, 4, 0, 14, 0, 0, 0, 15, 0, 0, 0, 0, 0, 0, 0, 23, 0, 4, 0, 16, 0, 0, 0, 6, 0, 0, 0, 2, 0, 0, 0, 32, 0, 4, 0, 17, 0, 0, 0, 1, 0, 0, 0, 16, 0, 0, 0, 59, 0, 4, 0, 17, 0, 0, 0, 18, 0, 0, 0, 1, 0, 0, 0, 43, 0, 4, 0, 6, 0, 0, 0, 20, 0, 0, 0, 0, 0, 0, 0, 43, 0, 4, 0, 6, 0, 0, 0, 21, 0, 0, 0, 0, 0, -128, 63, 32, 0, 4, 0, 25, 0, 0, 0, 3, 0, 0, 0, 7, 0, 0, 0, 32, 0, 4, 0, 27, 0, 0, 0, 3, 0, 0, 0, 16, 0, 0, 0, 59, 0, 4, 0, 27, 0, 0, 0, 28, 0, 0, 0, 3, 0, 0, 0, 59, 0, 4, 0, 17, 0, 0, 0, 29, 0, 0, 0, 1, 0, 0, 0, 54, 0, 5, 0, 2, 0, 0, 0, 4, 0, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, -8, 0, 2, 0, 5, 0, 0, 0, 61, 0, 4, 0, 16, 0, 0, 0, 19, 0, 0, 0, 18, 0, 0, 0, 81, 0, 5, 0, 6, 0, 0, 0, 22, 0, 0, 0, 19, 0, 0, 0, 0, 0, 0, 0, 81, 0, 5, 0, 6, 0, 0, 0, 23, 0, 0, 0, 19, 0, 0, 0, 1, 0, 0, 0, 80, 0, 7, 0, 7, 0, 0, 0, 24, 0, 0, 0, 22, 0, 0, 0, 23, 0, 0, 0, 20, 0, 0, 0, 21, 0, 0, 0, 65, 0, 5, 0, 25, 0, 0, 0, 26, 0, 0, 0, 13, 0, 0, 0, 15, 0, 0, 0, 62, 0, 3, 0, 26, 0, 0, 0, 24, 0, 0, 0, 61, 0, 4, 0, 16, 0, 0, 0, 30, 0, 0, 0, 29, 0, 0, 0, 62, 0, 3, 0, 28, 0, 0, 0, 30, 0, 0, 0, -3, 0, 1, 0, 56, 0, 1, 0};
   std::vector<char> fragmentShader_program = {3, 2, 35, 7, 0, 0, 1, 0, 11, 0, 13, 0, 27, 0, 0, 0, 0, 0, 0, 0, 17, 0, 2, 0, 1, 0, 0, 0, 11, 0, 6, 0, 1, 0, 0, 0, 71, 76, 83, 76, 46, 115, 116, 100, 46, 52, 53, 48, 0, 0, 0, 0, 14, 0, 3, 0, 0, 0, 0, 0, 1, 0, 0, 0, 15, 0, 7, 0, 4, 0, 0, 0, 4, 0, 0, 0, 109, 97, 105, 110, 0, 0, 0, 0, 9, 0, 0, 0, 17, 0, 0, 0, 16, 0, 3, 0, 4, 0, 0, 0, 7, 0, 0, 0, 3, 0, 3, 0, 2, 0, 0, 0, -62, 1, 0, 0, 4, 0, 10, 0, 71, 76, 95, 71, 79, 79, 71, 76, 69, 95, 99, 112, 112, 95, 115, 116, 121, 108, 101, 95, 108, 105, 110, 101, 95, 100, 105, 114, 101, 99, 116, 105, 118, 101, 0, 0, 4, 0, 8, 0, 71, 76, 95, 71, 79, 79, 71, 76, 69, 95, 105, 110, 99, 108, 117, 100, 101, 95, 100, 105, 114, 101, 99, 116, 105, 118, 101, 0, 5, 0, 4, 0, 4, 0, 0, 0, 109, 97, 105, 110, 0, 0, 0, 0, 5, 0, 5, 0, 9, 0, 0, 0, 111, 117, 116, 67, 111, 108, 111, 114, 0, 0, 0, 0, 5, 0, 5, 0, 13, 0, 0, 0, 117, 83, 97, 109, 112, 108, 101, 114, 0, 0, 0, 0, 5, 0, 4, 0, 17, 0, 0, 0, 105, 110, 85, 86, 0, 0, 0, 0, 71, 0, 4, 0, 9, 0, 0, 0, 30, 0, 0, 0, 0, 0, 0, 0, 71, 0, 4, 0, 13, 0, 0, 0, 34, 0, 0, 0, 0, 0, 0, 0, 71, 0, 4, 0, 13, 0, 0, 0, 33, 0, 0, 0, 0, 0, 0, 0, 71, 0, 4, 0, 17, 0, 0, 0, 30, 0, 0, 0, 0, 0, 0, 0, 19, 0, 2, 0, 2, 0, 0, 0, 33, 0, 3, 0, 3, 0, 0, 0, 2, 0, 0, 0, 22, 0, 3, 0, 6, 0, 0, 0, 32, 0, 0, 0, 23, 0, 4, 0, 7, 0, 0, 0, 6, 0, 0, 0, 4, 0, 0, 0, 32, 0, 4, 0, 8, 0, 0, 0, 3, 0, 0, 0, 7, 0, 0, 0, 59, 0, 4, 0, 8, 0, 0, 0, 9, 0, 0, 0, 3, 0, 0, 0, 25, 0, 9, 0, 10, 0, 0, 0, 6, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 27, 0, 3, 0, 11, 0, 0, 0, 10, 0, 0, 0, 32, 0, 4, 0, 12, 0, 0, 0, 0, 0, 0, 0, 11, 0, 0, 0, 59, 0, 4, 0, 12, 0, 0, 0, 13, 0, 0, 0, 0, 0, 0, 0, 23, 0, 4, 0, 15, 0, 0, 0, 6, 0, 0, 0, 2, 0, 0, 0, 32, 0, 4, 0, 16, 0, 0, 0, 1, 0, 0, 0, 15, 0, 0, 0, 59, 0, 4, 0, 16, 0, 0, 0, 17, 0, 0, 0, 1, 0, 0, 0, 23, 0, 4, 0, 20, 0, 0, 0, 6, 0, 0, 0, 3, 0, 0, 0, 43, 0, 4, 0, 6, 0, 0, 0, 22, 0, 0, 0, 0, 0, -128, 63, 54, 0, 5, 0, 2, 0, 0, 0, 4, 0, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, -8, 0, 2, 0, 5, 0, 0, 0, 61, 0, 4, 0, 11, 0, 0, 0, 14, 0, 0, 0, 13, 0, 0, 0, 61, 0, 4, 0, 15, 0, 0, 0, 18, 0, 0, 0, 17, 0, 0, 0, 87, 0, 5, 0, 7, 0, 0, 0, 19, 0, 0, 0, 14, 0, 0, 0, 18, 0, 0, 0, 79, 0, 8, 0, 20, 0, 0, 0, 21, 0, 0, 0, 19, 0, 0, 0, 19, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 81, 0, 5, 0, 6, 0, 0, 0, 23, 0, 0, 0, 21, 0, 0, 0, 0, 0, 0, 0, 81, 0, 5, 0, 6, 0, 0, 0, 24, 0, 0, 0, 21, 0, 0, 0, 1, 0, 0, 0, 81, 0, 5, 0, 6, 0, 0, 0, 25, 0, 0, 0, 21, 0, 0, 0, 2, 0, 0, 0, 80, 0, 7, 0, 7, 0, 0, 0, 26, 0, 0, 0, 23, 0, 0, 0, 24, 0, 0, 0, 25, 0, 0, 0, 22, 0, 0, 0, 62, 0, 3, 0, 9, 0, 0, 0, 26, 0, 0, 0, -3, 0, 1, 0, 56, 0, 1, 0};
 
-  const char* pbrVertexShader_program = "./shaders/pbr_v.spv";
-  const char* pbrFragmentShader_program = "./shaders/pbr_f.spv";
-  
+  static PurrfectEngineContext *sContext;
 
-  VkCommandBuffer *sCmdBufs{};
-  std::vector<fr::frSynchronization*> sSynchronizations{};
+  std::vector<VkPresentModeKHR> getSupportedPresentModes() {
+    VkPhysicalDevice physicalDevice = sContext->frRenderer->getPhysicalDevice();
+    VkSurfaceKHR surface = sContext->frWindow->getSurface();
+    uint32_t count = 0;
+    vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &count, nullptr);
+    std::vector<VkPresentModeKHR> modes(count);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &count, modes.data());
+    return modes;
+  }
 
-  static PurrfectEngineContext *sContext;
+  // Present mode selection needs an fr with frSwapchain::setPresentMode, the pinned one picks the mode itself.
+  template <typename T>
+  static auto applyPresentMode(T *swapchain, VkPresentModeKHR mode, int) -> decltype(swapchain->setPresentMode(mode), bool()) {
+    swapchain->setPresentMode(mode);
+    return true;
+  }
+
+  template <typename T>
+  static bool applyPresentMode(T *, VkPresentModeKHR, long) {
+    return false;
+  }
 
   void createSwapchain() {
+    sPresentMode = Utils::choosePresentMode(sRequestedPresentMode, getSupportedPresentModes());
     sContext->frSwapchain = new fr::frSwapchain();
+    if (!applyPresentMode(sContext->frSwapchain, sPresentMode, 0) && sRequestedPresentMode != VK_PRESENT_MODE_FIFO_KHR) {
+      static bool warned = false;
+      if (!warned) fprintf(stderr, "[renderer]: fr doesn't support choosing a present mode, the swapchain keeps fr's default.\n");
+      warned = true;
+    }
     sContext->frSwapchain->initialize(sContext->frRenderer, sContext->frWindow);
     sImageCount = sContext->frSwapchain->imageCount();
+    sImagesInFlight.assign(sImageCount, nullptr);
   }
 
   void createSwapchainObjects() {
@@ -74,7 +212,39 @@ namespace PurrfectEngine {
     }
   }
 
+  void createHeadlessObjects() {
+    sContext->frScImages.resize(sImageCount);
+    sContext->frFbs.resize(sImageCount);
+    sHeadlessTargets.resize(sImageCount);
+
+    for (uint32_t i = 0; i < sImageCount; ++i) {
+      sHeadlessTargets[i] = purrRenderTargetPool::getDefault()->acquire(purrRenderTargetDesc{
+        sHeadlessWidth, sHeadlessHeight, HEADLESS_FORMAT, VK_SAMPLE_COUNT_1_BIT,
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+      });
+      sContext->frScImages[i] = sHeadlessTargets[i]->getImage();
+
+      fr::frFramebuffer *fb = new fr::frFramebuffer();
+      fb->initialize(sContext->frRenderer, sHeadlessWidth, sHeadlessHeight, sContext->frRenderPass, { sContext->frScImages[i] });
+      char buf[32] = {0};
+      sprintf(buf, FRAMEBUFFER_NAME_FMT, i);
+      fb->setName(sContext->frRenderer, buf);
+      sContext->frFbs[i] = fb;
+    }
+  }
+
   void cleanupSwapchain() {
+    if (sContext->settings.headless) {
+      for (uint32_t i = 0; i < sImageCount; ++i) {
+        purrRenderTargetPool::getDefault()->release(sHeadlessTargets[i]);
+        delete sContext->frFbs[i];
+      }
+      sHeadlessTargets.clear();
+      sContext->frScImages.clear();
+      sContext->frFbs.clear();
+      return;
+    }
+
     for (uint32_t i = 0; i < sImageCount; ++i) {
       delete sContext->frScImages[i];
       delete sContext->frFbs[i];
@@ -82,13 +252,157 @@ namespace PurrfectEngine {
     delete sContext->frSwapchain;
   }
 
+  VkDescriptorSet getCameraSet(FrameData &frame) {
+    if (frame.cameraSet) return frame.cameraSet;
+    VkDescriptorBufferInfo bufferInfo = { frame.cameraBuffer->get(), 0, sizeof(CameraUBO) };
+    frame.cameraSet = frame.descriptors->allocate(sContext->frUboLayout->get());
+    if (frame.cameraSet) sCameraTemplate.update(frame.cameraSet, &bufferInfo);
+    return frame.cameraSet;
+  }
+
+  VkDescriptorSet getTransformsSet(FrameData &frame) {
+    if (frame.transformsSet) return frame.transformsSet;
+    VkDescriptorBufferInfo bufferInfo = { frame.transformsBuffer->get(), 0, sizeof(glm::mat4) * frame.transformsBufCap };
+    frame.transformsSet = frame.descriptors->allocate(sContext->frStorageBufLayout->get());
+    if (frame.transformsSet) sTransformsTemplate.update(frame.transformsSet, &bufferInfo);
+    return frame.transformsSet;
+  }
+
+  VkDescriptorSet getLightsSet(FrameData &frame) {
+    if (frame.lightsSet) return frame.lightsSet;
+    VkDescriptorBufferInfo bufferInfos[3] = {
+      { frame.lightsBuffer->get(), 0, frame.lightsBufSize },
+      { frame.clustersBuffer->get(), 0, frame.clustersBufSize },
+      { frame.lightIndicesBuffer->get(), 0, frame.lightIndicesBufSize },
+    };
+    frame.lightsSet = frame.descriptors->allocate(sContext->frLightsLayout->get());
+    if (frame.lightsSet) sLightsTemplate.update(frame.lightsSet, bufferInfos);
+    return frame.lightsSet;
+  }
+
+  VkDescriptorSet getDrawDataSet(FrameData &frame, uint32_t block) {
+    if (frame.drawDataSets.size() <= block) frame.drawDataSets.resize(block + 1, VK_NULL_HANDLE);
+    if (frame.drawDataSets[block]) return frame.drawDataSets[block];
+    VkDescriptorBufferInfo bufferInfo = { frame.drawData->getBuffer(block), 0, PURR_MAX_DRAW_DATA };
+    frame.drawDataSets[block] = frame.descriptors->allocate(sContext->frDrawDataLayout->get());
+    if (frame.drawDataSets[block]) sDrawDataTemplate.update(frame.drawDataSets[block], &bufferInfo);
+    return frame.drawDataSets[block];
+  }
+
+  // The GPU is done with the frame's previous sets and draw data once its fence signaled.
+  void resetFrameDescriptors(FrameData &frame) {
+    frame.descriptors->reset();
+    frame.cameraSet = VK_NULL_HANDLE;
+    frame.transformsSet = VK_NULL_HANDLE;
+    frame.lightsSet = VK_NULL_HANDLE;
+    frame.drawData->reset();
+    frame.drawDataSets.clear();
+  }
+
+  // Returns true when the buffer had to be recreated, its descriptor set needs to be replaced then.
+  static bool reserveStorageBuffer(purrBuffer *buffer, VkDeviceSize *capacity, VkDeviceSize size) {
+    if (*capacity >= size) return false;
+    if (*capacity == 0) *capacity = 256;
+    while (*capacity < size) *capacity *= 2;
+    buffer->initialize(*capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, purrMemoryCategory::Frame);
+    return true;
+  }
+
+  void createFrameData(FrameData &frame) {
+    frame.commands = new fr::frCommands();
+    frame.commands->initialize(sContext->frRenderer);
+    VkCommandBuffer *cmdBufs = frame.commands->allocateBuffers(VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
+    frame.cmdBuf = cmdBufs[0];
+
+    if (!sContext->settings.headless) {
+      frame.sync = new fr::frSynchronization();
+      frame.sync->initialize(sContext->frRenderer);
+    }
+
+    purrDescriptorAllocatorSettings descriptorSettings{};
+    descriptorSettings.lifetime = purrDescriptorLifetime::Frame;
+    descriptorSettings.setsPerPool = 16;
+    frame.descriptors = new purrDescriptorAllocator(descriptorSettings);
+
+    frame.drawData = new purrRingBuffer();
+    frame.drawData->initialize(64 * 1024, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, PURR_MAX_DRAW_DATA);
+
+    frame.cameraBuffer = new purrBuffer();
+    frame.cameraBuffer->initialize(sizeof(CameraUBO), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, purrMemoryCategory::Frame);
+
+    frame.transformsBufCap = 256;
+    frame.transformsBuffer = new purrBuffer();
+    frame.transformsBuffer->initialize(sizeof(glm::mat4) * frame.transformsBufCap, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, purrMemoryCategory::Frame);
+
+    glm::uvec3 grid = sLightClusters.getGridSize();
+    frame.lightsBuffer = new purrBuffer();
+    frame.clustersBuffer = new purrBuffer();
+    frame.lightIndicesBuffer = new purrBuffer();
+    reserveStorageBuffer(frame.lightsBuffer, &frame.lightsBufSize, sizeof(LightsHeader) + sizeof(purrLight) * 64);
+    reserveStorageBuffer(frame.clustersBuffer, &frame.clustersBufSize, sizeof(glm::uvec2) * grid.x * grid.y * grid.z);
+    reserveStorageBuffer(frame.lightIndicesBuffer, &frame.lightIndicesBufSize, sizeof(uint32_t) * 4096);
+    // Nothing was binned yet, an all zero header reads as "no lights".
+    LightsHeader header{};
+    frame.lightsBuffer->copyData(0, sizeof(header), &header);
+
+    if (!sContext->settings.headless) return;
+    VkDevice device = sContext->frRenderer->getDevice();
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    vkCreateFence(device, &fenceInfo, nullptr, &frame.fence);
+
+    VkBufferCreateInfo bufferCreateInfo{};
+    bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.size = static_cast<VkDeviceSize>(sHeadlessWidth) * sHeadlessHeight * 4;
+    bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    // Cached memory makes reading it on the CPU a lot faster, not every device has it.
+    purrAllocationInfo allocInfo{};
+    allocInfo.required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    allocInfo.preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+    allocInfo.category = purrMemoryCategory::Frame;
+    if (!purrGpuAllocator::getDefault()->createBuffer(bufferCreateInfo, allocInfo, &frame.readbackBuffer, &frame.readbackAllocation)) {
+      fprintf(stderr, "[renderer]: Failed to create readback buffer!\n");
+      return;
+    }
+    frame.readbackData = frame.readbackAllocation.mapped;
+  }
+
+  void deliverReadback(FrameData &frame) {
+    if (!frame.readbackPending) return;
+    frame.readbackPending = false;
+    if (sReadbackCallback) sReadbackCallback(static_cast<const uint8_t*>(frame.readbackData), sHeadlessWidth, sHeadlessHeight, frame.readbackFrame);
+  }
+
+  void cleanupFrameData(FrameData &frame) {
+    if (frame.fence) {
+      VkDevice device = sContext->frRenderer->getDevice();
+      vkDestroyFence(device, frame.fence, nullptr);
+      purrGpuAllocator::getDefault()->destroyBuffer(frame.readbackBuffer, frame.readbackAllocation);
+    }
+    delete frame.cameraBuffer;
+    delete frame.transformsBuffer;
+    delete frame.lightsBuffer;
+    delete frame.clustersBuffer;
+    delete frame.lightIndicesBuffer;
+    delete frame.drawData;
+    delete frame.descriptors;
+    delete frame.sync;
+    delete frame.commands;
+    frame = FrameData{};
+  }
+
   void recreateSwapchain() {
     auto p = sContext->frWindow->getSize();
     int w = p.first, h = p.second;
     while (w == 0 || h == 0) {
       p = sContext->frWindow->getSize();
       w = p.first; h = p.second;
-      glfwWaitEvents();
+      // On a render thread the main thread keeps polling.
+      if (std::this_thread::get_id() == sMainThread) glfwWaitEvents();
+      else std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
 
     sContext->frRenderer->waitIdle();
@@ -98,11 +412,115 @@ namespace PurrfectEngine {
     createSwapchainObjects();
   }
 
+  // beginFrame just resolved the timestamps of the frame that last used this slot.
+  static void updateRenderScale() {
+    if (!sUpscalePipeline || !sScenePipeline) return;
+    purrProfiler *profiler = purrProfiler::getDefault();
+    double gpuFrameMs = profiler->hasNewGpuFrameMs() ? profiler->getGpuFrameMs() : 0.0;
+    sScenePipeline->setRenderScale(sDynamicResolution.update(sFrame, gpuFrameMs));
+  }
+
+  // Fullscreen square into the swapchain render pass, shared by the plain and the upscaling composite.
+  static VkPipeline createCompositePipeline(VkShaderModule fragmentShader, VkPipelineLayout layout) {
+    VkPipelineShaderStageCreateInfo stages[2] = {};
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = purrPipelineCache::getDefault()->getShaderModule(vertexShader_program);
+    stages[0].pName = "main";
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = fragmentShader;
+    stages[1].pName = "main";
+
+    VkVertexInputBindingDescription *binding = Vertex2D::getBindingDescription();
+    VkVertexInputBindingDescription bindingDescription = *binding;
+    delete binding;
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions = Vertex2D::getAttributeDescriptions();
+
+    VkPipelineVertexInputStateCreateInfo vertexInput{};
+    vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInput.vertexBindingDescriptionCount = 1;
+    vertexInput.pVertexBindingDescriptions = &bindingDescription;
+    vertexInput.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+    vertexInput.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+    VkPipelineMultisampleStateCreateInfo multisample = {
+      VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
+      VK_SAMPLE_COUNT_1_BIT, VK_FALSE, 0.0f, VK_NULL_HANDLE,
+      VK_FALSE, VK_FALSE
+    };
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {
+      VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
+      VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_FALSE
+    };
+
+    VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    colorBlendAttachment.blendEnable = VK_FALSE;
+
+    VkPipelineColorBlendStateCreateInfo colorBlend = {
+      VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
+      VK_FALSE,
+      VK_LOGIC_OP_COPY,
+      1,
+      &colorBlendAttachment,
+      {0.0f, 0.0f, 0.0f, 0.0f}
+    };
+
+    VkPipelineRasterizationStateCreateInfo rasterization = {
+      VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
+      VK_FALSE, VK_FALSE, VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_CLOCKWISE,
+      VK_FALSE, 0.0f, 0.0f, 0.0f, 1.0f
+    };
+
+    std::vector<VkDynamicState> dynamicStates = {
+      VK_DYNAMIC_STATE_VIEWPORT,
+      VK_DYNAMIC_STATE_SCISSOR
+    };
+
+    VkPipelineDynamicStateCreateInfo dynamicState = {
+      VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
+      static_cast<uint32_t>(dynamicStates.size()), dynamicStates.data()
+    };
+
+    VkPipelineViewportStateCreateInfo viewportState = {
+      VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
+      1, nullptr, 1, nullptr
+    };
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = 2;
+    pipelineInfo.pStages = stages;
+    pipelineInfo.pVertexInputState = &vertexInput;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterization;
+    pipelineInfo.pMultisampleState = &multisample;
+    pipelineInfo.pColorBlendState = &colorBlend;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = layout;
+    pipelineInfo.renderPass = sContext->frRenderPass->get();
+    pipelineInfo.subpass = 0;
+    return purrPipelineCache::getDefault()->createGraphicsPipeline(pipelineInfo);
+  }
+
   void renderer::setContext(PurrfectEngineContext *context) {
     sContext = context;
+    purrGpuAllocator::setContext(context);
+    purrDescriptorAllocator::setContext(context);
+    purrRingBuffer::setContext(context);
     purrTexture::setContext(context);
     purrMesh::setContext(context);
     purrPipeline::setContext(context);
+    purrRenderTargetPool::setContext(context);
+    purrPipelineCache::setContext(context);
+    purrProfiler::setContext(context);
+    purrCascadedShadows::setContext(context);
+    purrOcclusionCuller::setContext(context);
+    purrPostProcess::setContext(context);
+    purrParticleSystem::setContext(context);
   }
 
   void renderer::setScene(purrScene *scene) {
@@ -110,36 +528,59 @@ namespace PurrfectEngine {
   }
 
   void renderer::setVSync(bool enabled) {
-    if (sVSync == enabled) return;
-    sVSync = enabled;
-    sScDirty = true;
+    setPresentMode(enabled ? VK_PRESENT_MODE_FIFO_KHR : VK_PRESENT_MODE_IMMEDIATE_KHR);
+  }
+
+  void renderer::setPresentMode(VkPresentModeKHR mode) {
+    if (mode == sRequestedPresentMode) return;
+    sRequestedPresentMode = mode;
+    // Before initialize, or when the fallback lands on the mode we already have, there's nothing to recreate.
+    if (!sContext->frSwapchain || sContext->settings.headless) return;
+    if (Utils::choosePresentMode(mode, getSupportedPresentModes()) != sPresentMode) sScDirty = true;
+  }
+
+  VkPresentModeKHR renderer::getPresentMode() {
+    return sPresentMode;
+  }
+
+  purrFramePacer *renderer::getFramePacer() {
+    if (!sFramePacer) sFramePacer = new purrFramePacer();
+    return sFramePacer;
   }
 
   void renderer::initialize(std::string title, int width, int height) {
-    sContext->frWindow = new fr::frWindow(title, width, height);
+    bool headless = sContext->settings.headless;
+    sMainThread = std::this_thread::get_id();
+    if (!headless) sContext->frWindow = new fr::frWindow(title, width, height);
 
     sContext->frRenderer = new fr::frRenderer();
 
     VkPhysicalDeviceFeatures physicalDeviceFeatures{};
     physicalDeviceFeatures.samplerAnisotropy = VK_TRUE;
 
-    sContext->frWindow->addExtensions(sContext->frRenderer);
+    if (!headless) sContext->frWindow->addExtensions(sContext->frRenderer);
     #if 1
     sContext->frRenderer->addLayer("VK_LAYER_KHRONOS_validation");
     sContext->frRenderer->addExtension(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     sContext->frRenderer->addExtension(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
     #endif
+    // Without a window there is no surface, the renderer only needs a graphics queue.
     sContext->frRenderer->initialize(sContext->frWindow, &physicalDeviceFeatures);
 
-    createSwapchain();
+    if (headless) {
+      sHeadlessWidth = width;
+      sHeadlessHeight = height;
+      sImageCount = std::max(sContext->settings.framesInFlight, 1u);
+      sImagesInFlight.assign(sImageCount, nullptr);
+    } else createSwapchain();
 
     { // Swapchain RenderPass
       sContext->frRenderPass = new fr::frRenderPass();
       sContext->frRenderPass->addAttachment(VkAttachmentDescription{
-        0, sContext->frSwapchain->format(), (VkSampleCountFlagBits)sContext->settings.msaa,
+        0, headless ? HEADLESS_FORMAT : sContext->frSwapchain->format(), VK_SAMPLE_COUNT_1_BIT,
         VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE,
         VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE,
-        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+        VK_IMAGE_LAYOUT_UNDEFINED, headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
       });
 
       VkAttachmentReference colorAttachmentRef{};
@@ -161,6 +602,17 @@ namespace PurrfectEngine {
 
       sContext->frRenderPass->addSubpass(subpass);
       sContext->frRenderPass->addDependency(dependency);
+      if (headless) {
+        // Readback copies the image right after the render pass.
+        VkSubpassDependency readbackDependency{};
+        readbackDependency.srcSubpass = 0;
+        readbackDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+        readbackDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        readbackDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        readbackDependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        readbackDependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        sContext->frRenderPass->addDependency(readbackDependency);
+      }
       sContext->frRenderPass->initialize(sContext->frRenderer);
       sContext->frRenderPass->setName(sContext->frRenderer, "Swapchain RP");
     }
@@ -189,119 +641,96 @@ namespace PurrfectEngine {
     });
     sContext->frStorageBufLayout->initialize(sContext->frRenderer);
 
-    { // Swapchain Pipeline
-      sContext->frPipeline = new fr::frPipeline();
-
-      auto vertShader = new fr::frShader();
-      auto fragShader = new fr::frShader();
-      { // Vertex shader
-        vertShader->initialize(sContext->frRenderer, vertexShader_program, VK_SHADER_STAGE_VERTEX_BIT);
-        sContext->frPipeline->addShader(vertShader);
-      }
-      { // Fragment shader
-        fragShader->initialize(sContext->frRenderer, fragmentShader_program, VK_SHADER_STAGE_FRAGMENT_BIT);
-        sContext->frPipeline->addShader(fragShader);
-      }
-
-      // PBR Init
-      auto pbrVertShader = new fr::frShader();
-      auto pbrFragShader = new fr::frShader();
-
-      { // PBR Vertex shader
-          pbrVertShader->initialize(sContext->frRenderer, pbrVertexShader_program, VK_SHADER_STAGE_VERTEX_BIT);
-          sContext->frPipeline->addShader(pbrVertShader);
-      }
-      { // PBR Fragment shader
-          pbrFragShader->initialize(sContext->frRenderer, pbrFragmentShader_program, VK_SHADER_STAGE_FRAGMENT_BIT);
-          sContext->frPipeline->addShader(pbrFragShader);
-      }
-
-      sContext->frPipeline->setVertexInputState<Vertex2D>();
-
-      sContext->frPipeline->setMultisampleInfo(VkPipelineMultisampleStateCreateInfo{
-        VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
-        (VkSampleCountFlagBits)sContext->settings.msaa, VK_FALSE, 0.0f, VK_NULL_HANDLE,
-        VK_FALSE, VK_FALSE
-      });
-
-      sContext->frPipeline->setInputAssemblyState(VkPipelineInputAssemblyStateCreateInfo{
-        VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
-        VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_FALSE
-      });
-
-      VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-      colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-      colorBlendAttachment.blendEnable = VK_FALSE;
-
-      sContext->frPipeline->setColorBlendState(VkPipelineColorBlendStateCreateInfo{
-        VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
-        VK_FALSE,
-        VK_LOGIC_OP_COPY,
-        1,
-        &colorBlendAttachment,
-        {0.0f, 0.0f, 0.0f, 0.0f}
-      });
-
-      sContext->frPipeline->setRasterizationState(VkPipelineRasterizationStateCreateInfo{
-        VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
-        VK_FALSE, VK_FALSE, VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_CLOCKWISE,
-        VK_FALSE, 0.0f, 0.0f, 0.0f, 1.0f
+    // Header and lights, (offset, count) per cluster, light index lists.
+    sContext->frLightsLayout = new fr::frDescriptorLayout();
+    for (uint32_t i = 0; i < 3; ++i) {
+      sContext->frLightsLayout->addBinding(VkDescriptorSetLayoutBinding{
+        i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+        VK_SHADER_STAGE_FRAGMENT_BIT,
+        VK_NULL_HANDLE
       });
+    }
+    sContext->frLightsLayout->initialize(sContext->frRenderer);
 
-      std::vector<VkDynamicState> dynamicStates = {
-        VK_DYNAMIC_STATE_VIEWPORT,
-        VK_DYNAMIC_STATE_SCISSOR
-      };
+    sContext->frDrawDataLayout = new fr::frDescriptorLayout();
+    sContext->frDrawDataLayout->addBinding(VkDescriptorSetLayoutBinding{
+      0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1,
+      VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+      VK_NULL_HANDLE
+    });
+    sContext->frDrawDataLayout->initialize(sContext->frRenderer);
 
-      sContext->frPipeline->setDynamicState(VkPipelineDynamicStateCreateInfo{
-        VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
-        static_cast<uint32_t>(dynamicStates.size()), dynamicStates.data()
-      });
+    // The frame sets are written whole every frame they're used, one template call each.
+    sCameraTemplate.initialize(sContext->frUboLayout->get(), {
+      { 0, 0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, sizeof(VkDescriptorBufferInfo) },
+    });
+    sTransformsTemplate.initialize(sContext->frStorageBufLayout->get(), {
+      { 0, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0, sizeof(VkDescriptorBufferInfo) },
+    });
+    sLightsTemplate.initialize(sContext->frLightsLayout->get(), {
+      { 0, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0, sizeof(VkDescriptorBufferInfo) },
+      { 1, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, sizeof(VkDescriptorBufferInfo), sizeof(VkDescriptorBufferInfo) },
+      { 2, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, sizeof(VkDescriptorBufferInfo) * 2, sizeof(VkDescriptorBufferInfo) },
+    });
+    sDrawDataTemplate.initialize(sContext->frDrawDataLayout->get(), {
+      { 0, 0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 0, sizeof(VkDescriptorBufferInfo) },
+    });
 
-      sContext->frPipeline->setViewportState(VkPipelineViewportStateCreateInfo{
-        VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
-        1, nullptr, 1, nullptr
-      });
+    purrPipelineCache::getDefault()->initialize(sContext->settings.pipelineCachePath);
 
-      sContext->frPipeline->addDescriptor(sContext->frTextureLayout);
+    { // Swapchain Pipeline
+      purrPipelineCache *cache = purrPipelineCache::getDefault();
+
+      VkDescriptorSetLayout setLayout = sContext->frTextureLayout->get();
+      VkPipelineLayoutCreateInfo layoutInfo{};
+      layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+      layoutInfo.setLayoutCount = 1;
+      layoutInfo.pSetLayouts = &setLayout;
+      VkPushConstantRange pushConstant = { VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(CompositeConstants) };
+      layoutInfo.pushConstantRangeCount = 1;
+      layoutInfo.pPushConstantRanges = &pushConstant;
+      if (vkCreatePipelineLayout(sContext->frRenderer->getDevice(), &layoutInfo, nullptr, &sSwapchainPipelineLayout) != VK_SUCCESS) {
+        fprintf(stderr, "[renderer]: Failed to create swapchain pipeline layout!\n");
+      }
 
-      sContext->frPipeline->initialize(sContext->frRenderer, sContext->frRenderPass);
+      sSwapchainPipeline = createCompositePipeline(cache->getShaderModule(fragmentShader_program), sSwapchainPipelineLayout);
 
-      delete vertShader;
-      delete fragShader;
-      delete pbrFragShader;
-      delete pbrVertShader;
+      if (sContext->settings.dynamicResolution) {
+        std::string path = std::string(sContext->settings.shaderPath) + "upscale.frag.spv";
+        VkShaderModule upscaleShader = cache->getShaderModule(path.c_str());
+        if (upscaleShader) sUpscalePipeline = createCompositePipeline(upscaleShader, sSwapchainPipelineLayout);
+        if (!sUpscalePipeline) fprintf(stderr, "[renderer]: No upscaling composite (%s), dynamic resolution is disabled.\n", path.c_str());
+        sDynamicResolution.reset();
+      }
     }
 
-    createSwapchainObjects();
+    if (headless) createHeadlessObjects();
+    else createSwapchainObjects();
 
     sContext->frCommands = new fr::frCommands();
     sContext->frCommands->initialize(sContext->frRenderer);
 
-    sCmdBufs = sContext->frCommands->allocateBuffers(VK_COMMAND_BUFFER_LEVEL_PRIMARY, sImageCount);
-
-    sContext->frDescriptors = new fr::frDescriptors();
-    sContext->frDescriptors->initialize(sContext->frRenderer, {
-      { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 },
-      { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 },
-      { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 },
-    });
+    uint32_t framesInFlight = sContext->settings.framesInFlight;
+    if (framesInFlight == 0) framesInFlight = 1;
+    sFrames.resize(framesInFlight);
+    for (FrameData &frame: sFrames) createFrameData(frame);
+    sFrame = 0;
 
-    sContext->frTextureDescriptors = new fr::frDescriptors();
-    sContext->frTextureDescriptors->initialize(sContext->frRenderer, {
-      { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2048 },
-    });
+    purrProfiler::getDefault()->initialize(framesInFlight);
 
-    for (size_t i = 0; i < sImageCount; ++i) {
-      fr::frSynchronization *sync = new fr::frSynchronization();
-      sync->initialize(sContext->frRenderer);
-      sSynchronizations.push_back(sync);
-    }
+    sNoShadowMap = new purrTexture(1, 1, VK_FORMAT_R8G8B8A8_UNORM);
+    sNoShadowMap->initialize(purrSampler::getDefault(), false);
+    sNoShadowMap->setPixels(std::vector<uint8_t>{ 255, 255, 255, 255 });
 
     sContext->frDepthFormat = sContext->frRenderer->FindSupportedFormat({VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT}, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
   }
 
   void renderer::getSwapchainSize(int *width, int *height) {
+    if (sContext->settings.headless) {
+      *width = sHeadlessWidth;
+      *height = sHeadlessHeight;
+      return;
+    }
     sContext->frSwapchain->getSize(width, height);
   }
 
@@ -311,142 +740,402 @@ namespace PurrfectEngine {
     sSceneDescriptor = scenePipeline->getColor()->getDescriptor();
   }
 
-  void renderer::updateCamera() {
-    if (!sCameraBuffer) {
-      sCameraBuffer = new fr::frBuffer();
-      sCameraBuffer->initialize(sContext->frRenderer, fr::frBuffer::frBufferInfo{
-        sizeof(CameraUBO), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, {}
-      });
-
-      VkDescriptorBufferInfo bufferInfo = {
-        sCameraBuffer->get(), 0, sizeof(CameraUBO)
-      };
-      sCameraUBO = sContext->frDescriptors->allocate(1, sContext->frUboLayout)[0];
-      sCameraUBO->update(fr::frDescriptor::frDescriptorWriteInfo{
-        0, 0, 1,
-        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-        VK_NULL_HANDLE, &bufferInfo, VK_NULL_HANDLE
-      });
-    }
+  void renderer::setMsaa(MSAA msaa) {
+    sContext->settings.msaa = msaa;
+    if (!sScenePipeline || sScenePipeline->getSampleCount() == static_cast<VkSampleCountFlagBits>(msaa)) return;
+    // Frames in flight still use the old framebuffer.
+    waitIdle();
+    sScenePipeline->setSampleCount(static_cast<VkSampleCountFlagBits>(msaa));
+  }
 
-    if (!sContext->activeScene) return;
-    purrObject *cameraObj = sContext->activeScene->getCamera();
-    if (!cameraObj) return;
-    purrCameraComp *cameraComp = (purrCameraComp*)cameraObj->getComponent("cameraComponent");
-    if (!cameraComp) return;
-    purrCamera *camera = cameraComp->getCamera();
+  void renderer::updateCamera() {
+    PURR_PROFILE_SCOPE("updateCamera");
+    const purrRenderSnapshot *snapshot = getSnapshot();
+    if (!snapshot->hasCamera) return;
 
     CameraUBO cameraUbo = {};
-    cameraUbo.projection = camera->getProjection();
-    cameraUbo.view = camera->getView();
-    sCameraBuffer->copyData(0, sizeof(cameraUbo), &cameraUbo);
+    cameraUbo.projection = snapshot->camera.projection;
+    cameraUbo.view = snapshot->camera.view;
+    sFrames[sFrame].cameraBuffer->copyData(0, sizeof(cameraUbo), &cameraUbo);
   }
 
   void renderer::updateTransforms() {
-    VkDeviceSize bufSize = sizeof(glm::mat4) * (sTransformsBufCap>0?sTransformsBufCap:(sTransformsBufCap=256));
-    bool cleanup = true;
-    if (!sTransformsBuffer) {
-      sTransformsBuffer = new fr::frBuffer();
-      sTransformsBufDirty = true;
-      cleanup = false;
-    }
-
-    if (sTransformsBufDirty) {
-      if (cleanup) sTransformsBuffer->cleanup();
-      sTransformsBuffer->initialize(sContext->frRenderer, fr::frBuffer::frBufferInfo{
-        bufSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, {}
-      });
-      sTransformsBufDirty = false;
-    }
-
-    if (!sTransformsDesc) {
-      VkDescriptorBufferInfo bufferInfo = {
-        sTransformsBuffer->get(), 0, bufSize
-      };
-      sTransformsDesc = sContext->frDescriptors->allocate(1, sContext->frStorageBufLayout)[0];
-      sTransformsDesc->update(fr::frDescriptor::frDescriptorWriteInfo{
-        0, 0, 1,
-        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-        VK_NULL_HANDLE, &bufferInfo, VK_NULL_HANDLE
-      });
+    PURR_PROFILE_SCOPE("updateTransforms");
+    const std::vector<glm::mat4> &transforms = getSnapshot()->transforms;
+    if (transforms.empty()) return;
+
+    FrameData &frame = sFrames[sFrame];
+    if (static_cast<uint32_t>(transforms.size()) > frame.transformsBufCap) {
+      // Only this frame's buffer is replaced, the GPU is done with it (renderBegin waited on its fence).
+      while (static_cast<uint32_t>(transforms.size()) > frame.transformsBufCap) frame.transformsBufCap*=2;
+      frame.transformsBuffer->initialize(sizeof(glm::mat4) * frame.transformsBufCap, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, purrMemoryCategory::Frame);
+      // A set written for the old buffer may already be bound this frame, it isn't updated but replaced.
+      frame.transformsSet = VK_NULL_HANDLE;
     }
 
-    if (!sContext->activeScene) return;
-    std::vector<purrObject*> objects = sContext->activeScene->getObjects();
+    frame.transformsBuffer->copyData(0, sizeof(glm::mat4)*transforms.size(), transforms.data());
+  }
+
+  void renderer::updateLights() {
+    PURR_PROFILE_SCOPE("updateLights");
+    const purrRenderSnapshot *snapshot = getSnapshot();
+    if (!snapshot->hasCamera) return;
+    const purrRenderCamera &camera = snapshot->camera;
+    const std::vector<purrLight> &lights = snapshot->lights;
+
+    glm::mat4 view = camera.view;
+    sLightClusters.build(lights, view, camera.projection, camera.settings.nearPlane, camera.settings.farPlane);
+
+    // Tiles are mapped from gl_FragCoord, which only covers the scaled part of the target with dynamic resolution.
+    VkExtent2D extent{};
+    if (sScenePipeline) extent = sScenePipeline->getRenderExtent();
+    else {
+      int w = 0, h = 0;
+      getSwapchainSize(&w, &h);
+      extent = { static_cast<uint32_t>(w), static_cast<uint32_t>(h) };
+    }
 
-    if (static_cast<uint32_t>(objects.size()) >= sTransformsBufCap) {
-      while (static_cast<uint32_t>(objects.size()) >= sTransformsBufCap) sTransformsBufCap*=2;
-      sTransformsBufDirty = true;
-      updateTransforms();
-      return;
+    glm::uvec3 grid = sLightClusters.getGridSize();
+    glm::vec2 sliceScaleBias = sLightClusters.getSliceScaleBias();
+    LightsHeader header{};
+    header.view = view;
+    header.grid = glm::uvec4(grid.x, grid.y, grid.z, static_cast<uint32_t>(lights.size()));
+    header.slicing = glm::vec4(sliceScaleBias.x, sliceScaleBias.y, static_cast<float>(extent.width), static_cast<float>(extent.height));
+    header.eye = glm::vec4(camera.position, 1.0f);
+    header.sunDirection = glm::vec4(-glm::normalize(sSun.direction), 0.0f);
+    header.sunColor = glm::vec4(sSun.color * sSun.intensity, 0.0f);
+    if (sShadows && sShadows->getShadowMap()) {
+      const std::vector<purrShadowCascade> &cascades = sShadows->getCascades();
+      uint32_t columns = sShadows->getAtlasColumns();
+      uint32_t rows = (static_cast<uint32_t>(cascades.size()) + columns - 1) / columns;
+      header.sunDirection.w = static_cast<float>(cascades.size());
+      header.shadowAtlas = glm::vec4(static_cast<float>(columns), 1.0f / columns, 1.0f / rows, static_cast<float>(sShadows->getSettings().resolution));
+      for (uint32_t i = 0; i < cascades.size(); ++i) {
+        header.shadowSplits[i] = cascades[i].splitDepth;
+        header.shadowMatrices[i] = cascades[i].viewProjection;
+      }
     }
 
-    std::vector<glm::mat4> transforms{};
-    transforms.reserve(objects.size());
-    for (purrObject *object: objects) transforms.push_back(object->getTransform()->getTransform());
-    uint32_t size = static_cast<uint32_t>(transforms.size());
-    sTransformsBuffer->copyData(0, sizeof(glm::mat4)*size, transforms.data());
+    const std::vector<glm::uvec2> &clusters = sLightClusters.getClusters();
+    const std::vector<uint32_t> &indices = sLightClusters.getIndices();
+    FrameData &frame = sFrames[sFrame];
+    // Only this frame's buffers are replaced, the GPU is done with them (renderBegin waited on its fence).
+    bool dirty = reserveStorageBuffer(frame.lightsBuffer, &frame.lightsBufSize, sizeof(LightsHeader) + sizeof(purrLight) * lights.size());
+    dirty |= reserveStorageBuffer(frame.clustersBuffer, &frame.clustersBufSize, sizeof(glm::uvec2) * clusters.size());
+    dirty |= reserveStorageBuffer(frame.lightIndicesBuffer, &frame.lightIndicesBufSize, sizeof(uint32_t) * indices.size());
+    if (dirty) frame.lightsSet = VK_NULL_HANDLE;
+
+    frame.lightsBuffer->copyData(0, sizeof(header), &header);
+    if (!lights.empty()) frame.lightsBuffer->copyData(sizeof(header), sizeof(purrLight) * lights.size(), lights.data());
+    frame.clustersBuffer->copyData(0, sizeof(glm::uvec2) * clusters.size(), clusters.data());
+    if (!indices.empty()) frame.lightIndicesBuffer->copyData(0, sizeof(uint32_t) * indices.size(), indices.data());
   }
 
   bool renderer::shouldClose() {
+    if (sContext->settings.headless) return false;
     return sContext->frWindow->shouldClose();
   }
 
   bool renderer::renderBegin() {
-    sSynchronizations[sFrame]->wait();
+    FrameData &frame = sFrames[sFrame];
+    if (sContext->settings.headless) {
+      VkDevice device = sContext->frRenderer->getDevice();
+      vkWaitForFences(device, 1, &frame.fence, VK_TRUE, UINT64_MAX);
+      // The frame that used this slot last is done, its pixels can be handed out without stalling.
+      deliverReadback(frame);
+      vkResetFences(device, 1, &frame.fence);
+      resetFrameDescriptors(frame);
+      sFrameArena.reset();
+      sImageIndex = sFrame;
+
+      purrRenderTargetPool::getDefault()->nextFrame();
+
+      vkResetCommandPool(device, frame.commands->get(), 0);
+      (*sContext).frActiveCmdBuf = frame.cmdBuf;
+      fr::frCommands::begin(frame.cmdBuf);
+      purrProfiler::getDefault()->beginFrame(frame.cmdBuf, sFrame);
+      updateRenderScale();
+      return true;
+    }
+
+    frame.sync->wait();
 
     try {
-      sImageIndex = sContext->frRenderer->acquireNextImage(sContext->frSwapchain, sSynchronizations[sFrame]);
+      sImageIndex = sContext->frRenderer->acquireNextImage(sContext->frSwapchain, frame.sync);
     } catch (fr::frSwapchainResizeException &ex) {
       recreateSwapchain();
       return false;
     }
 
-    sSynchronizations[sFrame]->reset();
+    // With fewer frames in flight than swapchain images, an image can come back while another frame still renders to it.
+    if (sImagesInFlight[sImageIndex] && sImagesInFlight[sImageIndex] != frame.sync) sImagesInFlight[sImageIndex]->wait();
+    sImagesInFlight[sImageIndex] = frame.sync;
+
+    frame.sync->reset();
+    resetFrameDescriptors(frame);
+    sFrameArena.reset();
 
-    vkResetCommandBuffer(sCmdBufs[sFrame], 0);
-    (*sContext).frActiveCmdBuf = sCmdBufs[sFrame];
-    fr::frCommands::begin(sCmdBufs[sFrame]);
+    purrRenderTargetPool::getDefault()->nextFrame();
+
+    vkResetCommandPool(sContext->frRenderer->getDevice(), frame.commands->get(), 0);
+    (*sContext).frActiveCmdBuf = frame.cmdBuf;
+    fr::frCommands::begin(frame.cmdBuf);
+    purrProfiler::getDefault()->beginFrame(frame.cmdBuf, sFrame);
+    updateRenderScale();
 
     return true;
   }
 
-  void renderer::bindCamera(fr::frPipeline *pipeline) {
-    pipeline->bindDescriptor(sCmdBufs[sFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, 0, sCameraUBO);
+  void renderer::bindCamera(VkPipelineLayout layout) {
+    VkDescriptorSet set = getCameraSet(sFrames[sFrame]);
+    vkCmdBindDescriptorSets(sFrames[sFrame].cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &set, 0, nullptr);
   }
 
-  void renderer::bindTransforms(fr::frPipeline *pipeline) {
-    pipeline->bindDescriptor(sCmdBufs[sFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, 1, sTransformsDesc);
+  void renderer::bindTransforms(VkPipelineLayout layout) {
+    VkDescriptorSet set = getTransformsSet(sFrames[sFrame]);
+    vkCmdBindDescriptorSets(sFrames[sFrame].cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 1, 1, &set, 0, nullptr);
   }
 
-  void renderer::renderScene(purrPipeline *pipeline) {
-    purrScene *scene = sContext->activeScene;
+  void renderer::bindLights(VkPipelineLayout layout) {
+    purrTexture *shadowMap = (sShadows && sShadows->getShadowMap()) ? sShadows->getShadowMap() : sNoShadowMap;
+    VkDescriptorSet sets[2] = { getLightsSet(sFrames[sFrame]), shadowMap->getDescriptor() };
+    vkCmdBindDescriptorSets(sFrames[sFrame].cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 2, 2, sets, 0, nullptr);
+  }
+
+  purrRingBuffer *renderer::getDrawData() {
+    return sFrames[sFrame].drawData;
+  }
+
+  void renderer::bindDrawData(VkPipelineLayout layout, uint32_t set, const purrRingAllocation &allocation) {
+    VkDescriptorSet descriptor = getDrawDataSet(sFrames[sFrame], allocation.block);
+    if (!descriptor) return;
+    vkCmdBindDescriptorSets(sFrames[sFrame].cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, set, 1, &descriptor, 1, &allocation.offset);
+  }
+
+  void renderer::setDrawDataCallback(DrawDataCallback callback) {
+    sDrawDataCallback = callback;
+  }
+
+  void renderer::setDirectionalLight(const purrDirectionalLight &light) {
+    sSun = light;
+  }
+
+  void renderer::setShadows(purrCascadedShadows *shadows) {
+    sShadows = shadows;
+  }
+
+  void renderer::setInterpolation(float alpha) {
+    sInterpolation = glm::clamp(alpha, 0.0f, 1.0f);
+  }
+
+  float renderer::getInterpolation() {
+    return sInterpolation;
+  }
+
+  void renderer::extractSnapshot(purrScene *scene, purrRenderSnapshot *snapshot) {
+    PURR_PROFILE_SCOPE("extractSnapshot");
+    snapshot->clear();
+    snapshot->frame = sSnapshotCount++;
     if (!scene) return;
-    std::vector<purrObject*> objects = scene->getObjects();
-    uint32_t idx = 0;
-    for (purrObject *obj: objects) {
-      purrComponent *meshComp = nullptr;
-      if ((meshComp = obj->getComponent("meshComponent"))) {
-        pipeline->get()->pushConstant(sCmdBufs[sFrame],
-                                      VK_SHADER_STAGE_VERTEX_BIT,
-                                      (uint32_t)0, 
-                                      static_cast<uint32_t>(sizeof(uint32_t)), 
-                                      (const void*)&idx);
-        ((purrMeshComp*)meshComp)->getMesh()->render(sCmdBufs[sFrame]);
+
+    purrObject *cameraObj = scene->getCamera();
+    purrCameraComp *cameraComp = cameraObj ? (purrCameraComp*)cameraObj->getComponent("cameraComponent") : nullptr;
+    if (cameraComp) {
+      purrCamera *camera = cameraComp->getCamera();
+      snapshot->hasCamera = true;
+      snapshot->camera.view = camera->getInterpolatedView(sInterpolation);
+      snapshot->camera.projection = camera->getProjection();
+      snapshot->camera.position = cameraObj->getTransform()->getInterpolatedPosition(sInterpolation);
+      snapshot->camera.settings = camera->getSettings();
+    }
+
+    const std::vector<purrObject*> &objects = scene->getObjects();
+    uint32_t drawDataSize = (sScenePipeline && sDrawDataCallback) ? sScenePipeline->getDrawDataSize() : 0;
+    snapshot->drawDataSize = drawDataSize;
+    snapshot->drawData.assign(static_cast<size_t>(drawDataSize) * objects.size(), 0);
+    for (uint32_t idx = 0; idx < static_cast<uint32_t>(objects.size()); ++idx) {
+      purrObject *object = objects[idx];
+      snapshot->transforms.push_back(object->getTransform()->getInterpolated(sInterpolation));
+
+      purrRenderObject renderObject{};
+      purrMeshComp *meshComp = (purrMeshComp*)object->getComponent("meshComponent");
+      if (meshComp) renderObject.mesh = meshComp->getMesh();
+      renderObject.occluder = (purrOccluderComp*)object->getComponent("occluderComponent");
+      renderObject.emitter = (purrParticleComp*)object->getComponent("particleComponent");
+      renderObject.isStatic = object->isStatic();
+      renderObject.uuid = object->getUuid()();
+      snapshot->objects.push_back(renderObject);
+
+      purrLightComp *lightComp = (purrLightComp*)object->getComponent("lightComponent");
+      if (lightComp) {
+        snapshot->lights.push_back(purrLight{
+          object->getTransform()->getInterpolatedPosition(sInterpolation), lightComp->getRadius(),
+          lightComp->getColor(), lightComp->getIntensity()
+        });
+      }
+      if (drawDataSize && renderObject.mesh) sDrawDataCallback(object, idx, &snapshot->drawData[static_cast<size_t>(idx) * drawDataSize]);
+    }
+  }
+
+  void renderer::setSnapshot(const purrRenderSnapshot *snapshot) {
+    sSnapshot = snapshot;
+  }
+
+  const purrRenderSnapshot *renderer::getSnapshot() {
+    if (sSnapshot) return sSnapshot;
+    if (sLiveSnapshotFrame != sFrameCount) {
+      extractSnapshot(sContext->activeScene, &sLiveSnapshot);
+      sLiveSnapshotFrame = sFrameCount;
+    }
+    return &sLiveSnapshot;
+  }
+
+  void renderer::setOcclusionCuller(purrOcclusionCuller *culler) {
+    sOcclusion = culler;
+  }
+
+  void renderer::setPostProcess(purrPostProcess *post) {
+    sPostProcess = post;
+    if (!post || sPostPipeline) return;
+
+    VkDescriptorSetLayout setLayouts[2] = { sContext->frTextureLayout->get(), post->getCompositeLayout() };
+    VkPushConstantRange pushConstant = { VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PostConstants) };
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 2;
+    layoutInfo.pSetLayouts = setLayouts;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstant;
+    if (!sPostPipelineLayout && vkCreatePipelineLayout(sContext->frRenderer->getDevice(), &layoutInfo, nullptr, &sPostPipelineLayout) != VK_SUCCESS) {
+      fprintf(stderr, "[renderer]: Failed to create post-process pipeline layout!\n");
+      sPostPipelineLayout = VK_NULL_HANDLE;
+      return;
+    }
+    std::string path = std::string(sContext->settings.shaderPath) + "post.frag.spv";
+    VkShaderModule postShader = purrPipelineCache::getDefault()->getShaderModule(path.c_str());
+    if (postShader) sPostPipeline = createCompositePipeline(postShader, sPostPipelineLayout);
+    if (!sPostPipeline) fprintf(stderr, "[renderer]: No post-process composite (%s), the scene is composited as is.\n", path.c_str());
+  }
+
+  void renderer::buildDrawList(purrPipeline *pipeline) {
+    PURR_PROFILE_SCOPE("buildDrawList");
+    sDrawList.clear();
+    sDrawListFrame = sFrameCount;
+    const purrRenderSnapshot *snapshot = getSnapshot();
+
+    glm::mat4 view = snapshot->camera.view;
+    bool prepass = pipeline->getPrepass() != VK_NULL_HANDLE;
+
+    for (uint32_t idx = 0; idx < static_cast<uint32_t>(snapshot->objects.size()); ++idx) {
+      purrMesh *mesh = snapshot->objects[idx].mesh;
+      if (!mesh || (sOcclusion && !sOcclusion->isVisible(idx))) continue;
+
+      glm::vec4 sphere = mesh->getBoundingSphere();
+      const glm::mat4 &model = snapshot->transforms[idx];
+      glm::vec4 center = view * (model * glm::vec4(sphere.x, sphere.y, sphere.z, 1.0f));
+      // The camera looks down -z in view space.
+      float depth = -center.z;
+
+      if (prepass) sDrawList.add(purrDrawPass::DepthPrepass, pipeline, 0, mesh, idx, depth);
+      sDrawList.add(purrDrawPass::Opaque, pipeline, 0, mesh, idx, depth);
+    }
+    sDrawList.sort();
+  }
+
+  purrDrawList *renderer::getDrawList() {
+    return &sDrawList;
+  }
+
+  purrFrameArena *renderer::getFrameArena() {
+    return &sFrameArena;
+  }
+
+  static void drawRange(purrPipeline *pipeline, purrDrawPass pass) {
+    VkCommandBuffer cmdBuf = sFrames[sFrame].cmdBuf;
+    const std::vector<purrDrawItem> &items = sDrawList.getItems();
+    uint32_t first = 0, count = 0;
+    sDrawList.getRange(pass, &first, &count);
+    // Depth only draws don't read per-draw data.
+    uint32_t drawDataSize = pass == purrDrawPass::DepthPrepass ? 0 : pipeline->getDrawDataSize();
+    // Written by the draw data callback when the snapshot was extracted, for the scene pipeline's size.
+    const purrRenderSnapshot *snapshot = renderer::getSnapshot();
+    bool hasDrawData = drawDataSize && drawDataSize <= snapshot->drawDataSize;
+    for (uint32_t i = first; i < first + count; ++i) {
+      vkCmdPushConstants(cmdBuf, pipeline->getLayout(),
+                         VK_SHADER_STAGE_VERTEX_BIT,
+                         (uint32_t)0,
+                         static_cast<uint32_t>(sizeof(uint32_t)),
+                         (const void*)&items[i].objectIndex);
+      if (drawDataSize) {
+        purrRingAllocation allocation = sFrames[sFrame].drawData->allocate(drawDataSize);
+        if (allocation.data) {
+          memset(allocation.data, 0, drawDataSize);
+          size_t offset = static_cast<size_t>(items[i].objectIndex) * snapshot->drawDataSize;
+          if (hasDrawData && offset < snapshot->drawData.size()) memcpy(allocation.data, &snapshot->drawData[offset], drawDataSize);
+          renderer::bindDrawData(pipeline->getLayout(), pipeline->getDrawDataSet(), allocation);
+        }
       }
-      ++idx;
+      items[i].mesh->render(cmdBuf);
+    }
+  }
+
+  void renderer::renderScene(purrPipeline *pipeline) {
+    PURR_PROFILE_SCOPE("renderScene");
+    if (!pipeline->isBound()) return;
+    if (sDrawListFrame != sFrameCount) buildDrawList(pipeline);
+
+    if (pipeline->isPrepassActive()) {
+      drawRange(pipeline, purrDrawPass::DepthPrepass);
+      vkCmdBindPipeline(sFrames[sFrame].cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->get());
     }
+    drawRange(pipeline, purrDrawPass::Opaque);
   }
 
   void renderer::render() {
     std::vector<VkClearValue> clearValues = {};
     clearValues.push_back({{{1.0f, 1.0f, 1.0f, 1.0f}}});
 
-    sContext->frRenderPass->begin(sCmdBufs[sFrame], sContext->frSwapchain->extent(), sContext->frFbs[sImageIndex], clearValues);
-
-    sContext->frPipeline->bind(sCmdBufs[sFrame], VK_PIPELINE_BIND_POINT_GRAPHICS);
-
-    auto scExtent = sContext->frSwapchain->extent();
+    // Its compute passes can't run inside the swapchain render pass.
+    bool post = sPostProcess && sPostPipeline && sScenePipeline;
+    if (post) sPostProcess->build(sScenePipeline->getColor(), sScenePipeline->getRenderExtent());
+    post = post && sPostProcess->isReady();
+
+    purrProfiler::getDefault()->beginGpuZone(sFrames[sFrame].cmdBuf, "Composite");
+    int w = 0, h = 0;
+    getSwapchainSize(&w, &h);
+    VkExtent2D scExtent = { static_cast<uint32_t>(w), static_cast<uint32_t>(h) };
+    sContext->frRenderPass->begin(sFrames[sFrame].cmdBuf, scExtent, sContext->frFbs[sImageIndex], clearValues);
+
+    bool upscale = sUpscalePipeline && sScenePipeline;
+    VkPipelineLayout compositeLayout = post ? sPostPipelineLayout : sSwapchainPipelineLayout;
+    vkCmdBindPipeline(sFrames[sFrame].cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, post ? sPostPipeline : upscale ? sUpscalePipeline : sSwapchainPipeline);
+    if (post) {
+      purrTexture *target = sScenePipeline->getColor();
+      VkExtent2D renderExtent = sScenePipeline->getRenderExtent();
+      purrPostProcessSettings settings = sPostProcess->getSettings();
+      PostConstants constants{};
+      constants.uvScale = glm::vec2(static_cast<float>(renderExtent.width) / target->getWidth(), static_cast<float>(renderExtent.height) / target->getHeight());
+      constants.texelSize = glm::vec2(1.0f / target->getWidth(), 1.0f / target->getHeight());
+      constants.sharpness = upscale ? sDynamicResolution.getSettings().sharpness : 0.0f;
+      constants.bloomIntensity = settings.bloomIntensity;
+      constants.exposure = std::exp2(settings.exposureCompensation) * (settings.autoExposure ? 1.0f : settings.exposure);
+      constants.flags = (settings.autoExposure ? 1u : 0u) | (static_cast<uint32_t>(settings.tonemapper) << 1) | (settings.bloom ? 8u : 0u);
+      constants.bloomScale = sPostProcess->getBloomScale();
+      constants.saturation = settings.saturation;
+      constants.contrast = settings.contrast;
+      constants.lift = glm::vec4(settings.lift, 0.0f);
+      constants.gamma = glm::vec4(settings.gamma, 0.0f);
+      constants.gain = glm::vec4(settings.gain, 0.0f);
+      vkCmdPushConstants(sFrames[sFrame].cmdBuf, sPostPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(constants), &constants);
+    } else if (upscale) {
+      purrTexture *target = sScenePipeline->getColor();
+      VkExtent2D renderExtent = sScenePipeline->getRenderExtent();
+      CompositeConstants constants{};
+      constants.uvScale = glm::vec2(static_cast<float>(renderExtent.width) / target->getWidth(), static_cast<float>(renderExtent.height) / target->getHeight());
+      constants.texelSize = glm::vec2(1.0f / target->getWidth(), 1.0f / target->getHeight());
+      constants.sharpness = sDynamicResolution.getSettings().sharpness;
+      vkCmdPushConstants(sFrames[sFrame].cmdBuf, sSwapchainPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(constants), &constants);
+    }
 
     VkViewport viewport{};
     viewport.x = 0.0f;
@@ -455,62 +1144,163 @@ namespace PurrfectEngine {
     viewport.height = static_cast<float>(scExtent.height);
     viewport.minDepth = 0.0f;
     viewport.maxDepth = 1.0f;
-    vkCmdSetViewport(sCmdBufs[sFrame], 0, 1, &viewport);
+    vkCmdSetViewport(sFrames[sFrame].cmdBuf, 0, 1, &viewport);
 
     VkRect2D scissor{};
     scissor.offset = {0, 0};
     scissor.extent = scExtent;
-    vkCmdSetScissor(sCmdBufs[sFrame], 0, 1, &scissor);
+    vkCmdSetScissor(sFrames[sFrame].cmdBuf, 0, 1, &scissor);
 
-    if (sSceneDescriptor) sContext->frPipeline->bindDescriptor(sCmdBufs[sFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, 0, sSceneDescriptor);
+    if (sSceneDescriptor) {
+      VkDescriptorSet set = sSceneDescriptor;
+      vkCmdBindDescriptorSets(sFrames[sFrame].cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, compositeLayout, 0, 1, &set, 0, nullptr);
+    }
+    if (post) {
+      VkDescriptorSet set = sPostProcess->getCompositeSet();
+      vkCmdBindDescriptorSets(sFrames[sFrame].cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, sPostPipelineLayout, 1, 1, &set, 0, nullptr);
+    }
     purrMesh2D *squareMesh = purrMesh2D::getSquareMesh();
-    squareMesh->render(sCmdBufs[sFrame]);
+    squareMesh->render(sFrames[sFrame].cmdBuf);
 
-    sContext->frRenderPass->end(sCmdBufs[sFrame]);
+    sContext->frRenderPass->end(sFrames[sFrame].cmdBuf);
+    purrProfiler::getDefault()->endGpuZone(sFrames[sFrame].cmdBuf);
   }
 
   bool renderer::present() {
-    fr::frCommands::end(sCmdBufs[sFrame]);
+    PURR_PROFILE_SCOPE("present");
+    FrameData &frame = sFrames[sFrame];
+    purrProfiler::getDefault()->endFrame(frame.cmdBuf);
+    if (sContext->settings.headless) {
+      if (sReadbackCallback && frame.readbackData) {
+        VkBufferImageCopy region{};
+        region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        region.imageExtent = { static_cast<uint32_t>(sHeadlessWidth), static_cast<uint32_t>(sHeadlessHeight), 1 };
+        vkCmdCopyImageToBuffer(frame.cmdBuf, sContext->frScImages[sImageIndex]->get(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, frame.readbackBuffer, 1, &region);
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(frame.cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+        frame.readbackPending = true;
+        frame.readbackFrame = sFrameCount;
+      }
+
+      fr::frCommands::end(frame.cmdBuf);
+      (*sContext).frActiveCmdBuf = VK_NULL_HANDLE;
+
+      VkSubmitInfo submitInfo{};
+      submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+      submitInfo.commandBufferCount = 1;
+      submitInfo.pCommandBuffers = &frame.cmdBuf;
+      if (vkQueueSubmit(sContext->frRenderer->getGraphicsQueue(), 1, &submitInfo, frame.fence) != VK_SUCCESS) {
+        fprintf(stderr, "[renderer]: Failed to submit headless frame!\n");
+      }
+
+      renderer::getFramePacer()->framePresented();
+      ++sFrameCount;
+      sFrame = (sFrame+1) % static_cast<uint32_t>(sFrames.size());
+      return true;
+    }
+
+    fr::frCommands::end(frame.cmdBuf);
     (*sContext).frActiveCmdBuf = VK_NULL_HANDLE;
-    fr::frCommands::submit(sContext->frRenderer, sCmdBufs[sFrame], sSynchronizations[sFrame]);
+    fr::frCommands::submit(sContext->frRenderer, frame.cmdBuf, frame.sync);
     try {
-      sContext->frRenderer->present(sContext->frSwapchain, sSynchronizations[sFrame], &sImageIndex);
+      sContext->frRenderer->present(sContext->frSwapchain, frame.sync, &sImageIndex);
     } catch (fr::frSwapchainResizeException &ex) {
       sScDirty = true;
     }
+    renderer::getFramePacer()->framePresented();
 
     if (sScDirty) {
       recreateSwapchain();
       sScDirty = false;
-      sFrame = (sFrame+1) % sContext->frSwapchain->imageCount();
+      ++sFrameCount;
+      sFrame = (sFrame+1) % static_cast<uint32_t>(sFrames.size());
       return false;
     }
-    sFrame = (sFrame+1) % sContext->frSwapchain->imageCount();
+    ++sFrameCount;
+    sFrame = (sFrame+1) % static_cast<uint32_t>(sFrames.size());
     return true;
   }
 
+  void renderer::setReadbackCallback(ReadbackCallback callback) {
+    sReadbackCallback = callback;
+  }
+
+  void renderer::flushReadbacks() {
+    if (!sContext->settings.headless) return;
+    VkDevice device = sContext->frRenderer->getDevice();
+    // Oldest frame first, so callbacks see frames in order.
+    for (uint32_t i = 0; i < sFrames.size(); ++i) {
+      FrameData &frame = sFrames[(sFrame + i) % sFrames.size()];
+      vkWaitForFences(device, 1, &frame.fence, VK_TRUE, UINT64_MAX);
+      deliverReadback(frame);
+    }
+  }
+
+  purrDynamicResolution *renderer::getDynamicResolution() {
+    return &sDynamicResolution;
+  }
+
+  purrLightClusters *renderer::getLightClusters() {
+    return &sLightClusters;
+  }
+
+  uint32_t renderer::getFrameIndex() {
+    return sFrame;
+  }
+
+  uint32_t renderer::getFramesInFlight() {
+    return static_cast<uint32_t>(sFrames.size());
+  }
+
   void renderer::waitIdle() {
     sContext->frRenderer->waitIdle();
   }
 
   void renderer::cleanup() {
+    cleanupSwapchain();
+    purrRenderTargetPool::cleanupAll();
     purrSampler::cleanupAll();
     purrMesh::cleanupAll();
     purrMesh2D::cleanupAll();
 
-    delete sContext->frWindow;
-    cleanupSwapchain();
-    if (sCameraBuffer) delete sCameraBuffer;
-    if (sTransformsBuffer) delete sTransformsBuffer;
+    if (sContext->frWindow) delete sContext->frWindow;
+    for (FrameData &frame: sFrames) cleanupFrameData(frame);
+    sFrames.clear();
     delete sContext->frRenderPass;
-    delete sContext->frPipeline;
+    vkDestroyPipeline(sContext->frRenderer->getDevice(), sSwapchainPipeline, nullptr);
+    if (sUpscalePipeline) vkDestroyPipeline(sContext->frRenderer->getDevice(), sUpscalePipeline, nullptr);
+    sUpscalePipeline = VK_NULL_HANDLE;
+    if (sPostPipeline) vkDestroyPipeline(sContext->frRenderer->getDevice(), sPostPipeline, nullptr);
+    if (sPostPipelineLayout) vkDestroyPipelineLayout(sContext->frRenderer->getDevice(), sPostPipelineLayout, nullptr);
+    sPostPipeline = VK_NULL_HANDLE;
+    sPostPipelineLayout = VK_NULL_HANDLE;
+    sPostProcess = nullptr;
+    vkDestroyPipelineLayout(sContext->frRenderer->getDevice(), sSwapchainPipelineLayout, nullptr);
+    purrPipelineCache::cleanupAll();
+    purrProfiler::cleanupAll();
+    if (sFramePacer) delete sFramePacer;
+    sFramePacer = nullptr;
+    purrClock::cleanupAll();
+    purrWorkerPool::cleanupAll();
+    delete sNoShadowMap;
+    sNoShadowMap = nullptr;
+    // Last, everything above may still hold allocations.
+    purrGpuAllocator::cleanupAll();
+    purrDescriptorAllocator::cleanupAll();
+    sCameraTemplate.cleanup();
+    sTransformsTemplate.cleanup();
+    sLightsTemplate.cleanup();
+    sDrawDataTemplate.cleanup();
     delete sContext->frCommands;
-    delete sContext->frDescriptors;
-    delete sContext->frTextureDescriptors;
     delete sContext->frTextureLayout;
     delete sContext->frUboLayout;
     delete sContext->frStorageBufLayout;
-    for (auto sync: sSynchronizations) delete sync;
+    delete sContext->frLightsLayout;
+    delete sContext->frDrawDataLayout;
     delete sContext->frRenderer;
   }
 
@@ -615,4 +1405,61 @@ namespace PurrfectEngine {
     return 0;
   }
 
+  VkImageAspectFlags Utils::formatToAspect(VkFormat format) {
+    switch (format) {
+    case VK_FORMAT_D16_UNORM:
+    case VK_FORMAT_D32_SFLOAT:         return VK_IMAGE_ASPECT_DEPTH_BIT;
+    case VK_FORMAT_D24_UNORM_S8_UINT:
+    case VK_FORMAT_D32_SFLOAT_S8_UINT: return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    default: break;
+    }
+    return VK_IMAGE_ASPECT_COLOR_BIT;
+  }
+
+  uint64_t Utils::hash64(const void *data, size_t size, uint64_t seed) {
+    // FNV-1a
+    const uint8_t *bytes = static_cast<const uint8_t*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i) {
+      hash ^= bytes[i];
+      hash *= 0x100000001b3ULL;
+    }
+    return hash;
+  }
+
+  bool Utils::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties, uint32_t *index) {
+    VkPhysicalDeviceMemoryProperties memProperties{};
+    vkGetPhysicalDeviceMemoryProperties(sContext->frRenderer->getPhysicalDevice(), &memProperties);
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; ++i) {
+      if ((typeBits & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+        *index = i;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  VkPresentModeKHR Utils::choosePresentMode(VkPresentModeKHR requested, const std::vector<VkPresentModeKHR> &supported) {
+    // Immediate falls back to the next lowest latency mode, mailbox never to a tearing one. FIFO is always supported.
+    std::vector<VkPresentModeKHR> candidates{};
+    switch (requested) {
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:    candidates = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR }; break;
+    case VK_PRESENT_MODE_MAILBOX_KHR:      candidates = { VK_PRESENT_MODE_MAILBOX_KHR }; break;
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR: candidates = { VK_PRESENT_MODE_FIFO_RELAXED_KHR }; break;
+    default: break;
+    }
+    for (VkPresentModeKHR mode: candidates) {
+      if (std::find(supported.begin(), supported.end(), mode) != supported.end()) return mode;
+    }
+    return VK_PRESENT_MODE_FIFO_KHR;
+  }
+
+
+  void Utils::computeBarrier(VkCommandBuffer cmdBuf) {
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+  }
 }
\ No newline at end of file
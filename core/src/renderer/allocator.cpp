@@ -0,0 +1,573 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+#include <cinttypes>
+#include <cstring>
+#include <set>
+
+namespace PurrfectEngine {
+
+  static PurrfectEngineContext *sContext = nullptr;
+
+  static purrGpuAllocator *sDefaultAllocator = nullptr;
+
+  // Smallest piece the buddy and TLSF blocks hand out, smaller requests are rounded up.
+  #define ALLOCATOR_MIN_SIZE 256
+  // TLSF second level subdivisions per power of two, 2^5.
+  #define TLSF_SL_BITS 5
+  #define TLSF_SL_COUNT (1u << TLSF_SL_BITS)
+  #define TLSF_FL_COUNT 64
+  #define TLSF_NONE UINT32_MAX
+
+  static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+  }
+
+  static uint32_t highestBit(uint64_t value) {
+    uint32_t bit = 0;
+    while (value >>= 1) ++bit;
+    return bit;
+  }
+
+  static uint32_t lowestBit(uint64_t value) {
+    uint32_t bit = 0;
+    while (!(value & 1)) { value >>= 1; ++bit; }
+    return bit;
+  }
+
+  struct purrGpuAllocator::Block {
+    virtual ~Block() = default;
+    virtual bool allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize *offset, uint64_t *handle) = 0;
+    virtual void free(uint64_t handle) = 0;
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+    uint32_t memoryType = 0;
+    void *mapped = nullptr;
+    purrAllocStrategy strategy = purrAllocStrategy::Tlsf;
+    bool image = false;
+    uint32_t allocations = 0;
+    VkDeviceSize used = 0;
+  };
+
+  struct purrGpuAllocator::LinearBlock: purrGpuAllocator::Block {
+    VkDeviceSize head = 0;
+
+    bool allocate(VkDeviceSize allocSize, VkDeviceSize alignment, VkDeviceSize *offset, uint64_t *handle) override {
+      VkDeviceSize start = alignUp(head, alignment);
+      if (start + allocSize > size) return false;
+      head = start + allocSize;
+      *offset = start;
+      *handle = start;
+      return true;
+    }
+
+    void free(uint64_t) override {
+      // Only the last free gives the space back, the allocator decrements allocations before calling this.
+      if (allocations == 0) head = 0;
+    }
+  };
+
+  struct purrGpuAllocator::BuddyBlock: purrGpuAllocator::Block {
+    // Level 0 is the whole block, level n pieces are size >> n. Offsets are multiples of ALLOCATOR_MIN_SIZE,
+    // so handles keep the level in their low bits.
+    std::vector<std::set<VkDeviceSize>> freeLists{};
+
+    void init() {
+      freeLists.assign(highestBit(size / ALLOCATOR_MIN_SIZE) + 1, {});
+      freeLists[0].insert(0);
+    }
+
+    bool allocate(VkDeviceSize allocSize, VkDeviceSize alignment, VkDeviceSize *offset, uint64_t *handle) override {
+      // Pieces are aligned to their own size, a power of two at least as big as the alignment fits both.
+      VkDeviceSize need = std::max<VkDeviceSize>(std::max(allocSize, alignment), ALLOCATOR_MIN_SIZE);
+      need = VkDeviceSize(1) << (highestBit(need - 1) + 1);
+      if (need > size) return false;
+      uint32_t level = highestBit(size / need);
+
+      int32_t found = static_cast<int32_t>(level);
+      while (found >= 0 && freeLists[found].empty()) --found;
+      if (found < 0) return false;
+
+      VkDeviceSize start = *freeLists[found].begin();
+      freeLists[found].erase(freeLists[found].begin());
+      for (uint32_t split = static_cast<uint32_t>(found) + 1; split <= level; ++split) freeLists[split].insert(start + (size >> split));
+
+      *offset = start;
+      *handle = start | level;
+      return true;
+    }
+
+    void free(uint64_t handle) override {
+      uint32_t level = static_cast<uint32_t>(handle & (ALLOCATOR_MIN_SIZE - 1));
+      VkDeviceSize start = handle & ~static_cast<uint64_t>(ALLOCATOR_MIN_SIZE - 1);
+      while (level > 0) {
+        VkDeviceSize buddy = start ^ (size >> level);
+        auto it = freeLists[level].find(buddy);
+        if (it == freeLists[level].end()) break;
+        freeLists[level].erase(it);
+        start = std::min(start, buddy);
+        --level;
+      }
+      freeLists[level].insert(start);
+    }
+  };
+
+  struct purrGpuAllocator::TlsfBlock: purrGpuAllocator::Block {
+    struct Node {
+      VkDeviceSize offset, size;
+      uint32_t prevPhysical, nextPhysical;
+      uint32_t prevFree, nextFree;
+      bool free;
+    };
+
+    std::vector<Node> nodes{};
+    std::vector<uint32_t> unusedNodes{};
+    uint64_t flBitmap = 0;
+    uint32_t slBitmaps[TLSF_FL_COUNT]{};
+    uint32_t heads[TLSF_FL_COUNT][TLSF_SL_COUNT]{};
+
+    void init() {
+      for (uint32_t fl = 0; fl < TLSF_FL_COUNT; ++fl) for (uint32_t sl = 0; sl < TLSF_SL_COUNT; ++sl) heads[fl][sl] = TLSF_NONE;
+      nodes.push_back(Node{ 0, size, TLSF_NONE, TLSF_NONE, TLSF_NONE, TLSF_NONE, true });
+      insertFree(0);
+    }
+
+    // Every node is at least ALLOCATOR_MIN_SIZE, so fl >= TLSF_SL_BITS.
+    static void mapping(VkDeviceSize nodeSize, uint32_t *fl, uint32_t *sl) {
+      *fl = highestBit(nodeSize);
+      *sl = static_cast<uint32_t>(nodeSize >> (*fl - TLSF_SL_BITS)) & (TLSF_SL_COUNT - 1);
+    }
+
+    uint32_t newNode(const Node &node) {
+      if (unusedNodes.empty()) {
+        nodes.push_back(node);
+        return static_cast<uint32_t>(nodes.size() - 1);
+      }
+      uint32_t index = unusedNodes.back();
+      unusedNodes.pop_back();
+      nodes[index] = node;
+      return index;
+    }
+
+    void insertFree(uint32_t index) {
+      uint32_t fl, sl;
+      mapping(nodes[index].size, &fl, &sl);
+      nodes[index].free = true;
+      nodes[index].prevFree = TLSF_NONE;
+      nodes[index].nextFree = heads[fl][sl];
+      if (heads[fl][sl] != TLSF_NONE) nodes[heads[fl][sl]].prevFree = index;
+      heads[fl][sl] = index;
+      flBitmap |= uint64_t(1) << fl;
+      slBitmaps[fl] |= 1u << sl;
+    }
+
+    void removeFree(uint32_t index) {
+      uint32_t fl, sl;
+      mapping(nodes[index].size, &fl, &sl);
+      Node &node = nodes[index];
+      if (node.prevFree != TLSF_NONE) nodes[node.prevFree].nextFree = node.nextFree;
+      else heads[fl][sl] = node.nextFree;
+      if (node.nextFree != TLSF_NONE) nodes[node.nextFree].prevFree = node.prevFree;
+      if (heads[fl][sl] == TLSF_NONE) {
+        slBitmaps[fl] &= ~(1u << sl);
+        if (!slBitmaps[fl]) flBitmap &= ~(uint64_t(1) << fl);
+      }
+      node.free = false;
+    }
+
+    bool allocate(VkDeviceSize allocSize, VkDeviceSize alignment, VkDeviceSize *offset, uint64_t *handle) override {
+      VkDeviceSize need = std::max<VkDeviceSize>(allocSize, ALLOCATOR_MIN_SIZE);
+      // Any node of the class above the request (padding included) fits, no list has to be walked.
+      VkDeviceSize search = need + (alignment > 1 ? alignment - 1 : 0);
+      uint32_t fl, sl;
+      mapping(search, &fl, &sl);
+      search += (VkDeviceSize(1) << (fl - TLSF_SL_BITS)) - 1;
+      mapping(search, &fl, &sl);
+      if (fl >= TLSF_FL_COUNT) return false;
+
+      uint32_t slMap = slBitmaps[fl] & (~0u << sl);
+      if (!slMap) {
+        uint64_t flMap = fl + 1 < TLSF_FL_COUNT ? flBitmap & (~uint64_t(0) << (fl + 1)) : 0;
+        if (!flMap) return false;
+        fl = lowestBit(flMap);
+        slMap = slBitmaps[fl];
+      }
+      sl = lowestBit(slMap);
+      uint32_t index = heads[fl][sl];
+      removeFree(index);
+
+      // Alignment padding stays part of the node, it's given back with it.
+      VkDeviceSize start = alignUp(nodes[index].offset, alignment);
+      VkDeviceSize used = start - nodes[index].offset + need;
+      VkDeviceSize remainder = nodes[index].size - used;
+      if (remainder >= ALLOCATOR_MIN_SIZE) {
+        uint32_t next = newNode(Node{ nodes[index].offset + used, remainder, index, nodes[index].nextPhysical, TLSF_NONE, TLSF_NONE, true });
+        if (nodes[next].nextPhysical != TLSF_NONE) nodes[nodes[next].nextPhysical].prevPhysical = next;
+        nodes[index].nextPhysical = next;
+        nodes[index].size = used;
+        insertFree(next);
+      }
+
+      *offset = start;
+      *handle = index;
+      return true;
+    }
+
+    void free(uint64_t handle) override {
+      uint32_t index = static_cast<uint32_t>(handle);
+      uint32_t next = nodes[index].nextPhysical;
+      if (next != TLSF_NONE && nodes[next].free) {
+        removeFree(next);
+        nodes[index].size += nodes[next].size;
+        nodes[index].nextPhysical = nodes[next].nextPhysical;
+        if (nodes[index].nextPhysical != TLSF_NONE) nodes[nodes[index].nextPhysical].prevPhysical = index;
+        unusedNodes.push_back(next);
+      }
+      uint32_t prev = nodes[index].prevPhysical;
+      if (prev != TLSF_NONE && nodes[prev].free) {
+        removeFree(prev);
+        nodes[prev].size += nodes[index].size;
+        nodes[prev].nextPhysical = nodes[index].nextPhysical;
+        if (nodes[prev].nextPhysical != TLSF_NONE) nodes[nodes[prev].nextPhysical].prevPhysical = prev;
+        unusedNodes.push_back(index);
+        index = prev;
+      }
+      insertFree(index);
+    }
+  };
+
+  purrGpuAllocator::purrGpuAllocator(purrGpuAllocatorSettings settings):
+    mSettings(settings)
+  {}
+
+  purrGpuAllocator::~purrGpuAllocator() {
+    cleanup();
+  }
+
+  void purrGpuAllocator::initialize() {
+    if (mInitialized) return;
+    VkPhysicalDevice physicalDevice = sContext->frRenderer->getPhysicalDevice();
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &mMemoryProperties);
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &props);
+    mMaxAllocations = props.limits.maxMemoryAllocationCount;
+
+    // The budget is a physical device query, the extension only has to be supported, not enabled.
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+    for (const VkExtensionProperties &extension: extensions) {
+      if (strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0) mBudgetExtension = true;
+    }
+    if (mBudgetExtension) {
+      VkInstance instance = sContext->frRenderer->getInstance();
+      mGetMemoryProperties2 = (PFN_vkGetPhysicalDeviceMemoryProperties2)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2");
+      if (!mGetMemoryProperties2) mGetMemoryProperties2 = (PFN_vkGetPhysicalDeviceMemoryProperties2)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2KHR");
+      mBudgetExtension = mGetMemoryProperties2 != nullptr;
+    }
+
+    mHeapAllocated.assign(mMemoryProperties.memoryHeapCount, 0);
+    mHeapWarned.assign(mMemoryProperties.memoryHeapCount, false);
+    mInitialized = true;
+  }
+
+  void purrGpuAllocator::cleanup() {
+    if (!mInitialized) return;
+    uint32_t leaked = 0;
+    for (purrMemoryCategoryStats &category: mCategories) leaked += category.allocations;
+    if (leaked) fprintf(stderr, "[purrGpuAllocator]: %u allocations were never freed!\n", leaked);
+
+    for (Block *block: mBlocks) {
+      freeMemory(block->memoryType, block->size, block->memory);
+      delete block;
+    }
+    mBlocks.clear();
+    mInitialized = false;
+  }
+
+  bool purrGpuAllocator::allocate(const purrAllocationInfo &info, purrAllocation *allocation) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mInitialized) initialize();
+    *allocation = {};
+
+    uint32_t memoryType = 0;
+    if (!findMemoryType(info, &memoryType)) {
+      fprintf(stderr, "[purrGpuAllocator]: No memory type for a %s allocation of %" PRIu64 " bytes!\n", getCategoryName(info.category), (uint64_t)info.requirements.size);
+      return false;
+    }
+
+    VkMemoryPropertyFlags properties = mMemoryProperties.memoryTypes[memoryType].propertyFlags;
+    VkDeviceSize blockSize = (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) ? mSettings.hostBlockSize : mSettings.deviceBlockSize;
+    VkDeviceSize threshold = mSettings.dedicatedThreshold ? mSettings.dedicatedThreshold : blockSize / 2;
+
+    allocation->size = info.requirements.size;
+    allocation->memoryType = memoryType;
+    allocation->category = info.category;
+
+    if (info.dedicated || info.requirements.size >= threshold) {
+      if (!allocateMemory(memoryType, info.requirements.size, &allocation->memory, &allocation->mapped)) return false;
+      ++mDedicatedCount;
+      mDedicatedBytes += info.requirements.size;
+    } else {
+      purrAllocStrategy strategy = info.strategy;
+      if (strategy == purrAllocStrategy::Default) {
+        strategy = info.category == purrMemoryCategory::Staging ? purrAllocStrategy::Linear :
+                   info.category == purrMemoryCategory::Target ? purrAllocStrategy::Buddy : purrAllocStrategy::Tlsf;
+      }
+
+      Block *target = nullptr;
+      for (Block *block: mBlocks) {
+        if (block->memoryType != memoryType || block->strategy != strategy || block->image != info.image) continue;
+        if (block->allocate(info.requirements.size, info.requirements.alignment, &allocation->offset, &allocation->handle)) {
+          target = block;
+          break;
+        }
+      }
+
+      if (!target) {
+        Block *block = nullptr;
+        if (strategy == purrAllocStrategy::Linear) block = new LinearBlock();
+        else if (strategy == purrAllocStrategy::Buddy) block = new BuddyBlock();
+        else block = new TlsfBlock();
+        block->size = blockSize;
+        block->memoryType = memoryType;
+        block->strategy = strategy;
+        block->image = info.image;
+        if (!allocateMemory(memoryType, blockSize, &block->memory, &block->mapped)) {
+          delete block;
+          return false;
+        }
+        if (strategy == purrAllocStrategy::Buddy) static_cast<BuddyBlock*>(block)->init();
+        else if (strategy == purrAllocStrategy::Tlsf) static_cast<TlsfBlock*>(block)->init();
+        mBlocks.push_back(block);
+
+        if (!block->allocate(info.requirements.size, info.requirements.alignment, &allocation->offset, &allocation->handle)) {
+          fprintf(stderr, "[purrGpuAllocator]: %" PRIu64 " bytes don't fit into a new block!\n", (uint64_t)info.requirements.size);
+          *allocation = {};
+          return false;
+        }
+        target = block;
+      }
+
+      ++target->allocations;
+      target->used += info.requirements.size;
+      allocation->memory = target->memory;
+      allocation->block = target;
+      if (target->mapped) allocation->mapped = static_cast<uint8_t*>(target->mapped) + allocation->offset;
+    }
+
+    purrMemoryCategoryStats &category = mCategories[static_cast<uint32_t>(info.category)];
+    ++category.allocations;
+    category.bytes += info.requirements.size;
+    return true;
+  }
+
+  void purrGpuAllocator::free(purrAllocation &allocation) {
+    if (!allocation.isValid()) return;
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    purrMemoryCategoryStats &category = mCategories[static_cast<uint32_t>(allocation.category)];
+    --category.allocations;
+    category.bytes -= allocation.size;
+
+    Block *block = static_cast<Block*>(allocation.block);
+    if (!block) {
+      freeMemory(allocation.memoryType, allocation.size, allocation.memory);
+      --mDedicatedCount;
+      mDedicatedBytes -= allocation.size;
+      allocation = {};
+      return;
+    }
+
+    --block->allocations;
+    block->used -= allocation.size;
+    block->free(allocation.handle);
+    allocation = {};
+    if (block->allocations) return;
+
+    // One empty block per kind is kept around for the next allocation, a second one is released.
+    for (auto it = mBlocks.begin(); it != mBlocks.end(); ++it) {
+      Block *other = *it;
+      if (other == block || other->allocations || other->memoryType != block->memoryType ||
+          other->strategy != block->strategy || other->image != block->image) continue;
+      freeMemory(block->memoryType, block->size, block->memory);
+      mBlocks.erase(std::find(mBlocks.begin(), mBlocks.end(), block));
+      delete block;
+      return;
+    }
+  }
+
+  bool purrGpuAllocator::createBuffer(const VkBufferCreateInfo &createInfo, purrAllocationInfo info, VkBuffer *buffer, purrAllocation *allocation) {
+    VkDevice device = sContext->frRenderer->getDevice();
+    if (vkCreateBuffer(device, &createInfo, nullptr, buffer) != VK_SUCCESS) {
+      fprintf(stderr, "[purrGpuAllocator]: Failed to create a buffer of %" PRIu64 " bytes!\n", (uint64_t)createInfo.size);
+      *buffer = VK_NULL_HANDLE;
+      return false;
+    }
+    vkGetBufferMemoryRequirements(device, *buffer, &info.requirements);
+    info.image = false;
+    if (!allocate(info, allocation)) {
+      vkDestroyBuffer(device, *buffer, nullptr);
+      *buffer = VK_NULL_HANDLE;
+      return false;
+    }
+    vkBindBufferMemory(device, *buffer, allocation->memory, allocation->offset);
+    return true;
+  }
+
+  bool purrGpuAllocator::createImage(const VkImageCreateInfo &createInfo, purrAllocationInfo info, VkImage *image, purrAllocation *allocation) {
+    VkDevice device = sContext->frRenderer->getDevice();
+    if (vkCreateImage(device, &createInfo, nullptr, image) != VK_SUCCESS) {
+      fprintf(stderr, "[purrGpuAllocator]: Failed to create a %ux%u image!\n", createInfo.extent.width, createInfo.extent.height);
+      *image = VK_NULL_HANDLE;
+      return false;
+    }
+    vkGetImageMemoryRequirements(device, *image, &info.requirements);
+    info.image = createInfo.tiling == VK_IMAGE_TILING_OPTIMAL;
+    if (!allocate(info, allocation)) {
+      vkDestroyImage(device, *image, nullptr);
+      *image = VK_NULL_HANDLE;
+      return false;
+    }
+    vkBindImageMemory(device, *image, allocation->memory, allocation->offset);
+    return true;
+  }
+
+  void purrGpuAllocator::destroyBuffer(VkBuffer buffer, purrAllocation &allocation) {
+    if (buffer) vkDestroyBuffer(sContext->frRenderer->getDevice(), buffer, nullptr);
+    free(allocation);
+  }
+
+  void purrGpuAllocator::destroyImage(VkImage image, purrAllocation &allocation) {
+    if (image) vkDestroyImage(sContext->frRenderer->getDevice(), image, nullptr);
+    free(allocation);
+  }
+
+  purrGpuMemoryStats purrGpuAllocator::getStats() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mInitialized) initialize();
+    purrGpuMemoryStats stats{};
+    for (uint32_t i = 0; i < static_cast<uint32_t>(purrMemoryCategory::Count); ++i) stats.categories[i] = mCategories[i];
+    for (Block *block: mBlocks) {
+      ++stats.blockCount;
+      stats.blockBytes += block->size;
+      stats.blockUsedBytes += block->used;
+    }
+    stats.dedicatedCount = mDedicatedCount;
+    stats.dedicatedBytes = mDedicatedBytes;
+    stats.deviceAllocations = mDeviceAllocations;
+    stats.maxDeviceAllocations = mMaxAllocations;
+    stats.budgetExtension = mBudgetExtension;
+    queryBudget(stats.heaps);
+    return stats;
+  }
+
+  const char *purrGpuAllocator::getCategoryName(purrMemoryCategory category) {
+    switch (category) {
+    case purrMemoryCategory::Mesh:    return "mesh";
+    case purrMemoryCategory::Texture: return "texture";
+    case purrMemoryCategory::Target:  return "target";
+    case purrMemoryCategory::Staging: return "staging";
+    case purrMemoryCategory::Frame:   return "frame";
+    default: return "unknown";
+    }
+  }
+
+  bool purrGpuAllocator::findMemoryType(const purrAllocationInfo &info, uint32_t *memoryType) const {
+    if (info.preferred && Utils::findMemoryType(info.requirements.memoryTypeBits, info.required | info.preferred, memoryType)) return true;
+    return Utils::findMemoryType(info.requirements.memoryTypeBits, info.required, memoryType);
+  }
+
+  bool purrGpuAllocator::allocateMemory(uint32_t memoryType, VkDeviceSize size, VkDeviceMemory *memory, void **mapped) {
+    if (mDeviceAllocations >= mMaxAllocations) {
+      fprintf(stderr, "[purrGpuAllocator]: maxMemoryAllocationCount (%u) reached!\n", mMaxAllocations);
+      return false;
+    }
+    uint32_t heap = mMemoryProperties.memoryTypes[memoryType].heapIndex;
+    if (!checkBudget(heap, size) && !mHeapWarned[heap]) {
+      fprintf(stderr, "[purrGpuAllocator]: Heap %u is over its budget, allocating %" PRIu64 " bytes anyway.\n", heap, (uint64_t)size);
+      mHeapWarned[heap] = true;
+    }
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryType;
+    VkDevice device = sContext->frRenderer->getDevice();
+    if (vkAllocateMemory(device, &allocInfo, nullptr, memory) != VK_SUCCESS) {
+      fprintf(stderr, "[purrGpuAllocator]: Failed to allocate %" PRIu64 " bytes!\n", (uint64_t)size);
+      *memory = VK_NULL_HANDLE;
+      return false;
+    }
+
+    *mapped = nullptr;
+    if (mMemoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) vkMapMemory(device, *memory, 0, VK_WHOLE_SIZE, 0, mapped);
+    ++mDeviceAllocations;
+    mHeapAllocated[heap] += size;
+    return true;
+  }
+
+  void purrGpuAllocator::freeMemory(uint32_t memoryType, VkDeviceSize size, VkDeviceMemory memory) {
+    // Freeing unmaps as well.
+    vkFreeMemory(sContext->frRenderer->getDevice(), memory, nullptr);
+    --mDeviceAllocations;
+    mHeapAllocated[mMemoryProperties.memoryTypes[memoryType].heapIndex] -= size;
+  }
+
+  bool purrGpuAllocator::checkBudget(uint32_t heap, VkDeviceSize size) {
+    std::vector<purrMemoryHeapStats> heaps{};
+    queryBudget(heaps);
+    if (heaps[heap].usage + size <= heaps[heap].budget) return true;
+    releaseEmptyBlocks(heap);
+    queryBudget(heaps);
+    return heaps[heap].usage + size <= heaps[heap].budget;
+  }
+
+  void purrGpuAllocator::queryBudget(std::vector<purrMemoryHeapStats> &heaps) {
+    heaps.assign(mMemoryProperties.memoryHeapCount, {});
+    for (uint32_t i = 0; i < mMemoryProperties.memoryHeapCount; ++i) {
+      heaps[i].size = mMemoryProperties.memoryHeaps[i].size;
+      heaps[i].allocated = mHeapAllocated[i];
+      heaps[i].usage = mHeapAllocated[i];
+      heaps[i].budget = heaps[i].size;
+    }
+    if (!mBudgetExtension) return;
+
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+    budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    VkPhysicalDeviceMemoryProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    properties.pNext = &budget;
+    mGetMemoryProperties2(sContext->frRenderer->getPhysicalDevice(), &properties);
+    for (uint32_t i = 0; i < mMemoryProperties.memoryHeapCount; ++i) {
+      heaps[i].usage = budget.heapUsage[i];
+      heaps[i].budget = budget.heapBudget[i];
+    }
+  }
+
+  void purrGpuAllocator::releaseEmptyBlocks(uint32_t heap) {
+    for (auto it = mBlocks.begin(); it != mBlocks.end();) {
+      Block *block = *it;
+      if (block->allocations || mMemoryProperties.memoryTypes[block->memoryType].heapIndex != heap) { ++it; continue; }
+      freeMemory(block->memoryType, block->size, block->memory);
+      delete block;
+      it = mBlocks.erase(it);
+    }
+  }
+
+  void purrGpuAllocator::setContext(PurrfectEngineContext *context) {
+    sContext = context;
+  }
+
+  purrGpuAllocator *purrGpuAllocator::getDefault() {
+    if (!sDefaultAllocator) sDefaultAllocator = new purrGpuAllocator();
+    return sDefaultAllocator;
+  }
+
+  void purrGpuAllocator::cleanupAll() {
+    if (sDefaultAllocator) delete sDefaultAllocator;
+    sDefaultAllocator = nullptr;
+  }
+
+}
\ No newline at end of file
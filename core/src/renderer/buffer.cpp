@@ -0,0 +1,51 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+#include <assert.h>
+#include <cstring>
+
+namespace PurrfectEngine {
+
+  purrBuffer::purrBuffer()
+  {}
+
+  purrBuffer::~purrBuffer() {
+    cleanup();
+  }
+
+  bool purrBuffer::initialize(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, purrMemoryCategory category) {
+    if (mBuffer) cleanup();
+    VkBufferCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    createInfo.size = size;
+    createInfo.usage = usage;
+    createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    purrAllocationInfo allocInfo{};
+    allocInfo.required = properties;
+    allocInfo.category = category;
+    if (!purrGpuAllocator::getDefault()->createBuffer(createInfo, allocInfo, &mBuffer, &mAllocation)) return false;
+    mSize = size;
+    return true;
+  }
+
+  void purrBuffer::cleanup() {
+    if (!mBuffer) return;
+    purrGpuAllocator::getDefault()->destroyBuffer(mBuffer, mAllocation);
+    mBuffer = VK_NULL_HANDLE;
+    mSize = 0;
+  }
+
+  void purrBuffer::copyData(VkDeviceSize offset, VkDeviceSize size, const void *data) {
+    assert(mAllocation.mapped && "Only host visible buffers can be written directly!");
+    assert(offset + size <= mSize);
+    memcpy(static_cast<uint8_t*>(mAllocation.mapped) + offset, data, static_cast<size_t>(size));
+  }
+
+  void purrBuffer::copyFromBuffer(fr::frCommands *commands, purrBuffer *src, VkDeviceSize size) {
+    VkCommandBuffer cmdBuf = commands->beginSingleTime();
+    VkBufferCopy region = { 0, 0, size };
+    vkCmdCopyBuffer(cmdBuf, src->get(), mBuffer, 1, &region);
+    commands->endSingleTime(cmdBuf);
+  }
+
+}
\ No newline at end of file
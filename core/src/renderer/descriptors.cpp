@@ -0,0 +1,223 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+#include <algorithm>
+
+namespace PurrfectEngine {
+
+  static PurrfectEngineContext *sContext = nullptr;
+
+  static purrDescriptorAllocator *sDefaultAllocator = nullptr;
+
+  // Core in 1.1, the KHR names cover 1.0 devices with the extension. Loaded on the first template.
+  static bool sTemplateFunctionsLoaded = false;
+  static PFN_vkCreateDescriptorUpdateTemplate sCreateTemplate = nullptr;
+  static PFN_vkDestroyDescriptorUpdateTemplate sDestroyTemplate = nullptr;
+  static PFN_vkUpdateDescriptorSetWithTemplate sUpdateWithTemplate = nullptr;
+
+  purrDescriptorAllocator::purrDescriptorAllocator(purrDescriptorAllocatorSettings settings)
+    : mSettings(settings), mNextPoolSets(settings.setsPerPool)
+  {}
+
+  purrDescriptorAllocator::~purrDescriptorAllocator() {
+    cleanup();
+  }
+
+  void purrDescriptorAllocator::cleanup() {
+    if (!sContext || !sContext->frRenderer) return;
+    VkDevice device = sContext->frRenderer->getDevice();
+    for (Pool &pool: mPools) vkDestroyDescriptorPool(device, pool.pool, nullptr);
+    mPools.clear();
+    mSetPools.clear();
+    mCurrent = 0;
+    mNextPoolSets = mSettings.setsPerPool;
+    mStats = {};
+  }
+
+  VkDescriptorSet purrDescriptorAllocator::allocate(VkDescriptorSetLayout layout) {
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    // The current pool first, then any other with room before growing.
+    for (uint32_t i = 0; i < mPools.size(); ++i) {
+      uint32_t pool = (mCurrent + i) % static_cast<uint32_t>(mPools.size());
+      if (mPools[pool].full) continue;
+      if (allocateFrom(pool, layout, &set)) return set;
+    }
+
+    if (!addPool()) return VK_NULL_HANDLE;
+    if (allocateFrom(static_cast<uint32_t>(mPools.size()) - 1, layout, &set)) return set;
+    ++mStats.failures;
+    fprintf(stderr, "[purrDescriptorAllocator]: Failed to allocate a descriptor set from a new pool!\n");
+    return VK_NULL_HANDLE;
+  }
+
+  void purrDescriptorAllocator::free(VkDescriptorSet set) {
+    if (!set || mSettings.lifetime != purrDescriptorLifetime::Persistent) return;
+    auto it = mSetPools.find(set);
+    if (it == mSetPools.end()) return;
+    Pool &pool = mPools[it->second];
+    vkFreeDescriptorSets(sContext->frRenderer->getDevice(), pool.pool, 1, &set);
+    --pool.sets;
+    --mStats.sets;
+    pool.full = false;
+    mSetPools.erase(it);
+  }
+
+  void purrDescriptorAllocator::reset() {
+    if (mSettings.lifetime != purrDescriptorLifetime::Frame) return;
+    VkDevice device = sContext->frRenderer->getDevice();
+    for (Pool &pool: mPools) {
+      if (pool.sets) vkResetDescriptorPool(device, pool.pool, 0);
+      pool.sets = 0;
+      pool.full = false;
+    }
+    mCurrent = 0;
+    mStats.sets = 0;
+    mStats.poolsAdded = 0;
+  }
+
+  bool purrDescriptorAllocator::addPool() {
+    Pool pool{};
+    pool.maxSets = mNextPoolSets;
+    mNextPoolSets = std::min(mNextPoolSets * 2, std::max(mSettings.maxSetsPerPool, mSettings.setsPerPool));
+
+    std::vector<VkDescriptorPoolSize> sizes = mSettings.typesPerSet;
+    for (VkDescriptorPoolSize &size: sizes) size.descriptorCount *= pool.maxSets;
+
+    VkDescriptorPoolCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    if (mSettings.lifetime == purrDescriptorLifetime::Persistent) createInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    createInfo.maxSets = pool.maxSets;
+    createInfo.poolSizeCount = static_cast<uint32_t>(sizes.size());
+    createInfo.pPoolSizes = sizes.data();
+    if (vkCreateDescriptorPool(sContext->frRenderer->getDevice(), &createInfo, nullptr, &pool.pool) != VK_SUCCESS) {
+      fprintf(stderr, "[purrDescriptorAllocator]: Failed to create descriptor pool!\n");
+      return false;
+    }
+    mPools.push_back(pool);
+    mCurrent = static_cast<uint32_t>(mPools.size()) - 1;
+    ++mStats.pools;
+    ++mStats.poolsAdded;
+    return true;
+  }
+
+  bool purrDescriptorAllocator::allocateFrom(uint32_t pool, VkDescriptorSetLayout layout, VkDescriptorSet *set) {
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = mPools[pool].pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+    // OUT_OF_POOL_MEMORY and FRAGMENTED_POOL are expected, anything else is treated the same and the next pool tried.
+    if (vkAllocateDescriptorSets(sContext->frRenderer->getDevice(), &allocInfo, set) != VK_SUCCESS) {
+      mPools[pool].full = true;
+      *set = VK_NULL_HANDLE;
+      return false;
+    }
+    ++mPools[pool].sets;
+    ++mStats.sets;
+    mCurrent = pool;
+    if (mSettings.lifetime == purrDescriptorLifetime::Persistent) mSetPools[*set] = pool;
+    return true;
+  }
+
+  void purrDescriptorAllocator::setContext(PurrfectEngineContext *context) {
+    sContext = context;
+    sTemplateFunctionsLoaded = false;
+  }
+
+  purrDescriptorAllocator *purrDescriptorAllocator::getDefault() {
+    if (!sDefaultAllocator) sDefaultAllocator = new purrDescriptorAllocator();
+    return sDefaultAllocator;
+  }
+
+  void purrDescriptorAllocator::cleanupAll() {
+    if (sDefaultAllocator) delete sDefaultAllocator;
+    sDefaultAllocator = nullptr;
+  }
+
+  purrDescriptorTemplate::purrDescriptorTemplate()
+  {}
+
+  purrDescriptorTemplate::~purrDescriptorTemplate() {
+    cleanup();
+  }
+
+  bool purrDescriptorTemplate::initialize(VkDescriptorSetLayout layout, const std::vector<VkDescriptorUpdateTemplateEntry> &entries) {
+    cleanup();
+    mEntries = entries;
+
+    VkDevice device = sContext->frRenderer->getDevice();
+    if (!sTemplateFunctionsLoaded) {
+      sTemplateFunctionsLoaded = true;
+      sCreateTemplate = (PFN_vkCreateDescriptorUpdateTemplate)vkGetDeviceProcAddr(device, "vkCreateDescriptorUpdateTemplate");
+      sDestroyTemplate = (PFN_vkDestroyDescriptorUpdateTemplate)vkGetDeviceProcAddr(device, "vkDestroyDescriptorUpdateTemplate");
+      sUpdateWithTemplate = (PFN_vkUpdateDescriptorSetWithTemplate)vkGetDeviceProcAddr(device, "vkUpdateDescriptorSetWithTemplate");
+      if (!sCreateTemplate || !sDestroyTemplate || !sUpdateWithTemplate) {
+        sCreateTemplate = (PFN_vkCreateDescriptorUpdateTemplate)vkGetDeviceProcAddr(device, "vkCreateDescriptorUpdateTemplateKHR");
+        sDestroyTemplate = (PFN_vkDestroyDescriptorUpdateTemplate)vkGetDeviceProcAddr(device, "vkDestroyDescriptorUpdateTemplateKHR");
+        sUpdateWithTemplate = (PFN_vkUpdateDescriptorSetWithTemplate)vkGetDeviceProcAddr(device, "vkUpdateDescriptorSetWithTemplateKHR");
+      }
+    }
+    if (!sCreateTemplate || !sDestroyTemplate || !sUpdateWithTemplate) return true;
+
+    VkDescriptorUpdateTemplateCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+    createInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(mEntries.size());
+    createInfo.pDescriptorUpdateEntries = mEntries.data();
+    createInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+    createInfo.descriptorSetLayout = layout;
+    if (sCreateTemplate(device, &createInfo, nullptr, &mTemplate) != VK_SUCCESS) {
+      // Not fatal, update() writes the entries one by one.
+      fprintf(stderr, "[purrDescriptorTemplate]: Failed to create descriptor update template!\n");
+      mTemplate = VK_NULL_HANDLE;
+    }
+    return true;
+  }
+
+  void purrDescriptorTemplate::cleanup() {
+    if (mTemplate) sDestroyTemplate(sContext->frRenderer->getDevice(), mTemplate, nullptr);
+    mTemplate = VK_NULL_HANDLE;
+    mEntries.clear();
+  }
+
+  void purrDescriptorTemplate::update(VkDescriptorSet set, const void *data) const {
+    VkDevice device = sContext->frRenderer->getDevice();
+    if (mTemplate) {
+      sUpdateWithTemplate(device, set, mTemplate, data);
+      return;
+    }
+
+    // Array elements are written separately, their infos don't have to be tightly packed in data.
+    const uint8_t *bytes = static_cast<const uint8_t*>(data);
+    std::vector<VkWriteDescriptorSet> writes{};
+    for (const VkDescriptorUpdateTemplateEntry &entry: mEntries) {
+      for (uint32_t i = 0; i < entry.descriptorCount; ++i) {
+        const void *info = bytes + entry.offset + entry.stride * i;
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = set;
+        write.dstBinding = entry.dstBinding;
+        write.dstArrayElement = entry.dstArrayElement + i;
+        write.descriptorCount = 1;
+        write.descriptorType = entry.descriptorType;
+        switch (entry.descriptorType) {
+        case VK_DESCRIPTOR_TYPE_SAMPLER:
+        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+        case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+          write.pImageInfo = static_cast<const VkDescriptorImageInfo*>(info);
+          break;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+          write.pTexelBufferView = static_cast<const VkBufferView*>(info);
+          break;
+        default:
+          write.pBufferInfo = static_cast<const VkDescriptorBufferInfo*>(info);
+          break;
+        }
+        writes.push_back(write);
+      }
+    }
+    vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+  }
+
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace PurrfectEngine {
+
+  // Items per radix job, below this a parallelFor costs more than it saves.
+  #define DRAWLIST_SORT_CHUNK 4096
+  #define DRAWLIST_RADIX 256
+
+  purrDrawList::purrDrawList()
+  {}
+
+  purrDrawList::~purrDrawList() {
+  }
+
+  void purrDrawList::clear() {
+    mItems.clear();
+    mPipelineIds.clear();
+    mMeshIds.clear();
+    mStats = {};
+  }
+
+  void purrDrawList::add(purrDrawPass pass, purrPipeline *pipeline, uint32_t material, purrMesh *mesh, uint32_t objectIndex, float depth) {
+    mItems.push_back(purrDrawItem{
+      makeKey(pass, getId(mPipelineIds, pipeline), material, getId(mMeshIds, mesh), depth),
+      pipeline, mesh, objectIndex
+    });
+  }
+
+  void purrDrawList::sort(purrWorkerPool *pool) {
+    auto start = std::chrono::steady_clock::now();
+    uint32_t count = size();
+    mStats.sortPasses = 0;
+
+    if (count > 1) {
+      uint32_t chunkCount = (count + DRAWLIST_SORT_CHUNK - 1) / DRAWLIST_SORT_CHUNK;
+      mScratch.resize(count);
+      mHistograms.resize(chunkCount * DRAWLIST_RADIX);
+
+      // Bytes that are the same in every key don't change the order, most frames that's the pass and pipeline bytes.
+      uint64_t diff = 0;
+      for (const purrDrawItem &item: mItems) diff |= item.key ^ mItems[0].key;
+
+      purrDrawItem *src = mItems.data();
+      purrDrawItem *dst = mScratch.data();
+      for (uint32_t shift = 0; shift < 64; shift += 8) {
+        if (!((diff >> shift) & 0xFF)) continue;
+
+        pool->parallelFor(chunkCount, [&](uint32_t chunk) {
+          uint32_t *histogram = &mHistograms[chunk * DRAWLIST_RADIX];
+          memset(histogram, 0, DRAWLIST_RADIX * sizeof(uint32_t));
+          uint32_t end = std::min(count, (chunk + 1) * DRAWLIST_SORT_CHUNK);
+          for (uint32_t i = chunk * DRAWLIST_SORT_CHUNK; i < end; ++i) ++histogram[(src[i].key >> shift) & 0xFF];
+        });
+
+        // Counts become write offsets, digit major and chunk minor, so every chunk scatters behind the ones before it.
+        uint32_t offset = 0;
+        for (uint32_t digit = 0; digit < DRAWLIST_RADIX; ++digit) {
+          for (uint32_t chunk = 0; chunk < chunkCount; ++chunk) {
+            uint32_t &counter = mHistograms[chunk * DRAWLIST_RADIX + digit];
+            uint32_t digitCount = counter;
+            counter = offset;
+            offset += digitCount;
+          }
+        }
+
+        pool->parallelFor(chunkCount, [&](uint32_t chunk) {
+          uint32_t *offsets = &mHistograms[chunk * DRAWLIST_RADIX];
+          uint32_t end = std::min(count, (chunk + 1) * DRAWLIST_SORT_CHUNK);
+          for (uint32_t i = chunk * DRAWLIST_SORT_CHUNK; i < end; ++i) dst[offsets[(src[i].key >> shift) & 0xFF]++] = src[i];
+        });
+
+        std::swap(src, dst);
+        ++mStats.sortPasses;
+      }
+      if (src != mItems.data()) mItems.swap(mScratch);
+    }
+
+    mStats.draws = count;
+    mStats.pipelineChanges = 0;
+    mStats.meshChanges = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+      // Pass switches rebind even when the pipeline id is the same, the pre-pass has a variant of its own.
+      if (i == 0 || (mItems[i].key >> 48) != (mItems[i-1].key >> 48)) ++mStats.pipelineChanges;
+      if (i == 0 || mItems[i].mesh != mItems[i-1].mesh) ++mStats.meshChanges;
+    }
+    mStats.sortMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  void purrDrawList::getRange(purrDrawPass pass, uint32_t *first, uint32_t *count) const {
+    uint64_t begin = static_cast<uint64_t>(pass) << 60;
+    auto lower = std::lower_bound(mItems.begin(), mItems.end(), begin, [](const purrDrawItem &item, uint64_t key) {
+      return item.key < key;
+    });
+    auto upper = std::find_if(lower, mItems.end(), [&](const purrDrawItem &item) {
+      return (item.key >> 60) != static_cast<uint64_t>(pass);
+    });
+    *first = static_cast<uint32_t>(lower - mItems.begin());
+    *count = static_cast<uint32_t>(upper - lower);
+  }
+
+  uint64_t purrDrawList::makeKey(purrDrawPass pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth) {
+    // Positive floats order the same as their bits, dropping the sign and the low mantissa bits leaves 20.
+    float clamped = depth > 0.0f ? depth : 0.0f;
+    uint32_t depthBits = 0;
+    memcpy(&depthBits, &clamped, sizeof(depthBits));
+    return (static_cast<uint64_t>(pass) & 0xF) << 60 |
+           static_cast<uint64_t>(pipeline & 0xFFF) << 48 |
+           static_cast<uint64_t>(material & 0xFFF) << 36 |
+           static_cast<uint64_t>(mesh & 0xFFFF) << 20 |
+           static_cast<uint64_t>(depthBits >> 11);
+  }
+
+  uint32_t purrDrawList::getId(std::unordered_map<const void*, uint32_t> &ids, const void *ptr) {
+    return ids.emplace(ptr, static_cast<uint32_t>(ids.size())).first->second;
+  }
+
+}
\ No newline at end of file
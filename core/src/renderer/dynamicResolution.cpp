@@ -0,0 +1,55 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+#include <cmath>
+
+namespace PurrfectEngine {
+
+  purrDynamicResolution::purrDynamicResolution()
+  {}
+
+  purrDynamicResolution::~purrDynamicResolution()
+  {}
+
+  void purrDynamicResolution::initialize(purrDynamicResolutionSettings settings) {
+    mSettings = settings;
+    mSettings.minScale = std::max(0.05f, std::min(mSettings.minScale, 1.0f));
+    mSettings.maxScale = std::max(mSettings.minScale, std::min(mSettings.maxScale, 1.0f));
+    reset();
+  }
+
+  float purrDynamicResolution::update(uint32_t frameIndex, double gpuFrameMs) {
+    if (frameIndex >= mSlotScales.size()) mSlotScales.resize(frameIndex + 1, 0.0f);
+    float measuredScale = mSlotScales[frameIndex];
+    mSlotScales[frameIndex] = mScale;
+    if (gpuFrameMs <= 0.0 || measuredScale <= 0.0f || mSettings.budgetMs <= 0.0f) return mScale;
+
+    // Normalized to scale 1, frames measured at different scales average together.
+    // The average smooths out noise when scaling up, the raw time reacts to spikes.
+    double cost = gpuFrameMs / (measuredScale * measuredScale);
+    mAverageCost = mAverageCost == 0.0 ? cost : mAverageCost * 0.9 + cost * 0.1;
+
+    float scale = mScale;
+    if (gpuFrameMs > mSettings.budgetMs) {
+      scale = std::min(mScale, measuredScale * static_cast<float>(std::sqrt(mSettings.budgetMs / gpuFrameMs)));
+      mAverageCost = cost;
+      mCalmFrames = 0;
+    } else if (mAverageCost * mScale * mScale < mSettings.budgetMs * mSettings.headroom) {
+      if (++mCalmFrames >= mSettings.upDelay) {
+        float target = static_cast<float>(std::sqrt(mSettings.budgetMs * mSettings.headroom / mAverageCost));
+        scale = std::max(mScale, std::min(target, mScale + mSettings.maxUpStep));
+      }
+    } else mCalmFrames = 0;
+
+    mScale = std::max(mSettings.minScale, std::min(scale, mSettings.maxScale));
+    mSlotScales[frameIndex] = mScale;
+    return mScale;
+  }
+
+  void purrDynamicResolution::reset() {
+    mScale = mSettings.maxScale;
+    mAverageCost = 0.0;
+    mCalmFrames = 0;
+    mSlotScales.clear();
+  }
+
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+#include <cmath>
+
+namespace PurrfectEngine {
+
+  #define STATS_WINDOW 1024
+
+  static double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+  }
+
+  purrFramePacer::purrFramePacer(purrClock *clock):
+    mClock(clock)
+  {}
+
+  purrFramePacer::~purrFramePacer()
+  {}
+
+  void purrFramePacer::setSettings(purrFramePacerSettings settings) {
+    if (settings.workWindow == 0) settings.workWindow = 1;
+    if (settings.targetFps != mSettings.targetFps) mDeadline = 0;
+    mSettings = settings;
+    mWork.clear();
+    mWorkNext = 0;
+  }
+
+  uint64_t purrFramePacer::waitForFrame() {
+    uint64_t now = mClock->now();
+    uint64_t period = getPeriodNs();
+    if (period) {
+      if (mDeadline == 0) mDeadline = now + period;
+      uint64_t lead = getPredictedWorkNs() + mSettings.marginNs;
+      if (mDeadline > now + lead) {
+        mClock->sleepUntil(mDeadline - lead);
+        uint64_t woke = mClock->now();
+        mSleepMsTotal += (woke - now) / 1e6;
+        now = woke;
+      }
+    }
+    mFrameStart = now;
+    mInFrame = true;
+    return now;
+  }
+
+  void purrFramePacer::framePresented() {
+    if (!mInFrame) return;
+    mInFrame = false;
+    uint64_t present = mClock->now();
+
+    uint64_t work = present - mFrameStart;
+    if (mWork.size() < mSettings.workWindow) mWork.push_back(work);
+    else mWork[mWorkNext] = work;
+    mWorkNext = (mWorkNext + 1) % mSettings.workWindow;
+
+    double frameMs = mLastPresent ? (present - mLastPresent) / 1e6 : 0.0;
+    double latencyMs = work / 1e6;
+    if (mLastPresent) {
+      if (mFrameMs.size() < STATS_WINDOW) {
+        mFrameMs.push_back(frameMs);
+        mLatencyMs.push_back(latencyMs);
+      } else {
+        mFrameMs[mStatsNext] = frameMs;
+        mLatencyMs[mStatsNext] = latencyMs;
+      }
+      mStatsNext = (mStatsNext + 1) % STATS_WINDOW;
+    }
+    mLastPresent = present;
+    ++mFrames;
+
+    uint64_t period = getPeriodNs();
+    if (!period) return;
+    if (mDeadline == 0) { // The limiter was turned on mid frame.
+      mDeadline = present + period;
+      return;
+    }
+    if (present > mDeadline) ++mMissed;
+    // Late by more than a period: start a new grid from here, catching up would only burst frames.
+    mDeadline = (present > mDeadline + period) ? present + period : mDeadline + period;
+  }
+
+  purrFramePacingStats purrFramePacer::getStats() const {
+    purrFramePacingStats stats{};
+    stats.frames = mFrames;
+    stats.missedDeadlines = mMissed;
+    if (mFrameMs.empty()) return stats;
+
+    double sum = 0.0, latencySum = 0.0;
+    for (size_t i = 0; i < mFrameMs.size(); ++i) {
+      sum += mFrameMs[i];
+      latencySum += mLatencyMs[i];
+    }
+    stats.frameMsMean = sum / mFrameMs.size();
+    stats.latencyMsMean = latencySum / mLatencyMs.size();
+
+    double variance = 0.0;
+    for (double ms: mFrameMs) variance += (ms - stats.frameMsMean) * (ms - stats.frameMsMean);
+    stats.frameMsStdDev = std::sqrt(variance / mFrameMs.size());
+    stats.frameMsP99 = percentile(mFrameMs, 0.99);
+    stats.latencyMsP99 = percentile(mLatencyMs, 0.99);
+    stats.sleepMsMean = mSleepMsTotal / mFrames;
+    return stats;
+  }
+
+  void purrFramePacer::resetStats() {
+    mFrameMs.clear();
+    mLatencyMs.clear();
+    mStatsNext = 0;
+    mFrames = 0;
+    mMissed = 0;
+    mSleepMsTotal = 0.0;
+  }
+
+  uint64_t purrFramePacer::getPredictedWorkNs() const {
+    if (mWork.empty()) return 0;
+    std::vector<uint64_t> work = mWork;
+    size_t rank = static_cast<size_t>(0.9 * (work.size() - 1) + 0.5);
+    std::nth_element(work.begin(), work.begin() + rank, work.end());
+    return work[rank];
+  }
+
+  uint64_t purrFramePacer::getPeriodNs() const {
+    if (mSettings.targetFps <= 0.0) return 0;
+    return static_cast<uint64_t>(1e9 / mSettings.targetFps);
+  }
+
+}
\ No newline at end of file
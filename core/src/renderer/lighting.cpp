@@ -0,0 +1,111 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cfloat>
+
+namespace PurrfectEngine {
+
+  purrLightClusters::purrLightClusters(uint32_t tilesX, uint32_t tilesY, uint32_t slices):
+    mTilesX(std::max(1u, tilesX)), mTilesY(std::max(1u, tilesY)), mSlices(std::max(1u, slices))
+  {}
+
+  purrLightClusters::~purrLightClusters()
+  {}
+
+  void purrLightClusters::build(const std::vector<purrLight> &lights, const glm::mat4 &view, const glm::mat4 &projection, float nearPlane, float farPlane) {
+    auto start = std::chrono::steady_clock::now();
+    mNear = std::max(nearPlane, 1e-4f);
+    mFar = std::max(farPlane, mNear * 1.001f);
+    float logRatio = std::log(mFar / mNear);
+    mSliceScaleBias = glm::vec2(mSlices / logRatio, -static_cast<float>(mSlices) * std::log(mNear) / logRatio);
+
+    mClusters.assign(static_cast<size_t>(mTilesX) * mTilesY * mSlices, glm::uvec2(0));
+    mRanges.clear();
+    mStats = purrLightClusterStats{};
+    mStats.lightCount = static_cast<uint32_t>(lights.size());
+
+    // Counting pass, the ranges are kept so the fill pass doesn't redo the projection.
+    for (uint32_t i = 0; i < lights.size(); ++i) {
+      const purrLight &light = lights[i];
+      glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+      float depth = -center.z; // Right handed, the camera looks down -z.
+      float radius = light.radius;
+      if (radius <= 0.0f || depth + radius < mNear || depth - radius > mFar) continue;
+
+      float nearDepth = std::max(depth - radius, mNear);
+      float farDepth = std::min(depth + radius, mFar);
+      uint32_t slice0 = static_cast<uint32_t>(std::max(0.0f, std::floor(std::log(nearDepth) * mSliceScaleBias.x + mSliceScaleBias.y)));
+      uint32_t slice1 = std::min(mSlices - 1, static_cast<uint32_t>(std::max(0.0f, std::floor(std::log(farDepth) * mSliceScaleBias.x + mSliceScaleBias.y))));
+
+      bool visible = false;
+      for (uint32_t slice = slice0; slice <= slice1; ++slice) {
+        float sliceNear = std::max(nearDepth, mNear * std::pow(mFar / mNear, static_cast<float>(slice) / mSlices));
+        float sliceFar = std::min(farDepth, mNear * std::pow(mFar / mNear, static_cast<float>(slice + 1) / mSlices));
+        if (sliceNear > sliceFar) continue;
+
+        // Widest cross section of the sphere inside [sliceNear, sliceFar].
+        float distance = (depth < sliceNear) ? sliceNear - depth : (depth > sliceFar) ? depth - sliceFar : 0.0f;
+        float sectionRadius = std::sqrt(std::max(0.0f, radius * radius - distance * distance));
+
+        Range range{ i, slice, 0, 0, 0, 0 };
+        glm::vec3 min = glm::vec3(center.x - sectionRadius, center.y - sectionRadius, -sliceFar);
+        glm::vec3 max = glm::vec3(center.x + sectionRadius, center.y + sectionRadius, -sliceNear);
+        if (!tileRange(projection, min, max, &range)) continue;
+
+        visible = true;
+        for (uint32_t y = range.y0; y <= range.y1; ++y) {
+          for (uint32_t x = range.x0; x <= range.x1; ++x) ++mClusters[getClusterIndex(x, y, slice)].y;
+        }
+        mRanges.push_back(range);
+      }
+      if (visible) ++mStats.visibleLights;
+    }
+
+    uint32_t offset = 0;
+    for (glm::uvec2 &cluster: mClusters) {
+      cluster.x = offset;
+      offset += cluster.y;
+      mStats.maxLightsPerCluster = std::max(mStats.maxLightsPerCluster, cluster.y);
+      if (cluster.y) ++mStats.occupiedClusters;
+      cluster.y = 0; // Refilled below.
+    }
+    mIndices.resize(offset);
+    mStats.indexCount = offset;
+
+    // Ranges are in light order, so every cluster's list comes out sorted by light index.
+    for (const Range &range: mRanges) {
+      for (uint32_t y = range.y0; y <= range.y1; ++y) {
+        for (uint32_t x = range.x0; x <= range.x1; ++x) {
+          glm::uvec2 &cluster = mClusters[getClusterIndex(x, y, range.slice)];
+          mIndices[cluster.x + cluster.y++] = range.light;
+        }
+      }
+    }
+
+    mStats.buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  bool purrLightClusters::tileRange(const glm::mat4 &projection, glm::vec3 min, glm::vec3 max, Range *range) const {
+    // The box is in front of the near plane, so its projection is bounded by the projections of its corners.
+    glm::vec2 lo(FLT_MAX), hi(-FLT_MAX);
+    for (uint32_t i = 0; i < 8; ++i) {
+      glm::vec4 corner = projection * glm::vec4((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z, 1.0f);
+      glm::vec2 ndc = glm::vec2(corner.x, corner.y) / corner.w;
+      lo = glm::min(lo, ndc);
+      hi = glm::max(hi, ndc);
+    }
+    if (hi.x < -1.0f || hi.y < -1.0f || lo.x > 1.0f || lo.y > 1.0f) return false;
+
+    // Same mapping as gl_FragCoord.xy / viewport in the shader, both axes go from -1 to 1 left/top to right/bottom.
+    glm::vec2 tiles = glm::vec2(mTilesX, mTilesY);
+    glm::vec2 t0 = glm::clamp((lo * 0.5f + 0.5f) * tiles, glm::vec2(0.0f), tiles - 1.0f);
+    glm::vec2 t1 = glm::clamp((hi * 0.5f + 0.5f) * tiles, glm::vec2(0.0f), tiles - 1.0f);
+    range->x0 = static_cast<uint32_t>(t0.x);
+    range->y0 = static_cast<uint32_t>(t0.y);
+    range->x1 = static_cast<uint32_t>(t1.x);
+    range->y1 = static_cast<uint32_t>(t1.y);
+    return true;
+  }
+
+}
\ No newline at end of file
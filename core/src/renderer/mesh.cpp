@@ -1,5 +1,7 @@
 #include "PurrfectEngine/PurrfectEngine.hpp"
 
+#include <cfloat>
+
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
@@ -75,6 +77,22 @@ namespace PurrfectEngine {
 
   static purrMesh *sSquareMesh = nullptr;
 
+  // Device local, filled through a staging buffer that is freed again right away.
+  static purrBuffer *createDeviceBuffer(fr::frCommands *commands, const void *data, VkDeviceSize size, VkBufferUsageFlags usage) {
+    if (!size) return nullptr;
+    purrBuffer staging{};
+    if (!staging.initialize(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, purrMemoryCategory::Staging)) return nullptr;
+    staging.copyData(0, size, data);
+
+    purrBuffer *buffer = new purrBuffer();
+    if (!buffer->initialize(size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, purrMemoryCategory::Mesh)) {
+      delete buffer;
+      return nullptr;
+    }
+    buffer->copyFromBuffer(commands, &staging, size);
+    return buffer;
+  }
+
   purrMesh::purrMesh():
     mValid(false)
   {}
@@ -95,45 +113,28 @@ namespace PurrfectEngine {
   }
   
   void purrMesh::initialize(fr::frCommands *commands, std::vector<Vertex3D> vertices, std::vector<uint32_t> indices) {
-    {
-      VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
-
-      fr::frBuffer *stagingBuffer = new fr::frBuffer();
-      stagingBuffer->initialize(sContext->frRenderer, fr::frBuffer::frBufferInfo{
-        bufferSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, {}
-      });
-      stagingBuffer->copyData(0, bufferSize, vertices.data());
-
-      mVertexBuffer = new fr::frBuffer();
-      mVertexBuffer->initialize(sContext->frRenderer, fr::frBuffer::frBufferInfo{
-        bufferSize,
-        (VkBufferUsageFlagBits)(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, {}
-      });
-      mVertexBuffer->copyFromBuffer(sContext->frRenderer, commands, stagingBuffer, bufferSize);
-
-      delete stagingBuffer;
+    { // Centered on the bounding box, not minimal but tight enough for culling.
+      glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+      for (const Vertex3D &vertex: vertices) {
+        min = glm::min(min, vertex.position);
+        max = glm::max(max, vertex.position);
+      }
+      glm::vec3 center = vertices.empty() ? glm::vec3(0.0f) : (min + max) * 0.5f;
+      float radius = 0.0f;
+      for (const Vertex3D &vertex: vertices) radius = std::max(radius, glm::length(vertex.position - center));
+      mBoundingSphere = glm::vec4(center, radius);
     }
 
-    {
-      VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
-
-      fr::frBuffer *stagingBuffer = new fr::frBuffer();
-      stagingBuffer->initialize(sContext->frRenderer, fr::frBuffer::frBufferInfo{
-        bufferSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, {}
-      });
-      stagingBuffer->copyData(0, bufferSize, indices.data());
-
-      mIndexBuffer = new fr::frBuffer();
-      mIndexBuffer->initialize(sContext->frRenderer, fr::frBuffer::frBufferInfo{
-        bufferSize,
-        (VkBufferUsageFlagBits)(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, {}
-      });
-      mIndexBuffer->copyFromBuffer(sContext->frRenderer, commands, stagingBuffer, bufferSize);
-      mIndexCount = indices.size();
-
-      delete stagingBuffer;
+    mVertexBuffer = createDeviceBuffer(commands, vertices.data(), sizeof(vertices[0]) * vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    mIndexBuffer = createDeviceBuffer(commands, indices.data(), sizeof(indices[0]) * indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+    mIndexCount = indices.size();
+    if (!mVertexBuffer || !mIndexBuffer) {
+      fprintf(stderr, "[purrMesh]: Failed to create the mesh's buffers!\n");
+      delete mVertexBuffer;
+      delete mIndexBuffer;
+      mVertexBuffer = nullptr;
+      mIndexBuffer = nullptr;
+      return;
     }
 
     mValid = true;
@@ -196,54 +197,20 @@ namespace PurrfectEngine {
   }
   
   void purrMesh2D::initialize(fr::frCommands *commands, std::vector<Vertex2D> vertices, std::vector<uint32_t> indices) {
-    {
-      VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
-
-      fr::frBuffer *stagingBuffer = new fr::frBuffer();
-      stagingBuffer->initialize(sContext->frRenderer, fr::frBuffer::frBufferInfo{
-        bufferSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, {}
-      });
-      stagingBuffer->copyData(0, bufferSize, vertices.data());
-
-      mVertexBuffer = new fr::frBuffer();
-      mVertexBuffer->initialize(sContext->frRenderer, fr::frBuffer::frBufferInfo{
-        bufferSize,
-        (VkBufferUsageFlagBits)(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, {}
-      });
-      mVertexBuffer->copyFromBuffer(sContext->frRenderer, commands, stagingBuffer, bufferSize);
-
-      delete stagingBuffer;
-    }
-
-    {
-      VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
-
-      fr::frBuffer *stagingBuffer = new fr::frBuffer();
-      stagingBuffer->initialize(sContext->frRenderer, fr::frBuffer::frBufferInfo{
-        bufferSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, {}
-      });
-      stagingBuffer->copyData(0, bufferSize, indices.data());
-
-      mIndexBuffer = new fr::frBuffer();
-      mIndexBuffer->initialize(sContext->frRenderer, fr::frBuffer::frBufferInfo{
-        bufferSize,
-        (VkBufferUsageFlagBits)(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, {}
-      });
-      mIndexBuffer->copyFromBuffer(sContext->frRenderer, commands, stagingBuffer, bufferSize);
-      mIndexCount = indices.size();
-
-      delete stagingBuffer;
-    }
+    mVertexBuffer = createDeviceBuffer(commands, vertices.data(), sizeof(vertices[0]) * vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    mIndexBuffer = createDeviceBuffer(commands, indices.data(), sizeof(indices[0]) * indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+    mIndexCount = indices.size();
   }
 
   void purrMesh2D::cleanup() {
     delete mVertexBuffer;
     delete mIndexBuffer;
+    mVertexBuffer = nullptr;
+    mIndexBuffer = nullptr;
   }
 
   void purrMesh2D::render(VkCommandBuffer cmdBuf) {
+    if (!mVertexBuffer || !mIndexBuffer) return;
     VkDeviceSize offsets[] = {0};
     VkBuffer vbufs[] = { mVertexBuffer->get() };
     vkCmdBindVertexBuffers(cmdBuf, 0, 1, vbufs, offsets);
@@ -0,0 +1,558 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cfloat>
+
+namespace PurrfectEngine {
+
+  static PurrfectEngineContext *sContext = nullptr;
+
+  // CPU depth is reduced to tiles of this size, one row of tiles is one raster job.
+  #define OCCLUSION_TILE_SIZE 8
+  #define OCCLUSION_TEST_CHUNK 1024
+
+  // Same layouts as shaders/hiz.comp and shaders/occlusion.comp.
+  struct ReduceConstants {
+    glm::uvec2 srcSize;
+    glm::uvec2 dstSize;
+  };
+
+  struct TestConstants {
+    glm::mat4 viewProjection;
+    glm::uvec4 info; // Object count, pyramid width, height and mip count.
+  };
+
+  static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  static VkPipelineLayout createPipelineLayout(fr::frDescriptorLayout *setLayout, uint32_t constantsSize) {
+    VkDescriptorSetLayout handle = setLayout->get();
+    VkPushConstantRange pushConstant = { VK_SHADER_STAGE_COMPUTE_BIT, 0, constantsSize };
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &handle;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstant;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    if (vkCreatePipelineLayout(sContext->frRenderer->getDevice(), &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+      fprintf(stderr, "[purrOcclusionCuller]: Failed to create pipeline layout!\n");
+      return VK_NULL_HANDLE;
+    }
+    return layout;
+  }
+
+  purrOcclusionCuller::purrOcclusionCuller(purrOcclusionSettings settings):
+    mSettings(settings)
+  {
+    // Whole tiles only, the raster jobs and the tile reduction don't have to deal with partial ones.
+    mSettings.width = std::max(1u, (mSettings.width + OCCLUSION_TILE_SIZE - 1) / OCCLUSION_TILE_SIZE) * OCCLUSION_TILE_SIZE;
+    mSettings.height = std::max(1u, (mSettings.height + OCCLUSION_TILE_SIZE - 1) / OCCLUSION_TILE_SIZE) * OCCLUSION_TILE_SIZE;
+    mSettings.boundsScale = std::max(mSettings.boundsScale, 1.0f);
+    mWorkers = new purrWorkerPool(mSettings.threads);
+  }
+
+  purrOcclusionCuller::~purrOcclusionCuller() {
+    cleanup();
+    delete mWorkers;
+  }
+
+  void purrOcclusionCuller::initialize() {
+    mFrames.resize(renderer::getFramesInFlight());
+
+    mReduceLayout = new fr::frDescriptorLayout();
+    mReduceLayout->addBinding(VkDescriptorSetLayoutBinding{ 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE });
+    mReduceLayout->addBinding(VkDescriptorSetLayoutBinding{ 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE });
+    mReduceLayout->initialize(sContext->frRenderer);
+
+    // Pyramid, bounding spheres, visibility.
+    mTestLayout = new fr::frDescriptorLayout();
+    mTestLayout->addBinding(VkDescriptorSetLayoutBinding{ 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE });
+    mTestLayout->addBinding(VkDescriptorSetLayoutBinding{ 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE });
+    mTestLayout->addBinding(VkDescriptorSetLayoutBinding{ 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE });
+    mTestLayout->initialize(sContext->frRenderer);
+
+    mReducePipelineLayout = createPipelineLayout(mReduceLayout, sizeof(ReduceConstants));
+    mTestPipelineLayout = createPipelineLayout(mTestLayout, sizeof(TestConstants));
+    std::string shaderPath = sContext->settings.shaderPath;
+    if (mReducePipelineLayout) mReducePipeline = purrPipelineCache::getDefault()->createComputePipeline(shaderPath + "hiz.comp.spv", mReducePipelineLayout);
+    if (mTestPipelineLayout) mTestPipeline = purrPipelineCache::getDefault()->createComputePipeline(shaderPath + "occlusion.comp.spv", mTestPipelineLayout);
+    if (!mReducePipeline || !mTestPipeline) fprintf(stderr, "[purrOcclusionCuller]: Missing compute shaders, GPU occlusion culling is disabled.\n");
+
+    // Texels are fetched, never filtered.
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_NEAREST;
+    samplerInfo.minFilter = VK_FILTER_NEAREST;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = 16.0f;
+    if (vkCreateSampler(sContext->frRenderer->getDevice(), &samplerInfo, nullptr, &mSampler) != VK_SUCCESS) {
+      fprintf(stderr, "[purrOcclusionCuller]: Failed to create sampler!\n");
+      mSampler = VK_NULL_HANDLE;
+    }
+  }
+
+  void purrOcclusionCuller::cleanup() {
+    if (!sContext || !sContext->frRenderer) return;
+    destroyPyramid();
+    VkDevice device = sContext->frRenderer->getDevice();
+    for (FrameData &frame: mFrames) {
+      delete frame.bounds;
+      purrGpuAllocator::getDefault()->destroyBuffer(frame.visibility, frame.visibilityAllocation);
+    }
+    mFrames.clear();
+    if (mReducePipeline) vkDestroyPipeline(device, mReducePipeline, nullptr);
+    if (mTestPipeline) vkDestroyPipeline(device, mTestPipeline, nullptr);
+    if (mReducePipelineLayout) vkDestroyPipelineLayout(device, mReducePipelineLayout, nullptr);
+    if (mTestPipelineLayout) vkDestroyPipelineLayout(device, mTestPipelineLayout, nullptr);
+    if (mSampler) vkDestroySampler(device, mSampler, nullptr);
+    mReducePipeline = mTestPipeline = VK_NULL_HANDLE;
+    mReducePipelineLayout = mTestPipelineLayout = VK_NULL_HANDLE;
+    mSampler = VK_NULL_HANDLE;
+    delete mReduceLayout;
+    delete mTestLayout;
+    mReduceLayout = nullptr;
+    mTestLayout = nullptr;
+  }
+
+  void purrOcclusionCuller::update(const glm::mat4 &viewProjection) {
+    PURR_PROFILE_SCOPE("updateOcclusion");
+    mViewProjection = viewProjection;
+    mStats = purrOcclusionStats{};
+    gatherBounds();
+    mVisible.assign(mSpheres.size(), 1);
+    if (mSettings.mode == purrOcclusionMode::Cpu) updateCpu();
+    else if (mSettings.mode == purrOcclusionMode::Gpu) readbackGpu();
+
+    auto start = std::chrono::steady_clock::now();
+    bool cpu = mSettings.mode == purrOcclusionMode::Cpu;
+    std::atomic<uint32_t> frustumCulled{0}, occluded{0};
+    uint32_t chunks = (static_cast<uint32_t>(mSpheres.size()) + OCCLUSION_TEST_CHUNK - 1) / OCCLUSION_TEST_CHUNK;
+    mWorkers->parallelFor(chunks, [&](uint32_t chunk) {
+      uint32_t begin = chunk * OCCLUSION_TEST_CHUNK;
+      uint32_t end = std::min(begin + OCCLUSION_TEST_CHUNK, static_cast<uint32_t>(mSpheres.size()));
+      uint32_t culled = 0, hidden = 0;
+      for (uint32_t i = begin; i < end; ++i) {
+        // GPU results are frames old, the frustum test always uses this frame's camera.
+        if (mSpheres[i].w < 0.0f || !mVisible[i]) continue;
+        glm::vec4 rect{};
+        float depth = 0.0f;
+        int result = projectSphere(mSpheres[i], &rect, &depth);
+        if (result == 0) {
+          mVisible[i] = 0;
+          ++culled;
+        } else if (result == 1 && cpu && isOccludedCpu(rect, depth)) {
+          mVisible[i] = 0;
+          ++hidden;
+        }
+      }
+      frustumCulled += culled;
+      occluded += hidden;
+    });
+    mStats.frustumCulled = frustumCulled;
+    mStats.occluded += occluded;
+    mStats.testMs = elapsedMs(start);
+  }
+
+  void purrOcclusionCuller::gatherBounds() {
+    mSpheres.clear();
+    mKeys.clear();
+    const purrRenderSnapshot *snapshot = renderer::getSnapshot();
+    mSpheres.resize(snapshot->objects.size(), glm::vec4(0.0f, 0.0f, 0.0f, -1.0f));
+    mKeys.resize(snapshot->objects.size());
+    for (uint32_t i = 0; i < snapshot->objects.size(); ++i) {
+      mKeys[i] = snapshot->objects[i].uuid;
+      purrMesh *mesh = snapshot->objects[i].mesh;
+      if (!mesh) continue;
+      const glm::mat4 &model = snapshot->transforms[i];
+      glm::vec4 sphere = mesh->getBoundingSphere();
+      float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+      mSpheres[i] = glm::vec4(glm::vec3(model * glm::vec4(sphere.x, sphere.y, sphere.z, 1.0f)), sphere.w * scale * mSettings.boundsScale);
+      ++mStats.tested;
+    }
+  }
+
+  int purrOcclusionCuller::projectSphere(glm::vec4 sphere, glm::vec4 *rect, float *depth) const {
+    // The sphere's box projects to the hull of its corners as long as all of them are in front of the camera.
+    glm::vec2 lo(FLT_MAX), hi(-FLT_MAX);
+    float nearest = FLT_MAX;
+    for (uint32_t c = 0; c < 8; ++c) {
+      glm::vec3 offset((c & 1) ? sphere.w : -sphere.w, (c & 2) ? sphere.w : -sphere.w, (c & 4) ? sphere.w : -sphere.w);
+      glm::vec4 clip = mViewProjection * glm::vec4(glm::vec3(sphere) + offset, 1.0f);
+      if (clip.w <= 1e-5f) return 2;
+      glm::vec3 ndc = glm::vec3(clip) / clip.w;
+      lo = glm::min(lo, glm::vec2(ndc.x, ndc.y));
+      hi = glm::max(hi, glm::vec2(ndc.x, ndc.y));
+      nearest = std::min(nearest, ndc.z);
+    }
+    if (lo.x > 1.0f || lo.y > 1.0f || hi.x < -1.0f || hi.y < -1.0f || nearest > 1.0f) return 0;
+    *rect = glm::vec4(lo.x, lo.y, hi.x, hi.y);
+    *depth = nearest;
+    return 1;
+  }
+
+  void purrOcclusionCuller::updateCpu() {
+    PURR_PROFILE_SCOPE("rasterizeOccluders");
+    auto start = std::chrono::steady_clock::now();
+    uint32_t width = mSettings.width, height = mSettings.height;
+    mDepth.resize(static_cast<size_t>(width) * height);
+    mTilesX = width / OCCLUSION_TILE_SIZE;
+    mTilesY = height / OCCLUSION_TILE_SIZE;
+    mTileDepth.resize(static_cast<size_t>(mTilesX) * mTilesY);
+
+    // Every occluder gets a fixed range of triangle slots, so they can be transformed in parallel.
+    const purrRenderSnapshot *snapshot = renderer::getSnapshot();
+    purrFrameVector<uint32_t> occluders(renderer::getFrameArena()); // Object indices.
+    purrFrameVector<uint32_t> offsets(renderer::getFrameArena());
+    uint32_t triangleCount = 0;
+    for (uint32_t i = 0; i < snapshot->objects.size(); ++i) {
+      purrOccluderComp *occluder = snapshot->objects[i].occluder;
+      if (!occluder || occluder->getIndices().size() < 3) continue;
+      occluders.push_back(i);
+      offsets.push_back(triangleCount);
+      triangleCount += static_cast<uint32_t>(occluder->getIndices().size() / 3);
+    }
+    mTriangles.resize(triangleCount);
+    mStats.occluders = static_cast<uint32_t>(occluders.size());
+    mStats.occluderTriangles = triangleCount;
+
+    float fw = static_cast<float>(width), fh = static_cast<float>(height);
+    mWorkers->parallelFor(static_cast<uint32_t>(occluders.size()), [&](uint32_t o) {
+      purrOccluderComp *occluder = snapshot->objects[occluders[o]].occluder;
+      const std::vector<glm::vec3> &positions = occluder->getPositions();
+      const std::vector<uint32_t> &indices = occluder->getIndices();
+      glm::mat4 mvp = mViewProjection * snapshot->transforms[occluders[o]];
+      for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        Triangle &tri = mTriangles[offsets[o] + t / 3];
+        tri.valid = false;
+        tri.depth = 0.0f;
+        bool inFront = true;
+        for (uint32_t k = 0; k < 3 && inFront; ++k) {
+          uint32_t index = indices[t + k];
+          glm::vec4 clip = index < positions.size() ? mvp * glm::vec4(positions[index], 1.0f) : glm::vec4(0.0f);
+          // Triangles crossing the near plane are dropped instead of clipped. Fewer occluders only means less culling.
+          inFront = clip.w > 1e-5f;
+          if (!inFront) break;
+          tri.x[k] = (clip.x / clip.w * 0.5f + 0.5f) * fw;
+          tri.y[k] = (clip.y / clip.w * 0.5f + 0.5f) * fh;
+          tri.depth = std::max(tri.depth, clip.z / clip.w);
+        }
+        if (!inFront || tri.depth > 1.0f) continue;
+        // Rows whose pixel centers fall inside the triangle's y range.
+        float minY = std::min(tri.y[0], std::min(tri.y[1], tri.y[2])), maxY = std::max(tri.y[0], std::max(tri.y[1], tri.y[2]));
+        float minX = std::min(tri.x[0], std::min(tri.x[1], tri.x[2])), maxX = std::max(tri.x[0], std::max(tri.x[1], tri.x[2]));
+        if (maxX < 0.0f || minX > fw || maxY < 0.0f || minY > fh) continue;
+        tri.minY = std::max(0, static_cast<int32_t>(std::ceil(minY - 0.5f)));
+        tri.maxY = std::min(static_cast<int32_t>(height) - 1, static_cast<int32_t>(std::floor(maxY - 0.5f)));
+        tri.valid = tri.minY <= tri.maxY;
+      }
+    });
+
+    mWorkers->parallelFor(mTilesY, [&](uint32_t band) { rasterizeBand(band); });
+    mStats.rasterMs = elapsedMs(start);
+  }
+
+  void purrOcclusionCuller::rasterizeBand(uint32_t band) {
+    int32_t width = static_cast<int32_t>(mSettings.width);
+    int32_t y0 = static_cast<int32_t>(band) * OCCLUSION_TILE_SIZE, y1 = y0 + OCCLUSION_TILE_SIZE;
+    std::fill(mDepth.begin() + static_cast<size_t>(y0) * width, mDepth.begin() + static_cast<size_t>(y1) * width, 1.0f);
+
+    for (const Triangle &tri: mTriangles) {
+      if (!tri.valid || tri.maxY < y0 || tri.minY >= y1) continue;
+      float area = (tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0]) - (tri.x[2] - tri.x[0]) * (tri.y[1] - tri.y[0]);
+      if (area == 0.0f) continue;
+      // Edge functions a*x + b*y + c, oriented so the inside is positive for either winding.
+      float sign = area > 0.0f ? 1.0f : -1.0f;
+      float a[3], b[3], c[3];
+      for (uint32_t i = 0; i < 3; ++i) {
+        uint32_t j = (i + 1) % 3;
+        a[i] = (tri.y[i] - tri.y[j]) * sign;
+        b[i] = (tri.x[j] - tri.x[i]) * sign;
+        c[i] = -(a[i] * tri.x[i] + b[i] * tri.y[i]);
+      }
+      float minX = std::min(tri.x[0], std::min(tri.x[1], tri.x[2])), maxX = std::max(tri.x[0], std::max(tri.x[1], tri.x[2]));
+      int32_t x0 = std::max(0, static_cast<int32_t>(std::ceil(minX - 0.5f)));
+      int32_t x1 = std::min(width - 1, static_cast<int32_t>(std::floor(maxX - 0.5f)));
+      float depth = tri.depth;
+
+      for (int32_t y = std::max(tri.minY, y0); y <= std::min(tri.maxY, y1 - 1); ++y) {
+        float py = y + 0.5f;
+        float r0 = b[0] * py + c[0], r1 = b[1] * py + c[1], r2 = b[2] * py + c[2];
+        float *row = mDepth.data() + static_cast<size_t>(y) * width;
+        // No branches and no loop carried state, the compiler turns this into SIMD compares and blends.
+        for (int32_t x = x0; x <= x1; ++x) {
+          float px = x + 0.5f;
+          bool inside = (a[0] * px + r0 >= 0.0f) & (a[1] * px + r1 >= 0.0f) & (a[2] * px + r2 >= 0.0f);
+          row[x] = inside ? std::min(row[x], depth) : row[x];
+        }
+      }
+    }
+
+    // Farthest depth per tile, anything behind it is behind every pixel of the tile.
+    for (uint32_t tx = 0; tx < mTilesX; ++tx) {
+      float farthest = 0.0f;
+      for (int32_t y = y0; y < y1; ++y) {
+        const float *row = mDepth.data() + static_cast<size_t>(y) * width + tx * OCCLUSION_TILE_SIZE;
+        for (uint32_t x = 0; x < OCCLUSION_TILE_SIZE; ++x) farthest = std::max(farthest, row[x]);
+      }
+      mTileDepth[band * mTilesX + tx] = farthest;
+    }
+  }
+
+  bool purrOcclusionCuller::isOccluded(glm::vec4 sphere) const {
+    glm::vec4 rect{};
+    float depth = 0.0f;
+    return projectSphere(sphere, &rect, &depth) == 1 && isOccludedCpu(rect, depth);
+  }
+
+  bool purrOcclusionCuller::isOccludedCpu(const glm::vec4 &rect, float depth) const {
+    if (mTileDepth.empty()) return false;
+    float tileWidth = static_cast<float>(mSettings.width) / mTilesX, tileHeight = static_cast<float>(mSettings.height) / mTilesY;
+    int32_t tx0 = std::max(0, static_cast<int32_t>(std::floor((rect.x * 0.5f + 0.5f) * mSettings.width / tileWidth)));
+    int32_t ty0 = std::max(0, static_cast<int32_t>(std::floor((rect.y * 0.5f + 0.5f) * mSettings.height / tileHeight)));
+    int32_t tx1 = std::min(static_cast<int32_t>(mTilesX) - 1, static_cast<int32_t>(std::floor((rect.z * 0.5f + 0.5f) * mSettings.width / tileWidth)));
+    int32_t ty1 = std::min(static_cast<int32_t>(mTilesY) - 1, static_cast<int32_t>(std::floor((rect.w * 0.5f + 0.5f) * mSettings.height / tileHeight)));
+    for (int32_t ty = ty0; ty <= ty1; ++ty) {
+      for (int32_t tx = tx0; tx <= tx1; ++tx) {
+        if (mTileDepth[ty * mTilesX + tx] >= depth) return false;
+      }
+    }
+    return true;
+  }
+
+  void purrOcclusionCuller::readbackGpu() {
+    if (mFrames.empty()) return;
+    // The renderer waited on this slot's fence, the test it recorded framesInFlight frames ago is done.
+    FrameData &frame = mFrames[renderer::getFrameIndex()];
+    if (!frame.pending || !frame.visibilityData) return;
+    frame.pending = false;
+    uint32_t count = std::min(frame.objectCount, static_cast<uint32_t>(frame.keys.size()));
+    auto hide = [&](uint32_t i) {
+      if (mSpheres[i].w < 0.0f || !mVisible[i]) return;
+      mVisible[i] = 0;
+      ++mStats.occluded;
+    };
+
+    if (count == mKeys.size() && std::equal(mKeys.begin(), mKeys.end(), frame.keys.begin())) {
+      for (uint32_t i = 0; i < count; ++i) if (!frame.visibilityData[i]) hide(i);
+      return;
+    }
+    // Objects were added or removed since the test was recorded, indices moved, so results go by UUID.
+    std::unordered_map<uint32_t, uint32_t> indices{};
+    indices.reserve(mKeys.size());
+    for (uint32_t i = 0; i < mKeys.size(); ++i) indices[mKeys[i]] = i;
+    for (uint32_t i = 0; i < count; ++i) {
+      if (frame.visibilityData[i]) continue;
+      auto it = indices.find(frame.keys[i]);
+      if (it != indices.end()) hide(it->second);
+    }
+  }
+
+  void purrOcclusionCuller::build(purrTexture *depth, VkExtent2D renderExtent) {
+    if (mSettings.mode != purrOcclusionMode::Gpu || !depth || !mReducePipeline || !mTestPipeline || !mSampler || mFrames.empty()) return;
+    if (depth->getImage()->getView() != mSourceView) createPyramid(depth);
+    uint32_t count = static_cast<uint32_t>(mSpheres.size());
+    FrameData &frame = mFrames[renderer::getFrameIndex()];
+    if (!mPyramid || count == 0 || !reserveFrame(frame, count)) return;
+
+    VkCommandBuffer cmdBuf = sContext->frActiveCmdBuf;
+    purrProfiler::getDefault()->beginGpuZone(cmdBuf, "Occlusion");
+    frame.bounds->copyData(0, sizeof(glm::vec4) * count, mSpheres.data());
+
+    VkDescriptorImageInfo pyramidInfo = { mSampler, mPyramidView, VK_IMAGE_LAYOUT_GENERAL };
+    VkDescriptorBufferInfo boundsInfo = { frame.bounds->get(), 0, sizeof(glm::vec4) * count };
+    VkDescriptorBufferInfo visibilityInfo = { frame.visibility, 0, sizeof(uint32_t) * count };
+    frame.descriptor->update(fr::frDescriptor::frDescriptorWriteInfo{ 0, 0, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &pyramidInfo, nullptr, nullptr });
+    frame.descriptor->update(fr::frDescriptor::frDescriptorWriteInfo{ 1, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr, &boundsInfo, nullptr });
+    frame.descriptor->update(fr::frDescriptor::frDescriptorWriteInfo{ 2, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr, &visibilityInfo, nullptr });
+
+    uint32_t mipCount = static_cast<uint32_t>(mMipViews.size());
+    { // Last frame's test may still read the pyramid, its contents are replaced entirely.
+      VkImageMemoryBarrier barrier{};
+      barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+      barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+      barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+      barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.image = mPyramid;
+      barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipCount, 0, 1 };
+      vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+
+    VkMemoryBarrier mipBarrier{};
+    mipBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    mipBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    mipBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    // Level 0 covers only the rendered part of the depth target (dynamic resolution), stretched over the whole level.
+    vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, mReducePipeline);
+    VkExtent2D src = { std::max(1u, renderExtent.width), std::max(1u, renderExtent.height) };
+    for (uint32_t mip = 0; mip < mipCount; ++mip) {
+      VkExtent2D dst = { std::max(1u, mPyramidSize.width >> mip), std::max(1u, mPyramidSize.height >> mip) };
+      ReduceConstants constants{ glm::uvec2(src.width, src.height), glm::uvec2(dst.width, dst.height) };
+      VkDescriptorSet set = mReduceDescriptors[mip]->get();
+      vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, mReducePipelineLayout, 0, 1, &set, 0, nullptr);
+      vkCmdPushConstants(cmdBuf, mReducePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+      vkCmdDispatch(cmdBuf, (dst.width + 7) / 8, (dst.height + 7) / 8, 1);
+      vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &mipBarrier, 0, nullptr, 0, nullptr);
+      src = dst;
+    }
+
+    vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, mTestPipeline);
+    VkDescriptorSet set = frame.descriptor->get();
+    vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, mTestPipelineLayout, 0, 1, &set, 0, nullptr);
+    TestConstants constants{ mViewProjection, glm::uvec4(count, mPyramidSize.width, mPyramidSize.height, mipCount) };
+    vkCmdPushConstants(cmdBuf, mTestPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+    vkCmdDispatch(cmdBuf, (count + 63) / 64, 1, 1);
+
+    VkBufferMemoryBarrier readback{};
+    readback.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    readback.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    readback.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    readback.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    readback.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    readback.buffer = frame.visibility;
+    readback.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &readback, 0, nullptr);
+    purrProfiler::getDefault()->endGpuZone(cmdBuf);
+
+    frame.objectCount = count;
+    frame.keys = mKeys;
+    frame.pending = true;
+  }
+
+  void purrOcclusionCuller::createPyramid(purrTexture *depth) {
+    // Only on the first build and when the depth target was replaced (resize), earlier frames may use the old pyramid.
+    sContext->frRenderer->waitIdle();
+    destroyPyramid();
+    VkDevice device = sContext->frRenderer->getDevice();
+
+    // Half the depth target, the first reduction already takes 2x2 texels.
+    mPyramidSize = { std::max(1u, static_cast<uint32_t>(depth->getWidth() + 1) / 2), std::max(1u, static_cast<uint32_t>(depth->getHeight() + 1) / 2) };
+    uint32_t mipCount = static_cast<uint32_t>(std::floor(std::log2(static_cast<float>(std::max(mPyramidSize.width, mPyramidSize.height))))) + 1;
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = VK_FORMAT_R32_SFLOAT;
+    imageInfo.extent = { mPyramidSize.width, mPyramidSize.height, 1 };
+    imageInfo.mipLevels = mipCount;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    purrAllocationInfo allocInfo{};
+    allocInfo.category = purrMemoryCategory::Target;
+    allocInfo.image = true;
+    if (!purrGpuAllocator::getDefault()->createImage(imageInfo, allocInfo, &mPyramid, &mPyramidAllocation)) {
+      fprintf(stderr, "[purrOcclusionCuller]: Failed to create depth pyramid!\n");
+      mPyramid = VK_NULL_HANDLE;
+      return;
+    }
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = mPyramid;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = VK_FORMAT_R32_SFLOAT;
+    viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipCount, 0, 1 };
+    vkCreateImageView(device, &viewInfo, nullptr, &mPyramidView);
+    mMipViews.resize(mipCount, VK_NULL_HANDLE);
+    for (uint32_t mip = 0; mip < mipCount; ++mip) {
+      viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, mip, 1, 0, 1 };
+      vkCreateImageView(device, &viewInfo, nullptr, &mMipViews[mip]);
+    }
+
+    uint32_t frameCount = static_cast<uint32_t>(mFrames.size());
+    mDescriptors = new fr::frDescriptors();
+    mDescriptors->initialize(sContext->frRenderer, {
+      { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, mipCount + frameCount },
+      { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, mipCount },
+      { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frameCount * 2 },
+    });
+    // Each level reads the one above it, level 0 reads the depth target.
+    mReduceDescriptors = mDescriptors->allocate(mipCount, mReduceLayout);
+    for (uint32_t mip = 0; mip < mipCount; ++mip) {
+      VkDescriptorImageInfo srcInfo = mip == 0 ? VkDescriptorImageInfo{ mSampler, depth->getImage()->getView(), VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL }
+                                               : VkDescriptorImageInfo{ mSampler, mMipViews[mip - 1], VK_IMAGE_LAYOUT_GENERAL };
+      VkDescriptorImageInfo dstInfo = { VK_NULL_HANDLE, mMipViews[mip], VK_IMAGE_LAYOUT_GENERAL };
+      mReduceDescriptors[mip]->update(fr::frDescriptor::frDescriptorWriteInfo{ 0, 0, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &srcInfo, nullptr, nullptr });
+      mReduceDescriptors[mip]->update(fr::frDescriptor::frDescriptorWriteInfo{ 1, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, &dstInfo, nullptr, nullptr });
+    }
+    for (FrameData &frame: mFrames) {
+      frame.descriptor = mDescriptors->allocate(1, mTestLayout)[0];
+      frame.pending = false;
+    }
+    mSourceView = depth->getImage()->getView();
+  }
+
+  void purrOcclusionCuller::destroyPyramid() {
+    VkDevice device = sContext->frRenderer->getDevice();
+    for (VkImageView view: mMipViews) if (view) vkDestroyImageView(device, view, nullptr);
+    mMipViews.clear();
+    if (mPyramidView) vkDestroyImageView(device, mPyramidView, nullptr);
+    purrGpuAllocator::getDefault()->destroyImage(mPyramid, mPyramidAllocation);
+    mPyramidView = VK_NULL_HANDLE;
+    mPyramid = VK_NULL_HANDLE;
+    // Frees the sets with the pool.
+    delete mDescriptors;
+    mDescriptors = nullptr;
+    mReduceDescriptors.clear();
+    for (FrameData &frame: mFrames) frame.descriptor = nullptr;
+    mSourceView = VK_NULL_HANDLE;
+  }
+
+  bool purrOcclusionCuller::reserveFrame(FrameData &frame, uint32_t objectCount) {
+    VkDeviceSize boundsSize = sizeof(glm::vec4) * objectCount;
+    if (frame.boundsCapacity < boundsSize) {
+      if (!frame.bounds) frame.bounds = new purrBuffer();
+      else frame.bounds->cleanup();
+      frame.boundsCapacity = std::max<VkDeviceSize>(frame.boundsCapacity * 2, boundsSize);
+      if (!frame.bounds->initialize(frame.boundsCapacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, purrMemoryCategory::Frame)) {
+        frame.boundsCapacity = 0;
+        return false;
+      }
+    }
+
+    VkDeviceSize visibilitySize = sizeof(uint32_t) * objectCount;
+    if (frame.visibilityCapacity >= visibilitySize) return true;
+    purrGpuAllocator::getDefault()->destroyBuffer(frame.visibility, frame.visibilityAllocation);
+    frame.visibility = VK_NULL_HANDLE;
+    frame.visibilityData = nullptr;
+    frame.visibilityCapacity = std::max<VkDeviceSize>(frame.visibilityCapacity * 2, visibilitySize);
+    frame.pending = false;
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = frame.visibilityCapacity;
+    bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    // Read on the CPU every frame, cached memory if the device has it.
+    purrAllocationInfo allocInfo{};
+    allocInfo.required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    allocInfo.preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+    allocInfo.category = purrMemoryCategory::Frame;
+    if (!purrGpuAllocator::getDefault()->createBuffer(bufferInfo, allocInfo, &frame.visibility, &frame.visibilityAllocation)) {
+      fprintf(stderr, "[purrOcclusionCuller]: Failed to create visibility buffer!\n");
+      frame.visibility = VK_NULL_HANDLE;
+      frame.visibilityCapacity = 0;
+      return false;
+    }
+    frame.visibilityData = static_cast<uint32_t*>(frame.visibilityAllocation.mapped);
+    return frame.visibilityData != nullptr;
+  }
+
+  void purrOcclusionCuller::setContext(PurrfectEngineContext *context) {
+    sContext = context;
+  }
+
+}
\ No newline at end of file
@@ -0,0 +1,477 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace PurrfectEngine {
+
+  static PurrfectEngineContext *sContext = nullptr;
+
+  #define PARTICLE_EMIT_GROUP_SIZE 64
+  // Keys one workgroup of shaders/particleSort.comp sorts in shared memory, two per invocation.
+  #define PARTICLE_SORT_BLOCK 1024
+
+  // Same layout as the State buffer of the particle shaders (std430).
+  struct ParticleState {
+    uint32_t alive;
+    uint32_t next;   // Append counter of the running update.
+    uint32_t padding[2];
+    VkDrawIndirectCommand draw;
+    VkDispatchIndirectCommand dispatch; // Over the live particles, for the next simulate.
+  };
+
+  struct SimulateConstants {
+    glm::vec4 gravityDrag;
+    float dt;
+    uint32_t capacity;
+  };
+
+  struct EmitConstants {
+    glm::vec4 positionRadius;
+    glm::vec4 velocitySpread;
+    glm::vec2 lifetime;
+    uint32_t count;
+    uint32_t spawnBase;
+    uint32_t seed;
+    uint32_t capacity;
+  };
+
+  struct SortConstants {
+    glm::vec4 viewRow; // Third row of the view matrix, -dot(viewRow, position) is the view depth.
+    uint32_t mode;     // 0: sort blocks, 1: global merge step, 2: block merge steps.
+    uint32_t j;
+    uint32_t k;
+  };
+
+  struct DrawConstants {
+    glm::vec4 colorStart;
+    glm::vec4 colorEnd;
+    glm::vec2 size;
+    uint32_t sorted;
+  };
+
+  struct ParticleDescriptors {
+    VkDescriptorBufferInfo buffers[4];
+  };
+
+  purrParticleBuffers::purrParticleBuffers()
+  {}
+
+  purrParticleBuffers::~purrParticleBuffers() {
+    cleanup();
+  }
+
+  bool purrParticleBuffers::initialize(uint32_t capacity, VkDescriptorSetLayout layout, purrDescriptorTemplate *descriptorTemplate) {
+    cleanup();
+    mCapacity = std::max(capacity, 1u);
+    mSortCapacity = PARTICLE_SORT_BLOCK;
+    while (mSortCapacity < mCapacity) mSortCapacity <<= 1;
+
+    for (purrBuffer *&particles: mParticles) {
+      particles = new purrBuffer();
+      if (!particles->initialize(sizeof(purrParticle) * mCapacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, purrMemoryCategory::Mesh)) {
+        cleanup();
+        return false;
+      }
+    }
+    mKeys = new purrBuffer();
+    if (!mKeys->initialize(sizeof(glm::uvec2) * mSortCapacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, purrMemoryCategory::Mesh)) {
+      cleanup();
+      return false;
+    }
+    mState = new purrBuffer();
+    if (!mState->initialize(sizeof(ParticleState), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, purrMemoryCategory::Frame)) {
+      cleanup();
+      return false;
+    }
+    ParticleState state{};
+    state.draw = { 6, 0, 0, 0 };
+    state.dispatch = { 0, 1, 1 };
+    mState->copyData(0, sizeof(state), &state);
+
+    for (uint32_t i = 0; i < 2; ++i) {
+      mSets[i] = purrDescriptorAllocator::getDefault()->allocate(layout);
+      if (!mSets[i]) {
+        cleanup();
+        return false;
+      }
+      ParticleDescriptors descriptors{};
+      descriptors.buffers[0] = { mParticles[i]->get(), 0, VK_WHOLE_SIZE };
+      descriptors.buffers[1] = { mParticles[i ^ 1]->get(), 0, VK_WHOLE_SIZE };
+      descriptors.buffers[2] = { mState->get(), 0, VK_WHOLE_SIZE };
+      descriptors.buffers[3] = { mKeys->get(), 0, VK_WHOLE_SIZE };
+      descriptorTemplate->update(mSets[i], &descriptors);
+    }
+    mParity = 0;
+    return true;
+  }
+
+  void purrParticleBuffers::cleanup() {
+    for (VkDescriptorSet &set: mSets) {
+      purrDescriptorAllocator::getDefault()->free(set);
+      set = VK_NULL_HANDLE;
+    }
+    for (purrBuffer *&particles: mParticles) {
+      delete particles;
+      particles = nullptr;
+    }
+    delete mState;
+    delete mKeys;
+    mState = nullptr;
+    mKeys = nullptr;
+    mCapacity = 0;
+  }
+
+  VkBuffer purrParticleBuffers::getState() const {
+    return mState ? mState->get() : VK_NULL_HANDLE;
+  }
+
+  uint32_t purrParticleBuffers::getAlive() const {
+    return mState ? static_cast<const ParticleState*>(mState->getMapped())->alive : 0;
+  }
+
+  purrParticleComp::purrParticleComp(purrParticleEmitterSettings settings):
+    mSettings(settings)
+  {}
+
+  purrParticleComp::~purrParticleComp() {
+    delete mBuffers;
+  }
+
+  purrParticleSystem::purrParticleSystem()
+  {}
+
+  purrParticleSystem::~purrParticleSystem() {
+    cleanup();
+  }
+
+  void purrParticleSystem::initialize() {
+    mLayout = new fr::frDescriptorLayout();
+    for (uint32_t binding = 0; binding < 4; ++binding) {
+      mLayout->addBinding(VkDescriptorSetLayoutBinding{ binding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT, VK_NULL_HANDLE });
+    }
+    mLayout->initialize(sContext->frRenderer);
+
+    std::vector<VkDescriptorUpdateTemplateEntry> entries{};
+    for (uint32_t binding = 0; binding < 4; ++binding) {
+      entries.push_back({ binding, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, sizeof(VkDescriptorBufferInfo) * binding, sizeof(VkDescriptorBufferInfo) });
+    }
+    mTemplate.initialize(mLayout->get(), entries);
+
+    VkDescriptorSetLayout setLayout = mLayout->get();
+    size_t constantsSize = std::max(std::max(sizeof(SimulateConstants), sizeof(EmitConstants)), sizeof(SortConstants));
+    VkPushConstantRange pushConstant = { VK_SHADER_STAGE_COMPUTE_BIT, 0, static_cast<uint32_t>(constantsSize) };
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &setLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstant;
+    if (vkCreatePipelineLayout(sContext->frRenderer->getDevice(), &layoutInfo, nullptr, &mPipelineLayout) != VK_SUCCESS) {
+      fprintf(stderr, "[purrParticleSystem]: Failed to create pipeline layout!\n");
+      mPipelineLayout = VK_NULL_HANDLE;
+      return;
+    }
+    std::string shaderPath = sContext->settings.shaderPath;
+    purrPipelineCache *cache = purrPipelineCache::getDefault();
+    mSimulatePipeline = cache->createComputePipeline(shaderPath + "particleSimulate.comp.spv", mPipelineLayout);
+    mEmitPipeline = cache->createComputePipeline(shaderPath + "particleEmit.comp.spv", mPipelineLayout);
+    mFinalizePipeline = cache->createComputePipeline(shaderPath + "particleFinalize.comp.spv", mPipelineLayout);
+    mSortPipeline = cache->createComputePipeline(shaderPath + "particleSort.comp.spv", mPipelineLayout);
+    if (!mSimulatePipeline || !mEmitPipeline || !mFinalizePipeline || !mSortPipeline)
+      fprintf(stderr, "[purrParticleSystem]: Missing compute shaders, particles are disabled.\n");
+
+    mDrawLayout = purrPipelineCache::getDefault()->getPipelineLayout(
+      { sContext->frUboLayout->get(), setLayout },
+      { VkPushConstantRange{ VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(DrawConstants) } });
+  }
+
+  void purrParticleSystem::cleanup() {
+    if (!sContext || !sContext->frRenderer) return;
+    VkDevice device = sContext->frRenderer->getDevice();
+    if (mSimulatePipeline) vkDestroyPipeline(device, mSimulatePipeline, nullptr);
+    if (mEmitPipeline) vkDestroyPipeline(device, mEmitPipeline, nullptr);
+    if (mFinalizePipeline) vkDestroyPipeline(device, mFinalizePipeline, nullptr);
+    if (mSortPipeline) vkDestroyPipeline(device, mSortPipeline, nullptr);
+    if (mPipelineLayout) vkDestroyPipelineLayout(device, mPipelineLayout, nullptr);
+    mSimulatePipeline = mEmitPipeline = mFinalizePipeline = mSortPipeline = VK_NULL_HANDLE;
+    mPipelineLayout = VK_NULL_HANDLE;
+    mDrawLayout = VK_NULL_HANDLE;
+    mDrawKey = mDrawHash = 0;
+    mTemplate.cleanup();
+    delete mLayout;
+    mLayout = nullptr;
+    mEmitters.clear();
+  }
+
+  void purrParticleSystem::update(float dt) {
+    PURR_PROFILE_SCOPE("updateParticles");
+    mEmitters.clear();
+    mEmitted = 0;
+    mDispatches = 0;
+    const purrRenderSnapshot *snapshot = renderer::getSnapshot();
+    if (!mSimulatePipeline || !mEmitPipeline || !mFinalizePipeline || !mSortPipeline) return;
+
+    purrFrameVector<glm::vec3> positions(renderer::getFrameArena());
+    for (uint32_t i = 0; i < snapshot->objects.size(); ++i) {
+      purrParticleComp *comp = snapshot->objects[i].emitter;
+      if (!comp) continue;
+      if (!comp->getBuffers()) {
+        purrParticleBuffers *buffers = new purrParticleBuffers();
+        if (!buffers->initialize(comp->getSettings().maxParticles, mLayout->get(), &mTemplate)) {
+          fprintf(stderr, "[purrParticleSystem]: Failed to create buffers for %u particles!\n", comp->getSettings().maxParticles);
+          delete buffers;
+          continue;
+        }
+        comp->setBuffers(buffers);
+      }
+      mEmitters.push_back(comp);
+      positions.push_back(glm::vec3(snapshot->transforms[i][3]));
+    }
+    if (mEmitters.empty()) return;
+
+    glm::mat4 view = snapshot->camera.view;
+
+    VkCommandBuffer cmdBuf = sContext->frActiveCmdBuf;
+    purrProfiler::getDefault()->beginGpuZone(cmdBuf, "Particles");
+
+    { // Last frame's draw read the particles and the arguments, its finalize wrote this simulate's dispatch.
+      VkMemoryBarrier barrier{};
+      barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+      barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+      barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+      vkCmdPipelineBarrier(cmdBuf,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    // Each step is recorded for every emitter before the barrier, so emitters share them.
+    vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, mSimulatePipeline);
+    for (purrParticleComp *comp: mEmitters) {
+      purrParticleEmitterSettings settings = comp->getSettings();
+      purrParticleBuffers *buffers = comp->getBuffers();
+      SimulateConstants constants{};
+      constants.gravityDrag = glm::vec4(settings.gravity, settings.drag);
+      constants.dt = dt;
+      constants.capacity = buffers->getCapacity();
+      VkDescriptorSet set = buffers->getSet();
+      vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, mPipelineLayout, 0, 1, &set, 0, nullptr);
+      vkCmdPushConstants(cmdBuf, mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+      vkCmdDispatchIndirect(cmdBuf, buffers->getState(), offsetof(ParticleState, dispatch));
+      ++mDispatches;
+    }
+    Utils::computeBarrier(cmdBuf);
+
+    vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, mEmitPipeline);
+    for (size_t i = 0; i < mEmitters.size(); ++i) {
+      purrParticleComp *comp = mEmitters[i];
+      purrParticleEmitterSettings settings = comp->getSettings();
+      purrParticleBuffers *buffers = comp->getBuffers();
+      purrParticleSpawner &spawner = comp->getSpawner();
+      // A long hitch would ask for more than fits, only the newest ones could survive anyway.
+      uint32_t count = std::min(spawner.step(settings.rate, dt), buffers->getCapacity());
+      EmitConstants constants{};
+      constants.positionRadius = glm::vec4(positions[i], settings.spawnRadius);
+      constants.velocitySpread = glm::vec4(settings.velocity, settings.velocitySpread);
+      constants.lifetime = settings.lifetime;
+      constants.count = count;
+      constants.spawnBase = spawner.spawned;
+      constants.seed = settings.seed;
+      constants.capacity = buffers->getCapacity();
+      spawner.spawned += count;
+      mEmitted += count;
+      if (!count) continue;
+      VkDescriptorSet set = buffers->getSet();
+      vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, mPipelineLayout, 0, 1, &set, 0, nullptr);
+      vkCmdPushConstants(cmdBuf, mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+      vkCmdDispatch(cmdBuf, (count + PARTICLE_EMIT_GROUP_SIZE - 1) / PARTICLE_EMIT_GROUP_SIZE, 1, 1);
+      ++mDispatches;
+    }
+    Utils::computeBarrier(cmdBuf);
+
+    vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, mFinalizePipeline);
+    for (purrParticleComp *comp: mEmitters) {
+      purrParticleBuffers *buffers = comp->getBuffers();
+      SimulateConstants constants{};
+      constants.capacity = buffers->getCapacity();
+      VkDescriptorSet set = buffers->getSet();
+      vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, mPipelineLayout, 0, 1, &set, 0, nullptr);
+      vkCmdPushConstants(cmdBuf, mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+      vkCmdDispatch(cmdBuf, 1, 1, 1);
+      ++mDispatches;
+    }
+    Utils::computeBarrier(cmdBuf);
+
+    sort(cmdBuf, glm::vec4(view[0][2], view[1][2], view[2][2], view[3][2]));
+
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+      0, 1, &barrier, 0, nullptr, 0, nullptr);
+    purrProfiler::getDefault()->endGpuZone(cmdBuf);
+
+    for (purrParticleComp *comp: mEmitters) comp->getBuffers()->swap();
+  }
+
+  void purrParticleSystem::sort(VkCommandBuffer cmdBuf, const glm::vec4 &viewRow) {
+    uint32_t maxCapacity = 0;
+    for (purrParticleComp *comp: mEmitters) {
+      if (comp->getSettings().sort) maxCapacity = std::max(maxCapacity, comp->getBuffers()->getSortCapacity());
+    }
+    if (!maxCapacity) return;
+
+    vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, mSortPipeline);
+    SortConstants constants{};
+    constants.viewRow = viewRow;
+    // Every pass needs sortCapacity / 2 invocations, one per compared pair.
+    auto dispatch = [&](uint32_t mode, uint32_t j, uint32_t k) {
+      constants.mode = mode;
+      constants.j = j;
+      constants.k = k;
+      for (purrParticleComp *comp: mEmitters) {
+        purrParticleBuffers *buffers = comp->getBuffers();
+        if (!comp->getSettings().sort || buffers->getSortCapacity() < k) continue;
+        VkDescriptorSet set = buffers->getSet();
+        vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, mPipelineLayout, 0, 1, &set, 0, nullptr);
+        vkCmdPushConstants(cmdBuf, mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+        vkCmdDispatch(cmdBuf, buffers->getSortCapacity() / PARTICLE_SORT_BLOCK, 1, 1);
+        ++mDispatches;
+      }
+      Utils::computeBarrier(cmdBuf);
+    };
+
+    // Blocks are sorted in shared memory (alternating direction), then merged: the steps that compare keys
+    // further apart than a block go through global memory one by one, the rest of each merge is one block pass.
+    dispatch(0, 0, PARTICLE_SORT_BLOCK);
+    for (uint32_t k = PARTICLE_SORT_BLOCK * 2; k <= maxCapacity; k <<= 1) {
+      for (uint32_t j = k / 2; j >= PARTICLE_SORT_BLOCK; j >>= 1) dispatch(1, j, k);
+      dispatch(2, PARTICLE_SORT_BLOCK / 2, k);
+    }
+  }
+
+  void purrParticleSystem::render(purrPipeline *pipeline) {
+    if (mEmitters.empty() || !mDrawLayout || !pipeline->isBound()) return;
+
+    purrGraphicsPipelineState state{};
+    state.shaders = {
+      { VK_SHADER_STAGE_VERTEX_BIT, std::string(sContext->settings.shaderPath) + "particle.vert.spv" },
+      { VK_SHADER_STAGE_FRAGMENT_BIT, std::string(sContext->settings.shaderPath) + "particle.frag.spv" },
+    };
+    state.colorFormats = { pipeline->getColor()->getFormat() };
+    state.depthFormat = pipeline->getDepth()->getFormat();
+    state.samples = pipeline->getSampleCount();
+    state.layout = mDrawLayout;
+    state.cullMode = VK_CULL_MODE_NONE;
+    state.depthWrite = false;
+    state.blend = true;
+    uint64_t hash = state.hash();
+    if (hash != mDrawHash) {
+      // New formats or sample count (e.g. renderer::setMsaa), the cache keeps the old variant around.
+      mDrawKey = purrPipelineCache::getDefault()->requestPipeline(state, purrPipelineCompileMode::Block);
+      mDrawHash = hash;
+    }
+    VkPipeline drawPipeline = purrPipelineCache::getDefault()->getPipeline(mDrawKey);
+    if (!drawPipeline) return;
+
+    VkCommandBuffer cmdBuf = sContext->frActiveCmdBuf;
+    vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, drawPipeline);
+    renderer::bindCamera(mDrawLayout);
+    for (purrParticleComp *comp: mEmitters) {
+      purrParticleEmitterSettings settings = comp->getSettings();
+      purrParticleBuffers *buffers = comp->getBuffers();
+      DrawConstants constants{};
+      constants.colorStart = settings.colorStart;
+      constants.colorEnd = settings.colorEnd;
+      constants.size = settings.size;
+      constants.sorted = settings.sort ? 1u : 0u;
+      VkDescriptorSet set = buffers->getDrawSet();
+      vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, mDrawLayout, 1, 1, &set, 0, nullptr);
+      vkCmdPushConstants(cmdBuf, mDrawLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+      vkCmdDrawIndirect(cmdBuf, buffers->getState(), offsetof(ParticleState, draw), 1, sizeof(VkDrawIndirectCommand));
+    }
+  }
+
+  purrParticleStats purrParticleSystem::getStats() const {
+    purrParticleStats stats{};
+    stats.emitters = static_cast<uint32_t>(mEmitters.size());
+    for (purrParticleComp *comp: mEmitters) {
+      stats.alive += comp->getBuffers()->getAlive();
+      stats.capacity += comp->getBuffers()->getCapacity();
+    }
+    stats.emitted = mEmitted;
+    stats.dispatches = mDispatches;
+    return stats;
+  }
+
+  void purrParticleSystem::setContext(PurrfectEngineContext *context) {
+    sContext = context;
+  }
+
+  purrParticleReference::purrParticleReference(purrParticleEmitterSettings settings):
+    mSettings(settings)
+  {}
+
+  void purrParticleReference::update(float dt, glm::vec3 emitterPosition, const glm::mat4 &view) {
+    // Simulate and compact.
+    size_t alive = 0;
+    for (size_t i = 0; i < mParticles.size(); ++i) {
+      purrParticle particle = mParticles[i];
+      if (simulate(mSettings, dt, &particle)) mParticles[alive++] = particle;
+    }
+    mParticles.resize(alive);
+
+    // Emit, what doesn't fit is dropped like on the GPU.
+    uint32_t capacity = std::max(mSettings.maxParticles, 1u);
+    uint32_t count = std::min(mSpawner.step(mSettings.rate, dt), capacity);
+    for (uint32_t i = 0; i < count && mParticles.size() < capacity; ++i) mParticles.push_back(spawn(mSettings, emitterPosition, mSpawner.spawned + i));
+    mSpawner.spawned += count;
+
+    mDrawOrder.resize(mParticles.size());
+    for (uint32_t i = 0; i < mDrawOrder.size(); ++i) mDrawOrder[i] = i;
+    if (!mSettings.sort) return;
+    glm::vec4 viewRow(view[0][2], view[1][2], view[2][2], view[3][2]);
+    std::vector<uint32_t> keys(mParticles.size());
+    for (size_t i = 0; i < mParticles.size(); ++i) keys[i] = sortKey(mParticles[i], viewRow);
+    std::sort(mDrawOrder.begin(), mDrawOrder.end(), [&](uint32_t a, uint32_t b) {
+      return keys[a] != keys[b] ? keys[a] < keys[b] : a < b;
+    });
+  }
+
+  uint32_t purrParticleReference::hash(uint32_t value) {
+    uint32_t state = value * 747796405u + 2891336453u;
+    uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+  }
+
+  purrParticle purrParticleReference::spawn(const purrParticleEmitterSettings &settings, glm::vec3 position, uint32_t spawnIndex) {
+    uint32_t seed = hash(spawnIndex ^ hash(settings.seed));
+    float r[7];
+    for (uint32_t i = 0; i < 7; ++i) r[i] = static_cast<float>(hash(seed + i)) * (1.0f / 4294967296.0f);
+
+    purrParticle particle{};
+    glm::vec3 offset = (glm::vec3(r[0], r[1], r[2]) * 2.0f - 1.0f) * settings.spawnRadius;
+    glm::vec3 velocity = settings.velocity + (glm::vec3(r[3], r[4], r[5]) * 2.0f - 1.0f) * settings.velocitySpread;
+    particle.positionAge = glm::vec4(position + offset, 0.0f);
+    particle.velocityLifetime = glm::vec4(velocity, settings.lifetime.x + (settings.lifetime.y - settings.lifetime.x) * r[6]);
+    return particle;
+  }
+
+  bool purrParticleReference::simulate(const purrParticleEmitterSettings &settings, float dt, purrParticle *particle) {
+    glm::vec3 velocity = glm::vec3(particle->velocityLifetime) + settings.gravity * dt;
+    velocity *= std::max(1.0f - settings.drag * dt, 0.0f);
+    particle->positionAge = glm::vec4(glm::vec3(particle->positionAge) + velocity * dt, particle->positionAge.w + dt);
+    particle->velocityLifetime = glm::vec4(velocity, particle->velocityLifetime.w);
+    return particle->positionAge.w < particle->velocityLifetime.w;
+  }
+
+  uint32_t purrParticleReference::sortKey(const purrParticle &particle, const glm::vec4 &viewRow) {
+    float depth = std::max(-(glm::dot(glm::vec3(viewRow), glm::vec3(particle.positionAge)) + viewRow.w), 0.0f);
+    uint32_t bits = 0;
+    memcpy(&bits, &depth, sizeof(bits));
+    return ~bits;
+  }
+
+}
\ No newline at end of file
@@ -1,23 +1,241 @@
 #include "PurrfectEngine/PurrfectEngine.hpp"
 
 #include <assert.h>
+#include <cmath>
 
 namespace PurrfectEngine {
 
   static PurrfectEngineContext *sContext;
 
+  // Highest count at or below requested that color and depth attachments both support.
+  static VkSampleCountFlagBits getSupportedSamples(VkSampleCountFlagBits requested) {
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(sContext->frRenderer->getPhysicalDevice(), &props);
+    VkSampleCountFlags supported = props.limits.framebufferColorSampleCounts & props.limits.framebufferDepthSampleCounts;
+    uint32_t samples = static_cast<uint32_t>(requested);
+    while (samples > 1 && !(supported & samples)) samples >>= 1;
+    return static_cast<VkSampleCountFlagBits>(std::max(samples, 1u));
+  }
+
   purrPipeline::purrPipeline(purrPipelineCreateInfo createInfo):
-    mRenderer(sContext->frRenderer), mRenderPass(new fr::frRenderPass()), mPipeline(new fr::frPipeline()), mCreateInfo(createInfo)
+    mRenderer(sContext->frRenderer), mCreateInfo(createInfo)
   {
     mColorTexture = createInfo.colorTarget;
-    mDepthTexture = createInfo.depthTarget;
     assert(mColorTexture && "colorTarget MUST always be a valid purrTexture object!");
+    mSamples = pickSamples(static_cast<VkSampleCountFlagBits>(createInfo.msaa));
+
+    acquireTargets(createInfo.width, createInfo.height);
+    createRenderPass();
+    createFramebuffer();
+
+    std::vector<VkDescriptorSetLayout> setLayouts = { sContext->frUboLayout->get(), sContext->frStorageBufLayout->get() };
+    if (createInfo.lighting) {
+      setLayouts.push_back(sContext->frLightsLayout->get());
+      setLayouts.push_back(sContext->frTextureLayout->get());
+      // The lighting shader always declares the draw data set, a layout without it can't be used with it.
+      mCreateInfo.drawDataSize = std::max(mCreateInfo.drawDataSize, static_cast<uint32_t>(PURR_LIGHTING_DRAW_DATA));
+    }
+    assert(mCreateInfo.drawDataSize <= PURR_MAX_DRAW_DATA && "Per-draw data is bound with a PURR_MAX_DRAW_DATA range!");
+    if (mCreateInfo.drawDataSize) {
+      mDrawDataSet = static_cast<uint32_t>(setLayouts.size());
+      setLayouts.push_back(sContext->frDrawDataLayout->get());
+    }
+    mLayout = purrPipelineCache::getDefault()->getPipelineLayout(setLayouts, {
+      VkPushConstantRange{ VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t) }
+    });
+  }
 
-    if (!mDepthTexture) {
-      mDepthTexture = new purrTexture(createInfo.width, createInfo.height, sContext->frDepthFormat);
-      mDepthTexture->initialize(nullptr, false, false);
+  purrPipeline::~purrPipeline() {
+    cleanup();
+  }
+
+  void purrPipeline::resize(int width, int height, purrTexture *colorTarget, purrTexture *depthTarget) {
+    assert(colorTarget && "colorTarget MUST always be a valid purrTexture object!");
+    // The render pass and pipeline variant stay, so the new targets must be compatible with them.
+    assert(colorTarget->mFormat == mColorTexture->mFormat && colorTarget->mSampleCount == mColorTexture->mSampleCount);
+
+    releaseTargets();
+    mCreateInfo.width = width;
+    mCreateInfo.height = height;
+    mCreateInfo.colorTarget = colorTarget;
+    mCreateInfo.depthTarget = depthTarget;
+
+    mColorTexture = colorTarget;
+    acquireTargets(width, height);
+
+    delete mFramebuffer;
+    createFramebuffer();
+  }
+
+  void purrPipeline::setSampleCount(VkSampleCountFlagBits samples) {
+    samples = pickSamples(samples);
+    if (samples == mSamples) return;
+    mSamples = samples;
+    mCreateInfo.msaa = static_cast<MSAA>(samples);
+
+    releaseTargets();
+    acquireTargets(mCreateInfo.width, mCreateInfo.height);
+    delete mFramebuffer;
+    delete mRenderPass;
+    createRenderPass();
+    createFramebuffer();
+
+    // Variants are keyed by sample count, switching back to a count used before doesn't compile anything.
+    mPipeline = VK_NULL_HANDLE;
+    mPrepass = VK_NULL_HANDLE;
+    if (mInitialized) initialize();
+  }
+
+  void purrPipeline::initialize() {
+    purrGraphicsPipelineState state{};
+    for (auto shdr: mCreateInfo.shaders) state.shaders.push_back({ shdr.first, shdr.second });
+    // unordered_map order isn't stable, equal create infos have to hash the same.
+    std::sort(state.shaders.begin(), state.shaders.end());
+
+    VkVertexInputBindingDescription *binding = Vertex3D::getBindingDescription();
+    state.binding = *binding;
+    delete binding;
+    state.attributes = Vertex3D::getAttributeDescriptions();
+
+    state.colorFormats = { mColorTexture->mFormat };
+    state.depthFormat = mDepthTexture->mFormat;
+    state.samples = mSamples;
+    state.layout = mLayout;
+    mInitialized = true;
+
+    if (mCreateInfo.depthPrepass) {
+      purrGraphicsPipelineState prepass = state;
+      prepass.shaders.clear();
+      for (auto &shader: state.shaders) if (shader.first == VK_SHADER_STAGE_VERTEX_BIT) prepass.shaders.push_back(shader);
+      prepass.colorWrite = false;
+      mPrepassKey = purrPipelineCache::getDefault()->requestPipeline(prepass, mCreateInfo.compileMode);
+      mPrepass = purrPipelineCache::getDefault()->getPipeline(mPrepassKey);
+
+      // Depth is complete after the pre-pass, the color draws only have to match it.
+      state.depthWrite = false;
+      state.depthCompare = VK_COMPARE_OP_LESS_OR_EQUAL;
     }
 
+    mKey = purrPipelineCache::getDefault()->requestPipeline(state, mCreateInfo.compileMode);
+    mPipeline = purrPipelineCache::getDefault()->getPipeline(mKey);
+  }
+
+  void purrPipeline::cleanup() {
+    releaseTargets();
+
+    // Pipeline and layout belong to purrPipelineCache.
+    delete mRenderPass;
+    delete mFramebuffer;
+    mRenderPass = nullptr;
+    mFramebuffer = nullptr;
+    mPipeline = VK_NULL_HANDLE;
+    mPrepass = VK_NULL_HANDLE;
+    mLayout = VK_NULL_HANDLE;
+  }
+
+  void purrPipeline::begin(VkClearValue clearColor) {
+    std::vector<VkClearValue> clearValues = {clearColor, {{1.0f, 0}}};
+    purrProfiler::getDefault()->beginGpuZone(sContext->frActiveCmdBuf, mCreateInfo.name);
+    VkExtent2D extent = getRenderExtent();
+    mRenderPass->begin(sContext->frActiveCmdBuf, extent, mFramebuffer, clearValues);
+
+    VkPipeline pipeline = get();
+    VkPipeline prepass = mCreateInfo.depthPrepass ? getPrepass() : VK_NULL_HANDLE;
+    // The color variant doesn't write depth, without its pre-pass it's treated like it's still compiling.
+    if (mCreateInfo.depthPrepass && !prepass) pipeline = VK_NULL_HANDLE;
+    mPrepassActive = pipeline != VK_NULL_HANDLE && prepass != VK_NULL_HANDLE;
+    if (!pipeline && mCreateInfo.compileMode == purrPipelineCompileMode::Fallback && mCreateInfo.fallback) pipeline = mCreateInfo.fallback->get();
+    mBound = pipeline != VK_NULL_HANDLE;
+    if (!mBound) return;
+
+    vkCmdBindPipeline(sContext->frActiveCmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, mPrepassActive ? prepass : pipeline);
+
+    VkViewport viewport = { 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+    VkRect2D scissor = { {0, 0}, extent };
+    vkCmdSetViewport(sContext->frActiveCmdBuf, 0, 1, &viewport);
+    vkCmdSetScissor(sContext->frActiveCmdBuf, 0, 1, &scissor);
+
+    renderer::bindCamera(mLayout);
+    renderer::bindTransforms(mLayout);
+    if (mCreateInfo.lighting) renderer::bindLights(mLayout);
+  }
+
+  void purrPipeline::setRenderScale(float scale) {
+    mRenderScale = std::max(0.0f, std::min(scale, 1.0f));
+  }
+
+  VkExtent2D purrPipeline::getRenderExtent() const {
+    return VkExtent2D{
+      static_cast<uint32_t>(std::max(1, std::min(mCreateInfo.width, static_cast<int>(std::lround(mCreateInfo.width * mRenderScale))))),
+      static_cast<uint32_t>(std::max(1, std::min(mCreateInfo.height, static_cast<int>(std::lround(mCreateInfo.height * mRenderScale)))))
+    };
+  }
+
+  VkPipeline purrPipeline::get() {
+    if (!mPipeline) mPipeline = purrPipelineCache::getDefault()->getPipeline(mKey);
+    return mPipeline;
+  }
+
+  VkPipeline purrPipeline::getPrepass() {
+    if (!mPrepass && mCreateInfo.depthPrepass) mPrepass = purrPipelineCache::getDefault()->getPipeline(mPrepassKey);
+    return mPrepass;
+  }
+
+  void purrPipeline::end() {
+    mRenderPass->end(sContext->frActiveCmdBuf);
+    purrProfiler::getDefault()->endGpuZone(sContext->frActiveCmdBuf);
+  }
+
+  VkSampleCountFlagBits purrPipeline::pickSamples(VkSampleCountFlagBits requested) const {
+    if (requested != VK_SAMPLE_COUNT_1_BIT && mCreateInfo.keepDepth) {
+      // A kept depth is sampled as a single sample texture and there's no depth resolve.
+      fprintf(stderr, "[purrPipeline]: MSAA isn't supported together with keepDepth, rendering without it.\n");
+      return VK_SAMPLE_COUNT_1_BIT;
+    }
+    VkSampleCountFlagBits samples = getSupportedSamples(requested);
+    if (samples != requested) fprintf(stderr, "[purrPipeline]: %u samples aren't supported, using %u.\n", static_cast<uint32_t>(requested), static_cast<uint32_t>(samples));
+    return samples;
+  }
+
+  void purrPipeline::acquireTargets(int width, int height) {
+    mDepthTexture = mCreateInfo.depthTarget ? mCreateInfo.depthTarget : acquireDepth(width, height);
+    assert(mDepthTexture->mSampleCount == mSamples && "depthTarget MUST have the pipeline's sample count!");
+    // Never stored, the samples are resolved into colorTarget at the end of the pass.
+    if (mSamples != VK_SAMPLE_COUNT_1_BIT) {
+      mMultisampleTexture = purrRenderTargetPool::getDefault()->acquire(purrRenderTargetDesc{
+        width, height, mColorTexture->mFormat, mSamples,
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true
+      });
+    }
+  }
+
+  void purrPipeline::releaseTargets() {
+    if (mDepthTexture && mDepthTexture != mCreateInfo.depthTarget) purrRenderTargetPool::getDefault()->release(mDepthTexture);
+    if (mMultisampleTexture) purrRenderTargetPool::getDefault()->release(mMultisampleTexture);
+    mDepthTexture = nullptr;
+    mMultisampleTexture = nullptr;
+  }
+
+  purrTexture *purrPipeline::acquireDepth(int width, int height) {
+    if (mCreateInfo.keepDepth) {
+      // frDepthFormat only has to be renderable, a kept depth gets sampled too.
+      VkFormat format = sContext->frRenderer->FindSupportedFormat({VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D16_UNORM}, VK_IMAGE_TILING_OPTIMAL,
+                                                                  VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+      return purrRenderTargetPool::getDefault()->acquire(purrRenderTargetDesc{
+        width, height, format, VK_SAMPLE_COUNT_1_BIT,
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+      });
+    }
+    return purrRenderTargetPool::getDefault()->acquire(purrRenderTargetDesc{
+      width, height, sContext->frDepthFormat, mSamples,
+      VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, true
+    });
+  }
+
+  void purrPipeline::createRenderPass() {
+    mRenderPass = new fr::frRenderPass();
+    bool multisampled = mSamples != VK_SAMPLE_COUNT_1_BIT;
+
     VkAttachmentReference colorRef = {
       0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
     };
@@ -26,138 +244,85 @@ namespace PurrfectEngine {
       1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
     };
 
-    mRenderPass->addAttachment(VkAttachmentDescription{
-      0, mColorTexture->mFormat, mColorTexture->mSampleCount,
-      VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE,
-      VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE,
-      VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-    });
+    VkAttachmentReference resolveRef = {
+      2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+    };
+
+    if (multisampled) {
+      mRenderPass->addAttachment(VkAttachmentDescription{
+        0, mColorTexture->mFormat, mSamples,
+        VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+      });
+    } else {
+      mRenderPass->addAttachment(VkAttachmentDescription{
+        0, mColorTexture->mFormat, mColorTexture->mSampleCount,
+        VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE,
+        VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+      });
+    }
 
     mRenderPass->addAttachment(VkAttachmentDescription{
       0, mDepthTexture->mFormat, mDepthTexture->mSampleCount,
-      VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE,
+      VK_ATTACHMENT_LOAD_OP_CLEAR, mCreateInfo.keepDepth ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE,
       VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE,
-      VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+      VK_IMAGE_LAYOUT_UNDEFINED, mCreateInfo.keepDepth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
     });
 
+    // Every pixel of the render area is resolved, nothing needs to be loaded.
+    if (multisampled) {
+      mRenderPass->addAttachment(VkAttachmentDescription{
+        0, mColorTexture->mFormat, mColorTexture->mSampleCount,
+        VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_STORE,
+        VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+      });
+    }
+
     VkSubpassDescription subpass{};
     subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
     subpass.colorAttachmentCount = 1;
     subpass.pColorAttachments = &colorRef;
+    subpass.pResolveAttachments = multisampled ? &resolveRef : nullptr;
     subpass.pDepthStencilAttachment = &depthRef;
     mRenderPass->addSubpass(subpass);
 
     VkSubpassDependency dependency{};
     dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
     dependency.dstSubpass = 0;
-    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    dependency.srcAccessMask = 0;
+    // Attachments may alias memory of pooled targets that earlier passes wrote to or sampled from.
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
     dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
     dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    // Last frame's kept depth may still be read by compute work recorded after its pass.
+    if (mCreateInfo.keepDepth) dependency.srcStageMask |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
     mRenderPass->addDependency(dependency);
 
-    mRenderPass->initialize(sContext->frRenderer);
-
-    mFramebuffer = new fr::frFramebuffer();
-    mFramebuffer->initialize(sContext->frRenderer, createInfo.width, createInfo.height, mRenderPass, { mColorTexture->getImage(), mDepthTexture->getImage() });
-
-    mPipeline = new fr::frPipeline();
-
-    for (auto shdr: createInfo.shaders) {
-      fr::frShader *shader = new fr::frShader();
-      shader->initialize(sContext->frRenderer, shdr.second, shdr.first);
-      mPipeline->addShader(shader);
-      mShaders.push_back(shader);
+    if (mCreateInfo.keepDepth) {
+      VkSubpassDependency depthDependency{};
+      depthDependency.srcSubpass = 0;
+      depthDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+      depthDependency.srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+      depthDependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+      depthDependency.dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+      depthDependency.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+      mRenderPass->addDependency(depthDependency);
     }
 
-    mPipeline->setVertexInputState<Vertex3D>();
-
-    mPipeline->setMultisampleInfo(VkPipelineMultisampleStateCreateInfo{
-      VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
-      (VkSampleCountFlagBits)sContext->settings.msaa, VK_FALSE, 0.0f, VK_NULL_HANDLE,
-      VK_FALSE, VK_FALSE
-    });
-
-    mPipeline->setInputAssemblyState(VkPipelineInputAssemblyStateCreateInfo{
-      VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
-      VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_FALSE
-    });
-
-    static VkPipelineColorBlendAttachmentState *sColorBlendAttachment = new VkPipelineColorBlendAttachmentState();
-    sColorBlendAttachment->colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    sColorBlendAttachment->blendEnable = VK_FALSE;
-
-    mPipeline->setColorBlendState(VkPipelineColorBlendStateCreateInfo{
-      VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
-      VK_FALSE,
-      VK_LOGIC_OP_COPY,
-      1,
-      sColorBlendAttachment,
-      {0.0f, 0.0f, 0.0f, 0.0f}
-    });
-
-    mPipeline->setRasterizationState(VkPipelineRasterizationStateCreateInfo{
-      VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
-      VK_FALSE, VK_FALSE, VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE,
-      VK_FALSE, 0.0f, 0.0f, 0.0f, 1.0f
-    });
-
-    mPipeline->setDynamicState(VkPipelineDynamicStateCreateInfo{
-      VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
-      0, VK_NULL_HANDLE
-    });
-
-    VkViewport *viewport = new VkViewport({ 0,0,static_cast<float>(createInfo.width),static_cast<float>(createInfo.height),0.0f,1.0f });
-    VkRect2D *scissor = new VkRect2D({ {}, { static_cast<uint32_t>(createInfo.width), static_cast<uint32_t>(createInfo.height) } });
-    mPipeline->setViewportState(VkPipelineViewportStateCreateInfo{
-      VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
-      1, viewport, 1, scissor
-    });
-
-    mPipeline->setDepthStencilState(VkPipelineDepthStencilStateCreateInfo{
-      VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
-      VK_TRUE, VK_TRUE, VK_COMPARE_OP_LESS,
-      VK_FALSE, VK_FALSE,
-      {}, {},
-      1.0f, 1.0f
-    });
-
-    mPipeline->addDescriptor(sContext->frUboLayout);
-    mPipeline->addDescriptor(sContext->frStorageBufLayout);
-    mPipeline->addPushConstant(VkPushConstantRange{
-      VK_SHADER_STAGE_VERTEX_BIT,
-      0, sizeof(uint32_t)
-    });
-  }
-
-  purrPipeline::~purrPipeline() {
-    cleanup();
-  }
-
-  void purrPipeline::initialize() {
-    mPipeline->initialize(mRenderer, mRenderPass);
-
-    for (auto shader: mShaders) delete shader;
-  }
-
-  void purrPipeline::cleanup() {
-    if (mDepthTexture != mCreateInfo.depthTarget) delete mDepthTexture;
-
-    delete mRenderPass;
-    delete mFramebuffer;
-    delete mPipeline;
-  }
-
-  void purrPipeline::begin(VkClearValue clearColor) {
-    std::vector<VkClearValue> clearValues = {clearColor, {{1.0f, 0}}};
-    mRenderPass->begin(sContext->frActiveCmdBuf, VkExtent2D{static_cast<uint32_t>(mCreateInfo.width), static_cast<uint32_t>(mCreateInfo.height)}, mFramebuffer, clearValues);
-    mPipeline->bind(sContext->frActiveCmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS);
-    renderer::bindCamera(mPipeline);
-    renderer::bindTransforms(mPipeline);
+    mRenderPass->initialize(sContext->frRenderer);
   }
 
-  void purrPipeline::end() {
-    mRenderPass->end(sContext->frActiveCmdBuf);
+  void purrPipeline::createFramebuffer() {
+    mFramebuffer = new fr::frFramebuffer();
+    if (mMultisampleTexture) {
+      mFramebuffer->initialize(sContext->frRenderer, mCreateInfo.width, mCreateInfo.height, mRenderPass,
+                               { mMultisampleTexture->getImage(), mDepthTexture->getImage(), mColorTexture->getImage() });
+    } else {
+      mFramebuffer->initialize(sContext->frRenderer, mCreateInfo.width, mCreateInfo.height, mRenderPass, { mColorTexture->getImage(), mDepthTexture->getImage() });
+    }
   }
 
   void purrPipeline::setContext(PurrfectEngineContext *context) {
@@ -0,0 +1,616 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <inttypes.h>
+
+namespace PurrfectEngine {
+
+  static PurrfectEngineContext *sContext = nullptr;
+
+  static purrPipelineCache *sDefaultCache = nullptr;
+
+  #define PIPELINE_CACHE_MAGIC 0x43505552 // "PURC"
+  #define PIPELINE_CACHE_VERSION 1
+  #define MAX_COMPILE_WORKERS 4
+
+  struct PipelineCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t  uuid[VK_UUID_SIZE];
+    uint64_t dataSize;
+    uint64_t dataHash;
+  };
+
+  static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  static PipelineCacheHeader makeHeader() {
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(sContext->frRenderer->getPhysicalDevice(), &props);
+
+    PipelineCacheHeader header{};
+    header.magic = PIPELINE_CACHE_MAGIC;
+    header.version = PIPELINE_CACHE_VERSION;
+    header.vendorID = props.vendorID;
+    header.deviceID = props.deviceID;
+    header.driverVersion = props.driverVersion;
+    memcpy(header.uuid, props.pipelineCacheUUID, VK_UUID_SIZE);
+    return header;
+  }
+
+  static int64_t getModifiedTime(const std::string &path) {
+    std::error_code error;
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+    return error ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+  }
+
+  uint64_t purrGraphicsPipelineState::hash() const {
+    uint64_t h = Utils::hash64(nullptr, 0);
+    for (auto &shader: shaders) {
+      h = Utils::hash64(&shader.first, sizeof(shader.first), h);
+      h = Utils::hash64(shader.second.data(), shader.second.size() + 1, h);
+    }
+    h = Utils::hash64(&binding, sizeof(binding), h);
+    h = Utils::hash64(attributes.data(), attributes.size() * sizeof(VkVertexInputAttributeDescription), h);
+    h = Utils::hash64(colorFormats.data(), colorFormats.size() * sizeof(VkFormat), h);
+    h = Utils::hash64(&depthFormat, sizeof(depthFormat), h);
+    h = Utils::hash64(&samples, sizeof(samples), h);
+    h = Utils::hash64(&layout, sizeof(layout), h);
+    h = Utils::hash64(&topology, sizeof(topology), h);
+    h = Utils::hash64(&polygonMode, sizeof(polygonMode), h);
+    h = Utils::hash64(&cullMode, sizeof(cullMode), h);
+    h = Utils::hash64(&frontFace, sizeof(frontFace), h);
+    h = Utils::hash64(&depthTest, sizeof(depthTest), h);
+    h = Utils::hash64(&depthWrite, sizeof(depthWrite), h);
+    h = Utils::hash64(&depthCompare, sizeof(depthCompare), h);
+    h = Utils::hash64(&blend, sizeof(blend), h);
+    h = Utils::hash64(&colorWrite, sizeof(colorWrite), h);
+    h = Utils::hash64(&depthBiasConstant, sizeof(depthBiasConstant), h);
+    h = Utils::hash64(&depthBiasSlope, sizeof(depthBiasSlope), h);
+    return h;
+  }
+
+  purrPipelineCache::purrPipelineCache()
+  {}
+
+  purrPipelineCache::~purrPipelineCache() {
+    cleanup();
+  }
+
+  void purrPipelineCache::initialize(const char *path) {
+    mPath = path ? path : "";
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<char> data = load();
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = data.size();
+    createInfo.pInitialData = data.empty() ? nullptr : data.data();
+    if (vkCreatePipelineCache(sContext->frRenderer->getDevice(), &createInfo, nullptr, &mCache) != VK_SUCCESS) {
+      // Driver rejected the data, start cold.
+      createInfo.initialDataSize = 0;
+      createInfo.pInitialData = nullptr;
+      data.clear();
+      if (vkCreatePipelineCache(sContext->frRenderer->getDevice(), &createInfo, nullptr, &mCache) != VK_SUCCESS) {
+        fprintf(stderr, "[purrPipelineCache]: Failed to create pipeline cache!\n");
+        mCache = VK_NULL_HANDLE;
+      }
+    }
+
+    mStats.warm = !data.empty();
+    mStats.loadedBytes = data.size();
+    mStats.loadMs = elapsedMs(start);
+
+    // Leave a core for the main thread, a handful of workers is plenty for pipelines showing up mid-frame.
+    uint32_t workers = std::thread::hardware_concurrency();
+    workers = std::clamp(workers > 1 ? workers - 1 : 1u, 1u, static_cast<uint32_t>(MAX_COMPILE_WORKERS));
+    for (uint32_t i = 0; i < workers; ++i) mWorkers.emplace_back(&purrPipelineCache::workerMain, this);
+  }
+
+  void purrPipelineCache::cleanup() {
+    if (!sContext || !sContext->frRenderer) return;
+    VkDevice device = sContext->frRenderer->getDevice();
+
+    stopWorkers();
+    for (auto &variant: mVariants) {
+      if (variant.second->pipeline) vkDestroyPipeline(device, variant.second->pipeline, nullptr);
+      delete variant.second;
+    }
+    mVariants.clear();
+    for (auto &layout: mLayouts) vkDestroyPipelineLayout(device, layout.second, nullptr);
+    mLayouts.clear();
+    for (auto &renderPass: mRenderPasses) vkDestroyRenderPass(device, renderPass.second, nullptr);
+    mRenderPasses.clear();
+
+    if (mCache) {
+      save();
+      fprintf(stdout, "[purrPipelineCache]: %s start, %u pipelines in %.2f ms, %u shader modules (%u requests) in %.2f ms, cache load %.2f ms, %u variants (%u hits)\n",
+              mStats.warm ? "Warm" : "Cold", mStats.pipelineCount, mStats.pipelineMs,
+              mStats.shaderModuleCount, mStats.shaderRequests, mStats.shaderMs, mStats.loadMs,
+              mStats.variantCount, mStats.variantHits);
+      vkDestroyPipelineCache(device, mCache, nullptr);
+      mCache = VK_NULL_HANDLE;
+    }
+
+    for (auto &module: mShaderModules) vkDestroyShaderModule(device, module.second, nullptr);
+    mShaderModules.clear();
+    mShaderPaths.clear();
+  }
+
+  bool purrPipelineCache::save() {
+    if (!mCache || mPath.empty()) return false;
+    VkDevice device = sContext->frRenderer->getDevice();
+
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device, mCache, &size, nullptr) != VK_SUCCESS || size == 0) return false;
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(device, mCache, &size, data.data()) != VK_SUCCESS) return false;
+    data.resize(size);
+
+    PipelineCacheHeader header = makeHeader();
+    header.dataSize = size;
+    header.dataHash = Utils::hash64(data.data(), data.size());
+
+    // Written to a temporary file first, a crash mid-write must not leave a truncated cache behind.
+    std::string tmpPath = mPath + ".tmp";
+    FILE *fd = fopen(tmpPath.c_str(), "wb");
+    if (!fd) {
+      fprintf(stderr, "[purrPipelineCache]: Failed to open \"%s\" for writing!\n", tmpPath.c_str());
+      return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, fd) == 1 && fwrite(data.data(), data.size(), 1, fd) == 1;
+    fclose(fd);
+    if (!ok) {
+      remove(tmpPath.c_str());
+      return false;
+    }
+    remove(mPath.c_str());
+    return rename(tmpPath.c_str(), mPath.c_str()) == 0;
+  }
+
+  std::vector<char> purrPipelineCache::load() {
+    if (mPath.empty()) return {};
+    FILE *fd = fopen(mPath.c_str(), "rb");
+    if (!fd) return {};
+
+    PipelineCacheHeader header{};
+    std::vector<char> data{};
+    if (fread(&header, sizeof(header), 1, fd) == 1) {
+      PipelineCacheHeader expected = makeHeader();
+      if (header.magic != expected.magic || header.version != expected.version) {
+        fprintf(stderr, "[purrPipelineCache]: \"%s\" is not a pipeline cache, ignoring it.\n", mPath.c_str());
+      } else if (header.vendorID != expected.vendorID || header.deviceID != expected.deviceID ||
+                 header.driverVersion != expected.driverVersion || memcmp(header.uuid, expected.uuid, VK_UUID_SIZE) != 0) {
+        fprintf(stdout, "[purrPipelineCache]: \"%s\" was created by a different device or driver, ignoring it.\n", mPath.c_str());
+      } else {
+        // The size comes from disk, a truncated or corrupted file mustn't get to pick the allocation.
+        long offset = ftell(fd);
+        fseek(fd, 0, SEEK_END);
+        long end = ftell(fd);
+        fseek(fd, offset, SEEK_SET);
+        uint64_t remaining = (offset >= 0 && end > offset) ? static_cast<uint64_t>(end - offset) : 0;
+        if (header.dataSize > remaining) header.dataSize = 0;
+        else data.resize(header.dataSize);
+        if (header.dataSize == 0 || fread(data.data(), data.size(), 1, fd) != 1 || Utils::hash64(data.data(), data.size()) != header.dataHash) {
+          fprintf(stderr, "[purrPipelineCache]: \"%s\" is corrupted, ignoring it.\n", mPath.c_str());
+          data.clear();
+        }
+      }
+    }
+    fclose(fd);
+    return data;
+  }
+
+  VkShaderModule purrPipelineCache::getShaderModule(const char *path) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return getShaderModuleLocked(std::string(path));
+  }
+
+  VkShaderModule purrPipelineCache::getShaderModule(const std::vector<char> &code) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return getShaderModuleLocked(code);
+  }
+
+  VkShaderModule purrPipelineCache::getShaderModuleLocked(const std::string &path, uint64_t *hash) {
+    int64_t modified = getModifiedTime(path);
+    auto it = mShaderPaths.find(path);
+    if (it != mShaderPaths.end() && it->second.modified == modified) {
+      ++mStats.shaderRequests;
+      if (hash) *hash = it->second.hash;
+      return mShaderModules[it->second.hash];
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    FILE *fd = fopen(path.c_str(), "rb");
+    if (!fd) {
+      fprintf(stderr, "[purrPipelineCache]: Failed to open shader \"%s\"!\n", path.c_str());
+      return VK_NULL_HANDLE;
+    }
+    fseek(fd, 0, SEEK_END);
+    long size = ftell(fd);
+    fseek(fd, 0, SEEK_SET);
+    std::vector<char> code(size > 0 ? static_cast<size_t>(size) : 0);
+    if (!code.empty() && fread(code.data(), code.size(), 1, fd) != 1) code.clear();
+    fclose(fd);
+    mStats.shaderMs += elapsedMs(start);
+
+    if (code.empty()) {
+      fprintf(stderr, "[purrPipelineCache]: Failed to read shader \"%s\"!\n", path.c_str());
+      return VK_NULL_HANDLE;
+    }
+
+    // The module of an older version of the file stays alive, pipelines built from it may still be in use.
+    VkShaderModule module = getShaderModuleLocked(code);
+    if (!module) return VK_NULL_HANDLE;
+    ShaderFile file{ Utils::hash64(code.data(), code.size()), modified };
+    mShaderPaths[path] = file;
+    if (hash) *hash = file.hash;
+    return module;
+  }
+
+  VkShaderModule purrPipelineCache::getShaderModuleLocked(const std::vector<char> &code) {
+    ++mStats.shaderRequests;
+    uint64_t hash = Utils::hash64(code.data(), code.size());
+    auto it = mShaderModules.find(hash);
+    if (it != mShaderModules.end()) return it->second;
+
+    auto start = std::chrono::steady_clock::now();
+    // SPIR-V has to be 4 byte aligned, std::vector<char> doesn't guarantee that.
+    std::vector<uint32_t> words((code.size() + 3) / 4, 0);
+    memcpy(words.data(), code.data(), code.size());
+
+    VkShaderModuleCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = code.size();
+    createInfo.pCode = words.data();
+
+    VkShaderModule module = VK_NULL_HANDLE;
+    if (vkCreateShaderModule(sContext->frRenderer->getDevice(), &createInfo, nullptr, &module) != VK_SUCCESS) {
+      fprintf(stderr, "[purrPipelineCache]: Failed to create shader module %016" PRIx64 "!\n", hash);
+      return VK_NULL_HANDLE;
+    }
+    mStats.shaderMs += elapsedMs(start);
+
+    mShaderModules[hash] = module;
+    mStats.shaderModuleCount = static_cast<uint32_t>(mShaderModules.size());
+    return module;
+  }
+
+  VkPipeline purrPipelineCache::createGraphicsPipeline(const VkGraphicsPipelineCreateInfo &createInfo) {
+    auto start = std::chrono::steady_clock::now();
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (vkCreateGraphicsPipelines(sContext->frRenderer->getDevice(), mCache, 1, &createInfo, nullptr, &pipeline) != VK_SUCCESS) {
+      fprintf(stderr, "[purrPipelineCache]: Failed to create graphics pipeline!\n");
+      return VK_NULL_HANDLE;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats.pipelineMs += elapsedMs(start);
+    ++mStats.pipelineCount;
+    return pipeline;
+  }
+
+  VkPipeline purrPipelineCache::createComputePipeline(const std::string &path, VkPipelineLayout layout) {
+    VkShaderModule module = getShaderModule(path.c_str());
+    if (!module) return VK_NULL_HANDLE;
+    VkComputePipelineCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    createInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    createInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    createInfo.stage.module = module;
+    createInfo.stage.pName = "main";
+    createInfo.layout = layout;
+    return createComputePipeline(createInfo);
+  }
+
+  VkPipeline purrPipelineCache::createComputePipeline(const VkComputePipelineCreateInfo &createInfo) {
+    auto start = std::chrono::steady_clock::now();
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (vkCreateComputePipelines(sContext->frRenderer->getDevice(), mCache, 1, &createInfo, nullptr, &pipeline) != VK_SUCCESS) {
+      fprintf(stderr, "[purrPipelineCache]: Failed to create compute pipeline!\n");
+      return VK_NULL_HANDLE;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats.pipelineMs += elapsedMs(start);
+    ++mStats.pipelineCount;
+    return pipeline;
+  }
+
+  VkPipelineLayout purrPipelineCache::getPipelineLayout(const std::vector<VkDescriptorSetLayout> &setLayouts, const std::vector<VkPushConstantRange> &pushConstants) {
+    uint64_t key = Utils::hash64(setLayouts.data(), setLayouts.size() * sizeof(VkDescriptorSetLayout));
+    key = Utils::hash64(pushConstants.data(), pushConstants.size() * sizeof(VkPushConstantRange), key);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mLayouts.find(key);
+    if (it != mLayouts.end()) return it->second;
+
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+    layoutInfo.pSetLayouts = setLayouts.data();
+    layoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstants.size());
+    layoutInfo.pPushConstantRanges = pushConstants.data();
+
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    if (vkCreatePipelineLayout(sContext->frRenderer->getDevice(), &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+      fprintf(stderr, "[purrPipelineCache]: Failed to create pipeline layout!\n");
+      return VK_NULL_HANDLE;
+    }
+    mLayouts[key] = layout;
+    return layout;
+  }
+
+  uint64_t purrPipelineCache::requestPipeline(const purrGraphicsPipelineState &state, purrPipelineCompileMode mode) {
+    uint64_t key = state.hash();
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    // Paths alone would hand out the old variant for a recompiled shader, the SPIR-V is part of the key.
+    std::vector<VkShaderModule> modules{};
+    for (auto &shader: state.shaders) {
+      uint64_t codeHash = 0;
+      modules.push_back(getShaderModuleLocked(shader.second, &codeHash));
+      key = Utils::hash64(&codeHash, sizeof(codeHash), key);
+    }
+
+    auto it = mVariants.find(key);
+    if (it != mVariants.end()) {
+      ++mStats.variantHits;
+      Variant *variant = it->second;
+      if (mode == purrPipelineCompileMode::Block) mIdleCv.wait(lock, [&]() { return !variant->pending; });
+      return key;
+    }
+
+    Variant *variant = new Variant();
+    variant->state = state;
+    variant->modules = modules;
+    variant->pending = true;
+    mVariants[key] = variant;
+    mStats.variantCount = static_cast<uint32_t>(mVariants.size());
+
+    if (mode == purrPipelineCompileMode::Block || mWorkers.empty()) {
+      lock.unlock();
+      VkPipeline pipeline = compile(state, modules);
+      lock.lock();
+      variant->pipeline = pipeline;
+      variant->failed = !pipeline;
+      variant->pending = false;
+      mIdleCv.notify_all();
+    } else {
+      mQueue.push_back(key);
+      ++mStats.pendingCount;
+      mQueueCv.notify_one();
+    }
+    return key;
+  }
+
+  VkPipeline purrPipelineCache::getPipeline(uint64_t key) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mVariants.find(key);
+    return it == mVariants.end() ? VK_NULL_HANDLE : it->second->pipeline;
+  }
+
+  bool purrPipelineCache::isPending(uint64_t key) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mVariants.find(key);
+    return it != mVariants.end() && it->second->pending;
+  }
+
+  void purrPipelineCache::waitIdle() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mIdleCv.wait(lock, [&]() { return mQueue.empty() && mBusyWorkers == 0; });
+  }
+
+  VkRenderPass purrPipelineCache::getRenderPass(const purrGraphicsPipelineState &state) {
+    uint64_t key = Utils::hash64(state.colorFormats.data(), state.colorFormats.size() * sizeof(VkFormat));
+    key = Utils::hash64(&state.depthFormat, sizeof(state.depthFormat), key);
+    key = Utils::hash64(&state.samples, sizeof(state.samples), key);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mRenderPasses.find(key);
+    if (it != mRenderPasses.end()) return it->second;
+
+    // Only formats, sample counts and the subpass layout matter for compatibility, load/store ops and layouts don't.
+    std::vector<VkAttachmentDescription> attachments{};
+    std::vector<VkAttachmentReference> colorRefs{};
+    for (VkFormat format: state.colorFormats) {
+      colorRefs.push_back({ static_cast<uint32_t>(attachments.size()), VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
+      attachments.push_back(VkAttachmentDescription{
+        0, format, state.samples,
+        VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+      });
+    }
+    VkAttachmentReference depthRef = { static_cast<uint32_t>(attachments.size()), VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+    if (state.depthFormat != VK_FORMAT_UNDEFINED) {
+      attachments.push_back(VkAttachmentDescription{
+        0, state.depthFormat, state.samples,
+        VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+      });
+    }
+
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = static_cast<uint32_t>(colorRefs.size());
+    subpass.pColorAttachments = colorRefs.data();
+    subpass.pDepthStencilAttachment = state.depthFormat != VK_FORMAT_UNDEFINED ? &depthRef : nullptr;
+
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    if (vkCreateRenderPass(sContext->frRenderer->getDevice(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+      fprintf(stderr, "[purrPipelineCache]: Failed to create compatible render pass!\n");
+      return VK_NULL_HANDLE;
+    }
+    mRenderPasses[key] = renderPass;
+    return renderPass;
+  }
+
+  VkPipeline purrPipelineCache::compile(const purrGraphicsPipelineState &state, const std::vector<VkShaderModule> &modules) {
+    std::vector<VkPipelineShaderStageCreateInfo> stages{};
+    for (size_t i = 0; i < state.shaders.size(); ++i) {
+      VkPipelineShaderStageCreateInfo stage{};
+      stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+      stage.stage = state.shaders[i].first;
+      stage.module = modules[i];
+      stage.pName = "main";
+      if (!stage.module) return VK_NULL_HANDLE;
+      stages.push_back(stage);
+    }
+
+    VkRenderPass renderPass = getRenderPass(state);
+    if (!renderPass) return VK_NULL_HANDLE;
+
+    VkPipelineVertexInputStateCreateInfo vertexInput{};
+    vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInput.vertexBindingDescriptionCount = state.attributes.empty() ? 0 : 1;
+    vertexInput.pVertexBindingDescriptions = &state.binding;
+    vertexInput.vertexAttributeDescriptionCount = static_cast<uint32_t>(state.attributes.size());
+    vertexInput.pVertexAttributeDescriptions = state.attributes.data();
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {
+      VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
+      state.topology, VK_FALSE
+    };
+
+    // Viewport and scissor are dynamic, one variant serves every target size.
+    VkPipelineViewportStateCreateInfo viewportState = {
+      VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
+      1, VK_NULL_HANDLE, 1, VK_NULL_HANDLE
+    };
+
+    VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicState = {
+      VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
+      2, dynamicStates
+    };
+
+    VkPipelineRasterizationStateCreateInfo rasterization = {
+      VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
+      VK_FALSE, VK_FALSE, state.polygonMode, state.cullMode, state.frontFace,
+      (state.depthBiasConstant != 0.0f || state.depthBiasSlope != 0.0f) ? VK_TRUE : VK_FALSE,
+      state.depthBiasConstant, 0.0f, state.depthBiasSlope, 1.0f
+    };
+
+    VkPipelineMultisampleStateCreateInfo multisample = {
+      VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
+      state.samples, VK_FALSE, 0.0f, VK_NULL_HANDLE,
+      VK_FALSE, VK_FALSE
+    };
+
+    VkPipelineDepthStencilStateCreateInfo depthStencil = {
+      VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
+      state.depthTest, state.depthWrite, state.depthCompare,
+      VK_FALSE, VK_FALSE,
+      {}, {},
+      1.0f, 1.0f
+    };
+
+    VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+    colorBlendAttachment.colorWriteMask = state.colorWrite ? (VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT) : 0;
+    colorBlendAttachment.blendEnable = state.blend;
+    colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments(state.colorFormats.size(), colorBlendAttachment);
+
+    VkPipelineColorBlendStateCreateInfo colorBlend = {
+      VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO, VK_NULL_HANDLE, 0,
+      VK_FALSE,
+      VK_LOGIC_OP_COPY,
+      static_cast<uint32_t>(colorBlendAttachments.size()),
+      colorBlendAttachments.data(),
+      {0.0f, 0.0f, 0.0f, 0.0f}
+    };
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = static_cast<uint32_t>(stages.size());
+    pipelineInfo.pStages = stages.data();
+    pipelineInfo.pVertexInputState = &vertexInput;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterization;
+    pipelineInfo.pMultisampleState = &multisample;
+    pipelineInfo.pDepthStencilState = &depthStencil;
+    pipelineInfo.pColorBlendState = &colorBlend;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = state.layout;
+    pipelineInfo.renderPass = renderPass;
+    pipelineInfo.subpass = 0;
+    return createGraphicsPipeline(pipelineInfo);
+  }
+
+  void purrPipelineCache::workerMain() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    for (;;) {
+      mQueueCv.wait(lock, [&]() { return mStopping || !mQueue.empty(); });
+      if (mStopping) return;
+
+      uint64_t key = mQueue.front();
+      mQueue.pop_front();
+      Variant *variant = mVariants[key];
+      purrGraphicsPipelineState state = variant->state;
+      std::vector<VkShaderModule> modules = variant->modules;
+      ++mBusyWorkers;
+
+      lock.unlock();
+      VkPipeline pipeline = compile(state, modules);
+      lock.lock();
+
+      variant->pipeline = pipeline;
+      variant->failed = !pipeline;
+      variant->pending = false;
+      --mStats.pendingCount;
+      --mBusyWorkers;
+      mIdleCv.notify_all();
+    }
+  }
+
+  void purrPipelineCache::stopWorkers() {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStopping = true;
+      // Whatever hasn't started yet is dropped, those variants stay empty.
+      for (uint64_t key: mQueue) mVariants[key]->pending = false;
+      mStats.pendingCount -= static_cast<uint32_t>(mQueue.size());
+      mQueue.clear();
+    }
+    mQueueCv.notify_all();
+    for (std::thread &worker: mWorkers) worker.join();
+    mWorkers.clear();
+    mStopping = false;
+    mIdleCv.notify_all();
+  }
+
+  void purrPipelineCache::setContext(PurrfectEngineContext *context) {
+    sContext = context;
+  }
+
+  purrPipelineCache *purrPipelineCache::getDefault() {
+    if (!sDefaultCache) sDefaultCache = new purrPipelineCache();
+    return sDefaultCache;
+  }
+
+  void purrPipelineCache::cleanupAll() {
+    if (sDefaultCache) delete sDefaultCache;
+    sDefaultCache = nullptr;
+  }
+
+}
\ No newline at end of file
@@ -0,0 +1,363 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+#include <cmath>
+
+namespace PurrfectEngine {
+
+  static PurrfectEngineContext *sContext = nullptr;
+
+  #define POST_HISTOGRAM_BINS 256
+  #define POST_GROUP_SIZE 16
+  // Average scene luminance that maps to an exposure of 1, middle gray.
+  #define POST_EXPOSURE_KEY 0.18f
+
+  // Same layouts as shaders/postDownsample.comp, postUpsample.comp and postExposure.comp.
+  struct SampleConstants {
+    glm::uvec2 dstSize;
+    glm::vec2 srcScale;   // Part of the source level that holds this frame's data, in uv.
+    glm::vec2 srcTexel;
+    float srcLod;
+    uint32_t flags;       // 1: histogram, 2: write bloom, 4: threshold.
+    glm::vec4 threshold;  // Threshold, threshold - knee, 2 * knee, 0.25 / knee.
+    glm::vec2 logLuminance; // Min and 1 / range.
+  };
+
+  struct ExposureConstants {
+    float minLogLuminance;
+    float logLuminanceRange;
+    float adaptation;
+    uint32_t pixelCount;
+  };
+
+  struct ExposureData {
+    uint32_t histogram[POST_HISTOGRAM_BINS];
+    float averageLuminance;
+  };
+
+  // Source image, destination image and exposure buffer of one dispatch.
+  struct SampleDescriptors {
+    VkDescriptorImageInfo source;
+    VkDescriptorImageInfo destination;
+    VkDescriptorBufferInfo exposure;
+  };
+
+  struct CompositeDescriptors {
+    VkDescriptorImageInfo bloom;
+    VkDescriptorBufferInfo exposure;
+  };
+
+  purrPostProcess::purrPostProcess(purrPostProcessSettings settings):
+    mSettings(settings)
+  {}
+
+  purrPostProcess::~purrPostProcess() {
+    cleanup();
+  }
+
+  void purrPostProcess::initialize() {
+    mLayout = new fr::frDescriptorLayout();
+    mLayout->addBinding(VkDescriptorSetLayoutBinding{ 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE });
+    mLayout->addBinding(VkDescriptorSetLayoutBinding{ 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE });
+    mLayout->addBinding(VkDescriptorSetLayoutBinding{ 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE });
+    mLayout->initialize(sContext->frRenderer);
+
+    mCompositeLayout = new fr::frDescriptorLayout();
+    mCompositeLayout->addBinding(VkDescriptorSetLayoutBinding{ 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, VK_NULL_HANDLE });
+    mCompositeLayout->addBinding(VkDescriptorSetLayoutBinding{ 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, VK_NULL_HANDLE });
+    mCompositeLayout->initialize(sContext->frRenderer);
+
+    mTemplate.initialize(mLayout->get(), {
+      { 0, 0, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, offsetof(SampleDescriptors, source), sizeof(VkDescriptorImageInfo) },
+      { 1, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, offsetof(SampleDescriptors, destination), sizeof(VkDescriptorImageInfo) },
+      { 2, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, offsetof(SampleDescriptors, exposure), sizeof(VkDescriptorBufferInfo) },
+    });
+    mCompositeTemplate.initialize(mCompositeLayout->get(), {
+      { 0, 0, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, offsetof(CompositeDescriptors, bloom), sizeof(VkDescriptorImageInfo) },
+      { 1, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, offsetof(CompositeDescriptors, exposure), sizeof(VkDescriptorBufferInfo) },
+    });
+    mDescriptors = new purrDescriptorAllocator();
+
+    VkDescriptorSetLayout setLayout = mLayout->get();
+    VkPushConstantRange pushConstant = { VK_SHADER_STAGE_COMPUTE_BIT, 0, static_cast<uint32_t>(std::max(sizeof(SampleConstants), sizeof(ExposureConstants))) };
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &setLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstant;
+    if (vkCreatePipelineLayout(sContext->frRenderer->getDevice(), &layoutInfo, nullptr, &mPipelineLayout) != VK_SUCCESS) {
+      fprintf(stderr, "[purrPostProcess]: Failed to create pipeline layout!\n");
+      mPipelineLayout = VK_NULL_HANDLE;
+      return;
+    }
+    std::string shaderPath = sContext->settings.shaderPath;
+    purrPipelineCache *cache = purrPipelineCache::getDefault();
+    mDownsamplePipeline = cache->createComputePipeline(shaderPath + "postDownsample.comp.spv", mPipelineLayout);
+    mExposurePipeline = cache->createComputePipeline(shaderPath + "postExposure.comp.spv", mPipelineLayout);
+    mUpsamplePipeline = cache->createComputePipeline(shaderPath + "postUpsample.comp.spv", mPipelineLayout);
+    if (!mDownsamplePipeline || !mExposurePipeline || !mUpsamplePipeline)
+      fprintf(stderr, "[purrPostProcess]: Missing compute shaders, post-processing is disabled.\n");
+
+    // Bilinear taps inside a level, levels are picked with an explicit lod.
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = 16.0f;
+    if (vkCreateSampler(sContext->frRenderer->getDevice(), &samplerInfo, nullptr, &mSampler) != VK_SUCCESS) {
+      fprintf(stderr, "[purrPostProcess]: Failed to create sampler!\n");
+      mSampler = VK_NULL_HANDLE;
+    }
+
+    // Written by the GPU only, except for the starting luminance. Host visible so getStats() can read it.
+    mExposure = new purrBuffer();
+    if (!mExposure->initialize(sizeof(ExposureData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, purrMemoryCategory::Frame)) {
+      delete mExposure;
+      mExposure = nullptr;
+      return;
+    }
+    ExposureData data{};
+    data.averageLuminance = POST_EXPOSURE_KEY;
+    mExposure->copyData(0, sizeof(data), &data);
+  }
+
+  void purrPostProcess::cleanup() {
+    if (!sContext || !sContext->frRenderer) return;
+    destroyBloom();
+    VkDevice device = sContext->frRenderer->getDevice();
+    if (mDownsamplePipeline) vkDestroyPipeline(device, mDownsamplePipeline, nullptr);
+    if (mExposurePipeline) vkDestroyPipeline(device, mExposurePipeline, nullptr);
+    if (mUpsamplePipeline) vkDestroyPipeline(device, mUpsamplePipeline, nullptr);
+    if (mPipelineLayout) vkDestroyPipelineLayout(device, mPipelineLayout, nullptr);
+    if (mSampler) vkDestroySampler(device, mSampler, nullptr);
+    mDownsamplePipeline = mExposurePipeline = mUpsamplePipeline = VK_NULL_HANDLE;
+    mPipelineLayout = VK_NULL_HANDLE;
+    mSampler = VK_NULL_HANDLE;
+    mTemplate.cleanup();
+    mCompositeTemplate.cleanup();
+    delete mDescriptors;
+    delete mExposure;
+    delete mLayout;
+    delete mCompositeLayout;
+    mDescriptors = nullptr;
+    mExposure = nullptr;
+    mLayout = nullptr;
+    mCompositeLayout = nullptr;
+  }
+
+  void purrPostProcess::build(purrTexture *scene, VkExtent2D renderExtent) {
+    if (!scene || !mDownsamplePipeline || !mExposurePipeline || !mUpsamplePipeline || !mSampler || !mExposure) return;
+    if (scene->getImage()->getView() != mSourceView) createBloom(scene);
+    if (!mBloom) return;
+
+    uint64_t now = purrClock::getDefault()->now();
+    float dt = mLastBuild ? static_cast<float>(now - mLastBuild) * 1e-9f : 0.0f;
+    mLastBuild = now;
+
+    VkCommandBuffer cmdBuf = sContext->frActiveCmdBuf;
+    purrProfiler::getDefault()->beginGpuZone(cmdBuf, "Post-process");
+
+    uint32_t levels = static_cast<uint32_t>(mMipViews.size());
+    { // The scene pass just wrote the source, last frame's composite may still read the chain and the luminance.
+      VkMemoryBarrier barrier{};
+      barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+      barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+      barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+      VkImageMemoryBarrier imageBarrier{};
+      imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+      imageBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      imageBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+      imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+      imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      imageBarrier.image = mBloom;
+      imageBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levels, 0, 1 };
+      vkCmdPipelineBarrier(cmdBuf,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, mBloomFresh ? 1 : 0, &imageBarrier);
+      mBloomFresh = false;
+    }
+
+    // Only the rendered part of the scene (dynamic resolution) is downsampled, every level keeps that fraction.
+    std::vector<VkExtent2D> used(levels), sizes(levels);
+    for (uint32_t i = 0; i < levels; ++i) {
+      sizes[i] = { std::max(1u, mBloomSize.width >> i), std::max(1u, mBloomSize.height >> i) };
+      VkExtent2D above = i ? used[i-1] : renderExtent;
+      used[i] = { std::min(sizes[i].width, std::max(1u, (above.width + 1) / 2)), std::min(sizes[i].height, std::max(1u, (above.height + 1) / 2)) };
+    }
+    mBloomScale = glm::vec2(static_cast<float>(used[0].width) / sizes[0].width, static_cast<float>(used[0].height) / sizes[0].height);
+
+    float logRange = std::max(mSettings.maxLogLuminance - mSettings.minLogLuminance, 1e-3f);
+    float knee = std::max(mSettings.bloomThreshold * mSettings.bloomKnee, 1e-5f);
+    SampleConstants constants{};
+    constants.threshold = glm::vec4(mSettings.bloomThreshold, mSettings.bloomThreshold - knee, 2.0f * knee, 0.25f / knee);
+    constants.logLuminance = glm::vec2(mSettings.minLogLuminance, 1.0f / logRange);
+
+    auto dispatch = [&](VkDescriptorSet set, uint32_t dstLevel, VkExtent2D srcUsed, VkExtent2D srcSize, uint32_t srcLod) {
+      constants.dstSize = glm::uvec2(used[dstLevel].width, used[dstLevel].height);
+      constants.srcScale = glm::vec2(static_cast<float>(srcUsed.width) / srcSize.width, static_cast<float>(srcUsed.height) / srcSize.height);
+      constants.srcTexel = glm::vec2(1.0f / srcSize.width, 1.0f / srcSize.height);
+      constants.srcLod = static_cast<float>(srcLod);
+      vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, mPipelineLayout, 0, 1, &set, 0, nullptr);
+      vkCmdPushConstants(cmdBuf, mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+      vkCmdDispatch(cmdBuf, (constants.dstSize.x + POST_GROUP_SIZE - 1) / POST_GROUP_SIZE, (constants.dstSize.y + POST_GROUP_SIZE - 1) / POST_GROUP_SIZE, 1);
+      Utils::computeBarrier(cmdBuf);
+    };
+
+    // Histogram and bloom threshold share the one full resolution read of the scene.
+    if (mSettings.autoExposure || mSettings.bloom) {
+      vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, mDownsamplePipeline);
+      constants.flags = (mSettings.autoExposure ? 1u : 0u) | (mSettings.bloom ? 6u : 0u);
+      dispatch(mSets[0], 0, renderExtent, mSourceSize, 0);
+    }
+
+    if (mSettings.autoExposure) {
+      vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, mExposurePipeline);
+      ExposureConstants exposure{};
+      exposure.minLogLuminance = mSettings.minLogLuminance;
+      exposure.logLuminanceRange = logRange;
+      exposure.adaptation = 1.0f - std::exp(-dt * std::max(mSettings.adaptationSpeed, 0.0f));
+      exposure.pixelCount = used[0].width * used[0].height;
+      vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, mPipelineLayout, 0, 1, &mSets[0], 0, nullptr);
+      vkCmdPushConstants(cmdBuf, mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(exposure), &exposure);
+      vkCmdDispatch(cmdBuf, 1, 1, 1);
+      Utils::computeBarrier(cmdBuf);
+    }
+
+    if (mSettings.bloom) {
+      constants.flags = 2u;
+      for (uint32_t i = 1; i < levels; ++i) dispatch(mSets[1 + i], i, used[i-1], sizes[i-1], i - 1);
+
+      // Each level adds the blurred level below it to itself, back up to the first one the composite samples.
+      vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, mUpsamplePipeline);
+      for (uint32_t i = levels - 1; i-- > 0;) dispatch(mSets[1 + i], i, used[i+1], sizes[i+1], i + 1);
+    }
+
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    purrProfiler::getDefault()->endGpuZone(cmdBuf);
+  }
+
+  VkDescriptorSetLayout purrPostProcess::getCompositeLayout() const {
+    return mCompositeLayout ? mCompositeLayout->get() : VK_NULL_HANDLE;
+  }
+
+  void purrPostProcess::setSettings(purrPostProcessSettings settings) {
+    // A different chain length needs new images, build() recreates them when the source doesn't match.
+    if (settings.bloomLevels != mSettings.bloomLevels) mSourceView = VK_NULL_HANDLE;
+    mSettings = settings;
+  }
+
+  purrPostProcessStats purrPostProcess::getStats() const {
+    purrPostProcessStats stats{};
+    if (mExposure) stats.averageLuminance = static_cast<const ExposureData*>(mExposure->getMapped())->averageLuminance;
+    stats.exposure = std::exp2(mSettings.exposureCompensation) *
+      (mSettings.autoExposure ? POST_EXPOSURE_KEY / std::max(stats.averageLuminance, 1e-4f) : mSettings.exposure);
+    stats.bloomLevels = static_cast<uint32_t>(mMipViews.size());
+    return stats;
+  }
+
+  void purrPostProcess::createBloom(purrTexture *scene) {
+    // Only on the first build and when the scene target was replaced (resize), earlier frames may use the old chain.
+    sContext->frRenderer->waitIdle();
+    destroyBloom();
+    VkDevice device = sContext->frRenderer->getDevice();
+
+    mSourceSize = { static_cast<uint32_t>(scene->getWidth()), static_cast<uint32_t>(scene->getHeight()) };
+    mBloomSize = { std::max(1u, (mSourceSize.width + 1) / 2), std::max(1u, (mSourceSize.height + 1) / 2) };
+    uint32_t maxLevels = static_cast<uint32_t>(std::floor(std::log2(static_cast<float>(std::max(mBloomSize.width, mBloomSize.height))))) + 1;
+    uint32_t levels = std::max(1u, std::min(mSettings.bloomLevels, maxLevels));
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = VK_FORMAT_R16G16B16A16_SFLOAT;
+    imageInfo.extent = { mBloomSize.width, mBloomSize.height, 1 };
+    imageInfo.mipLevels = levels;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    purrAllocationInfo allocInfo{};
+    allocInfo.category = purrMemoryCategory::Target;
+    allocInfo.image = true;
+    if (!purrGpuAllocator::getDefault()->createImage(imageInfo, allocInfo, &mBloom, &mBloomAllocation)) {
+      fprintf(stderr, "[purrPostProcess]: Failed to create bloom chain!\n");
+      mBloom = VK_NULL_HANDLE;
+      return;
+    }
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = mBloom;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = imageInfo.format;
+    viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levels, 0, 1 };
+    vkCreateImageView(device, &viewInfo, nullptr, &mBloomView);
+    mMipViews.resize(levels, VK_NULL_HANDLE);
+    for (uint32_t i = 0; i < levels; ++i) {
+      viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, i, 1, 0, 1 };
+      vkCreateImageView(device, &viewInfo, nullptr, &mMipViews[i]);
+    }
+
+    VkDescriptorBufferInfo exposureInfo = { mExposure->get(), 0, sizeof(ExposureData) };
+    mSets.resize(levels + 1, VK_NULL_HANDLE);
+    for (uint32_t i = 0; i <= levels; ++i) {
+      mSets[i] = mDescriptors->allocate(mLayout->get());
+      if (!mSets[i]) {
+        destroyBloom();
+        return;
+      }
+      SampleDescriptors descriptors{};
+      descriptors.source = i == 0
+        ? VkDescriptorImageInfo{ mSampler, scene->getImage()->getView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }
+        : VkDescriptorImageInfo{ mSampler, mBloomView, VK_IMAGE_LAYOUT_GENERAL };
+      descriptors.destination = { VK_NULL_HANDLE, mMipViews[i ? i - 1 : 0], VK_IMAGE_LAYOUT_GENERAL };
+      descriptors.exposure = exposureInfo;
+      mTemplate.update(mSets[i], &descriptors);
+    }
+
+    mCompositeSet = mDescriptors->allocate(mCompositeLayout->get());
+    if (!mCompositeSet) {
+      destroyBloom();
+      return;
+    }
+    CompositeDescriptors composite{ { mSampler, mBloomView, VK_IMAGE_LAYOUT_GENERAL }, exposureInfo };
+    mCompositeTemplate.update(mCompositeSet, &composite);
+
+    mSourceView = scene->getImage()->getView();
+    mBloomFresh = true;
+  }
+
+  void purrPostProcess::destroyBloom() {
+    VkDevice device = sContext->frRenderer->getDevice();
+    if (mDescriptors) {
+      for (VkDescriptorSet set: mSets) mDescriptors->free(set);
+      mDescriptors->free(mCompositeSet);
+    }
+    mSets.clear();
+    mCompositeSet = VK_NULL_HANDLE;
+    for (VkImageView view: mMipViews) if (view) vkDestroyImageView(device, view, nullptr);
+    mMipViews.clear();
+    if (mBloomView) vkDestroyImageView(device, mBloomView, nullptr);
+    mBloomView = VK_NULL_HANDLE;
+    purrGpuAllocator::getDefault()->destroyImage(mBloom, mBloomAllocation);
+    mBloom = VK_NULL_HANDLE;
+    mSourceView = VK_NULL_HANDLE;
+  }
+
+  void purrPostProcess::setContext(PurrfectEngineContext *context) {
+    sContext = context;
+  }
+
+}
\ No newline at end of file
@@ -0,0 +1,241 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+#include <chrono>
+#include <atomic>
+#include <inttypes.h>
+
+namespace PurrfectEngine {
+
+  static PurrfectEngineContext *sContext = nullptr;
+
+  static purrProfiler *sDefaultProfiler = nullptr;
+
+  // Events past this are dropped, a capture shouldn't grow without bound when left enabled.
+  #define MAX_PROFILE_EVENTS (1 << 20)
+
+  struct CpuZone {
+    const char *name;
+    uint64_t startNs;
+  };
+
+  static thread_local std::vector<CpuZone> sCpuZones{};
+  static thread_local uint32_t sThreadIndex = UINT32_MAX;
+  static std::atomic<uint32_t> sThreadCount{0};
+
+  static uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+  }
+
+  static uint32_t threadIndex() {
+    if (sThreadIndex == UINT32_MAX) sThreadIndex = sThreadCount++;
+    return sThreadIndex;
+  }
+
+  purrProfiler::purrProfiler()
+  {}
+
+  purrProfiler::~purrProfiler() {
+    cleanup();
+  }
+
+  void purrProfiler::initialize(uint32_t framesInFlight, uint32_t maxGpuZones) {
+    mFrames.resize(framesInFlight);
+    mQueriesPerFrame = maxGpuZones * 2;
+
+    VkPhysicalDevice physicalDevice = sContext->frRenderer->getPhysicalDevice();
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &props);
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+
+    uint32_t validBits = 0;
+    uint32_t graphicsFamily = sContext->frRenderer->getGraphicsFamily();
+    if (graphicsFamily < familyCount) validBits = families[graphicsFamily].timestampValidBits;
+    if (validBits == 0 || props.limits.timestampPeriod == 0.0f) {
+      fprintf(stderr, "[purrProfiler]: Graphics queue doesn't support timestamps, only CPU zones are recorded.\n");
+      return;
+    }
+    mTimestampPeriod = props.limits.timestampPeriod;
+    mTimestampMask = validBits >= 64 ? ~0ULL : ((1ULL << validBits) - 1);
+
+    VkQueryPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = mQueriesPerFrame * framesInFlight;
+    if (vkCreateQueryPool(sContext->frRenderer->getDevice(), &poolInfo, nullptr, &mQueryPool) != VK_SUCCESS) {
+      fprintf(stderr, "[purrProfiler]: Failed to create timestamp query pool!\n");
+      mQueryPool = VK_NULL_HANDLE;
+    }
+  }
+
+  void purrProfiler::cleanup() {
+    if (mQueryPool) vkDestroyQueryPool(sContext->frRenderer->getDevice(), mQueryPool, nullptr);
+    mQueryPool = VK_NULL_HANDLE;
+    mFrames.clear();
+  }
+
+  void purrProfiler::beginFrame(VkCommandBuffer cmdBuf, uint32_t frameIndex) {
+    mNewGpuFrameMs = false;
+    if (frameIndex >= mFrames.size()) return;
+    mFrameIndex = frameIndex;
+    FrameQueries &frame = mFrames[frameIndex];
+    // The renderer waited on this slot's fence already.
+    if (frame.pending) resolve(frame, frameIndex);
+
+    frame.zones.clear();
+    frame.open.clear();
+    frame.used = 0;
+    mInFrame = mQueryPool != VK_NULL_HANDLE;
+    if (!mInFrame) return;
+    vkCmdResetQueryPool(cmdBuf, mQueryPool, frameIndex * mQueriesPerFrame, mQueriesPerFrame);
+    // The frame zone is always recorded (two timestamps), getGpuFrameMs() is used outside of captures too.
+    writeZoneBegin(cmdBuf, "Frame");
+  }
+
+  void purrProfiler::endFrame(VkCommandBuffer cmdBuf) {
+    if (!mInFrame) return;
+    FrameQueries &frame = mFrames[mFrameIndex];
+    // Unbalanced zones are dropped when resolving, the frame zone is always the first one.
+    frame.open.resize(std::min<size_t>(frame.open.size(), 1));
+    writeZoneEnd(cmdBuf);
+    frame.submitNs = nowNs();
+    frame.pending = !frame.zones.empty();
+    mInFrame = false;
+  }
+
+  void purrProfiler::beginGpuZone(VkCommandBuffer cmdBuf, const char *name) {
+    if (!mInFrame || !mEnabled) return;
+    writeZoneBegin(cmdBuf, name);
+  }
+
+  void purrProfiler::endGpuZone(VkCommandBuffer cmdBuf) {
+    // The frame zone is closed by endFrame only.
+    if (!mInFrame || mFrames[mFrameIndex].open.size() <= 1) return;
+    writeZoneEnd(cmdBuf);
+  }
+
+  void purrProfiler::writeZoneBegin(VkCommandBuffer cmdBuf, const char *name) {
+    FrameQueries &frame = mFrames[mFrameIndex];
+    if (frame.used + 2 > mQueriesPerFrame) return;
+
+    uint32_t query = mFrameIndex * mQueriesPerFrame + frame.used;
+    frame.used += 2;
+    vkCmdWriteTimestamp(cmdBuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, mQueryPool, query);
+    frame.open.push_back(static_cast<uint32_t>(frame.zones.size()));
+    frame.zones.push_back(GpuZone{ name, query, UINT32_MAX });
+  }
+
+  void purrProfiler::writeZoneEnd(VkCommandBuffer cmdBuf) {
+    FrameQueries &frame = mFrames[mFrameIndex];
+    if (frame.open.empty()) return;
+
+    GpuZone &zone = frame.zones[frame.open.back()];
+    frame.open.pop_back();
+    zone.endQuery = zone.startQuery + 1;
+    vkCmdWriteTimestamp(cmdBuf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, mQueryPool, zone.endQuery);
+  }
+
+  void purrProfiler::beginCpuZone(const char *name) {
+    if (!mEnabled) return;
+    sCpuZones.push_back(CpuZone{ name, nowNs() });
+  }
+
+  void purrProfiler::endCpuZone() {
+    if (sCpuZones.empty()) return;
+    CpuZone zone = sCpuZones.back();
+    sCpuZones.pop_back();
+    addEvent(purrProfileEvent{ zone.name, zone.startNs, nowNs(), threadIndex(), false });
+  }
+
+  bool purrProfiler::exportChromeTrace(const char *path) {
+    // Frames still in flight are picked up too, if the GPU finished them (e.g. after renderer::waitIdle).
+    for (uint32_t i = 0; i < mFrames.size(); ++i) if (mFrames[i].pending && !(mInFrame && i == mFrameIndex)) resolve(mFrames[i], i);
+
+    FILE *fd = fopen(path, "wb");
+    if (!fd) {
+      fprintf(stderr, "[purrProfiler]: Failed to open \"%s\" for writing!\n", path);
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    uint64_t base = UINT64_MAX;
+    for (const purrProfileEvent &event: mEvents) base = std::min(base, event.startNs);
+
+    fprintf(fd, "{\"traceEvents\":[\n");
+    fprintf(fd, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPU\"}},\n");
+    fprintf(fd, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GPU\"}}");
+    for (const purrProfileEvent &event: mEvents) {
+      // Chrome trace timestamps are in microseconds.
+      fprintf(fd, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u}",
+              event.name, event.gpu ? "gpu" : "cpu",
+              (event.startNs - base) / 1000.0, (event.endNs - event.startNs) / 1000.0,
+              event.gpu ? 1 : 0, event.thread);
+    }
+    fprintf(fd, "\n]}\n");
+    fclose(fd);
+    return true;
+  }
+
+  void purrProfiler::clear() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEvents.clear();
+  }
+
+  void purrProfiler::resolve(FrameQueries &frame, uint32_t frameIndex) {
+    frame.pending = false;
+    if (!mQueryPool || frame.used == 0) return;
+
+    std::vector<uint64_t> results(frame.used * 2, 0);
+    // No WAIT_BIT, the frame is complete. Unavailable queries (e.g. a frame that was never submitted) are skipped.
+    vkGetQueryPoolResults(sContext->frRenderer->getDevice(), mQueryPool, frameIndex * mQueriesPerFrame, frame.used,
+                          results.size() * sizeof(uint64_t), results.data(), sizeof(uint64_t) * 2,
+                          VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+    // GPU clock domain is unrelated to steady_clock, the first timestamp of the frame is pinned to its submission.
+    uint64_t first = UINT64_MAX;
+    for (const GpuZone &zone: frame.zones) {
+      uint32_t i = zone.startQuery - frameIndex * mQueriesPerFrame;
+      if (results[i*2+1]) first = std::min(first, results[i*2] & mTimestampMask);
+    }
+    if (first == UINT64_MAX) return;
+
+    for (size_t i = 0; i < frame.zones.size(); ++i) {
+      const GpuZone &zone = frame.zones[i];
+      if (zone.endQuery == UINT32_MAX) continue;
+      uint32_t s = zone.startQuery - frameIndex * mQueriesPerFrame;
+      uint32_t e = zone.endQuery - frameIndex * mQueriesPerFrame;
+      if (!results[s*2+1] || !results[e*2+1]) continue;
+      uint64_t start = static_cast<uint64_t>(((results[s*2] & mTimestampMask) - first) * mTimestampPeriod);
+      uint64_t end = static_cast<uint64_t>(((results[e*2] & mTimestampMask) - first) * mTimestampPeriod);
+      if (i == 0) {
+        mGpuFrameMs = (end - start) / 1e6;
+        mNewGpuFrameMs = true;
+      }
+      if (mEnabled) addEvent(purrProfileEvent{ zone.name, frame.submitNs + start, frame.submitNs + end, 0, true });
+    }
+  }
+
+  void purrProfiler::addEvent(purrProfileEvent event) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mEvents.size() >= MAX_PROFILE_EVENTS) return;
+    mEvents.push_back(event);
+  }
+
+  void purrProfiler::setContext(PurrfectEngineContext *context) {
+    sContext = context;
+  }
+
+  purrProfiler *purrProfiler::getDefault() {
+    if (!sDefaultProfiler) sDefaultProfiler = new purrProfiler();
+    return sDefaultProfiler;
+  }
+
+  void purrProfiler::cleanupAll() {
+    if (sDefaultProfiler) delete sDefaultProfiler;
+    sDefaultProfiler = nullptr;
+  }
+
+}
\ No newline at end of file
@@ -0,0 +1,380 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+#include <assert.h>
+#include <queue>
+
+namespace PurrfectEngine {
+
+  struct AccessInfo {
+    VkPipelineStageFlags stage;
+    VkAccessFlags access;
+    VkImageLayout layout;
+  };
+
+  static const VkAccessFlags sWriteAccessMask =
+    VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+  static AccessInfo getAccessInfo(purrResourceAccess access) {
+    switch (access) {
+    case purrResourceAccess::ColorAttachment:   return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+    case purrResourceAccess::DepthAttachment:   return { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+    case purrResourceAccess::DepthRead:         return { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL };
+    case purrResourceAccess::SampledFragment:   return { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    case purrResourceAccess::SampledCompute:    return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    case purrResourceAccess::StorageImageRead:  return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL };
+    case purrResourceAccess::StorageImageWrite: return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL };
+    case purrResourceAccess::TransferSrc:       return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL };
+    case purrResourceAccess::TransferDst:       return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL };
+    case purrResourceAccess::UniformRead:       return { VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_UNIFORM_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED };
+    case purrResourceAccess::StorageRead:       return { VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED };
+    case purrResourceAccess::StorageWrite:      return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED };
+    case purrResourceAccess::VertexRead:        return { VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED };
+    case purrResourceAccess::IndexRead:         return { VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED };
+    case purrResourceAccess::IndirectRead:      return { VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED };
+    }
+    return { VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL };
+  }
+
+  void purrRenderGraph::Builder::read(Handle resource, purrResourceAccess access) {
+    assert(resource < mGraph->mResources.size());
+    mGraph->mPasses[mPass].accesses.push_back(Access{ resource, access, VK_IMAGE_LAYOUT_UNDEFINED, false });
+  }
+
+  void purrRenderGraph::Builder::write(Handle resource, purrResourceAccess access, VkImageLayout finalLayout) {
+    assert(resource < mGraph->mResources.size());
+    mGraph->mPasses[mPass].accesses.push_back(Access{ resource, access, finalLayout, true });
+  }
+
+  void purrRenderGraph::Builder::sideEffect() {
+    mGraph->mPasses[mPass].sideEffect = true;
+  }
+
+  purrRenderGraph::purrRenderGraph()
+  {}
+
+  purrRenderGraph::~purrRenderGraph() {
+    reset();
+  }
+
+  purrRenderGraph::Handle purrRenderGraph::importTexture(const char *name, purrTexture *texture, VkImageLayout initialLayout) {
+    assert(texture);
+    Resource resource{};
+    resource.name = name;
+    resource.texture = texture;
+    resource.image = texture->getImage()->get();
+    resource.aspect = Utils::formatToAspect(texture->getFormat());
+    resource.initialLayout = initialLayout;
+    return addResource(resource);
+  }
+
+  purrRenderGraph::Handle purrRenderGraph::importImage(const char *name, VkImage image, VkFormat format, VkImageLayout initialLayout) {
+    Resource resource{};
+    resource.name = name;
+    resource.image = image;
+    resource.aspect = Utils::formatToAspect(format);
+    resource.initialLayout = initialLayout;
+    return addResource(resource);
+  }
+
+  purrRenderGraph::Handle purrRenderGraph::importBuffer(const char *name, VkBuffer buffer, VkDeviceSize size) {
+    Resource resource{};
+    resource.name = name;
+    resource.buffer = true;
+    resource.vkBuffer = buffer;
+    resource.size = size;
+    return addResource(resource);
+  }
+
+  purrRenderGraph::Handle purrRenderGraph::createTexture(const char *name, purrRenderTargetDesc desc, purrSampler *sampler) {
+    Resource resource{};
+    resource.name = name;
+    resource.transient = true;
+    resource.desc = desc;
+    resource.sampler = sampler;
+    resource.aspect = Utils::formatToAspect(desc.format);
+    return addResource(resource);
+  }
+
+  void purrRenderGraph::addPass(const char *name, SetupFn setup, ExecuteFn execute) {
+    mCompiled = false;
+    Pass pass{};
+    pass.name = name;
+    pass.execute = execute;
+    mPasses.push_back(pass);
+
+    Builder builder(this, static_cast<uint32_t>(mPasses.size()-1));
+    if (setup) setup(builder);
+  }
+
+  void purrRenderGraph::setOutput(Handle resource) {
+    assert(resource < mResources.size());
+    mCompiled = false;
+    mResources[resource].output = true;
+  }
+
+  void purrRenderGraph::compile() {
+    const uint32_t passCount = static_cast<uint32_t>(mPasses.size());
+
+    { // Dependencies, passes are declared in submission order.
+      purrFrameVector<int32_t> lastWriter(mResources.size(), -1, renderer::getFrameArena());
+      std::vector<std::vector<uint32_t>> readers(mResources.size());
+      for (uint32_t i = 0; i < passCount; ++i) {
+        Pass &pass = mPasses[i];
+        pass.dependencies.clear();
+        pass.after.clear();
+        pass.culled = false;
+
+        auto addEdge = [](std::vector<uint32_t> &edges, uint32_t pass) {
+          if (std::find(edges.begin(), edges.end(), pass) == edges.end()) edges.push_back(pass);
+        };
+
+        for (const Access &access: pass.accesses) {
+          int32_t writer = lastWriter[access.resource];
+          if (writer >= 0 && static_cast<uint32_t>(writer) != i) {
+            addEdge(pass.dependencies, writer);
+            addEdge(pass.after, writer);
+          }
+
+          if (access.write) {
+            for (uint32_t reader: readers[access.resource]) if (reader != i) addEdge(pass.after, reader);
+            readers[access.resource].clear();
+          } else readers[access.resource].push_back(i);
+        }
+
+        for (const Access &access: pass.accesses) if (access.write) lastWriter[access.resource] = i;
+      }
+    }
+
+    { // Culling, walk back from outputs and passes with side effects.
+      std::vector<bool> required(passCount, false);
+      purrFrameVector<uint32_t> stack(renderer::getFrameArena());
+      for (uint32_t i = 0; i < passCount; ++i) {
+        bool needed = mPasses[i].sideEffect;
+        for (const Access &access: mPasses[i].accesses) if (access.write && mResources[access.resource].output) needed = true;
+        if (needed) {
+          required[i] = true;
+          stack.push_back(i);
+        }
+      }
+
+      while (!stack.empty()) {
+        uint32_t pass = stack.back();
+        stack.pop_back();
+        for (uint32_t dependency: mPasses[pass].dependencies) {
+          if (required[dependency]) continue;
+          required[dependency] = true;
+          stack.push_back(dependency);
+        }
+      }
+
+      mCulledCount = 0;
+      for (uint32_t i = 0; i < passCount; ++i) {
+        mPasses[i].culled = !required[i];
+        if (mPasses[i].culled) ++mCulledCount;
+      }
+    }
+
+    { // Topological order, ties are broken by declaration order.
+      purrFrameVector<uint32_t> indegree(passCount, 0, renderer::getFrameArena());
+      std::vector<std::vector<uint32_t>> dependents(passCount);
+      for (uint32_t i = 0; i < passCount; ++i) {
+        if (mPasses[i].culled) continue;
+        for (uint32_t before: mPasses[i].after) {
+          if (mPasses[before].culled) continue;
+          dependents[before].push_back(i);
+          ++indegree[i];
+        }
+      }
+
+      std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> ready{};
+      for (uint32_t i = 0; i < passCount; ++i) if (!mPasses[i].culled && indegree[i] == 0) ready.push(i);
+
+      mOrder.clear();
+      while (!ready.empty()) {
+        uint32_t pass = ready.top();
+        ready.pop();
+        mOrder.push_back(pass);
+        for (uint32_t dependent: dependents[pass]) if (--indegree[dependent] == 0) ready.push(dependent);
+      }
+      assert(mOrder.size() == passCount - mCulledCount && "Render graph has a cycle!");
+    }
+
+    // Lifetimes
+    for (Resource &resource: mResources) resource.firstPass = resource.lastPass = -1;
+    for (uint32_t i = 0; i < mOrder.size(); ++i) {
+      for (const Access &access: mPasses[mOrder[i]].accesses) {
+        Resource &resource = mResources[access.resource];
+        if (resource.firstPass < 0) resource.firstPass = static_cast<int32_t>(i);
+        resource.lastPass = static_cast<int32_t>(i);
+      }
+    }
+
+    mCompiled = true;
+  }
+
+  void purrRenderGraph::execute(VkCommandBuffer cmdBuf) {
+    if (!mCompiled) compile();
+
+    for (Resource &resource: mResources) {
+      resource.layout = resource.initialLayout;
+      resource.writeStages = resource.readStages = 0;
+      resource.writeAccess = resource.readAccess = 0;
+    }
+
+    mBarrierCount = 0;
+    purrRenderTargetPool *pool = purrRenderTargetPool::getDefault();
+    for (uint32_t i = 0; i < mOrder.size(); ++i) {
+      const Pass &pass = mPasses[mOrder[i]];
+
+      for (Resource &resource: mResources) {
+        if (!resource.transient || resource.firstPass != static_cast<int32_t>(i)) continue;
+        resource.texture = pool->acquire(resource.desc, resource.sampler);
+        resource.image = resource.texture->getImage()->get();
+        resource.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        // The memory may belong to a target that was released earlier, wait for whoever used it.
+        pool->getAliasHazard(resource.texture, &resource.writeStages, &resource.writeAccess);
+      }
+
+      recordBarriers(cmdBuf, pass);
+      if (pass.execute) pass.execute(cmdBuf);
+
+      for (const Access &access: pass.accesses) {
+        if (access.write && access.finalLayout != VK_IMAGE_LAYOUT_UNDEFINED) mResources[access.resource].layout = access.finalLayout;
+      }
+
+      for (Resource &resource: mResources) {
+        if (!resource.transient || resource.lastPass != static_cast<int32_t>(i)) continue;
+        pool->release(resource.texture, resource.writeStages | resource.readStages, resource.writeAccess);
+        resource.texture = nullptr;
+        resource.image = VK_NULL_HANDLE;
+      }
+    }
+  }
+
+  void purrRenderGraph::reset() {
+    purrRenderTargetPool *pool = purrRenderTargetPool::getDefault();
+    for (Resource &resource: mResources) if (resource.transient && resource.texture) pool->release(resource.texture);
+    mResources.clear();
+    mPasses.clear();
+    mOrder.clear();
+    mCompiled = false;
+    mCulledCount = 0;
+  }
+
+  purrTexture *purrRenderGraph::getTexture(Handle resource) const {
+    assert(resource < mResources.size() && !mResources[resource].buffer);
+    return mResources[resource].texture;
+  }
+
+  VkBuffer purrRenderGraph::getBuffer(Handle resource) const {
+    assert(resource < mResources.size() && mResources[resource].buffer);
+    return mResources[resource].vkBuffer;
+  }
+
+  purrRenderGraph::Handle purrRenderGraph::addResource(Resource resource) {
+    mCompiled = false;
+    mResources.push_back(resource);
+    return static_cast<Handle>(mResources.size()-1);
+  }
+
+  void purrRenderGraph::recordBarriers(VkCommandBuffer cmdBuf, const Pass &pass) {
+    VkPipelineStageFlags srcStages = 0, dstStages = 0;
+    purrFrameVector<VkImageMemoryBarrier> imageBarriers(renderer::getFrameArena());
+    purrFrameVector<VkBufferMemoryBarrier> bufferBarriers(renderer::getFrameArena());
+
+    // A pass that reads and writes the same resource gets one barrier for it, an image can only be in one layout.
+    // Accesses that disagree on the layout meet in GENERAL.
+    struct MergedAccess {
+      Handle resource;
+      AccessInfo info;
+      bool write;
+    };
+    std::vector<MergedAccess> accesses{};
+    accesses.reserve(pass.accesses.size());
+    for (const Access &access: pass.accesses) {
+      AccessInfo info = getAccessInfo(access.access);
+      auto it = std::find_if(accesses.begin(), accesses.end(), [&](const MergedAccess &merged) { return merged.resource == access.resource; });
+      if (it == accesses.end()) {
+        accesses.push_back(MergedAccess{ access.resource, info, access.write });
+        continue;
+      }
+      it->info.stage |= info.stage;
+      it->info.access |= info.access;
+      if (it->info.layout != info.layout) it->info.layout = VK_IMAGE_LAYOUT_GENERAL;
+      it->write |= access.write;
+    }
+
+    for (const MergedAccess &access: accesses) {
+      Resource &resource = mResources[access.resource];
+      const AccessInfo &info = access.info;
+      VkImageLayout layout = resource.buffer ? VK_IMAGE_LAYOUT_UNDEFINED : info.layout;
+      bool transition = !resource.buffer && resource.layout != layout;
+
+      VkPipelineStageFlags srcStage = resource.writeStages;
+      VkAccessFlags srcAccess = resource.writeAccess;
+      bool needed = transition;
+      if (access.write) {
+        // Write-after-write and write-after-read
+        srcStage |= resource.readStages;
+        needed |= srcStage != 0;
+      } else {
+        // Read-after-write, unless an earlier barrier already made the writes visible to this stage.
+        bool visible = (resource.readStages & info.stage) == info.stage && (resource.readAccess & info.access) == info.access;
+        if (transition) srcStage |= resource.readStages;
+        needed |= resource.writeStages != 0 && !visible;
+      }
+
+      if (needed) {
+        srcStages |= srcStage ? srcStage : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+        dstStages |= info.stage;
+
+        if (resource.buffer) {
+          VkBufferMemoryBarrier barrier{};
+          barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+          barrier.srcAccessMask = srcAccess;
+          barrier.dstAccessMask = info.access;
+          barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+          barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+          barrier.buffer = resource.vkBuffer;
+          barrier.offset = 0;
+          barrier.size = resource.size;
+          bufferBarriers.push_back(barrier);
+        } else {
+          VkImageMemoryBarrier barrier{};
+          barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+          barrier.srcAccessMask = srcAccess;
+          barrier.dstAccessMask = info.access;
+          barrier.oldLayout = resource.layout;
+          barrier.newLayout = layout;
+          barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+          barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+          barrier.image = resource.image;
+          barrier.subresourceRange = { resource.aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+          imageBarriers.push_back(barrier);
+        }
+      }
+
+      if (access.write) {
+        resource.writeStages = info.stage;
+        resource.writeAccess = info.access & sWriteAccessMask;
+        resource.readStages = 0;
+        resource.readAccess = 0;
+      } else {
+        if (transition) resource.readStages = resource.readAccess = 0;
+        resource.readStages |= info.stage;
+        resource.readAccess |= info.access;
+      }
+      if (!resource.buffer) resource.layout = layout;
+    }
+
+    if (imageBarriers.empty() && bufferBarriers.empty()) return;
+    // One barrier call per pass, the driver gets all transitions at once.
+    vkCmdPipelineBarrier(cmdBuf, srcStages, dstStages, 0,
+                         0, nullptr,
+                         static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+                         static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+    mBarrierCount += static_cast<uint32_t>(imageBarriers.size() + bufferBarriers.size());
+  }
+
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+namespace PurrfectEngine {
+
+  purrRenderThread::purrRenderThread()
+  {}
+
+  purrRenderThread::~purrRenderThread() {
+    stop();
+  }
+
+  void purrRenderThread::start(FrameCallback frame) {
+    stop();
+    mFrame = frame;
+    mStopping = false;
+    mRunning = true;
+    mThread = std::thread(&purrRenderThread::threadMain, this);
+  }
+
+  void purrRenderThread::stop() {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStopping = true;
+    }
+    mCv.notify_all();
+    if (mThread.joinable()) mThread.join();
+    mRunning = false;
+  }
+
+  void purrRenderThread::submit(purrScene *scene, bool wait) {
+    // The expensive part runs while the render thread is still busy with the previous frame.
+    renderer::extractSnapshot(scene, &mMailbox.getWriteSlot());
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (wait) mCv.wait(lock, [this]() { return !mRunning || !mMailbox.hasNew(); });
+    if (mMailbox.publish()) ++mStats.dropped;
+    ++mStats.submitted;
+    lock.unlock();
+    mCv.notify_all();
+  }
+
+  void purrRenderThread::flush() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCv.wait(lock, [this]() { return !mRunning || mStats.rendered + mStats.dropped == mStats.submitted; });
+  }
+
+  purrRenderThreadStats purrRenderThread::getStats() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+  }
+
+  void purrRenderThread::threadMain() {
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCv.wait(lock, [this]() { return mStopping || mMailbox.hasNew(); });
+        if (mStopping) break;
+        // Under the lock, so a submit() waiting for the slot to free up can't miss it.
+        mMailbox.acquire();
+      }
+      mCv.notify_all();
+
+      const purrRenderSnapshot &snapshot = mMailbox.getReadSlot();
+      renderer::setSnapshot(&snapshot);
+      bool keepRunning = mFrame(snapshot);
+      renderer::setSnapshot(nullptr);
+
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        ++mStats.rendered;
+      }
+      mCv.notify_all();
+      if (!keepRunning) break;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mRunning = false;
+    }
+    mCv.notify_all();
+  }
+
+}
\ No newline at end of file
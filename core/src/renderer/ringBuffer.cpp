@@ -0,0 +1,98 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+#include <algorithm>
+
+namespace PurrfectEngine {
+
+  static PurrfectEngineContext *sContext = nullptr;
+
+  purrRingBuffer::purrRingBuffer()
+  {}
+
+  purrRingBuffer::~purrRingBuffer() {
+    cleanup();
+  }
+
+  bool purrRingBuffer::initialize(VkDeviceSize capacity, VkBufferUsageFlags usage, VkDeviceSize bindRange) {
+    cleanup();
+    mUsage = usage;
+    mBindRange = bindRange;
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(sContext->frRenderer->getPhysicalDevice(), &props);
+    mAlignment = 1;
+    if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) mAlignment = std::max(mAlignment, props.limits.minUniformBufferOffsetAlignment);
+    if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) mAlignment = std::max(mAlignment, props.limits.minStorageBufferOffsetAlignment);
+    return addBlock(std::max<VkDeviceSize>(capacity, mAlignment));
+  }
+
+  void purrRingBuffer::cleanup() {
+    for (Block &block: mBlocks) delete block.buffer;
+    mBlocks.clear();
+    mAllocations = 0;
+  }
+
+  void purrRingBuffer::reset() {
+    mAllocations = 0;
+    if (mBlocks.size() > 1) {
+      // Overflowed, one buffer that holds everything the last use needed.
+      VkDeviceSize capacity = 0;
+      for (Block &block: mBlocks) capacity += block.capacity;
+      cleanup();
+      addBlock(capacity);
+      return;
+    }
+    for (Block &block: mBlocks) block.head = 0;
+  }
+
+  purrRingAllocation purrRingBuffer::allocate(VkDeviceSize size) {
+    purrRingAllocation allocation{};
+    if (mBlocks.empty()) return allocation;
+
+    Block *block = &mBlocks.back();
+    VkDeviceSize offset = (block->head + mAlignment - 1) / mAlignment * mAlignment;
+    if (offset + size > block->capacity) {
+      if (!addBlock(std::max(block->capacity * 2, size))) return allocation;
+      block = &mBlocks.back();
+      offset = 0;
+    }
+
+    block->head = offset + size;
+    ++mAllocations;
+    allocation.data = static_cast<uint8_t*>(block->buffer->getMapped()) + offset;
+    allocation.buffer = block->buffer->get();
+    allocation.offset = static_cast<uint32_t>(offset);
+    allocation.block = static_cast<uint32_t>(mBlocks.size()) - 1;
+    return allocation;
+  }
+
+  purrRingBufferStats purrRingBuffer::getStats() const {
+    purrRingBufferStats stats{};
+    for (const Block &block: mBlocks) {
+      stats.used += block.head;
+      stats.capacity += block.capacity;
+    }
+    stats.allocations = mAllocations;
+    stats.blocks = static_cast<uint32_t>(mBlocks.size());
+    return stats;
+  }
+
+  bool purrRingBuffer::addBlock(VkDeviceSize capacity) {
+    Block block{};
+    block.capacity = capacity;
+    block.buffer = new purrBuffer();
+    if (!block.buffer->initialize(capacity + mBindRange, mUsage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, purrMemoryCategory::Frame) ||
+        !block.buffer->getMapped()) {
+      fprintf(stderr, "[purrRingBuffer]: Failed to create a %llu byte ring buffer!\n", static_cast<unsigned long long>(capacity));
+      delete block.buffer;
+      return false;
+    }
+    mBlocks.push_back(block);
+    return true;
+  }
+
+  void purrRingBuffer::setContext(PurrfectEngineContext *context) {
+    sContext = context;
+  }
+
+}
\ No newline at end of file
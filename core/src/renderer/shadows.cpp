@@ -0,0 +1,381 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+#include <cmath>
+
+namespace PurrfectEngine {
+
+  static PurrfectEngineContext *sContext = nullptr;
+
+  // Same layout as shaders/shadow.vert, the transforms SSBO is set 1 like in the scene pipelines.
+  struct ShadowConstants {
+    uint32_t objectIndex;
+    uint32_t padding[3];
+    glm::mat4 viewProjection;
+  };
+
+  purrCascadedShadows::purrCascadedShadows(purrShadowSettings settings):
+    mSettings(settings)
+  {
+    mSettings.cascadeCount = std::max(1u, std::min(mSettings.cascadeCount, static_cast<uint32_t>(PURR_MAX_SHADOW_CASCADES)));
+    mSettings.resolution = std::max(mSettings.resolution, 16u);
+    // A square-ish grid of tiles keeps the atlas within maxImageDimension2D for large cascades.
+    mColumns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(mSettings.cascadeCount))));
+    mRows = (mSettings.cascadeCount + mColumns - 1) / mColumns;
+    mCascades.resize(mSettings.cascadeCount);
+    mBounds.resize(mSettings.cascadeCount, CascadeBounds{ glm::vec3(0.0f), glm::vec3(0.0f), 0.0f, 0.0f, false });
+  }
+
+  purrCascadedShadows::~purrCascadedShadows() {
+    cleanup();
+  }
+
+  void purrCascadedShadows::initialize() {
+    mFormat = sContext->frRenderer->FindSupportedFormat({VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM}, VK_IMAGE_TILING_OPTIMAL,
+                                                        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+    glm::uvec2 size = getAtlasSize();
+    mLightViewValid = false;
+
+    // Both atlases are held for the lifetime of the shadows, nothing else may alias them.
+    mStaticMap = purrRenderTargetPool::getDefault()->acquire(purrRenderTargetDesc{
+      static_cast<int>(size.x), static_cast<int>(size.y), mFormat, VK_SAMPLE_COUNT_1_BIT,
+      VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+    });
+    mShadowMap = purrRenderTargetPool::getDefault()->acquire(purrRenderTargetDesc{
+      static_cast<int>(size.x), static_cast<int>(size.y), mFormat, VK_SAMPLE_COUNT_1_BIT,
+      VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+    }, purrSampler::getDefault());
+
+    VkAttachmentReference depthRef = { 0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.pDepthStencilAttachment = &depthRef;
+
+    { // Static casters, only the dirty cascades are cleared (inside the pass) and redrawn, the rest is loaded.
+      mStaticPass = new fr::frRenderPass();
+      mStaticPass->addAttachment(VkAttachmentDescription{
+        0, mFormat, VK_SAMPLE_COUNT_1_BIT,
+        VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_STORE,
+        VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+      });
+      mStaticPass->addSubpass(subpass);
+
+      VkSubpassDependency dependency{};
+      dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+      dependency.dstSubpass = 0;
+      dependency.srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT; // Last frame's copy.
+      dependency.srcAccessMask = 0;
+      dependency.dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+      dependency.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+      mStaticPass->addDependency(dependency);
+
+      VkSubpassDependency copyDependency{};
+      copyDependency.srcSubpass = 0;
+      copyDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+      copyDependency.srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+      copyDependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+      copyDependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+      copyDependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+      mStaticPass->addDependency(copyDependency);
+      mStaticPass->initialize(sContext->frRenderer);
+      mStaticPass->setName(sContext->frRenderer, "Static Shadows RP");
+    }
+
+    { // Dynamic casters on top of the copied static depth, ends ready for sampling.
+      mDynamicPass = new fr::frRenderPass();
+      mDynamicPass->addAttachment(VkAttachmentDescription{
+        0, mFormat, VK_SAMPLE_COUNT_1_BIT,
+        VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_STORE,
+        VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+      });
+      mDynamicPass->addSubpass(subpass);
+
+      VkSubpassDependency dependency{};
+      dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+      dependency.dstSubpass = 0;
+      dependency.srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+      dependency.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      dependency.dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+      dependency.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+      mDynamicPass->addDependency(dependency);
+
+      VkSubpassDependency sampleDependency{};
+      sampleDependency.srcSubpass = 0;
+      sampleDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+      sampleDependency.srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+      sampleDependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+      sampleDependency.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+      sampleDependency.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+      mDynamicPass->addDependency(sampleDependency);
+      mDynamicPass->initialize(sContext->frRenderer);
+      mDynamicPass->setName(sContext->frRenderer, "Dynamic Shadows RP");
+    }
+
+    mStaticFramebuffer = new fr::frFramebuffer();
+    mStaticFramebuffer->initialize(sContext->frRenderer, size.x, size.y, mStaticPass, { mStaticMap->getImage() });
+    mDynamicFramebuffer = new fr::frFramebuffer();
+    mDynamicFramebuffer->initialize(sContext->frRenderer, size.x, size.y, mDynamicPass, { mShadowMap->getImage() });
+
+    mLayout = purrPipelineCache::getDefault()->getPipelineLayout({ sContext->frUboLayout->get(), sContext->frStorageBufLayout->get() }, {
+      VkPushConstantRange{ VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ShadowConstants) }
+    });
+
+    purrGraphicsPipelineState state{};
+    state.shaders = { { VK_SHADER_STAGE_VERTEX_BIT, std::string(sContext->settings.shaderPath) + "shadow.vert.spv" } };
+    VkVertexInputBindingDescription *binding = Vertex3D::getBindingDescription();
+    state.binding = *binding;
+    delete binding;
+    state.attributes = Vertex3D::getAttributeDescriptions();
+    state.depthFormat = mFormat;
+    state.layout = mLayout;
+    // Casters are drawn from both sides, thin geometry and open meshes still cast.
+    state.cullMode = VK_CULL_MODE_NONE;
+    state.depthBiasConstant = mSettings.depthBiasConstant;
+    state.depthBiasSlope = mSettings.depthBiasSlope;
+    mPipelineKey = purrPipelineCache::getDefault()->requestPipeline(state, purrPipelineCompileMode::Block);
+
+    mStaticInitialized = false;
+  }
+
+  void purrCascadedShadows::cleanup() {
+    if (mStaticMap) purrRenderTargetPool::getDefault()->release(mStaticMap);
+    if (mShadowMap) purrRenderTargetPool::getDefault()->release(mShadowMap);
+    mStaticMap = nullptr;
+    mShadowMap = nullptr;
+    // Pipeline and layout belong to purrPipelineCache.
+    delete mStaticFramebuffer;
+    delete mDynamicFramebuffer;
+    delete mStaticPass;
+    delete mDynamicPass;
+    mStaticFramebuffer = nullptr;
+    mDynamicFramebuffer = nullptr;
+    mStaticPass = nullptr;
+    mDynamicPass = nullptr;
+    mLayout = VK_NULL_HANDLE;
+  }
+
+  void purrCascadedShadows::update(const purrRenderCamera &camera, glm::vec3 lightDirection) {
+    PURR_PROFILE_SCOPE("updateShadows");
+    lightDirection = glm::normalize(lightDirection);
+    if (!mLightViewValid || glm::dot(lightDirection, mLightDirection) < 0.99999f) {
+      // Every cascade's light space changes, so does everything in them.
+      mLightDirection = lightDirection;
+      glm::vec3 up = std::abs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+      mLightView = glm::lookAt(glm::vec3(0.0f), lightDirection, up);
+      mLightViewValid = true;
+      for (CascadeBounds &bounds: mBounds) bounds.valid = false;
+    }
+
+    gatherCasters();
+    uint64_t staticHash = Utils::hash64(nullptr, 0);
+    for (const Caster &caster: mCasters) {
+      if (!caster.isStatic) continue;
+      staticHash = Utils::hash64(&caster.mesh, sizeof(caster.mesh), staticHash);
+      staticHash = Utils::hash64(&caster.center, sizeof(caster.center), staticHash);
+      staticHash = Utils::hash64(&caster.radius, sizeof(caster.radius), staticHash);
+    }
+    if (staticHash != mStaticHash) invalidateStatic();
+    mStaticHash = staticHash;
+
+    const purrCamera::Settings &settings = camera.settings;
+    glm::mat4 inverseView = glm::inverse(camera.view);
+    float nearPlane = std::max(settings.nearPlane, 1e-4f);
+    float farPlane = std::max(std::min(settings.farPlane, mSettings.maxDistance), nearPlane * 1.001f);
+    float tanY = std::tan(glm::radians(settings.fov) * 0.5f);
+    float tanX = tanY * settings.aspectRatio;
+    float resolution = static_cast<float>(mSettings.resolution);
+
+    float splitNear = nearPlane;
+    for (uint32_t i = 0; i < mSettings.cascadeCount; ++i) {
+      float p = static_cast<float>(i + 1) / mSettings.cascadeCount;
+      float logSplit = nearPlane * std::pow(farPlane / nearPlane, p);
+      float uniformSplit = nearPlane + (farPlane - nearPlane) * p;
+      float splitFar = mSettings.splitLambda * logSplit + (1.0f - mSettings.splitLambda) * uniformSplit;
+
+      // The sphere around the frustum slice doesn't change with the camera's rotation, a box fitted
+      // to the slice would, and with it the texel size. Quantized so float noise can't resize it.
+      float centerDepth = (splitNear + splitFar) * 0.5f;
+      float radius = 0.0f;
+      for (float depth: { splitNear, splitFar }) {
+        glm::vec2 corner = glm::vec2(tanX, tanY) * depth;
+        radius = std::max(radius, std::sqrt(corner.x * corner.x + corner.y * corner.y + (depth - centerDepth) * (depth - centerDepth)));
+      }
+      radius = std::ceil(radius * 16.0f) / 16.0f;
+      glm::vec3 center = glm::vec3(inverseView * glm::vec4(0.0f, 0.0f, -centerDepth, 1.0f));
+
+      purrShadowCascade &cascade = mCascades[i];
+      CascadeBounds &bounds = mBounds[i];
+      float coverage = radius * (1.0f + mSettings.padding);
+      if (!bounds.valid || coverage != cascade.radius || glm::length(center - bounds.anchor) > radius * mSettings.padding) {
+        float texelSize = 2.0f * coverage / resolution;
+        glm::vec3 lightCenter = glm::vec3(mLightView * glm::vec4(center, 1.0f));
+        lightCenter.x = std::floor(lightCenter.x / texelSize) * texelSize;
+        lightCenter.y = std::floor(lightCenter.y / texelSize) * texelSize;
+
+        // Light view space looks down -z, casters between the light and the cascade have a larger z.
+        bounds.anchor = center;
+        bounds.lightCenter = lightCenter;
+        bounds.zMin = lightCenter.z - coverage;
+        bounds.zMax = lightCenter.z + coverage + mSettings.casterDistance;
+        bounds.valid = true;
+
+        // Orthographic, depth goes from 0 at zMax to 1 at zMin.
+        float depthRange = bounds.zMax - bounds.zMin;
+        glm::mat4 projection(1.0f);
+        projection[0][0] = 1.0f / coverage;
+        projection[1][1] = 1.0f / coverage;
+        projection[2][2] = -1.0f / depthRange;
+        projection[3][0] = -lightCenter.x / coverage;
+        projection[3][1] = -lightCenter.y / coverage;
+        projection[3][2] = bounds.zMax / depthRange;
+
+        cascade.viewProjection = projection * mLightView;
+        cascade.texelSize = texelSize;
+        cascade.radius = coverage;
+        cascade.staticDirty = true;
+      }
+      cascade.splitDepth = splitFar;
+      splitNear = splitFar;
+    }
+  }
+
+  void purrCascadedShadows::invalidateStatic() {
+    for (purrShadowCascade &cascade: mCascades) cascade.staticDirty = true;
+  }
+
+  void purrCascadedShadows::render() {
+    VkCommandBuffer cmdBuf = sContext->frActiveCmdBuf;
+    VkPipeline pipeline = purrPipelineCache::getDefault()->getPipeline(mPipelineKey);
+    mStats = purrShadowStats{};
+    if (!pipeline || !mShadowMap || !mStaticMap) return;
+
+    purrProfiler::getDefault()->beginGpuZone(cmdBuf, "Shadows");
+    glm::uvec2 size = getAtlasSize();
+    VkExtent2D extent = { size.x, size.y };
+
+    if (!mStaticInitialized) {
+      // The static pass expects TRANSFER_SRC, every cascade is dirty so the undefined contents are all cleared.
+      VkImageMemoryBarrier barrier{};
+      barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+      barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+      barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.image = mStaticMap->getImage()->get();
+      barrier.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+      vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+      invalidateStatic();
+      mStaticInitialized = true;
+    }
+
+    bool staticDirty = false;
+    for (const purrShadowCascade &cascade: mCascades) staticDirty |= cascade.staticDirty;
+    if (staticDirty) {
+      mStaticPass->begin(cmdBuf, extent, mStaticFramebuffer, { VkClearValue{} });
+      vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+      renderer::bindTransforms(mLayout);
+      for (uint32_t i = 0; i < mCascades.size(); ++i) {
+        if (!mCascades[i].staticDirty) continue;
+        VkClearAttachment clear{};
+        clear.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+        clear.clearValue.depthStencil = { 1.0f, 0 };
+        VkClearRect rect = { getTile(i), 0, 1 };
+        vkCmdClearAttachments(cmdBuf, 1, &clear, 1, &rect);
+        drawCasters(cmdBuf, i, true);
+        mCascades[i].staticDirty = false;
+        ++mStats.staticCascades;
+      }
+      mStaticPass->end(cmdBuf);
+    }
+
+    { // Last frame may still sample the atlas, its contents are replaced entirely.
+      VkImageMemoryBarrier barrier{};
+      barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+      barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.image = mShadowMap->getImage()->get();
+      barrier.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+      vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+      VkImageCopy region{};
+      region.srcSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1 };
+      region.dstSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1 };
+      region.extent = { size.x, size.y, 1 };
+      vkCmdCopyImage(cmdBuf, mStaticMap->getImage()->get(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                     mShadowMap->getImage()->get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    }
+
+    mDynamicPass->begin(cmdBuf, extent, mDynamicFramebuffer, { VkClearValue{} });
+    vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    renderer::bindTransforms(mLayout);
+    for (uint32_t i = 0; i < mCascades.size(); ++i) drawCasters(cmdBuf, i, false);
+    mDynamicPass->end(cmdBuf);
+    purrProfiler::getDefault()->endGpuZone(cmdBuf);
+  }
+
+  glm::uvec2 purrCascadedShadows::getAtlasSize() const {
+    return glm::uvec2(mColumns * mSettings.resolution, mRows * mSettings.resolution);
+  }
+
+  void purrCascadedShadows::gatherCasters() {
+    mCasters.clear();
+    const purrRenderSnapshot *snapshot = renderer::getSnapshot();
+    for (uint32_t i = 0; i < snapshot->objects.size(); ++i) {
+      purrMesh *mesh = snapshot->objects[i].mesh;
+      if (!mesh) continue;
+      const glm::mat4 &model = snapshot->transforms[i];
+      glm::vec4 sphere = mesh->getBoundingSphere();
+      float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+      mCasters.push_back(Caster{
+        i, mesh, glm::vec3(model * glm::vec4(sphere.x, sphere.y, sphere.z, 1.0f)), sphere.w * scale, snapshot->objects[i].isStatic
+      });
+    }
+  }
+
+  bool purrCascadedShadows::overlaps(const Caster &caster, uint32_t cascade) const {
+    const CascadeBounds &bounds = mBounds[cascade];
+    float extent = mCascades[cascade].radius + caster.radius;
+    glm::vec3 center = glm::vec3(mLightView * glm::vec4(caster.center, 1.0f));
+    return std::abs(center.x - bounds.lightCenter.x) <= extent && std::abs(center.y - bounds.lightCenter.y) <= extent &&
+           center.z + caster.radius >= bounds.zMin && center.z - caster.radius <= bounds.zMax;
+  }
+
+  void purrCascadedShadows::drawCasters(VkCommandBuffer cmdBuf, uint32_t cascade, bool isStatic) {
+    VkRect2D tile = getTile(cascade);
+    VkViewport viewport = { static_cast<float>(tile.offset.x), static_cast<float>(tile.offset.y),
+                            static_cast<float>(tile.extent.width), static_cast<float>(tile.extent.height), 0.0f, 1.0f };
+    vkCmdSetViewport(cmdBuf, 0, 1, &viewport);
+    vkCmdSetScissor(cmdBuf, 0, 1, &tile);
+
+    ShadowConstants constants{};
+    constants.viewProjection = mCascades[cascade].viewProjection;
+    for (const Caster &caster: mCasters) {
+      if (caster.isStatic != isStatic) continue;
+      if (!overlaps(caster, cascade)) {
+        ++mStats.culledDraws;
+        continue;
+      }
+      constants.objectIndex = caster.index;
+      vkCmdPushConstants(cmdBuf, mLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+      caster.mesh->render(cmdBuf);
+      if (isStatic) ++mStats.staticDraws;
+      else ++mStats.dynamicDraws;
+    }
+  }
+
+  VkRect2D purrCascadedShadows::getTile(uint32_t cascade) const {
+    return VkRect2D{
+      { static_cast<int32_t>((cascade % mColumns) * mSettings.resolution), static_cast<int32_t>((cascade / mColumns) * mSettings.resolution) },
+      { mSettings.resolution, mSettings.resolution }
+    };
+  }
+
+  void purrCascadedShadows::setContext(PurrfectEngineContext *context) {
+    sContext = context;
+  }
+
+}
\ No newline at end of file
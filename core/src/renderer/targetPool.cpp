@@ -0,0 +1,231 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+#include <assert.h>
+#include <inttypes.h>
+
+namespace PurrfectEngine {
+
+  static PurrfectEngineContext *sContext = nullptr;
+
+  static purrRenderTargetPool *sDefaultPool = nullptr;
+
+  // Idle targets are kept around for a while, so resizing back and forth or passes that skip a frame don't reallocate.
+  // Counted on top of the frames in flight, until those are done the GPU may still use idle targets.
+  #define EXTRA_IDLE_FRAMES 6
+
+  static uint32_t getFramesInFlight() {
+    return std::max(sContext->settings.framesInFlight, 1u);
+  }
+
+  purrRenderTargetPool::purrRenderTargetPool()
+  {}
+
+  purrRenderTargetPool::~purrRenderTargetPool() {
+    cleanup();
+  }
+
+  purrTexture *purrRenderTargetPool::acquire(purrRenderTargetDesc desc, purrSampler *sampler) {
+    if (desc.transient) {
+      // Transient attachments may only be used as attachments.
+      desc.usage &= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+      desc.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+      sampler = nullptr;
+    }
+
+    for (Entry *entry: mEntries) {
+      if (entry->inUse || entry->block->inUse || !(entry->desc == desc)) continue;
+      entry->inUse = true;
+      entry->lastUsed = mFrame;
+      entry->block->inUse = true;
+      entry->block->lastUsed = mFrame;
+      if (entry->texture->mSampler != sampler) entry->texture->setSampler(sampler);
+      return entry->texture;
+    }
+
+    VkDevice device = sContext->frRenderer->getDevice();
+    bool color = !(desc.usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
+
+    Entry *entry = new Entry();
+    entry->desc = desc;
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = desc.format;
+    imageInfo.extent = { static_cast<uint32_t>(desc.width), static_cast<uint32_t>(desc.height), 1 };
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = desc.samples;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = desc.usage;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (vkCreateImage(device, &imageInfo, nullptr, &entry->image) != VK_SUCCESS) {
+      fprintf(stderr, "[purrRenderTargetPool]: Failed to create %dx%d render target!\n", desc.width, desc.height);
+      delete entry;
+      return nullptr;
+    }
+
+    VkMemoryRequirements requirements{};
+    vkGetImageMemoryRequirements(device, entry->image, &requirements);
+    entry->size = requirements.size;
+
+    uint32_t memoryType = 0;
+    if (!(desc.transient && Utils::findMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, &memoryType)) &&
+        !Utils::findMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memoryType)) {
+      fprintf(stderr, "[purrRenderTargetPool]: No suitable memory type for %dx%d render target!\n", desc.width, desc.height);
+      vkDestroyImage(device, entry->image, nullptr);
+      delete entry;
+      return nullptr;
+    }
+
+    entry->block = findBlock(requirements, memoryType);
+    if (!entry->block) {
+      vkDestroyImage(device, entry->image, nullptr);
+      delete entry;
+      return nullptr;
+    }
+    vkBindImageMemory(device, entry->image, entry->block->allocation.memory, entry->block->allocation.offset);
+
+    entry->texture = new purrTexture(desc.width, desc.height, desc.format);
+    entry->texture->mSampleCount = desc.samples;
+    entry->texture->mPooled = true;
+    entry->texture->initialize(entry->image, desc.usage, sampler, color);
+
+    entry->inUse = true;
+    entry->lastUsed = mFrame;
+    entry->block->inUse = true;
+    entry->block->lastUsed = mFrame;
+    mEntries.push_back(entry);
+    return entry->texture;
+  }
+
+  void purrRenderTargetPool::release(purrTexture *target, VkPipelineStageFlags stages, VkAccessFlags access) {
+    if (!target) return;
+    for (Entry *entry: mEntries) {
+      if (entry->texture != target) continue;
+      assert(entry->inUse && "Render target released twice!");
+      entry->inUse = false;
+      entry->lastUsed = mFrame;
+      entry->block->inUse = false;
+      entry->block->lastUsed = mFrame;
+      // The last user waited for the ones before it, so its stages alone cover the block.
+      entry->block->stages = stages;
+      entry->block->access = access;
+      return;
+    }
+    assert(0 && "Render target doesn't belong to this pool!");
+  }
+
+  void purrRenderTargetPool::getAliasHazard(purrTexture *target, VkPipelineStageFlags *stages, VkAccessFlags *access) const {
+    *stages = 0;
+    *access = 0;
+    for (Entry *entry: mEntries) {
+      if (entry->texture != target) continue;
+      *stages = entry->block->stages;
+      *access = entry->block->access;
+      return;
+    }
+  }
+
+  void purrRenderTargetPool::trim(uint32_t maxIdleFrames) {
+    assert(maxIdleFrames > getFramesInFlight() && "Render targets trimmed while the GPU may still use them!");
+    for (auto it = mEntries.begin(); it != mEntries.end();) {
+      Entry *entry = *it;
+      if (entry->inUse || mFrame - entry->lastUsed < maxIdleFrames) { ++it; continue; }
+      destroyEntry(entry);
+      it = mEntries.erase(it);
+    }
+
+    for (auto it = mBlocks.begin(); it != mBlocks.end();) {
+      Block *block = *it;
+      bool bound = std::find_if(mEntries.begin(), mEntries.end(), [&](Entry *entry) { return entry->block == block; }) != mEntries.end();
+      if (bound || block->inUse || mFrame - block->lastUsed < maxIdleFrames) { ++it; continue; }
+      purrGpuAllocator::getDefault()->free(block->allocation);
+      mAllocatedBytes -= block->size;
+      delete block;
+      it = mBlocks.erase(it);
+    }
+  }
+
+  void purrRenderTargetPool::nextFrame() {
+    ++mFrame;
+    trim(getFramesInFlight() + EXTRA_IDLE_FRAMES);
+  }
+
+  void purrRenderTargetPool::cleanup() {
+    for (Entry *entry: mEntries) destroyEntry(entry);
+    for (Block *block: mBlocks) {
+      purrGpuAllocator::getDefault()->free(block->allocation);
+      delete block;
+    }
+    mEntries.clear();
+    mBlocks.clear();
+    mAllocatedBytes = 0;
+  }
+
+  purrRenderTargetStats purrRenderTargetPool::getStats() const {
+    purrRenderTargetStats stats{};
+    stats.allocatedBytes = mAllocatedBytes;
+    stats.peakBytes = mPeakBytes;
+    for (Entry *entry: mEntries) if (entry->inUse) {
+      stats.requestedBytes += entry->size;
+      ++stats.targetCount;
+    }
+    stats.blockCount = static_cast<uint32_t>(mBlocks.size());
+    return stats;
+  }
+
+  purrRenderTargetPool::Block *purrRenderTargetPool::findBlock(VkMemoryRequirements requirements, uint32_t memoryType) {
+    // Best fit among free blocks, aliasing memory of targets that were released.
+    Block *best = nullptr;
+    for (Block *block: mBlocks) {
+      if (block->inUse || block->memoryType != memoryType || block->size < requirements.size || block->allocation.offset % requirements.alignment) continue;
+      if (!best || block->size < best->size) best = block;
+    }
+    if (best) return best;
+
+    Block *block = new Block();
+    block->size = requirements.size;
+    block->memoryType = memoryType;
+
+    // Blocks are suballocated like everything else, pinned to the memory type picked above so they can be aliased.
+    purrAllocationInfo allocInfo{};
+    allocInfo.requirements = requirements;
+    allocInfo.requirements.memoryTypeBits = 1u << memoryType;
+    allocInfo.required = 0;
+    allocInfo.category = purrMemoryCategory::Target;
+    allocInfo.image = true;
+    if (!purrGpuAllocator::getDefault()->allocate(allocInfo, &block->allocation)) {
+      fprintf(stderr, "[purrRenderTargetPool]: Failed to allocate %" PRIu64 " bytes!\n", (uint64_t)block->size);
+      delete block;
+      return nullptr;
+    }
+
+    mAllocatedBytes += block->size;
+    mPeakBytes = std::max(mPeakBytes, mAllocatedBytes);
+    mBlocks.push_back(block);
+    return block;
+  }
+
+  void purrRenderTargetPool::destroyEntry(Entry *entry) {
+    delete entry->texture;
+    vkDestroyImage(sContext->frRenderer->getDevice(), entry->image, nullptr);
+    delete entry;
+  }
+
+  void purrRenderTargetPool::setContext(PurrfectEngineContext *context) {
+    sContext = context;
+  }
+
+  purrRenderTargetPool *purrRenderTargetPool::getDefault() {
+    if (!sDefaultPool) sDefaultPool = new purrRenderTargetPool();
+    return sDefaultPool;
+  }
+
+  void purrRenderTargetPool::cleanupAll() {
+    if (sDefaultPool) delete sDefaultPool;
+    sDefaultPool = nullptr;
+  }
+
+}
\ No newline at end of file
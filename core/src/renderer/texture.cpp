@@ -1,6 +1,7 @@
 #include "PurrfectEngine/PurrfectEngine.hpp"
 
 #include <assert.h>
+#include <cmath>
 
 namespace PurrfectEngine {
 
@@ -48,38 +49,84 @@ namespace PurrfectEngine {
     if (mImage) cleanup(); // I don't trust my ability of writing code that won't leak memory (NULL)
     mMipmaps = mipmaps;
     mColor = color;
+    VkImageUsageFlags usage = (color?VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT:VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) | (mipmaps ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0) | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+    // The image comes from purrGpuAllocator, fr::frImage only wraps it. Full mip chain, like frImage would create.
+    VkImageCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    createInfo.imageType = VK_IMAGE_TYPE_2D;
+    createInfo.format = mFormat;
+    createInfo.extent = { static_cast<uint32_t>(mWidth), static_cast<uint32_t>(mHeight), 1 };
+    createInfo.mipLevels = mipmaps ? static_cast<uint32_t>(std::floor(std::log2(std::max(mWidth, mHeight)))) + 1 : 1;
+    createInfo.arrayLayers = 1;
+    createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    createInfo.usage = usage;
+    createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    purrAllocationInfo allocInfo{};
+    allocInfo.category = purrMemoryCategory::Texture;
+    if (!purrGpuAllocator::getDefault()->createImage(createInfo, allocInfo, &mOwnedImage, &mAllocation)) return;
+
     mImage = new fr::frImage();
-    mImage->initialize(sContext->frRenderer, fr::frImage::frImageInfo{
+    mImage->initialize(sContext->frRenderer, mOwnedImage, fr::frImage::frImageInfo{
       mWidth, mHeight, mFormat,
-      (VkImageUsageFlagBits)((color?VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT:VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) | (mipmaps ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0) | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT),
-      true, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      (VkImageUsageFlagBits)usage,
+      false, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
       color?VK_IMAGE_ASPECT_COLOR_BIT:VK_IMAGE_ASPECT_DEPTH_BIT, mipmaps
     });
 
-    mSampler = sampler;
+    setSampler(sampler);
+  }
 
-    if (mSampler) {
-      VkDescriptorImageInfo imageInfo = {};
-      imageInfo.sampler = mSampler->mSampler->get();
-      imageInfo.imageView = mImage->getView();
-      imageInfo.imageLayout = color?VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-      mDescriptor = sContext->frTextureDescriptors->allocate(1, sContext->frTextureLayout)[0];
-      mDescriptor->update(fr::frDescriptor::frDescriptorWriteInfo{
-        0, 0, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-        &imageInfo, VK_NULL_HANDLE, VK_NULL_HANDLE
-      });
-    }
+  void purrTexture::initialize(VkImage image, VkImageUsageFlags usage, purrSampler *sampler, bool color) {
+    if (mImage) cleanup();
+    mMipmaps = false;
+    mColor = color;
+    mImage = new fr::frImage();
+    mImage->initialize(sContext->frRenderer, image, fr::frImage::frImageInfo{
+      mWidth, mHeight, mFormat,
+      (VkImageUsageFlagBits)usage,
+      false, 0,
+      color?VK_IMAGE_ASPECT_COLOR_BIT:VK_IMAGE_ASPECT_DEPTH_BIT, false
+    });
+
+    setSampler(sampler);
+  }
+
+  void purrTexture::setSampler(purrSampler *sampler) {
+    mSampler = sampler;
+    if (!mSampler) return;
+
+    VkDescriptorImageInfo imageInfo = {};
+    imageInfo.sampler = mSampler->mSampler->get();
+    imageInfo.imageView = mImage->getView();
+    // Sampled depth (e.g. shadow maps) has to be in a read-only layout, the render pass writing it ends there.
+    imageInfo.imageLayout = mColor?VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+    if (!mDescriptor) mDescriptor = purrDescriptorAllocator::getDefault()->allocate(sContext->frTextureLayout->get());
+    if (!mDescriptor) return;
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = mDescriptor;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &imageInfo;
+    vkUpdateDescriptorSets(sContext->frRenderer->getDevice(), 1, &write, 0, nullptr);
   }
 
   void purrTexture::cleanup() {
     if (mImage) delete mImage;
-    if (mDescriptor) delete mDescriptor;
+    if (mDescriptor) purrDescriptorAllocator::getDefault()->free(mDescriptor);
     mImage = nullptr;
-    mDescriptor = nullptr;
+    mDescriptor = VK_NULL_HANDLE;
+    if (mOwnedImage) purrGpuAllocator::getDefault()->destroyImage(mOwnedImage, mAllocation);
+    mOwnedImage = VK_NULL_HANDLE;
   }
 
   void purrTexture::resize(int width, int height) {
+    assert(!mPooled && "Pooled render targets have to be re-acquired from purrRenderTargetPool instead!");
     mWidth = width;
     mHeight = height;
     cleanup();
@@ -87,43 +134,31 @@ namespace PurrfectEngine {
   }
 
   void purrTexture::setPixels(std::vector<uint8_t> pixels) {
-    size_t maxSize = mWidth * mHeight * PurrfectEngine::Utils::formatToChannels(mFormat);
-    assert(pixels.size() <= maxSize);
-    VkDeviceSize bufferSize = static_cast<VkDeviceSize>(pixels.size());
-
-    fr::frBuffer *stagingBuffer = new fr::frBuffer();
-    stagingBuffer->initialize(sContext->frRenderer, fr::frBuffer::frBufferInfo{
-      bufferSize,
-      VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, {}
-    });
-    stagingBuffer->copyData(0, bufferSize, pixels.data());
-
-    mImage->transitionLayout(sContext->frRenderer, sContext->frCommands, fr::frImage::frImageTransitionInfo{
-      VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-      0, VK_ACCESS_TRANSFER_WRITE_BIT
-    });
-    mImage->copyFromBuffer(sContext->frRenderer, sContext->frCommands, stagingBuffer, bufferSize);
-    mImage->generateMipmaps(sContext->frRenderer, sContext->frCommands);
+    setPixels(pixels.data(), pixels.size());
   }
 
   void purrTexture::setPixels(uint8_t *pixels, size_t size) {
     size_t maxSize = mWidth * mHeight * PurrfectEngine::Utils::formatToChannels(mFormat);
     assert(size <= maxSize);
-    
-    fr::frBuffer *stagingBuffer = new fr::frBuffer();
-    stagingBuffer->initialize(sContext->frRenderer, fr::frBuffer::frBufferInfo{
-      size,
-      VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, {}
-    });
-    stagingBuffer->copyData(0, size, pixels);
+
+    purrBuffer stagingBuffer{};
+    if (!stagingBuffer.initialize(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, purrMemoryCategory::Staging)) return;
+    stagingBuffer.copyData(0, size, pixels);
 
     mImage->transitionLayout(sContext->frRenderer, sContext->frCommands, fr::frImage::frImageTransitionInfo{
       VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
       VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
       0, VK_ACCESS_TRANSFER_WRITE_BIT
     });
-    mImage->copyFromBuffer(sContext->frRenderer, sContext->frCommands, stagingBuffer, size);
+
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask = mColor ? VK_IMAGE_ASPECT_COLOR_BIT : VK_IMAGE_ASPECT_DEPTH_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = { static_cast<uint32_t>(mWidth), static_cast<uint32_t>(mHeight), 1 };
+    VkCommandBuffer cmdBuf = sContext->frCommands->beginSingleTime();
+    vkCmdCopyBufferToImage(cmdBuf, stagingBuffer.get(), mImage->get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    sContext->frCommands->endSingleTime(cmdBuf);
+
     mImage->generateMipmaps(sContext->frRenderer, sContext->frCommands);
   }
 
@@ -38,8 +38,9 @@ namespace PurrfectEngine {
   bool purrScene::removeObject(PUID uuid) {
     std::vector<PUID>::iterator it;
     if ((it = std::find(mUuids.begin(), mUuids.end(), uuid)) == mUuids.end()) return false;
-    mUuids.erase(it);
+    // Before erasing, `it` is invalid afterwards.
     mObjects.erase(mObjects.begin()+(it-mUuids.begin()));
+    mUuids.erase(it);
     return true;
   }
 
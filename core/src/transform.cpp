@@ -8,17 +8,34 @@ namespace PurrfectEngine {
 
   purrTransform::purrTransform(glm::vec3 position, glm::quat rotation, glm::vec3 scale):
     mPos(position), mRot(rotation), mScale(scale)
-  { update(); }
+  { update(); savePrevious(); }
 
   purrTransform::purrTransform(glm::mat4 transform)
-  { setTransform(transform); }
+  { setTransform(transform); savePrevious(); }
 
   purrTransform::~purrTransform() {
 
   }
 
   void purrTransform::update() {
-    mTransform = glm::mat4(glm::mat3(mRot)) * glm::scale(glm::translate(glm::mat4(1.0f), mPos), mScale);
+    mTransform = compose(mPos, mRot, mScale);
+  }
+
+  glm::vec3 purrTransform::getInterpolatedPosition(float alpha) const {
+    return glm::mix(mPrevPos, mPos, alpha);
+  }
+
+  glm::quat purrTransform::getInterpolatedRotation(float alpha) const {
+    return glm::slerp(mPrevRot, mRot, alpha);
+  }
+
+  glm::mat4 purrTransform::getInterpolated(float alpha) const {
+    if (alpha >= 1.0f) return compose(mPos, mRot, mScale);
+    return compose(getInterpolatedPosition(alpha), getInterpolatedRotation(alpha), glm::mix(mPrevScale, mScale, alpha));
+  }
+
+  glm::mat4 purrTransform::compose(glm::vec3 position, glm::quat rotation, glm::vec3 scale) {
+    return glm::mat4(glm::mat3(rotation)) * glm::scale(glm::translate(glm::mat4(1.0f), position), scale);
   }
 
   void purrTransform::setTransform(glm::mat4 trans) {
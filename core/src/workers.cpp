@@ -0,0 +1,92 @@
+#include "PurrfectEngine/PurrfectEngine.hpp"
+
+namespace PurrfectEngine {
+
+  static purrWorkerPool *sDefaultPool = nullptr;
+
+  purrWorkerPool::purrWorkerPool(uint32_t threads):
+    mThreadCount(threads ? threads : std::max(1u, std::thread::hardware_concurrency()) - 1)
+  {}
+
+  purrWorkerPool::~purrWorkerPool() {
+    stop();
+  }
+
+  void purrWorkerPool::parallelFor(uint32_t count, const std::function<void(uint32_t)> &job) {
+    if (count == 0) return;
+    if (count == 1) {
+      job(0);
+      return;
+    }
+    std::lock_guard<std::mutex> call(mCallMutex);
+    if (mWorkers.size() < mThreadCount) start();
+    if (mWorkers.empty()) {
+      for (uint32_t i = 0; i < count; ++i) job(i);
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mJob = &job;
+      mJobCount = count;
+      mNextJob = 0;
+      mBusyWorkers = static_cast<uint32_t>(mWorkers.size());
+      ++mGeneration;
+    }
+    mWorkCv.notify_all();
+    runJobs();
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDoneCv.wait(lock, [this]() { return mBusyWorkers == 0; });
+    mJob = nullptr;
+  }
+
+  uint32_t purrWorkerPool::getConcurrency() const {
+    return mThreadCount + 1;
+  }
+
+  void purrWorkerPool::start() {
+    mStopping = false;
+    // Workers start at the current generation, the next parallelFor is the first one they pick up.
+    while (mWorkers.size() < mThreadCount) mWorkers.emplace_back(&purrWorkerPool::workerMain, this, mGeneration);
+  }
+
+  void purrWorkerPool::stop() {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStopping = true;
+    }
+    mWorkCv.notify_all();
+    for (std::thread &worker: mWorkers) worker.join();
+    mWorkers.clear();
+  }
+
+  void purrWorkerPool::runJobs() {
+    for (uint32_t i = mNextJob++; i < mJobCount; i = mNextJob++) (*mJob)(i);
+  }
+
+  void purrWorkerPool::workerMain(uint32_t generation) {
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mWorkCv.wait(lock, [&]() { return mStopping || mGeneration != generation; });
+        if (mStopping) return;
+        generation = mGeneration;
+      }
+      runJobs();
+      std::lock_guard<std::mutex> lock(mMutex);
+      if (--mBusyWorkers == 0) mDoneCv.notify_one();
+    }
+  }
+
+  purrWorkerPool *purrWorkerPool::getDefault() {
+    if (!sDefaultPool) sDefaultPool = new purrWorkerPool();
+    return sDefaultPool;
+  }
+
+  void purrWorkerPool::cleanupAll() {
+    if (sDefaultPool) delete sDefaultPool;
+    sDefaultPool = nullptr;
+  }
+
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#version 450
+
+layout(location = 0) in vec2 inUV;
+layout(location = 1) in vec4 inColor;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+  float r = dot(inUV, inUV);
+  if (r > 1.0) discard;
+  outColor = vec4(inColor.rgb, inColor.a * (1.0 - r));
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#version 450
+
+// Camera facing quad per particle, drawn indirectly with the live count as instance count (see purrParticleSystem::render).
+
+layout(set = 0, binding = 0) uniform CameraUBO {
+  mat4 projection;
+  mat4 view;
+} camera;
+
+struct Particle {
+  vec4 positionAge;
+  vec4 velocityLifetime;
+};
+
+layout(set = 1, binding = 1) readonly buffer Particles { Particle particles[]; } particles;
+layout(set = 1, binding = 3) readonly buffer Keys { uvec2 keys[]; } keys;
+
+layout(push_constant) uniform constants {
+  vec4 colorStart;
+  vec4 colorEnd;
+  vec2 size;
+  uint sorted;
+} pc;
+
+layout(location = 0) out vec2 outUV;
+layout(location = 1) out vec4 outColor;
+
+const vec2 corners[6] = vec2[](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+void main() {
+  uint index = pc.sorted != 0u ? keys.keys[gl_InstanceIndex].y : uint(gl_InstanceIndex);
+  Particle particle = particles.particles[index];
+  float t = clamp(particle.positionAge.w / max(particle.velocityLifetime.w, 1e-5), 0.0, 1.0);
+
+  vec2 corner = corners[gl_VertexIndex];
+  vec4 viewPos = camera.view * vec4(particle.positionAge.xyz, 1.0);
+  viewPos.xy += corner * mix(pc.size.x, pc.size.y, t);
+  gl_Position = camera.projection * viewPos;
+  outUV = corner;
+  outColor = mix(pc.colorStart, pc.colorEnd, t);
+}
\ No newline at end of file
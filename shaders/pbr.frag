@@ -0,0 +1,153 @@
+#version 450
+
+// Clustered forward shading, the froxel grid is built on the CPU by purrLightClusters (renderer::updateLights).
+// Every fragment only walks the lights binned into its own cluster.
+
+struct Light {
+  vec3 position;
+  float radius;
+  vec3 color;
+  float intensity;
+};
+
+layout(std430, set = 2, binding = 0) readonly buffer LightBuffer {
+  mat4 view;
+  uvec4 grid;   // Tiles x, tiles y, slices, light count.
+  vec4 slicing; // Slice scale, slice bias, viewport width, viewport height.
+  vec4 eye;
+  vec4 sunDirection; // Towards the light, w is the shadow cascade count.
+  vec4 sunColor;
+  vec4 shadowSplits;
+  vec4 shadowAtlas;  // Tiles per row, 1 / tiles per row, 1 / tiles per column, texels per cascade.
+  mat4 shadowMatrices[4];
+  Light lights[];
+} lightData;
+
+layout(std430, set = 2, binding = 1) readonly buffer ClusterBuffer {
+  uvec2 clusters[]; // Offset into indices, light count.
+} clusterData;
+
+layout(std430, set = 2, binding = 2) readonly buffer IndexBuffer {
+  uint indices[];
+} indexData;
+
+// Cascade atlas written by purrCascadedShadows, a white 1x1 texture when there are no shadows.
+layout(set = 3, binding = 0) uniform sampler2D uShadowMap;
+
+// Per-draw data, lighting pipelines have at least PURR_LIGHTING_DRAW_DATA bytes. Alpha blends the tint in, so zeroed data is untinted.
+layout(std140, set = 4, binding = 0) uniform DrawData {
+  vec4 tint;
+} drawData;
+
+layout(location = 0) in vec3 inWorldPos;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec3 inColor;
+layout(location = 3) in vec2 inUV;
+
+layout(location = 0) out vec4 outColor;
+
+const float PI = 3.14159265359;
+const float ROUGHNESS = 0.5;
+const float METALLIC = 0.0;
+const vec3 AMBIENT = vec3(0.03);
+
+float distributionGGX(float NdotH, float roughness) {
+  float a = roughness * roughness;
+  float a2 = a * a;
+  float d = NdotH * NdotH * (a2 - 1.0) + 1.0;
+  return a2 / (PI * d * d);
+}
+
+float geometrySmith(float NdotV, float NdotL, float roughness) {
+  float k = (roughness + 1.0) * (roughness + 1.0) / 8.0;
+  return (NdotV / (NdotV * (1.0 - k) + k)) * (NdotL / (NdotL * (1.0 - k) + k));
+}
+
+vec3 fresnelSchlick(float cosTheta, vec3 F0) {
+  return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
+}
+
+vec3 brdf(vec3 N, vec3 V, vec3 L, float NdotV, vec3 albedo, vec3 F0) {
+  vec3 H = normalize(V + L);
+  float NdotL = max(dot(N, L), 0.0);
+  float NdotH = max(dot(N, H), 0.0);
+  vec3 F = fresnelSchlick(max(dot(H, V), 0.0), F0);
+  vec3 specular = distributionGGX(NdotH, ROUGHNESS) * geometrySmith(NdotV, NdotL, ROUGHNESS) * F / (4.0 * NdotV * NdotL + 1e-4);
+  vec3 kD = (1.0 - F) * (1.0 - METALLIC);
+  return (kD * albedo / PI + specular) * NdotL;
+}
+
+// Inverse square falloff windowed to reach zero at the radius, so lights outside their clusters contribute nothing.
+float attenuation(float distance, float radius) {
+  float ratio = distance / radius;
+  float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+  return window * window / (distance * distance + 1.0);
+}
+
+// 3x3 PCF on texel centers of the cascade's tile, texelFetch keeps taps from bleeding into the neighbouring tiles.
+float shadow(float depth) {
+  uint cascadeCount = uint(lightData.sunDirection.w);
+  if (cascadeCount == 0) return 1.0;
+  uint cascade = 0;
+  while (cascade + 1 < cascadeCount && depth > lightData.shadowSplits[cascade]) ++cascade;
+  if (depth > lightData.shadowSplits[cascadeCount - 1]) return 1.0;
+
+  vec4 clip = lightData.shadowMatrices[cascade] * vec4(inWorldPos, 1.0);
+  vec3 ndc = clip.xyz / clip.w;
+  if (ndc.z > 1.0) return 1.0;
+  int tileSize = int(lightData.shadowAtlas.w);
+  ivec2 tile = ivec2(cascade % uint(lightData.shadowAtlas.x), cascade / uint(lightData.shadowAtlas.x)) * tileSize;
+  vec2 texel = (ndc.xy * 0.5 + 0.5) * float(tileSize);
+
+  float lit = 0.0;
+  for (int y = -1; y <= 1; ++y) {
+    for (int x = -1; x <= 1; ++x) {
+      ivec2 coord = clamp(ivec2(texel) + ivec2(x, y), ivec2(0), ivec2(tileSize - 1));
+      lit += (ndc.z <= texelFetch(uShadowMap, tile + coord, 0).r) ? 1.0 : 0.0;
+    }
+  }
+  return lit / 9.0;
+}
+
+float viewDepth() {
+  return -(lightData.view * vec4(inWorldPos, 1.0)).z;
+}
+
+uint clusterIndex(float depth) {
+  uvec3 grid = lightData.grid.xyz;
+  int slice = int(floor(log(max(depth, 1e-4)) * lightData.slicing.x + lightData.slicing.y));
+  uvec2 tile = uvec2(gl_FragCoord.xy / lightData.slicing.zw * vec2(grid.xy));
+  uvec3 cluster = min(uvec3(tile, uint(clamp(slice, 0, int(grid.z) - 1))), grid - 1);
+  return (cluster.z * grid.y + cluster.y) * grid.x + cluster.x;
+}
+
+void main() {
+  vec3 albedo = inColor * mix(vec3(1.0), drawData.tint.rgb, drawData.tint.a);
+  vec3 N = normalize(inNormal);
+  vec3 V = normalize(lightData.eye.xyz - inWorldPos);
+  float NdotV = max(dot(N, V), 1e-4);
+  vec3 F0 = mix(vec3(0.04), albedo, METALLIC);
+
+  float depth = viewDepth();
+  vec3 Lo = vec3(0.0);
+  if (any(greaterThan(lightData.sunColor.rgb, vec3(0.0)))) {
+    vec3 L = normalize(lightData.sunDirection.xyz);
+    if (dot(N, L) > 0.0) Lo += brdf(N, V, L, NdotV, albedo, F0) * lightData.sunColor.rgb * shadow(depth);
+  }
+
+  if (lightData.grid.w > 0) {
+    uvec2 cluster = clusterData.clusters[clusterIndex(depth)];
+    for (uint i = 0; i < cluster.y; ++i) {
+      Light light = lightData.lights[indexData.indices[cluster.x + i]];
+      vec3 toLight = light.position - inWorldPos;
+      float distance = length(toLight);
+      if (distance >= light.radius) continue;
+
+      vec3 L = toLight / distance;
+      if (dot(N, L) <= 0.0) continue;
+      Lo += brdf(N, V, L, NdotV, albedo, F0) * light.color * light.intensity * attenuation(distance, light.radius);
+    }
+  }
+
+  outColor = vec4(AMBIENT * albedo + Lo, 1.0);
+}
\ No newline at end of file
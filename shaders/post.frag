@@ -0,0 +1,83 @@
+#version 450
+
+// Composite with purrPostProcess: exposure, bloom, tonemapping and grading, fused with the sharpening of upscale.frag
+// so the HDR scene is read only once more at full resolution.
+
+layout(set = 0, binding = 0) uniform sampler2D uScene;
+layout(set = 1, binding = 0) uniform sampler2D uBloom;
+layout(set = 1, binding = 1) readonly buffer Exposure {
+  uint histogram[256];
+  float averageLuminance;
+} exposure;
+
+layout(push_constant) uniform constants {
+  vec2 uvScale;   // Part of the scene target that was rendered to.
+  vec2 texelSize;
+  float sharpness;
+  float bloomIntensity;
+  float exposure; // Compensation, times the manual exposure when it isn't metered.
+  uint flags;     // 1: auto exposure, 2-3: tonemapper, 8: bloom.
+  vec2 bloomScale;
+  float saturation;
+  float contrast;
+  vec4 lift;
+  vec4 gamma;
+  vec4 gain;
+} pc;
+
+layout(location = 0) in vec2 inUV;
+
+layout(location = 0) out vec4 outColor;
+
+vec3 tap(vec2 uv) {
+  return texture(uScene, clamp(uv, 0.5 * pc.texelSize, pc.uvScale - 0.5 * pc.texelSize)).rgb;
+}
+
+float luminance(vec3 color) {
+  return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+vec3 tonemap(vec3 color) {
+  uint tonemapper = (pc.flags >> 1u) & 3u;
+  if (tonemapper == 1u) return color / (1.0 + luminance(color));
+  if (tonemapper == 2u) {
+    // Narkowicz's ACES fit.
+    return clamp((color * (2.51 * color + 0.03)) / (color * (2.43 * color + 0.59) + 0.14), 0.0, 1.0);
+  }
+  return clamp(color, 0.0, 1.0);
+}
+
+void main() {
+  float scale = pc.exposure;
+  if ((pc.flags & 1u) != 0u) scale *= 0.18 / max(exposure.averageLuminance, 1e-4);
+
+  vec2 uv = inUV * pc.uvScale;
+  vec3 c = tap(uv) * scale;
+  vec3 n = tap(uv + vec2(0.0, -pc.texelSize.y)) * scale;
+  vec3 s = tap(uv + vec2(0.0,  pc.texelSize.y)) * scale;
+  vec3 w = tap(uv + vec2(-pc.texelSize.x, 0.0)) * scale;
+  vec3 e = tap(uv + vec2( pc.texelSize.x, 0.0)) * scale;
+
+  // Contrast adaptive sharpening as in upscale.frag, the amount is measured on compressed values since these are HDR.
+  vec3 mn = min(c, min(min(n, s), min(w, e)));
+  vec3 mx = max(c, max(max(n, s), max(w, e)));
+  mn /= 1.0 + mn;
+  mx /= 1.0 + mx;
+  vec3 amp = sqrt(clamp(min(mn, 1.0 - mx) / max(mx, vec3(1e-4)), 0.0, 1.0));
+  vec3 weight = -amp * mix(0.125, 0.2, clamp(pc.sharpness, 0.0, 1.0)) * step(1e-4, pc.sharpness);
+  vec3 color = max((c + (n + s + w + e) * weight) / (1.0 + 4.0 * weight), vec3(0.0));
+
+  if ((pc.flags & 8u) != 0u) {
+    vec2 bloomTexel = 1.0 / vec2(textureSize(uBloom, 0));
+    vec2 bloomUV = clamp(inUV * pc.bloomScale, 0.5 * bloomTexel, pc.bloomScale - 0.5 * bloomTexel);
+    color += textureLod(uBloom, bloomUV, 0.0).rgb * scale * pc.bloomIntensity;
+  }
+
+  color = tonemap(color);
+
+  color = pc.gain.rgb * (color + pc.lift.rgb * (1.0 - color));
+  color = pow(max(color, vec3(0.0)), 1.0 / max(pc.gamma.rgb, vec3(1e-3)));
+  color = mix(vec3(luminance(color)), color, pc.saturation);
+  color = (color - 0.18) * pc.contrast + 0.18;
+  outColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#version 450
+
+// Depth only, drawn once per cascade into its tile of the shadow atlas (see purrCascadedShadows).
+
+layout(std140, set = 1, binding = 0) readonly buffer ModelBuffer {
+  mat4 models[];
+} models;
+
+layout(push_constant) uniform constants {
+  uint objectIndex;
+  mat4 viewProjection;
+} pc;
+
+layout(location = 0) in vec3 inPos;
+
+void main() {
+  gl_Position = pc.viewProjection * models.models[pc.objectIndex] * vec4(inPos, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#version 450
+
+layout(binding = 0) uniform sampler2D uSampler;
+
+layout(push_constant) uniform constants {
+  vec2 uvScale;   // Part of the scene target that was rendered to.
+  vec2 texelSize;
+  float sharpness;
+} pc;
+
+layout(location = 0) in vec2 inUV;
+
+layout(location = 0) out vec4 outColor;
+
+// Bilinear taps are clamped to the rendered part, texels past it hold stale data from larger scales.
+vec3 tap(vec2 uv) {
+  return texture(uSampler, clamp(uv, 0.5 * pc.texelSize, pc.uvScale - 0.5 * pc.texelSize)).rgb;
+}
+
+void main() {
+  vec2 uv = inUV * pc.uvScale;
+  vec3 c = tap(uv);
+  vec3 n = tap(uv + vec2(0.0, -pc.texelSize.y));
+  vec3 s = tap(uv + vec2(0.0,  pc.texelSize.y));
+  vec3 w = tap(uv + vec2(-pc.texelSize.x, 0.0));
+  vec3 e = tap(uv + vec2( pc.texelSize.x, 0.0));
+
+  // Contrast adaptive sharpening: the negative lobe shrinks where the neighbourhood is already contrasty,
+  // so edges don't ring while the blur of the upscale is taken back in flat areas.
+  vec3 mn = min(c, min(min(n, s), min(w, e)));
+  vec3 mx = max(c, max(max(n, s), max(w, e)));
+  vec3 amp = sqrt(clamp(min(mn, 2.0 - mx) / max(mx, vec3(1e-4)), 0.0, 1.0));
+  vec3 weight = -amp * mix(0.125, 0.2, clamp(pc.sharpness, 0.0, 1.0)) * step(1e-4, pc.sharpness);
+
+  vec3 color = (c + (n + s + w + e) * weight) / (1.0 + 4.0 * weight);
+  outColor = vec4(max(color, vec3(0.0)), 1.0);
+}
\ No newline at end of file
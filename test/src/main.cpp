@@ -1,4 +1,7 @@
 #include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cmath>
 
 #include <PurrfectEngine/PurrfectEngine.hpp>
 
@@ -9,38 +12,133 @@ namespace input = PurrfectEngine::Input;
 purrPipeline* scenePipeline = nullptr;
 purrTexture* sceneRenderTarget = nullptr;
 purrSampler* sceneSampler = nullptr;
+bool sceneLighting = false;
+bool sceneKeepDepth = false;
+bool sceneDepthPrepass = false;
+PurrfectEngine::MSAA sceneMsaa = PurrfectEngine::MSAA::None;
 
 void createSceneObjects(int width, int height) {
-  sceneRenderTarget = new PurrfectEngine::purrTexture(width, height, VK_FORMAT_R16G16B16A16_SFLOAT);
-  sceneRenderTarget->initialize(sceneSampler, false);
+  sceneRenderTarget = purrRenderTargetPool::getDefault()->acquire(PurrfectEngine::purrRenderTargetDesc{
+    width, height, VK_FORMAT_R16G16B16A16_SFLOAT
+  }, sceneSampler);
   PurrfectEngine::purrPipelineCreateInfo pipelineInfo = {
     width, height,
     { {VK_SHADER_STAGE_VERTEX_BIT, "../shaders/vert.spv"}, {VK_SHADER_STAGE_FRAGMENT_BIT, "../shaders/frag.spv"} },
     sceneRenderTarget
   };
+  pipelineInfo.name = "Scene";
+  if (sceneLighting) {
+    pipelineInfo.shaders = { {VK_SHADER_STAGE_VERTEX_BIT, "../shaders/pbr.vert.spv"}, {VK_SHADER_STAGE_FRAGMENT_BIT, "../shaders/pbr.frag.spv"} };
+    pipelineInfo.lighting = true;
+    pipelineInfo.drawDataSize = sizeof(glm::vec4); // pbr.frag's tint.
+  }
+  pipelineInfo.keepDepth = sceneKeepDepth;
+  pipelineInfo.depthPrepass = sceneDepthPrepass;
+  pipelineInfo.msaa = sceneMsaa;
   scenePipeline = new PurrfectEngine::purrPipeline(pipelineInfo);
   scenePipeline->initialize();
   renderer::setScenePipeline(scenePipeline);
 }
 
 void cleanupSceneObjects() {
-  delete sceneRenderTarget;
+  purrRenderTargetPool::getDefault()->release(sceneRenderTarget);
   delete scenePipeline;
 }
 
+// Only the targets and framebuffer are reallocated, the pipeline itself survives the resize.
 void recreateSceneObjects(int width, int height) {
-  cleanupSceneObjects();
-  createSceneObjects(width, height);
+  purrRenderTargetPool::getDefault()->release(sceneRenderTarget);
+  sceneRenderTarget = purrRenderTargetPool::getDefault()->acquire(PurrfectEngine::purrRenderTargetDesc{
+    width, height, VK_FORMAT_R16G16B16A16_SFLOAT
+  }, sceneSampler);
+  scenePipeline->resize(width, height, sceneRenderTarget);
+  renderer::setScenePipeline(scenePipeline);
 }
 
 int main(int argc, char **argv) {
   PurrfectEngine::PurrfectEngineContext *context = new PurrfectEngine::PurrfectEngineContext();
+  int exitCode = 0;
+
+  // --headless [frames]: render offscreen without a window, write the last frame to frame.ppm and print the throughput.
+  // --profile: record CPU/GPU zones and write them to trace.json on exit.
+  // --dynamic-resolution [budgetMs]: scale the scene resolution to keep GPU time under the budget.
+  // --present-mode fifo|mailbox|immediate, --fps <n>: present mode and frame limiter, pacing stats are printed on exit.
+  // --lights <n>: scatter n small point lights around the model and shade it with the clustered PBR pipeline.
+  // --shadows: add a static ground plane and a sun with cascaded shadows, the model is a dynamic caster.
+  // --occlusion cpu|gpu: hide a grid of models behind a wall and cull them with the software rasterizer or the depth pyramid.
+  // --depth-prepass: lay down the scene's depth before shading it, draw list stats are printed on exit.
+  // --msaa <samples>: multisample the scene pass, M toggles it at runtime.
+  // --particles <n>: a GPU particle fountain of up to n particles, headless runs fail if its count differs from the CPU reference.
+  // --post: auto exposure, bloom and ACES tonemapping of the HDR scene, the metered luminance is printed on exit.
+  // --render-thread: record and present on a render thread fed with scene snapshots, simulation overlaps rendering.
+  // --tick-rate <hz>: fixed simulation rate of the camera movement, rendering interpolates between ticks.
+  uint32_t headlessFrames = 0;
+  uint32_t lightCount = 0;
+  bool shadows = false;
+  bool post = false;
+  uint32_t particleCount = 0;
+  purrOcclusionMode occlusionMode = purrOcclusionMode::Off;
+  bool profile = false;
+  float gpuBudgetMs = 0.0f;
+  VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+  double targetFps = 0.0;
+  double tickRate = 60.0;
+  bool useRenderThread = false;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--profile") == 0) profile = true;
+    else if (strcmp(argv[i], "--shadows") == 0) shadows = true;
+    else if (strcmp(argv[i], "--post") == 0) post = true;
+    else if (strcmp(argv[i], "--render-thread") == 0) useRenderThread = true;
+    else if (strcmp(argv[i], "--particles") == 0 && i+1 < argc) particleCount = static_cast<uint32_t>(atoi(argv[++i]));
+    else if (strcmp(argv[i], "--depth-prepass") == 0) sceneDepthPrepass = true;
+    else if (strcmp(argv[i], "--msaa") == 0 && i+1 < argc) context->settings.msaa = static_cast<PurrfectEngine::MSAA>(atoi(argv[++i]));
+    else if (strcmp(argv[i], "--fps") == 0 && i+1 < argc) targetFps = atof(argv[++i]);
+    else if (strcmp(argv[i], "--tick-rate") == 0 && i+1 < argc) tickRate = atof(argv[++i]);
+    else if (strcmp(argv[i], "--occlusion") == 0 && i+1 < argc) {
+      occlusionMode = strcmp(argv[++i], "gpu") == 0 ? purrOcclusionMode::Gpu : purrOcclusionMode::Cpu;
+    }
+    else if (strcmp(argv[i], "--lights") == 0 && i+1 < argc) lightCount = static_cast<uint32_t>(atoi(argv[++i]));
+    else if (strcmp(argv[i], "--present-mode") == 0 && i+1 < argc) {
+      const char *mode = argv[++i];
+      if (strcmp(mode, "mailbox") == 0) presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+      else if (strcmp(mode, "immediate") == 0) presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+      else presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    }
+    else if (strcmp(argv[i], "--dynamic-resolution") == 0) {
+      context->settings.dynamicResolution = true;
+      gpuBudgetMs = (i+1 < argc && argv[i+1][0] != '-') ? static_cast<float>(atof(argv[++i])) : 0.0f;
+    }
+    else if (strcmp(argv[i], "--headless") == 0) {
+      context->settings.headless = true;
+      headlessFrames = (i+1 < argc) ? static_cast<uint32_t>(atoi(argv[++i])) : 100;
+      if (headlessFrames == 0) headlessFrames = 100;
+    }
+  }
 
   try {
   input::setContext(context);
   renderer::setContext(context);
-  renderer::setVSync(true);
+  renderer::setPresentMode(presentMode);
   renderer::initialize("PurrfectEngine - Test", 1920, 1080);
+  purrFramePacerSettings pacerSettings{};
+  pacerSettings.targetFps = targetFps;
+  renderer::getFramePacer()->setSettings(pacerSettings);
+  purrProfiler::getDefault()->setEnabled(profile);
+  if (gpuBudgetMs > 0.0f) {
+    purrDynamicResolutionSettings resolutionSettings{};
+    resolutionSettings.budgetMs = gpuBudgetMs;
+    renderer::getDynamicResolution()->initialize(resolutionSettings);
+  }
+
+  std::vector<uint8_t> lastFrame{};
+  int lastFrameWidth = 0, lastFrameHeight = 0;
+  if (context->settings.headless) {
+    renderer::setReadbackCallback([&](const uint8_t *pixels, int w, int h, uint64_t) {
+      lastFrame.assign(pixels, pixels + static_cast<size_t>(w) * h * 4);
+      lastFrameWidth = w;
+      lastFrameHeight = h;
+    });
+  }
 
   purrScene *scene = new purrScene();
   { // Initialize object
@@ -53,6 +151,86 @@ int main(int argc, char **argv) {
     scene->addObject(object);
   }
 
+  sceneLighting = lightCount > 0 || shadows;
+  if (sceneLighting) {
+    // Per-draw tint for pbr.frag, every dynamic object but the first gets a hue of its own.
+    renderer::setDrawDataCallback([](purrObject *object, uint32_t objectIndex, void *data) {
+      if (object->isStatic() || objectIndex == 0) return;
+      float hue = objectIndex * 0.618034f * 6.2831853f;
+      glm::vec4 tint(0.5f + 0.5f * std::cos(hue), 0.5f + 0.5f * std::cos(hue + 2.094f), 0.5f + 0.5f * std::cos(hue + 4.189f), 0.6f);
+      memcpy(data, &tint, sizeof(tint));
+    });
+  }
+  purrCascadedShadows *cascadedShadows = nullptr;
+  if (shadows) {
+    purrObject *ground = new purrObject();
+    purrMesh *plane = new purrMesh();
+    glm::vec3 normal(0.0f, 1.0f, 0.0f), color(0.8f);
+    plane->initialize(context->frCommands, {
+      Vertex3D{ glm::vec3(-20.0f, 0.0f, -20.0f), color, glm::vec2(0.0f, 0.0f), normal },
+      Vertex3D{ glm::vec3( 20.0f, 0.0f, -20.0f), color, glm::vec2(1.0f, 0.0f), normal },
+      Vertex3D{ glm::vec3( 20.0f, 0.0f,  20.0f), color, glm::vec2(1.0f, 1.0f), normal },
+      Vertex3D{ glm::vec3(-20.0f, 0.0f,  20.0f), color, glm::vec2(0.0f, 1.0f), normal },
+    }, { 0, 2, 1, 0, 3, 2 });
+    ground->addComponent(new purrMeshComp(plane));
+    ground->setStatic(true);
+    scene->addObject(ground);
+
+    purrDirectionalLight sun{};
+    sun.direction = glm::vec3(-0.4f, -1.0f, 0.3f);
+    sun.intensity = 3.0f;
+    renderer::setDirectionalLight(sun);
+    cascadedShadows = new purrCascadedShadows();
+    cascadedShadows->initialize();
+    renderer::setShadows(cascadedShadows);
+  }
+  for (uint32_t i = 0; i < lightCount; ++i) { // Lights on a jittered shell around the model
+    float t = (i + 0.5f) / lightCount;
+    float theta = std::acos(1.0f - 2.0f * t), phi = i * 2.39996323f;
+    float distance = 1.2f + 0.8f * ((i * 7919u) % 101u) / 100.0f;
+    purrObject *object = new purrObject(new purrTransform(glm::vec3(0.0f, 1.0f, 0.0f) + distance * glm::vec3(
+      std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi))));
+    glm::vec3 color = glm::vec3(0.5f + 0.5f * std::cos(phi), 0.5f + 0.5f * std::cos(phi + 2.094f), 0.5f + 0.5f * std::cos(phi + 4.189f));
+    object->addComponent(new purrLightComp(color, 20.0f / std::sqrt(static_cast<float>(lightCount)), 0.75f));
+    scene->addObject(object);
+  }
+
+  purrOcclusionCuller *occlusion = nullptr;
+  if (occlusionMode != purrOcclusionMode::Off) {
+    // A thin box between the camera and a grid of models, only its occluder is rasterized by the CPU mode.
+    glm::vec3 wallMin(-4.0f, -2.0f, -0.1f), wallMax(4.0f, 4.0f, 0.1f), color(0.6f);
+    std::vector<Vertex3D> vertices{};
+    for (uint32_t i = 0; i < 8; ++i) {
+      glm::vec3 corner((i & 1) ? wallMax.x : wallMin.x, (i & 2) ? wallMax.y : wallMin.y, (i & 4) ? wallMax.z : wallMin.z);
+      vertices.push_back(Vertex3D{ corner, color, glm::vec2(0.0f), glm::vec3(0.0f, 0.0f, (i & 4) ? 1.0f : -1.0f) });
+    }
+    purrOccluderComp *occluder = purrOccluderComp::box(wallMin, wallMax);
+    purrMesh *wallMesh = new purrMesh();
+    wallMesh->initialize(context->frCommands, vertices, occluder->getIndices());
+    purrObject *wall = new purrObject(new purrTransform(glm::vec3(0.0f, 0.0f, 2.5f)));
+    wall->addComponent(new purrMeshComp(wallMesh));
+    wall->addComponent(occluder);
+    wall->setStatic(true);
+    scene->addObject(wall);
+
+    purrMeshComp *modelComp = (purrMeshComp*)scene->getObjects()[0]->getComponent("meshComponent");
+    for (int z = 0; z < 8; ++z) {
+      for (int x = 0; x < 8; ++x) {
+        purrObject *object = new purrObject(new purrTransform(glm::vec3(x - 3.5f, 0.5f + (z % 2), 4.0f + z)));
+        object->getTransform()->setScale(glm::vec3(0.3f));
+        object->addComponent(new purrMeshComp(modelComp->getMesh(), false));
+        scene->addObject(object);
+      }
+    }
+
+    purrOcclusionSettings occlusionSettings{};
+    occlusionSettings.mode = occlusionMode;
+    occlusion = new purrOcclusionCuller(occlusionSettings);
+    if (occlusionMode == purrOcclusionMode::Gpu) occlusion->initialize();
+    renderer::setOcclusionCuller(occlusion);
+    sceneKeepDepth = occlusionMode == purrOcclusionMode::Gpu;
+  }
+
   { // Initialize camera
     purrObject *object = new purrObject(new purrTransform(glm::vec3(0.0f, 0.0f, -5.0f)));
     object->addComponent(new purrCameraComp(new purrCamera()));
@@ -61,6 +239,32 @@ int main(int argc, char **argv) {
   }
   renderer::setScene(scene);
 
+  purrParticleSystem *particles = nullptr;
+  purrParticleReference *particleReference = nullptr;
+  purrObject *fountain = nullptr;
+  if (particleCount) {
+    purrParticleEmitterSettings emitterSettings{};
+    emitterSettings.maxParticles = particleCount;
+    emitterSettings.rate = particleCount / 2.0f; // Lifetimes average 1.5 s, so the buffer never runs full.
+    fountain = new purrObject(new purrTransform(glm::vec3(0.0f, -1.0f, 0.0f)));
+    fountain->addComponent(new purrParticleComp(emitterSettings));
+    scene->addObject(fountain);
+    particles = new purrParticleSystem();
+    particles->initialize();
+    if (context->settings.headless) particleReference = new purrParticleReference(emitterSettings);
+  }
+
+  purrPostProcess *postProcess = nullptr;
+  if (post) {
+    postProcess = new purrPostProcess();
+    postProcess->initialize();
+    renderer::setPostProcess(postProcess);
+  }
+
+  // Starts the scene pass at the configured count, M switches between it and no MSAA.
+  sceneMsaa = context->settings.msaa;
+  PurrfectEngine::MSAA toggleMsaa = sceneMsaa != PurrfectEngine::MSAA::None ? sceneMsaa : PurrfectEngine::MSAA::X4;
+
   sceneSampler = new purrSampler();
   sceneSampler->initialize(fr::frSampler::frSamplerInfo{});
 
@@ -68,44 +272,213 @@ int main(int argc, char **argv) {
   renderer::getSwapchainSize(&width, &height);
   createSceneObjects(width, height);
 
-  bool escapePressed = false;
-  float lastTime = 0;
-  while (!renderer::shouldClose()) {
-    float time = (float)glfwGetTime();
-    float deltaTime = time - lastTime;
-    lastTime = time;
+  // Headless frames are 1/60 s apart no matter how long they take, so runs are reproducible.
+  purrManualClock headlessClock{};
+  purrMainLoopSettings loopSettings{};
+  loopSettings.tickRate = tickRate;
+  purrMainLoop loop(loopSettings, context->settings.headless ? &headlessClock : nullptr);
+
+  // Everything between renderBegin and present, from the frame's snapshot (renderer::getSnapshot).
+  auto recordFrame = [&](float deltaTime) {
+    const purrRenderSnapshot *snapshot = renderer::getSnapshot();
+    renderer::updateCamera();
+    renderer::updateTransforms();
+    if (cascadedShadows) {
+      cascadedShadows->update(snapshot->camera, glm::vec3(-0.4f, -1.0f, 0.3f));
+      cascadedShadows->render();
+    }
+    if (sceneLighting) renderer::updateLights();
+    if (particles) {
+      particles->update(deltaTime);
+      if (particleReference) particleReference->update(deltaTime, fountain->getTransform()->getPosition(), snapshot->camera.view);
+    }
+    if (occlusion) occlusion->update(snapshot->camera.projection * snapshot->camera.view);
+
+    purrRenderGraph graph{};
+    purrRenderGraph::Handle sceneTarget = graph.importTexture("Scene", sceneRenderTarget);
+    graph.addPass("Scene", [&](purrRenderGraph::Builder &builder) {
+      builder.write(sceneTarget, purrResourceAccess::ColorAttachment, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }, [&](VkCommandBuffer) {
+      scenePipeline->begin({{{0.0f, 0.0f, 0.0f, 1.0f}}});
+      renderer::renderScene(scenePipeline);
+      if (particles) particles->render(scenePipeline);
+      scenePipeline->end();
+      if (occlusion) occlusion->build(scenePipeline->getDepth(), scenePipeline->getRenderExtent());
+    });
+    graph.addPass("Composite", [&](purrRenderGraph::Builder &builder) {
+      builder.read(sceneTarget, purrResourceAccess::SampledFragment);
+      builder.sideEffect();
+    }, [&](VkCommandBuffer) {
+      renderer::render();
+    });
+    graph.compile();
+    graph.execute(context->frActiveCmdBuf);
+    if (!renderer::present()) {
+      renderer::getSwapchainSize(&width, &height);
+      recreateSceneObjects(width, height);
+    }
+  };
 
+  auto pollInput = [&]() {
+    if (context->settings.headless) return;
     glfwPollEvents();
+    input::Update();
 
-    int x = input::IsKeyDown(input::key::D) - input::IsKeyDown(input::key::A);
-    int z = input::IsKeyDown(input::key::W) - input::IsKeyDown(input::key::S);
+    // Caught even when pressed and released between two polls.
+    if (input::GetSnapshot()->WasKeyPressed(input::key::M)) {
+      sceneMsaa = sceneMsaa == PurrfectEngine::MSAA::None ? toggleMsaa : PurrfectEngine::MSAA::None;
+    }
+  };
+  auto simulate = [&]() {
+    if (context->settings.headless) headlessClock.advance(1000000000ull / 60);
+    std::shared_ptr<const input::Snapshot> keys = input::GetSnapshot();
+    loop.advance(scene, [&](double dt) {
+      // The keys as they were at the tick's own time.
+      uint64_t time = loop.getTickTime();
+      int x = keys->IsKeyDownAt(input::key::D, time) - keys->IsKeyDownAt(input::key::A, time);
+      int z = keys->IsKeyDownAt(input::key::W, time) - keys->IsKeyDownAt(input::key::S, time);
+      glm::vec3 pos = scene->getCamera()->getTransform()->getPosition();
+      pos.x += x * static_cast<float>(dt);
+      pos.z += z * static_cast<float>(dt);
+      scene->getCamera()->getTransform()->setPosition(pos);
+    });
+  };
 
-    glm::vec3 pos = scene->getCamera()->getTransform()->getPosition();
-    pos.x += x * deltaTime;
-    pos.z += z * deltaTime;
-    scene->getCamera()->getTransform()->setPosition(pos);
+  bool escapePressed = false;
+  uint32_t frame = 0;
+  auto headlessStart = std::chrono::steady_clock::now();
+  purrRenderThread *renderThread = nullptr;
+  if (useRenderThread) {
+    // The main thread simulates and submits snapshots, the render thread records them one frame behind.
+    std::atomic<int> requestedMsaa{static_cast<int>(sceneMsaa)};
+    uint64_t lastRenderNs = purrClock::getDefault()->now();
+    renderThread = new purrRenderThread();
+    renderThread->start([&](const purrRenderSnapshot &) {
+      if (!renderer::renderBegin()) {
+        renderer::getSwapchainSize(&width, &height);
+        recreateSceneObjects(width, height);
+        return true;
+      }
+      renderer::getFramePacer()->waitForFrame();
+      PurrfectEngine::MSAA msaa = static_cast<PurrfectEngine::MSAA>(requestedMsaa.load());
+      if (msaa != context->settings.msaa) renderer::setMsaa(msaa);
 
-    if (!renderer::renderBegin()) {
-      renderer::getSwapchainSize(&width, &height);
-      recreateSceneObjects(width, height);
-      continue;
+      uint64_t now = purrClock::getDefault()->now();
+      float deltaTime = context->settings.headless ? 1.0f / 60.0f : static_cast<float>((now - lastRenderNs) * 1e-9);
+      lastRenderNs = now;
+      recordFrame(deltaTime);
+      return true;
+    });
+    while (!renderer::shouldClose() && renderThread->isRunning()) {
+      if (context->settings.headless && frame++ >= headlessFrames) break;
+      pollInput();
+      requestedMsaa = static_cast<int>(sceneMsaa);
+      simulate();
+      renderThread->submit(scene);
     }
+    renderThread->flush();
+    renderThread->stop();
+  } else {
+    while (!renderer::shouldClose()) {
+      if (context->settings.headless && frame++ >= headlessFrames) break;
 
-    renderer::updateCamera();
-    renderer::updateTransforms();
-    scenePipeline->begin({{{0.0f, 0.0f, 0.0f, 1.0f}}});
-    renderer::renderScene(scenePipeline);
-    scenePipeline->end();
+      if (!renderer::renderBegin()) {
+        renderer::getSwapchainSize(&width, &height);
+        recreateSceneObjects(width, height);
+        continue;
+      }
+      // As late as possible, the input below is what this frame shows.
+      renderer::getFramePacer()->waitForFrame();
 
-    renderer::render();
-    if (!renderer::present()) {
-      renderer::getSwapchainSize(&width, &height);
-      recreateSceneObjects(width, height);
+      pollInput();
+      if (sceneMsaa != context->settings.msaa) renderer::setMsaa(sceneMsaa);
+      simulate();
+      recordFrame(static_cast<float>(loop.getFrameSeconds()));
     }
   }
   
   renderer::waitIdle();
+  purrFramePacingStats pacing = renderer::getFramePacer()->getStats();
+  printf("Frame time %.2f ms (stddev %.2f, p99 %.2f), input to present %.2f ms (p99 %.2f), %u missed deadlines\n",
+         pacing.frameMsMean, pacing.frameMsStdDev, pacing.frameMsP99, pacing.latencyMsMean, pacing.latencyMsP99, pacing.missedDeadlines);
+  if (sceneLighting) {
+    purrLightClusterStats lightStats = renderer::getLightClusters()->getStats();
+    printf("Lights %u (%u visible), %u cluster entries, max %u per cluster in %u occupied clusters, binned in %.3f ms\n",
+           lightStats.lightCount, lightStats.visibleLights, lightStats.indexCount, lightStats.maxLightsPerCluster, lightStats.occupiedClusters, lightStats.buildMs);
+  }
+  if (cascadedShadows) {
+    purrShadowStats shadowStats = cascadedShadows->getStats();
+    printf("Shadows: %u static cascades redrawn last frame, %u static and %u dynamic draws, %u culled\n",
+           shadowStats.staticCascades, shadowStats.staticDraws, shadowStats.dynamicDraws, shadowStats.culledDraws);
+  }
+  if (occlusion) {
+    purrOcclusionStats occlusionStats = occlusion->getStats();
+    printf("Occlusion: %u tested, %u outside the frustum, %u occluded, %u occluder triangles rasterized in %.3f ms, tested in %.3f ms\n",
+           occlusionStats.tested, occlusionStats.frustumCulled, occlusionStats.occluded, occlusionStats.occluderTriangles, occlusionStats.rasterMs, occlusionStats.testMs);
+  }
+  if (renderThread) {
+    purrRenderThreadStats threadStats = renderThread->getStats();
+    printf("Render thread: %llu snapshots submitted, %llu rendered, %llu dropped\n",
+           (unsigned long long)threadStats.submitted, (unsigned long long)threadStats.rendered, (unsigned long long)threadStats.dropped);
+  }
+  purrMainLoopStats loopStats = loop.getStats();
+  printf("Main loop: %llu ticks in %llu frames, at most %u per frame, %llu dropped\n",
+         (unsigned long long)loopStats.ticks, (unsigned long long)loopStats.frames, loopStats.maxSteps, (unsigned long long)loopStats.droppedSteps);
+  purrDrawListStats drawStats = renderer::getDrawList()->getStats();
+  printf("Draw list: %u draws, %u pipeline and %u mesh changes, %u radix passes in %.3f ms\n",
+         drawStats.draws, drawStats.pipelineChanges, drawStats.meshChanges, drawStats.sortPasses, drawStats.sortMs);
+  purrGpuMemoryStats memoryStats = purrGpuAllocator::getDefault()->getStats();
+  printf("GPU memory: %u device allocations (max %u), %u blocks with %.1f of %.1f MiB used, %u dedicated (%.1f MiB)\n",
+         memoryStats.deviceAllocations, memoryStats.maxDeviceAllocations, memoryStats.blockCount,
+         memoryStats.blockUsedBytes / 1048576.0, memoryStats.blockBytes / 1048576.0, memoryStats.dedicatedCount, memoryStats.dedicatedBytes / 1048576.0);
+  for (uint32_t i = 0; i < static_cast<uint32_t>(purrMemoryCategory::Count); ++i) {
+    printf("  %-8s %5u allocations, %.1f MiB\n", purrGpuAllocator::getCategoryName(static_cast<purrMemoryCategory>(i)),
+           memoryStats.categories[i].allocations, memoryStats.categories[i].bytes / 1048576.0);
+  }
+  if (particles) {
+    purrParticleStats particleStats = particles->getStats();
+    printf("Particles: %u alive of %u, %u emitted and %u dispatches in the last frame\n",
+           particleStats.alive, particleStats.capacity, particleStats.emitted, particleStats.dispatches);
+    if (particleReference) {
+      printf("Particles: %u alive in the CPU reference\n", particleReference->getAlive());
+      // The mapped count is a frame behind while rendering, after waitIdle it holds the last update's.
+      if (particleStats.alive != particleReference->getAlive()) {
+        fprintf(stderr, "Particles: GPU count %u doesn't match the CPU reference %u!\n", particleStats.alive, particleReference->getAlive());
+        exitCode = 1;
+      }
+    }
+  }
+  if (postProcess) {
+    purrPostProcessStats postStats = postProcess->getStats();
+    printf("Post-process: average luminance %.4f, exposure %.3f, %u bloom levels\n", postStats.averageLuminance, postStats.exposure, postStats.bloomLevels);
+  }
+  purrPoolStats poolStats = purrObjectPools::getStats();
+  purrArenaStats arenaStats = renderer::getFrameArena()->getStats();
+  printf("Object pools: %u live of %u slots in %u chunks, %u heap allocations; frame arena peak %.1f of %.1f KiB in %u blocks\n",
+         poolStats.live, poolStats.capacity, poolStats.chunks, poolStats.heapAllocations,
+         arenaStats.peak / 1024.0, arenaStats.capacity / 1024.0, arenaStats.blocks);
+  purrDescriptorStats descriptorStats = purrDescriptorAllocator::getDefault()->getStats();
+  printf("Descriptors: %u persistent sets in %u pools\n", descriptorStats.sets, descriptorStats.pools);
+  if (profile) purrProfiler::getDefault()->exportChromeTrace("trace.json");
+  if (context->settings.headless) {
+    renderer::flushReadbacks();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - headlessStart).count();
+    printf("Rendered %u frames in %.3f s (%.1f fps)\n", headlessFrames, seconds, headlessFrames / seconds);
+
+    FILE *fd = fopen("frame.ppm", "wb");
+    if (fd && !lastFrame.empty()) {
+      fprintf(fd, "P6\n%d %d\n255\n", lastFrameWidth, lastFrameHeight);
+      for (size_t i = 0; i < lastFrame.size(); i += 4) fwrite(&lastFrame[i], 3, 1, fd);
+    }
+    if (fd) fclose(fd);
+  }
   delete scene;
+  delete cascadedShadows;
+  delete occlusion;
+  delete postProcess;
+  delete particles;
+  delete particleReference;
+  delete renderThread;
   delete sceneSampler;
   cleanupSceneObjects();
   renderer::cleanup();
@@ -115,5 +488,5 @@ int main(int argc, char **argv) {
 
   delete context;
 
-  return 0;
+  return exitCode;
 }
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef   PURRENGINE_TEST_UNIT_HPP_
+#define   PURRENGINE_TEST_UNIT_HPP_
+
+#include <cstdio>
+#include <vector>
+
+// Tests register themselves from their own translation unit, main runs all of them.
+// A failed PURR_CHECK reports and marks the running test failed, the test keeps going.
+namespace unit {
+
+  struct Test {
+    const char *name;
+    void (*fn)();
+  };
+
+  inline std::vector<Test> &tests() {
+    static std::vector<Test> sTests{};
+    return sTests;
+  }
+
+  inline bool &failed() {
+    static bool sFailed = false;
+    return sFailed;
+  }
+
+  inline void fail(const char *file, int line, const char *expr) {
+    fprintf(stderr, "[unit]: %s:%d: check failed: %s\n", file, line, expr);
+    failed() = true;
+  }
+
+  struct Registrar {
+    Registrar(const char *name, void (*fn)()) { tests().push_back(Test{ name, fn }); }
+  };
+
+}
+
+#define PURR_TEST(name) \
+  static void purrTest_##name(); \
+  static ::unit::Registrar purrTestRegistrar_##name(#name, purrTest_##name); \
+  static void purrTest_##name()
+
+#define PURR_CHECK(expr) do { if (!(expr)) ::unit::fail(__FILE__, __LINE__, #expr); } while (0)
+#define PURR_CHECK_NEAR(a, b, eps) PURR_CHECK(std::abs((a) - (b)) <= (eps))
+
+#endif // PURRENGINE_TEST_UNIT_HPP_
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include <cmath>
+
+#include <PurrfectEngine/PurrfectEngine.hpp>
+
+#include <unit.hpp>
+
+using namespace PurrfectEngine;
+
+#define MS 1000000ULL
+
+PURR_TEST(framePacerDeadlines) {
+  purrManualClock clock(0);
+  purrFramePacer pacer(&clock);
+  purrFramePacerSettings settings{};
+  settings.targetFps = 100.0;
+  settings.marginNs = 1 * MS;
+  pacer.setSettings(settings);
+
+  // No work measured yet, only the margin is kept before the first deadline.
+  PURR_CHECK(pacer.waitForFrame() == 9 * MS);
+  PURR_CHECK(pacer.getDeadline() == 10 * MS);
+  clock.advance(MS / 2);
+  pacer.framePresented();
+  PURR_CHECK(pacer.getDeadline() == 20 * MS);
+
+  // Predicted work is now 0.5ms.
+  PURR_CHECK(pacer.waitForFrame() == 18 * MS + MS / 2);
+  clock.advance(MS / 2);
+  pacer.framePresented();
+  PURR_CHECK(pacer.getDeadline() == 30 * MS);
+
+  // 15ms of work presents at 43.5ms, more than a period late: the grid starts over from there.
+  PURR_CHECK(pacer.waitForFrame() == 28 * MS + MS / 2);
+  clock.advance(15 * MS);
+  pacer.framePresented();
+  PURR_CHECK(pacer.getDeadline() == 53 * MS + MS / 2);
+  PURR_CHECK(pacer.getPredictedWorkNs() == 15 * MS);
+
+  purrFramePacingStats stats = pacer.getStats();
+  PURR_CHECK(stats.frames == 3);
+  PURR_CHECK(stats.missedDeadlines == 1);
+  PURR_CHECK_NEAR(stats.frameMsMean, 17.0, 1e-9);      // 9.5 and 24.5, the first frame has no previous present.
+  PURR_CHECK_NEAR(stats.latencyMsMean, 7.75, 1e-9);    // 0.5 and 15.
+  PURR_CHECK_NEAR(stats.sleepMsMean, 27.5 / 3, 1e-9);  // 9 + 9 + 9.5.
+  PURR_CHECK(clock.getSleptNs() == 27 * MS + MS / 2);
+
+  pacer.resetStats();
+  PURR_CHECK(pacer.getStats().frames == 0);
+}
+
+PURR_TEST(framePacerLimiterOff) {
+  purrManualClock clock(5 * MS);
+  purrFramePacer pacer(&clock);
+
+  PURR_CHECK(pacer.waitForFrame() == 5 * MS);
+  clock.advance(3 * MS);
+  pacer.framePresented();
+  PURR_CHECK(pacer.waitForFrame() == 8 * MS);
+  clock.advance(3 * MS);
+  pacer.framePresented();
+
+  PURR_CHECK(pacer.getDeadline() == 0);
+  PURR_CHECK(clock.getSleptNs() == 0);
+  purrFramePacingStats stats = pacer.getStats();
+  PURR_CHECK(stats.frames == 2);
+  PURR_CHECK(stats.missedDeadlines == 0);
+  PURR_CHECK_NEAR(stats.frameMsMean, 3.0, 1e-9);
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#include <unit.hpp>
+
+int main() {
+  int failures = 0;
+  for (const unit::Test &test: unit::tests()) {
+    unit::failed() = false;
+    test.fn();
+    printf("%s %s\n", unit::failed() ? "FAIL" : "ok  ", test.name);
+    if (unit::failed()) ++failures;
+  }
+  printf("%zu tests, %d failed\n", unit::tests().size(), failures);
+  return failures ? 1 : 0;
+}
\ No newline at end of file
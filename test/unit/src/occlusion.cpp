@@ -0,0 +1,44 @@
+#include <PurrfectEngine/PurrfectEngine.hpp>
+
+#include <unit.hpp>
+
+using namespace PurrfectEngine;
+
+// A 4x4 wall 10 units in front of a camera at the origin looking down -z, rasterized by the CPU culler.
+// Nothing here touches the device, the GPU mode isn't covered.
+PURR_TEST(occlusionCpuWall) {
+  purrScene scene{};
+  purrObject *wall = new purrObject(new purrTransform(glm::vec3(0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f)));
+  wall->addComponent(purrOccluderComp::box(glm::vec3(-2.0f, -2.0f, -10.5f), glm::vec3(2.0f, 2.0f, -10.0f)));
+  scene.addObject(wall);
+  purrRenderSnapshot snapshot{};
+  renderer::extractSnapshot(&scene, &snapshot);
+  renderer::setSnapshot(&snapshot);
+
+  purrOcclusionSettings settings{};
+  settings.mode = purrOcclusionMode::Cpu;
+  settings.threads = 2;
+  purrOcclusionCuller culler(settings);
+  glm::mat4 projection = glm::perspective(glm::radians(90.0f), static_cast<float>(settings.width) / settings.height, 0.1f, 100.0f);
+  glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+  culler.update(projection * view);
+
+  purrOcclusionStats stats = culler.getStats();
+  PURR_CHECK(stats.occluders == 1);
+  PURR_CHECK(stats.occluderTriangles == 12);
+
+  PURR_CHECK(culler.isOccluded(glm::vec4(0.0f, 0.0f, -20.0f, 1.0f)));    // Right behind it.
+  PURR_CHECK(culler.isOccluded(glm::vec4(-1.0f, 1.0f, -40.0f, 2.0f)));   // Farther, still within its silhouette.
+  PURR_CHECK(!culler.isOccluded(glm::vec4(0.0f, 0.0f, -5.0f, 1.0f)));    // In front of it.
+  PURR_CHECK(!culler.isOccluded(glm::vec4(8.0f, 0.0f, -20.0f, 1.0f)));   // Beside it.
+  PURR_CHECK(!culler.isOccluded(glm::vec4(4.0f, 0.0f, -20.0f, 1.0f)));   // Straddling its edge.
+  PURR_CHECK(!culler.isOccluded(glm::vec4(0.0f, 0.0f, -20.0f, 6.0f)));   // Larger than it.
+
+  // Without occluders nothing is hidden.
+  purrRenderSnapshot empty{};
+  renderer::setSnapshot(&empty);
+  culler.update(projection * view);
+  PURR_CHECK(culler.getStats().occluders == 0);
+  PURR_CHECK(!culler.isOccluded(glm::vec4(0.0f, 0.0f, -20.0f, 1.0f)));
+  renderer::setSnapshot(nullptr);
+}
\ No newline at end of file
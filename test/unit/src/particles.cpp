@@ -0,0 +1,86 @@
+#include <cstring>
+
+#include <PurrfectEngine/PurrfectEngine.hpp>
+
+#include <unit.hpp>
+
+using namespace PurrfectEngine;
+
+static bool sameParticle(const purrParticle &a, const purrParticle &b) {
+  return memcmp(&a, &b, sizeof(purrParticle)) == 0;
+}
+
+PURR_TEST(particleSpawnDeterministic) {
+  purrParticleEmitterSettings settings{};
+  glm::vec3 position(1.0f, 2.0f, 3.0f);
+  purrParticle particle = purrParticleReference::spawn(settings, position, 7);
+  PURR_CHECK(sameParticle(particle, purrParticleReference::spawn(settings, position, 7)));
+  PURR_CHECK(!sameParticle(particle, purrParticleReference::spawn(settings, position, 8)));
+  settings.seed = 1;
+  PURR_CHECK(!sameParticle(particle, purrParticleReference::spawn(settings, position, 7)));
+
+  for (uint32_t i = 0; i < 256; ++i) {
+    purrParticle p = purrParticleReference::spawn(settings, position, i);
+    glm::vec3 offset = glm::vec3(p.positionAge) - position;
+    PURR_CHECK(std::abs(offset.x) <= settings.spawnRadius && std::abs(offset.y) <= settings.spawnRadius && std::abs(offset.z) <= settings.spawnRadius);
+    PURR_CHECK(p.positionAge.w == 0.0f);
+    PURR_CHECK(p.velocityLifetime.w >= settings.lifetime.x && p.velocityLifetime.w <= settings.lifetime.y);
+  }
+}
+
+PURR_TEST(particleSimulateLifetime) {
+  purrParticleEmitterSettings settings{};
+  settings.drag = 0.0f;
+  purrParticle particle{ glm::vec4(0.0f), glm::vec4(0.0f, 2.0f, 0.0f, 0.5f) };
+  // Steps of 1/8 s are exact in binary, the fourth one reaches the lifetime.
+  PURR_CHECK(purrParticleReference::simulate(settings, 0.125f, &particle));
+  PURR_CHECK_NEAR(particle.velocityLifetime.y, 2.0f + settings.gravity.y * 0.125f, 1e-6f);
+  PURR_CHECK_NEAR(particle.positionAge.y, particle.velocityLifetime.y * 0.125f, 1e-6f);
+  PURR_CHECK(purrParticleReference::simulate(settings, 0.125f, &particle));
+  PURR_CHECK(purrParticleReference::simulate(settings, 0.125f, &particle));
+  PURR_CHECK(!purrParticleReference::simulate(settings, 0.125f, &particle));
+  PURR_CHECK(particle.positionAge.w == 0.5f);
+}
+
+PURR_TEST(particleSortKeyBackToFront) {
+  glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+  glm::vec4 viewRow(view[0][2], view[1][2], view[2][2], view[3][2]);
+  purrParticle nearParticle{ glm::vec4(0.0f, 0.0f, -2.0f, 0.0f), glm::vec4(0.0f) };
+  purrParticle farParticle{ glm::vec4(1.0f, 0.0f, -10.0f, 0.0f), glm::vec4(0.0f) };
+  purrParticle behind{ glm::vec4(0.0f, 0.0f, 5.0f, 0.0f), glm::vec4(0.0f) };
+  PURR_CHECK(purrParticleReference::sortKey(farParticle, viewRow) < purrParticleReference::sortKey(nearParticle, viewRow));
+  // Behind the camera clamps to depth 0, drawn last.
+  PURR_CHECK(purrParticleReference::sortKey(nearParticle, viewRow) < purrParticleReference::sortKey(behind, viewRow));
+}
+
+PURR_TEST(particleReferenceCompaction) {
+  purrParticleEmitterSettings settings{};
+  settings.rate = 64.0f;
+  settings.lifetime = glm::vec2(1.0f, 1.0f);
+  glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 1.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+  glm::vec4 viewRow(view[0][2], view[1][2], view[2][2], view[3][2]);
+
+  // 8 particles per step of 1/8 s, each one lives through 7 simulates, the 8th removes it.
+  purrParticleReference reference(settings);
+  reference.update(0.125f, glm::vec3(0.0f), view);
+  PURR_CHECK(reference.getAlive() == 8);
+  PURR_CHECK(sameParticle(reference.getParticles()[0], purrParticleReference::spawn(settings, glm::vec3(0.0f), 0)));
+  for (uint32_t i = 1; i < 4; ++i) reference.update(0.125f, glm::vec3(0.0f), view);
+  PURR_CHECK(reference.getAlive() == 32);
+  for (uint32_t i = 4; i < 20; ++i) reference.update(0.125f, glm::vec3(0.0f), view);
+  PURR_CHECK(reference.getAlive() == 64);
+
+  // Survivors stay in spawn order and the draw order is back to front.
+  const std::vector<purrParticle> &particles = reference.getParticles();
+  PURR_CHECK(sameParticle(particles.back(), purrParticleReference::spawn(settings, glm::vec3(0.0f), 20 * 8 - 1)));
+  const std::vector<uint32_t> &order = reference.getDrawOrder();
+  PURR_CHECK(order.size() == particles.size());
+  for (size_t i = 1; i < order.size(); ++i)
+    PURR_CHECK(purrParticleReference::sortKey(particles[order[i - 1]], viewRow) <= purrParticleReference::sortKey(particles[order[i]], viewRow));
+
+  // What doesn't fit is dropped.
+  settings.maxParticles = 40;
+  purrParticleReference full(settings);
+  for (uint32_t i = 0; i < 20; ++i) full.update(0.125f, glm::vec3(0.0f), view);
+  PURR_CHECK(full.getAlive() == 40);
+}
\ No newline at end of file
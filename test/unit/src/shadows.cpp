@@ -0,0 +1,49 @@
+#include <cmath>
+
+#include <PurrfectEngine/PurrfectEngine.hpp>
+
+#include <unit.hpp>
+
+using namespace PurrfectEngine;
+
+// Only update() is exercised, it fits the cascades on the CPU and needs no device. An empty snapshot has no casters.
+static void checkCascadesFollow(glm::vec3 lightDirection) {
+  purrRenderSnapshot snapshot{};
+  renderer::setSnapshot(&snapshot);
+
+  purrTransform transform(glm::vec3(2.0f, 1.0f, -3.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+  purrCamera camera(&transform);
+  purrRenderCamera renderCamera{};
+  renderCamera.view = camera.getView();
+  renderCamera.projection = camera.getProjection();
+  renderCamera.position = transform.getPosition();
+  renderCamera.settings = camera.getSettings();
+  purrCascadedShadows shadows{};
+  shadows.update(renderCamera, lightDirection);
+  renderer::setSnapshot(nullptr);
+
+  glm::vec3 direction = glm::normalize(lightDirection);
+  PURR_CHECK(glm::dot(shadows.getLightDirection(), direction) > 0.9999f);
+
+  float previousSplit = 0.0f;
+  for (const purrShadowCascade &cascade: shadows.getCascades()) {
+    // Orthographic along the light: its direction maps to pure depth.
+    glm::vec4 projected = cascade.viewProjection * glm::vec4(direction, 0.0f);
+    PURR_CHECK(std::abs(projected.x) < 1e-3f);
+    PURR_CHECK(std::abs(projected.y) < 1e-3f);
+    PURR_CHECK(std::abs(projected.z) > 1e-6f);
+
+    PURR_CHECK(cascade.splitDepth > previousSplit);
+    PURR_CHECK(cascade.texelSize > 0.0f);
+    previousSplit = cascade.splitDepth;
+  }
+  PURR_CHECK_NEAR(previousSplit, shadows.getSettings().maxDistance, 1e-3f);
+}
+
+PURR_TEST(shadowCascadesFollowOverheadSun) {
+  checkCascadesFollow(glm::vec3(0.0f, -1.0f, 0.0f));
+}
+
+PURR_TEST(shadowCascadesFollowSlantedSun) {
+  checkCascadesFollow(glm::vec3(-0.4f, -1.0f, 0.3f));
+}
\ No newline at end of file